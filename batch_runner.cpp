@@ -0,0 +1,138 @@
+#include "batch_runner.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Номера прогонов [begin, end), ещё не взятые потоком. Владелец берёт номера с начала,
+// другие потоки забирают половину с конца
+struct alignas(64) WorkRange {
+    mutex lock;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+class WorkStealingQueue {
+public:
+    WorkStealingQueue(size_t count, size_t workers)
+        : ranges_(workers) {
+        for (size_t i = 0; i < workers; ++i) {
+            ranges_[i].begin = count * i / workers;
+            ranges_[i].end = count * (i + 1) / workers;
+        }
+    }
+
+    // Возвращает следующий номер для потока worker либо nullopt, если работа закончилась
+    optional<size_t> Next(size_t worker) {
+        if (auto index = Take(ranges_[worker])) {
+            return index;
+        }
+        for (size_t shift = 1; shift < ranges_.size(); ++shift) {
+            if (Steal(ranges_[(worker + shift) % ranges_.size()], ranges_[worker])) {
+                return Take(ranges_[worker]);
+            }
+        }
+        return nullopt;
+    }
+
+private:
+    static optional<size_t> Take(WorkRange& range) {
+        lock_guard guard(range.lock);
+        if (range.begin == range.end) {
+            return nullopt;
+        }
+        return range.begin++;
+    }
+
+    // Переносит половину номеров victim (не меньше одного) в пустой диапазон thief
+    static bool Steal(WorkRange& victim, WorkRange& thief) {
+        size_t begin = 0;
+        size_t end = 0;
+        {
+            lock_guard guard(victim.lock);
+            if (victim.begin == victim.end) {
+                return false;
+            }
+            end = victim.end;
+            begin = victim.begin + (victim.end - victim.begin) / 2;
+            victim.end = begin;
+        }
+        lock_guard guard(thief.lock);
+        thief.begin = begin;
+        thief.end = end;
+        return true;
+    }
+
+    vector<WorkRange> ranges_;
+};
+
+void RunOne(const CompiledProgram& program, size_t index, const BatchInput& input, const BatchOptions& options,
+            BatchResult& result) {
+    ostringstream output;
+    runtime::SimpleContext context(output);
+    runtime::MemoryBudget budget(options.memory_limit);
+    runtime::ExecutionLimits limits;
+    limits.SetStepLimit(options.max_steps);
+
+    RunOptions run;
+    run.memory_budget = options.memory_limit != 0 ? &budget : nullptr;
+    run.limits = options.max_steps != 0 ? &limits : nullptr;
+    try {
+        runtime::Closure globals;
+        if (input) {
+            input(index, globals);
+        }
+        program.Run(globals, context, run);
+    } catch (const exception& e) {
+        result.errors[index] = e.what();
+    }
+    result.outputs[index] = std::move(output).str();
+}
+
+}  // namespace
+
+double BatchResult::Throughput() const {
+    const chrono::duration<double> seconds = elapsed;
+    return seconds.count() > 0 ? static_cast<double>(outputs.size()) / seconds.count() : 0;
+}
+
+BatchResult RunBatch(const CompiledProgram& program, size_t runs, const BatchInput& input,
+                     const BatchOptions& options) {
+    BatchResult result;
+    result.threads = options.threads != 0 ? options.threads : max(thread::hardware_concurrency(), 1U);
+    result.outputs.resize(runs);
+    result.errors.resize(runs);
+
+    const auto start = chrono::steady_clock::now();
+    WorkStealingQueue queue(runs, result.threads);
+    auto worker = [&](size_t id) {
+        while (const auto index = queue.Next(id)) {
+            RunOne(program, *index, input, options, result);
+        }
+    };
+    {
+        vector<thread> threads;
+        threads.reserve(result.threads - 1);
+        for (size_t id = 1; id < result.threads; ++id) {
+            threads.emplace_back(worker, id);
+        }
+        // Текущий поток работает наравне с остальными
+        worker(0);
+        for (thread& t : threads) {
+            t.join();
+        }
+    }
+    result.elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+    result.failed = static_cast<size_t>(count_if(result.errors.begin(), result.errors.end(), [](const string& error) {
+        return !error.empty();
+    }));
+    return result;
+}
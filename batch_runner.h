@@ -0,0 +1,51 @@
+#pragma once
+
+#include "interpreter.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Параметры пакетного выполнения программы
+struct BatchOptions {
+    // Число рабочих потоков. 0 - по числу ядер
+    size_t threads = 0;
+    // Ограничение памяти каждого прогона в байтах, 0 - без ограничения (см. runtime::MemoryBudget)
+    size_t memory_limit = 0;
+    // Бюджет шагов каждого прогона, 0 - без ограничения (см. runtime::ExecutionLimits)
+    uint64_t max_steps = 0;
+};
+
+// Результаты пакетного выполнения
+struct BatchResult {
+    // Вывод каждого прогона в порядке номеров
+    std::vector<std::string> outputs;
+    // Текст ошибки каждого прогона, пустой для успешных
+    std::vector<std::string> errors;
+    // Число прогонов, завершившихся ошибкой
+    size_t failed = 0;
+    // Число рабочих потоков
+    size_t threads = 0;
+    // Время выполнения всего пакета
+    std::chrono::nanoseconds elapsed{0};
+
+    // Возвращает число прогонов в секунду
+    [[nodiscard]] double Throughput() const;
+};
+
+// Заполняет глобальные переменные прогона с номером index его входными данными.
+// Вызывается в потоке, который выполняет прогон
+using BatchInput = std::function<void(size_t index, runtime::Closure& globals)>;
+
+/*
+ * Выполняет программу program runs раз на пуле потоков с перехватом работы.
+ * Номера прогонов делятся между потоками поровну. Поток, исчерпавший свою часть, забирает половину
+ * оставшихся номеров у другого потока, поэтому неравномерные по длительности прогоны не оставляют потоки
+ * без работы. Каждый прогон получает собственные глобальные переменные, контекст вывода, бюджет памяти
+ * и ограничения выполнения, а куча и пул объектов у каждого потока свои.
+ * Ошибка прогона не прерывает пакет, а записывается в BatchResult::errors
+ */
+BatchResult RunBatch(const CompiledProgram& program, size_t runs, const BatchInput& input,
+                     const BatchOptions& options);
@@ -0,0 +1,64 @@
+#include "batch_runner.h"
+#include "bench_runner.h"
+
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+const string PROGRAM = R"(
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def __str__():
+    return '(' + str(self.x) + ', ' + str(self.y) + ')'
+
+f = Fib()
+p = Point(n, f.calc(12))
+print p
+)"s;
+
+constexpr size_t RUNS = 2000;
+
+// Пропускная способность пакета из RUNS прогонов на 1, 2, 4... потоках вплоть до числа ядер
+void BenchBatchScaling(BenchRunner& br) {
+    const string name = "BenchBatchScaling"s;
+    if (!br.IsSelected(name)) {
+        return;
+    }
+    const CompiledProgram program(PROGRAM, RunOptions{});
+    const size_t cores = max(thread::hardware_concurrency(), 1U);
+    double single = 0;
+    for (size_t threads = 1;; threads = min(threads * 2, cores)) {
+        BatchOptions options;
+        options.threads = threads;
+        const BatchResult result = RunBatch(program, RUNS, [](size_t index, runtime::Closure& globals) {
+            globals["n"s] = runtime::ObjectHolder::Own(runtime::Number(static_cast<int>(index)));
+        }, options);
+        DoNotOptimize(result);
+
+        const double throughput = result.Throughput();
+        single = threads == 1 ? throughput : single;
+        br.Report(name, "threads="s + to_string(threads) + " throughput"s, throughput, "runs/s"s);
+        br.Report(name, "threads="s + to_string(threads) + " speedup"s, throughput / single, "x"s);
+        if (threads == cores) {
+            break;
+        }
+    }
+}
+
+}  // namespace
+
+void RunBatchRunnerBenchmarks(BenchRunner& br) {
+    BenchBatchScaling(br);
+}
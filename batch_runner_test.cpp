@@ -0,0 +1,124 @@
+#include "batch_runner.h"
+#include "test_runner.h"
+
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const string PROGRAM = R"(
+class Square:
+  def __init__(n):
+    self.n = n
+
+  def value():
+    return self.n * self.n
+
+  def __str__():
+    return 'square of ' + str(self.n)
+
+s = Square(n)
+print s, s.value(), 100 / n
+)"s;
+
+void SetNumber(runtime::Closure& globals, int n) {
+    globals["n"s] = runtime::ObjectHolder::Own(runtime::Number(n));
+}
+
+string Expected(int n) {
+    return "square of "s + to_string(n) + " "s + to_string(n * n) + " "s + to_string(100 / n) + "\n"s;
+}
+
+void TestBatchRunsEveryInput() {
+    for (const bool lazy : {false, true}) {
+        RunOptions options;
+        options.lazy_methods = lazy;
+        const CompiledProgram program(PROGRAM, options);
+        BatchOptions batch;
+        batch.threads = 4;
+
+        const size_t runs = 1000;
+        const BatchResult result = RunBatch(program, runs, [](size_t index, runtime::Closure& globals) {
+            SetNumber(globals, static_cast<int>(index) + 1);
+        }, batch);
+
+        ASSERT_EQUAL(result.threads, 4U);
+        ASSERT_EQUAL(result.failed, 0U);
+        ASSERT_EQUAL(result.outputs.size(), runs);
+        for (size_t i = 0; i < runs; ++i) {
+            ASSERT_EQUAL(result.outputs[i], Expected(static_cast<int>(i) + 1));
+            ASSERT(result.errors[i].empty());
+        }
+        ASSERT(result.Throughput() > 0);
+    }
+}
+
+void TestBatchIsolatesFailures() {
+    const CompiledProgram program(PROGRAM, RunOptions{});
+    BatchOptions batch;
+    batch.threads = 3;
+    batch.max_steps = 1000;
+    // Каждый пятый прогон делит на ноль
+    const BatchResult result = RunBatch(program, 50, [](size_t index, runtime::Closure& globals) {
+        SetNumber(globals, static_cast<int>(index % 5));
+    }, batch);
+
+    ASSERT_EQUAL(result.failed, 10U);
+    for (size_t i = 0; i < 50; ++i) {
+        const int n = static_cast<int>(i % 5);
+        if (n == 0) {
+            ASSERT(!result.errors[i].empty());
+        }
+        else {
+            ASSERT(result.errors[i].empty());
+            ASSERT_EQUAL(result.outputs[i], Expected(n));
+        }
+    }
+}
+
+void TestBatchAppliesLimitsPerRun() {
+    const CompiledProgram program(R"(
+class Counter:
+  def count(n):
+    if n > 0:
+      return self.count(n - 1) + 1
+    return 0
+
+c = Counter()
+print c.count(n)
+)"s, RunOptions{});
+    BatchOptions batch;
+    batch.threads = 2;
+    batch.max_steps = 200;
+    const BatchResult result = RunBatch(program, 20, [](size_t index, runtime::Closure& globals) {
+        SetNumber(globals, static_cast<int>(index) * 10);
+    }, batch);
+
+    // Длинные прогоны останавливаются, не мешая коротким
+    ASSERT(result.failed > 0);
+    ASSERT(result.failed < 20);
+    ASSERT_EQUAL(result.outputs[1], "10\n"s);
+    ASSERT(!result.errors[19].empty());
+}
+
+void TestBatchWithoutRuns() {
+    const CompiledProgram program("print 1\n"s, RunOptions{});
+    BatchOptions batch;
+    batch.threads = 8;
+    const BatchResult result = RunBatch(program, 0, {}, batch);
+    ASSERT(result.outputs.empty());
+    ASSERT_EQUAL(result.failed, 0U);
+
+    const BatchResult single = RunBatch(program, 3, {}, batch);
+    ASSERT_EQUAL(single.outputs, (vector<string>{"1\n"s, "1\n"s, "1\n"s}));
+}
+
+}  // namespace
+
+void RunBatchRunnerTests(TestRunner& tr) {
+    RUN_TEST(tr, TestBatchRunsEveryInput);
+    RUN_TEST(tr, TestBatchIsolatesFailures);
+    RUN_TEST(tr, TestBatchAppliesLimitsPerRun);
+    RUN_TEST(tr, TestBatchWithoutRuns);
+}
@@ -0,0 +1,43 @@
+#include "bench_runner.h"
+
+#include <cstdlib>
+#include <string>
+
+void RunInterpreterBenchmarks(BenchRunner& br);
+void RunBatchRunnerBenchmarks(BenchRunner& br);
+
+namespace ast {
+void RunSerializeBenchmarks(BenchRunner& br);
+}
+
+namespace runtime {
+void RunOutputContextBenchmarks(BenchRunner& br);
+void RunHeapBenchmarks(BenchRunner& br);
+void RunObjectPoolBenchmarks(BenchRunner& br);
+void RunMemoryBudgetBenchmarks(BenchRunner& br);
+void RunExecutionLimitsBenchmarks(BenchRunner& br);
+void RunIsolateBenchmarks(BenchRunner& br);
+void RunCoroutineBenchmarks(BenchRunner& br);
+void RunListBenchmarks(BenchRunner& br);
+void RunDictBenchmarks(BenchRunner& br);
+void RunStringMethodsBenchmarks(BenchRunner& br);
+}
+
+// Использование: mython_bench [фильтр по имени замера] [число повторов]
+int main(int argc, char* argv[]) {
+    BenchRunner br(argc > 2 ? std::atoi(argv[2]) : 3, argc > 1 ? argv[1] : "");
+    RunInterpreterBenchmarks(br);
+    RunBatchRunnerBenchmarks(br);
+    runtime::RunOutputContextBenchmarks(br);
+    runtime::RunHeapBenchmarks(br);
+    runtime::RunObjectPoolBenchmarks(br);
+    runtime::RunMemoryBudgetBenchmarks(br);
+    runtime::RunExecutionLimitsBenchmarks(br);
+    runtime::RunIsolateBenchmarks(br);
+    runtime::RunCoroutineBenchmarks(br);
+    runtime::RunListBenchmarks(br);
+    runtime::RunDictBenchmarks(br);
+    runtime::RunStringMethodsBenchmarks(br);
+    ast::RunSerializeBenchmarks(br);
+    return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+// Простейший запускатель замеров производительности, устроен по образцу TestRunner.
+// Каждый замер выполняется repetitions раз, выводится лучшее и среднее время
+class BenchRunner {
+public:
+    explicit BenchRunner(int repetitions = 3, std::string filter = {})
+        : repetitions_(std::max(repetitions, 1))
+        , filter_(std::move(filter)) {
+    }
+
+    // Возвращает true, если замер bench_name выбран фильтром командной строки
+    [[nodiscard]] bool IsSelected(const std::string& bench_name) const {
+        return filter_.empty() || bench_name.find(filter_) != std::string::npos;
+    }
+
+    template <class BenchFunc>
+    void RunBench(BenchFunc func, const std::string& bench_name) {
+        if (!IsSelected(bench_name)) {
+            return;
+        }
+
+        double best = std::numeric_limits<double>::max();
+        double total = 0;
+        for (int i = 0; i < repetitions_; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+            total += elapsed.count();
+        }
+
+        std::cout << std::fixed << std::setprecision(3) << bench_name << ": best " << best << " ms, mean "
+                  << total / repetitions_ << " ms" << std::endl;
+    }
+
+    // Выводит дополнительную метрику замера, например пропускную способность
+    void Report(const std::string& bench_name, const std::string& metric, double value, const std::string& unit) const {
+        if (IsSelected(bench_name)) {
+            std::cout << std::fixed << std::setprecision(3) << bench_name << ": " << metric << ' ' << value << ' '
+                      << unit << std::endl;
+        }
+    }
+
+private:
+    int repetitions_;
+    std::string filter_;
+};
+
+#define RUN_BENCH(br, func) br.RunBench(func, #func)
+
+// Не даёт компилятору выбросить вычисление value как неиспользуемое
+template <class T>
+void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
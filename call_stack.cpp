@@ -0,0 +1,90 @@
+#include "call_stack.h"
+
+#include <string>
+
+#include <pthread.h>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        thread_local CallStack* current_stack = nullptr;
+
+        // Стек вызовов на системном стеке текущего потока
+        CallStack& ThreadStack() {
+            thread_local CallStack stack = [] {
+                void* base = nullptr;
+                size_t size = 0;
+                pthread_attr_t attr;
+                if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+                    pthread_attr_getstack(&attr, &base, &size);
+                    pthread_attr_destroy(&attr);
+                }
+                return CallStack(base, size);
+            }();
+            return stack;
+        }
+    }  // namespace
+
+    CallStack::CallStack(const void* native_base, size_t native_size, size_t max_depth)
+        : max_depth_(max_depth)
+        , native_limit_(native_size > NATIVE_STACK_RESERVE
+                            ? static_cast<const char*>(native_base) + NATIVE_STACK_RESERVE
+                            : nullptr) {
+        top_ = &frames_.emplace_back();
+    }
+
+    CallStack& CallStack::Current() {
+        return current_stack != nullptr ? *current_stack : ThreadStack();
+    }
+
+    CallStack::Scope::Scope(CallStack& stack)
+        : previous_(current_stack) {
+        current_stack = &stack;
+    }
+
+    CallStack::Scope::~Scope() {
+        current_stack = previous_;
+    }
+
+    Frame& CallStack::Push() {
+        if (depth_ >= max_depth_) {
+            throw RecursionError("Maximum recursion depth exceeded: "s + to_string(max_depth_) + " calls"s);
+        }
+        // Стек растёт вниз: кадр текущей функции лежит тем ниже, чем глубже вызов
+        if (static_cast<const char*>(__builtin_frame_address(0)) < native_limit_) {
+            throw RecursionError("Maximum recursion depth exceeded: stack is exhausted after "s + to_string(depth_)
+                                 + " calls"s);
+        }
+        ++depth_;
+        if (depth_ == frames_.size()) {
+            frames_.emplace_back();
+        }
+        top_ = &frames_[depth_];
+        return *top_;
+    }
+
+    void CallStack::Pop() noexcept {
+        Frame& frame = *top_;
+        frame.locals.clear();
+        frame.result = {};
+        frame.jump = Jump::None;
+        frame.tail_object = {};
+        frame.tail_method = nullptr;
+        frame.tail_args.clear();
+        frame.callee = {};
+        --depth_;
+        top_ = &frames_[depth_];
+    }
+
+    void CallStack::SetMaxDepth(size_t max_depth) {
+        max_depth_ = max_depth;
+    }
+
+    void CallStack::ReleaseFrames() noexcept {
+        frames_.resize(depth_ + 1);
+        top_ = &frames_[depth_];
+    }
+
+}  // namespace runtime
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstddef>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace runtime {
+
+    // Ошибка программы, превысившей наибольшую глубину вызовов методов
+    class RecursionError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Команда, прервавшая выполнение составных инструкций кадра
+    enum class Jump {
+        None,
+        // return: метод завершается
+        Return,
+        // break: завершается ближайший цикл
+        Break,
+        // continue: ближайший цикл переходит к следующему повторению
+        Continue,
+    };
+
+    // Кадр вызова метода
+    struct Frame {
+        // Параметры метода, его локальные переменные и self
+        Closure locals;
+        // Значение, переданное командой return
+        ObjectHolder result;
+        // Выполненная команда перехода: пока она не обработана, составные инструкции кадра не выполняются
+        Jump jump = Jump::None;
+        // Хвостовой вызов return object.method(args), который выполнится в этом кадре после выхода из метода.
+        // tail_method равен nullptr, если хвостового вызова нет
+        ObjectHolder tail_object;
+        const std::string* tail_method = nullptr;
+        std::vector<ObjectHolder> tail_args;
+        // Экземпляр, метод которого выполняется в кадре после хвостового вызова. Ссылка держит его,
+        // пока выполняется метод, как при обычном вызове его держит вызывающий
+        ObjectHolder callee;
+    };
+
+    /*
+     * Стек вызовов методов Mython. Кадры хранятся в куче и используются повторно: таблица переменных
+     * кадра сохраняет свои корзины между вызовами, а команды return, break и continue не выбрасывают
+     * исключений, а отмечают кадр, и составные инструкции завершаются обычным возвратом.
+     * Нижний кадр принадлежит инструкциям верхнего уровня программы.
+     *
+     * Методы по-прежнему вызывают друг друга рекурсией C++, поэтому, кроме глубины вызовов, стек следит
+     * за запасом системного стека, на котором выполняется (потока либо сопрограммы), и выбрасывает
+     * RecursionError прежде, чем системный стек переполнится.
+     *
+     * У каждого потока свой стек вызовов, у каждой задачи (см. CoroutineScheduler) - тоже
+     */
+    class CallStack {
+    public:
+        static constexpr size_t DEFAULT_MAX_DEPTH = 10000;
+        // Запас системного стека, который остаётся на инструкции между двумя вызовами методов
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+        static constexpr size_t NATIVE_STACK_RESERVE = 256 * 1024;
+#else
+        static constexpr size_t NATIVE_STACK_RESERVE = 64 * 1024;
+#endif
+
+        // Стек вызовов, выполняющихся на системном стеке [native_base, native_base + native_size)
+        CallStack(const void* native_base, size_t native_size, size_t max_depth = DEFAULT_MAX_DEPTH);
+
+        CallStack(const CallStack&) = delete;
+        CallStack& operator=(const CallStack&) = delete;
+
+        // Возвращает стек вызовов, подключённый к текущему потоку, а без подключённого - стек потока
+        static CallStack& Current();
+
+        // Подключает стек вызовов к текущему потоку на время своей жизни
+        class Scope {
+        public:
+            explicit Scope(CallStack& stack);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            CallStack* previous_;
+        };
+
+        // Кадр метода на время его вызова
+        class FrameGuard {
+        public:
+            explicit FrameGuard(CallStack& stack)
+                : stack_(stack)
+                , frame_(stack.Push()) {
+            }
+
+            ~FrameGuard() {
+                stack_.Pop();
+            }
+
+            FrameGuard(const FrameGuard&) = delete;
+            FrameGuard& operator=(const FrameGuard&) = delete;
+
+            Frame& operator*() const {
+                return frame_;
+            }
+
+            Frame* operator->() const {
+                return &frame_;
+            }
+
+        private:
+            CallStack& stack_;
+            Frame& frame_;
+        };
+
+        // Добавляет кадр для вызова метода. Если глубина вызовов достигла наибольшей или системного стека
+        // осталось меньше NATIVE_STACK_RESERVE, выбрасывает RecursionError
+        Frame& Push();
+        // Убирает верхний кадр, освобождая его переменные и результат
+        void Pop() noexcept;
+
+        // Возвращает кадр выполняющегося метода либо нижний кадр, если методы не выполняются
+        [[nodiscard]] Frame& Top() const {
+            return *top_;
+        }
+
+        // Число выполняющихся методов
+        [[nodiscard]] size_t GetDepth() const {
+            return depth_;
+        }
+
+        [[nodiscard]] size_t GetMaxDepth() const {
+            return max_depth_;
+        }
+
+        void SetMaxDepth(size_t max_depth);
+
+        // Освобождает память кадров выше текущего, сохранённых для повторного использования
+        void ReleaseFrames() noexcept;
+
+    private:
+        // Кадры с адресами, которые не меняются при добавлении новых
+        std::deque<Frame> frames_;
+        Frame* top_ = nullptr;
+        size_t depth_ = 0;
+        size_t max_depth_;
+        // Адрес системного стека, ниже которого вызовы запрещены
+        const char* native_limit_;
+    };
+
+}  // namespace runtime
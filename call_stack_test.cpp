@@ -0,0 +1,207 @@
+#include "call_stack.h"
+#include "interpreter.h"
+#include "test_program.h"
+#include "test_runner.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+const string DOWN_CLASS = R"(
+class Down:
+  def down(n):
+    if n > 0:
+      return self.down(n - 1) + 1
+    return 0
+
+d = Down()
+)"s;
+
+RunOptions MaxDepth(size_t max_depth) {
+    RunOptions options;
+    options.max_depth = max_depth;
+    return options;
+}
+
+void TestCallStackFrames() {
+    int marker = 0;
+    CallStack stack(nullptr, 0, 2);
+    ASSERT_EQUAL(stack.GetDepth(), 0U);
+    Frame& root = stack.Top();
+    {
+        CallStack::FrameGuard first(stack);
+        first->locals["x"s] = ObjectHolder::Own(Number(1));
+        ASSERT_EQUAL(&stack.Top(), &*first);
+        {
+            CallStack::FrameGuard second(stack);
+            ASSERT_EQUAL(stack.GetDepth(), 2U);
+            ASSERT_THROWS(stack.Push(), RecursionError);
+        }
+        ASSERT_EQUAL(stack.GetDepth(), 1U);
+    }
+    ASSERT_EQUAL(&stack.Top(), &root);
+    // Кадр используется повторно, но без переменных прошлого вызова
+    Frame& reused = stack.Push();
+    ASSERT(reused.locals.empty());
+    ASSERT(!reused.result);
+    stack.Pop();
+    stack.ReleaseFrames();
+    ASSERT_EQUAL(&stack.Top(), &root);
+
+    // Без запаса системного стека вызовы запрещены
+    CallStack exhausted(&marker, CallStack::NATIVE_STACK_RESERVE * 2);
+    ASSERT_THROWS(exhausted.Push(), RecursionError);
+}
+
+void TestRecursionDepthLimit() {
+    ASSERT_EQUAL(Run(DOWN_CLASS + "print d.down(2000)\n"s), "2000\n"s);
+    ASSERT_EQUAL(Run(DOWN_CLASS + "print d.down(99)\n"s, MaxDepth(100)), "99\n"s);
+    try {
+        Run(DOWN_CLASS + "print d.down(100)\n"s, MaxDepth(100));
+        ASSERT(false);
+    } catch (const RecursionError& e) {
+        ASSERT(string(e.what()).find("100 calls"s) != string::npos);
+    }
+    // После ошибки стек вызовов потока пуст и снова пригоден для программ
+    ASSERT_EQUAL(CallStack::Current().GetDepth(), 0U);
+    ASSERT_EQUAL(Run(DOWN_CLASS + "print d.down(10)\n"s), "10\n"s);
+}
+
+void TestNativeStackGuard() {
+    // Глубина не ограничена, но системный стек кончается раньше: вместо аварии - RecursionError
+    const string endless = DOWN_CLASS + "print d.down(100000000)\n"s;
+    ASSERT_THROWS(Run(endless, MaxDepth(1'000'000'000)), RecursionError);
+
+    // У задачи свой системный стек, и его запас проверяется так же
+    const string in_task = DOWN_CLASS + "t = task(d.down, 100000000)\nt.join()\n"s;
+    ASSERT_THROWS(Run(in_task, MaxDepth(1'000'000'000)), RecursionError);
+}
+
+void TestReturnStopsMethod() {
+    const string program = R"(
+class Finder:
+  def find(n):
+    if n > 3:
+      if n > 5:
+        print 'big'
+        return 'big'
+      print 'medium'
+      return 'medium'
+    print 'small'
+    return 'small'
+
+  def nothing():
+    x = 1
+
+f = Finder()
+a = f.find(7)
+b = f.find(4)
+c = f.find(1)
+print a, b, c, f.nothing()
+)"s;
+    ASSERT_EQUAL(Run(program), "big\nmedium\nsmall\nbig medium small None\n"s);
+    ASSERT_THROWS(Run("print 1\nreturn 2\n"s), runtime_error);
+}
+
+void TestTailCalls() {
+    // Миллион шагов рекурсии в хвостовой позиции при глубине вызовов 10
+    const string countdown = R"(
+class Counter:
+  def count(n, total):
+    if n == 0:
+      return total
+    return self.count(n - 1, total + 1)
+
+c = Counter()
+print c.count(1000000, 0)
+)"s;
+    ASSERT_EQUAL(Run(countdown, MaxDepth(10)), "1000000\n"s);
+
+    // Хвостовые вызовы между разными экземплярами
+    const string ping_pong = R"(
+class Player:
+  def __init__(name):
+    self.name = name
+
+  def hit(n, other):
+    if n == 0:
+      return self.name
+    return other.hit(n - 1, self)
+
+a = Player('a')
+b = Player('b')
+print a.hit(100001, b), a.hit(100000, b)
+)"s;
+    ASSERT_EQUAL(Run(ping_pong, MaxDepth(10)), "b a\n"s);
+
+    // Экземпляр, на который ссылается только переменная вызывающего метода, живёт до конца вызова
+    const string temporary = R"(
+class Adder:
+  def __init__(base):
+    self.base = base
+
+  def add(n):
+    return self.base + n
+
+class Maker:
+  def make(n):
+    adder = Adder(n * 10)
+    return adder.add(n)
+
+m = Maker()
+print m.make(4)
+)"s;
+    ASSERT_EQUAL(Run(temporary, MaxDepth(10)), "44\n"s);
+
+    // Вызов внутри выражения - не хвостовой и растит стек
+    const string not_tail = R"(
+class Counter:
+  def count(n):
+    if n == 0:
+      return 0
+    return self.count(n - 1) + 1
+
+c = Counter()
+print c.count(100)
+)"s;
+    ASSERT_THROWS(Run(not_tail, MaxDepth(10)), RecursionError);
+
+    // Хвостовой вызов метода встроенного объекта выполняется как обычный
+    const string native = R"(
+class Reader:
+  def read(ch):
+    return ch.receive()
+
+ch = Channel()
+ch.send(42)
+r = Reader()
+print r.read(ch)
+)"s;
+    ASSERT_EQUAL(Run(native), "42\n"s);
+
+    // Каждый хвостовой вызов - шаг выполнения
+    ExecutionLimits limits;
+    limits.SetStepLimit(10000);
+    ostringstream out;
+    SimpleContext context(out);
+    RunOptions options;
+    options.limits = &limits;
+    ASSERT_THROWS(RunMythonProgram(countdown, context, options), ExecutionStopped);
+}
+
+}  // namespace
+
+void RunCallStackTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestCallStackFrames);
+    RUN_TEST(tr, runtime::TestRecursionDepthLimit);
+    RUN_TEST(tr, runtime::TestNativeStackGuard);
+    RUN_TEST(tr, runtime::TestReturnStopsMethod);
+    RUN_TEST(tr, runtime::TestTailCalls);
+}
+
+}  // namespace runtime
@@ -0,0 +1,68 @@
+#include "client.h"
+
+#include "server_protocol.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace server {
+
+    Client::Client(const string& socket_path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            throw invalid_argument("Socket path is too long: "s + socket_path);
+        }
+        memcpy(address.sun_path, socket_path.data(), socket_path.size());
+
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) {
+            throw system_error(errno, generic_category(), "socket"s);
+        }
+        if (::connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            const int error = errno;
+            ::close(fd_);
+            throw system_error(error, generic_category(), "Can not connect to "s + socket_path);
+        }
+    }
+
+    Client::~Client() {
+        ::close(fd_);
+    }
+
+    Response Client::Execute(const Request& request, const OutputHandler& output) {
+        if (request.key.empty()) {
+            WriteFrame(fd_, FrameType::Source, request.source);
+        }
+        else {
+            WriteFrame(fd_, FrameType::Key, request.key);
+        }
+        WriteFrame(fd_, FrameType::Input, request.input);
+
+        Frame frame;
+        while (ReadFrame(fd_, frame)) {
+            switch (frame.type) {
+                case FrameType::Output:
+                    if (output) {
+                        output(frame.data);
+                    }
+                    break;
+                case FrameType::Done:
+                    return Response{std::move(frame.data), {}};
+                case FrameType::Error:
+                    return Response{{}, std::move(frame.data)};
+                default:
+                    throw ProtocolError("Unexpected frame in response"s);
+            }
+        }
+        throw ProtocolError("Server closed the connection"s);
+    }
+
+}  // namespace server
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace server {
+
+    // Запрос к серверу интерпретатора
+    struct Request {
+        // Исходный код программы. Не используется, если задан key
+        std::string source;
+        // Ключ программы, ранее выполненной сервером (см. Response::key)
+        std::string key;
+        // Входные данные, доступные программе в переменной input
+        std::string input;
+    };
+
+    // Итог выполнения запроса
+    struct Response {
+        // Ключ программы, по которому её можно выполнить повторно без передачи исходного кода.
+        // Пуст, если сервер не сохранил программу
+        std::string key;
+        // Текст ошибки выполнения, пустой при успехе
+        std::string error;
+    };
+
+    // Принимает очередную часть вывода программы
+    using OutputHandler = std::function<void(std::string_view)>;
+
+    /*
+     * Соединение с сервером интерпретатора через локальный сокет.
+     * Через одно соединение можно выполнить несколько запросов подряд. Соединение, простоявшее без запросов
+     * дольше ServerOptions::idle_timeout, сервер закрывает
+     */
+    class Client {
+    public:
+        // Подключается к серверу. При ошибке выбрасывает std::system_error
+        explicit Client(const std::string& socket_path);
+        ~Client();
+
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        // Выполняет запрос, передавая части вывода программы в output по мере их поступления.
+        // Ошибка выполнения программы возвращается в Response::error, а сбой соединения
+        // выбрасывается как std::system_error или ProtocolError
+        Response Execute(const Request& request, const OutputHandler& output);
+
+    private:
+        int fd_;
+    };
+
+}  // namespace server
@@ -0,0 +1,559 @@
+#include "coroutine.h"
+
+#include "call_stack.h"
+#include "isolate.h"
+#include "task_scheduler.h"
+
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#include <sanitizer/common_interface_defs.h>
+#endif
+#if defined(__SANITIZE_THREAD__)
+#include <sanitizer/tsan_interface.h>
+#endif
+
+// TSan следит за переключениями стеков только через swapcontext
+#if defined(__x86_64__) && defined(__ELF__) && !defined(__SANITIZE_THREAD__)
+#define COROUTINE_ASM_SWITCH 1
+#endif
+
+#ifdef COROUTINE_ASM_SWITCH
+// Сохраняет на текущем стеке регистры, которые по System V AMD64 ABI сохраняет вызываемая функция, и управляющие
+// слова SSE и x87, записывает вершину стека в *from и восстанавливает то же самое со стека to
+extern "C" void mython_switch_stack(void** from, void* to);
+// Первая функция стека сопрограммы: вызывает функцию из r13 с параметром из r12 (см. Coroutine::Coroutine)
+extern "C" void mython_coroutine_trampoline();
+
+asm(R"(
+    .text
+    .p2align 4
+    .globl mython_switch_stack
+    .hidden mython_switch_stack
+    .type mython_switch_stack, @function
+mython_switch_stack:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size mython_switch_stack, .-mython_switch_stack
+
+    .p2align 4
+    .globl mython_coroutine_trampoline
+    .hidden mython_coroutine_trampoline
+    .type mython_coroutine_trampoline, @function
+mython_coroutine_trampoline:
+    .cfi_startproc
+    .cfi_undefined rip
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .cfi_endproc
+    .size mython_coroutine_trampoline, .-mython_coroutine_trampoline
+)");
+#endif
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        thread_local Coroutine* current_coroutine = nullptr;
+        thread_local CoroutineScheduler* current_scheduler = nullptr;
+        thread_local Task::State* current_task = nullptr;
+
+        // Число стеков завершившихся задач, которые планировщик держит для новых задач
+        constexpr size_t MAX_FREE_STACKS = 64;
+        // Пауза, с которой программа проверяет условие ожидания, пока его может выполнить только изолят
+        constexpr auto STALL_PAUSE = chrono::microseconds(50);
+
+        size_t PageSize() {
+            static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return size;
+        }
+
+        // Исключение, которым раскручивается стек прерванной задачи. Не наследует std::exception,
+        // чтобы его не перехватил обработчик ошибок программы
+        struct TaskCancelled {};
+    }  // namespace
+
+    Coroutine::Stack::Stack(size_t size) {
+        const size_t page = PageSize();
+        mapped_ = (size + page - 1) / page * page + page;
+        memory_ = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                       -1, 0);
+        if (memory_ == MAP_FAILED) {
+            memory_ = nullptr;
+            throw system_error(errno, generic_category(), "Can not allocate a coroutine stack"s);
+        }
+        // Стек растёт вниз, поэтому защитная страница - в начале
+        if (mprotect(memory_, page, PROT_NONE) != 0) {
+            const int error = errno;
+            munmap(memory_, mapped_);
+            memory_ = nullptr;
+            throw system_error(error, generic_category(), "Can not protect a coroutine stack"s);
+        }
+    }
+
+    Coroutine::Stack::Stack(Stack&& other) noexcept
+        : memory_(exchange(other.memory_, nullptr))
+        , mapped_(exchange(other.mapped_, 0)) {
+    }
+
+    Coroutine::Stack& Coroutine::Stack::operator=(Stack&& other) noexcept {
+        if (this != &other) {
+            if (memory_ != nullptr) {
+                munmap(memory_, mapped_);
+            }
+            memory_ = exchange(other.memory_, nullptr);
+            mapped_ = exchange(other.mapped_, 0);
+        }
+        return *this;
+    }
+
+    Coroutine::Stack::~Stack() {
+        if (memory_ != nullptr) {
+            munmap(memory_, mapped_);
+        }
+    }
+
+    void* Coroutine::Stack::GetBase() const {
+        return memory_ != nullptr ? static_cast<char*>(memory_) + PageSize() : nullptr;
+    }
+
+    size_t Coroutine::Stack::GetSize() const {
+        return memory_ != nullptr ? mapped_ - PageSize() : 0;
+    }
+
+    Coroutine::Coroutine(Body body, Stack stack)
+        : body_(std::move(body))
+        , stack_(std::move(stack)) {
+#if defined(__SANITIZE_ADDRESS__)
+        // На повторно используемом стеке могут остаться отметки кадров прошлой сопрограммы
+        __asan_unpoison_memory_region(stack_.GetBase(), stack_.GetSize());
+#endif
+#if defined(__SANITIZE_THREAD__)
+        fiber_ = __tsan_create_fiber(0);
+#endif
+#ifdef COROUTINE_ASM_SWITCH
+        // Кадр, который mython_switch_stack снимает со стека при первом Resume: управляющие слова SSE и x87
+        // по умолчанию, r15, r14, r13 (функция), r12 (её параметр), rbx, rbp и адрес возврата в трамплин.
+        // После возврата в трамплин вершина стека выровнена на 16 байт, как требует ABI перед call
+        const uintptr_t top = (reinterpret_cast<uintptr_t>(stack_.GetBase()) + stack_.GetSize()) & ~uintptr_t{15};
+        auto* frame = reinterpret_cast<uint64_t*>(top) - 8;
+        frame[0] = 0x1F80U | (uint64_t{0x037FU} << 32);
+        frame[1] = 0;
+        frame[2] = 0;
+        frame[3] = reinterpret_cast<uint64_t>(&Coroutine::Run);
+        frame[4] = reinterpret_cast<uint64_t>(this);
+        frame[5] = 0;
+        frame[6] = 0;
+        frame[7] = reinterpret_cast<uint64_t>(&mython_coroutine_trampoline);
+        stack_pointer_ = frame;
+#else
+        if (getcontext(&context_) != 0) {
+            throw system_error(errno, generic_category(), "Can not create a coroutine"s);
+        }
+        context_.uc_stack.ss_sp = stack_.GetBase();
+        context_.uc_stack.ss_size = stack_.GetSize();
+        context_.uc_link = nullptr;
+        // makecontext передаёт только параметры int, поэтому указатель делится на две половины
+        const auto address = reinterpret_cast<uintptr_t>(this);
+        makecontext(&context_, reinterpret_cast<void (*)()>(&Coroutine::Entry), 2,
+                    static_cast<unsigned int>(static_cast<uint64_t>(address) >> 32),
+                    static_cast<unsigned int>(address & 0xFFFFFFFFU));
+#endif
+    }
+
+    Coroutine::~Coroutine() {
+#if defined(__SANITIZE_THREAD__)
+        __tsan_destroy_fiber(fiber_);
+#endif
+    }
+
+    void Coroutine::Entry(unsigned int high, unsigned int low) {
+        Run(reinterpret_cast<Coroutine*>(static_cast<uintptr_t>((static_cast<uint64_t>(high) << 32) | low)));
+    }
+
+    void Coroutine::Run(Coroutine* self) noexcept {
+#if defined(__SANITIZE_ADDRESS__)
+        __sanitizer_finish_switch_fiber(nullptr, &self->caller_bottom_, &self->caller_size_);
+#endif
+        try {
+            self->body_();
+        } catch (...) {
+            // Над телом нет кадров, в которые можно раскрутить стек, а молча потерять ошибку нельзя
+            terminate();
+        }
+        self->finished_ = true;
+#if defined(__SANITIZE_ADDRESS__)
+        // nullptr вместо сохранения: стек сопрограммы больше не понадобится
+        __sanitizer_start_switch_fiber(nullptr, self->caller_bottom_, self->caller_size_);
+#endif
+#if defined(__SANITIZE_THREAD__)
+        __tsan_switch_to_fiber(self->caller_fiber_, 0);
+#endif
+        self->SwitchOut();
+        // Завершившаяся сопрограмма больше не продолжается (см. Resume)
+        terminate();
+    }
+
+    void Coroutine::SwitchIn() {
+#ifdef COROUTINE_ASM_SWITCH
+        mython_switch_stack(&caller_stack_pointer_, stack_pointer_);
+#else
+        swapcontext(&caller_, &context_);
+#endif
+    }
+
+    void Coroutine::SwitchOut() {
+#ifdef COROUTINE_ASM_SWITCH
+        mython_switch_stack(&stack_pointer_, caller_stack_pointer_);
+#else
+        swapcontext(&context_, &caller_);
+#endif
+    }
+
+    void Coroutine::Resume() {
+        if (finished_) {
+            return;
+        }
+        previous_ = current_coroutine;
+        current_coroutine = this;
+#if defined(__SANITIZE_ADDRESS__)
+        void* caller_fake_stack = nullptr;
+        __sanitizer_start_switch_fiber(&caller_fake_stack, stack_.GetBase(), stack_.GetSize());
+#endif
+#if defined(__SANITIZE_THREAD__)
+        caller_fiber_ = __tsan_get_current_fiber();
+        __tsan_switch_to_fiber(fiber_, 0);
+#endif
+        SwitchIn();
+#if defined(__SANITIZE_ADDRESS__)
+        __sanitizer_finish_switch_fiber(caller_fake_stack, nullptr, nullptr);
+#endif
+        current_coroutine = previous_;
+    }
+
+    void Coroutine::Suspend() {
+        Coroutine* self = current_coroutine;
+        if (self == nullptr) {
+            throw logic_error("Coroutine::Suspend is called outside of a coroutine"s);
+        }
+#if defined(__SANITIZE_ADDRESS__)
+        __sanitizer_start_switch_fiber(&self->fake_stack_, self->caller_bottom_, self->caller_size_);
+#endif
+#if defined(__SANITIZE_THREAD__)
+        __tsan_switch_to_fiber(self->caller_fiber_, 0);
+#endif
+        self->SwitchOut();
+#if defined(__SANITIZE_ADDRESS__)
+        __sanitizer_finish_switch_fiber(self->fake_stack_, &self->caller_bottom_, &self->caller_size_);
+#endif
+    }
+
+    Coroutine* Coroutine::Current() {
+        return current_coroutine;
+    }
+
+    bool Coroutine::IsFinished() const {
+        return finished_;
+    }
+
+    Coroutine::Stack Coroutine::ReleaseStack() {
+        if (!finished_) {
+            throw logic_error("Stack of a running coroutine can not be released"s);
+        }
+        return std::move(stack_);
+    }
+
+    struct Task::State {
+        // Вызов, который выполняет задача. Освобождается после выполнения
+        ObjectHolder object;
+        std::string method;
+        std::vector<ObjectHolder> args;
+        Context* context = nullptr;
+        // Создаются при первом переключении в задачу
+        std::unique_ptr<Coroutine> coroutine;
+        std::unique_ptr<CallStack> calls;
+        // Наибольшая глубина вызовов задачи - та же, что у запустившего её кода
+        size_t max_depth = CallStack::DEFAULT_MAX_DEPTH;
+
+        ObjectHolder result;
+        bool done = false;
+        // Ошибка задачи; выбрасывается из join, а если join не вызывался - из CoroutineScheduler::Finish
+        std::exception_ptr error;
+        bool joined = false;
+        // Задача проверила условие ожидания и снова ждёт
+        bool waiting = false;
+        // Планировщик разрушается, задача должна раскрутить стек
+        bool cancelled = false;
+    };
+
+    namespace {
+        // Приостанавливает текущую задачу. Если задачу прервали, раскручивает её стек
+        void SuspendTask(Task::State& task) {
+            Coroutine::Suspend();
+            if (task.cancelled) {
+                throw TaskCancelled{};
+            }
+        }
+
+        ObjectHolder TakeResult(Task::State& task) {
+            task.joined = true;
+            if (task.error) {
+                rethrow_exception(task.error);
+            }
+            return task.result;
+        }
+    }  // namespace
+
+    Task::Task(shared_ptr<State> state)
+        : state_(std::move(state)) {
+    }
+
+    ObjectHolder Task::Call(const string& method, const vector<ObjectHolder>& args, [[maybe_unused]] Context& context) {
+        if (!args.empty()) {
+            throw runtime_error("Task."s + method + " takes no arguments"s);
+        }
+        if (method == "join"s) {
+            return Join();
+        }
+        if (method == "done"s) {
+            return ObjectHolder::Own(Bool(state_->done));
+        }
+        throw runtime_error("Task has no method "s + method);
+    }
+
+    void Task::Print(ostream& os, [[maybe_unused]] Context& context) {
+        os << "Task"sv;
+    }
+
+    ObjectHolder Task::Join() {
+        if (current_task == state_.get()) {
+            throw runtime_error("Task can not join itself"s);
+        }
+        const bool waited = CoroutineScheduler::WaitFor([this] {
+            return state_->done;
+        });
+        if (!waited && !state_->done) {
+            // Задача принадлежит планировщику, который уже не выполняет задачи
+            throw runtime_error("Task can not be joined outside of its program"s);
+        }
+        return TakeResult(*state_);
+    }
+
+    CoroutineScheduler::CoroutineScheduler(size_t stack_size)
+        : stack_size_(stack_size) {
+    }
+
+    CoroutineScheduler::~CoroutineScheduler() {
+        for (const auto& task : tasks_) {
+            if (task->coroutine && !task->coroutine->IsFinished()) {
+                task->cancelled = true;
+                Resume(*task);
+            }
+            task->object = {};
+            task->args.clear();
+            task->done = true;
+        }
+    }
+
+    CoroutineScheduler* CoroutineScheduler::Current() {
+        return current_scheduler;
+    }
+
+    CoroutineScheduler::Scope::Scope(CoroutineScheduler* scheduler)
+        : previous_(current_scheduler) {
+        current_scheduler = scheduler;
+    }
+
+    CoroutineScheduler::Scope::~Scope() {
+        current_scheduler = previous_;
+    }
+
+    ObjectHolder CoroutineScheduler::Spawn(const ObjectHolder& object, const string& method, vector<ObjectHolder> args,
+                                           Context& context) {
+        const auto* instance = object.TryAs<ClassInstance>();
+        if (instance == nullptr || !instance->HasMethod(method, args.size())) {
+            throw runtime_error("task: object has no method "s + method + " with "s + to_string(args.size())
+                                + " parameter(s)"s);
+        }
+        auto state = make_shared<Task::State>();
+        state->object = object;
+        state->method = method;
+        state->args = std::move(args);
+        state->context = &context;
+        state->max_depth = CallStack::Current().GetMaxDepth();
+        tasks_.push_back(state);
+        ++stats_.tasks;
+        return ObjectHolder::Make<Task>(std::move(state));
+    }
+
+    void CoroutineScheduler::Yield() {
+        if (current_task != nullptr) {
+            SuspendTask(*current_task);
+        }
+        else if (current_scheduler != nullptr) {
+            current_scheduler->RunRound();
+        }
+    }
+
+    bool CoroutineScheduler::WaitFor(const function<bool()>& ready) {
+        if (current_task != nullptr) {
+            Task::State& task = *current_task;
+            while (!ready()) {
+                task.waiting = true;
+                SuspendTask(task);
+            }
+            task.waiting = false;
+            return true;
+        }
+        CoroutineScheduler* scheduler = current_scheduler;
+        if (scheduler == nullptr) {
+            return false;
+        }
+        while (!ready()) {
+            if (scheduler->tasks_.empty()) {
+                return false;
+            }
+            if (!scheduler->RunRound() && !ready()) {
+                scheduler->OnStalled(false);
+            }
+        }
+        return true;
+    }
+
+    void CoroutineScheduler::Finish() {
+        while (!tasks_.empty()) {
+            if (!RunRound()) {
+                OnStalled(true);
+            }
+        }
+        // Ошибка задачи, результат которой никто не ждал, не должна потеряться
+        for (auto& task : finished_) {
+            if (task->error && !task->joined) {
+                auto error = task->error;
+                finished_.clear();
+                rethrow_exception(error);
+            }
+        }
+        finished_.clear();
+    }
+
+    CoroutineStats CoroutineScheduler::GetStats() const {
+        return stats_;
+    }
+
+    bool CoroutineScheduler::RunRound() {
+        bool progress = false;
+        // Задачи, запущенные во время круга, выполняются уже в следующем
+        for (size_t count = tasks_.size(); count > 0 && !tasks_.empty(); --count) {
+            shared_ptr<Task::State> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            Resume(*task);
+            if (!task->waiting) {
+                progress = true;
+            }
+            if (task->done) {
+                if (task->error && !task->joined) {
+                    finished_.push_back(std::move(task));
+                }
+            }
+            else {
+                tasks_.push_back(std::move(task));
+            }
+        }
+        return progress;
+    }
+
+    void CoroutineScheduler::Resume(Task::State& task) {
+        if (!task.coroutine) {
+            Coroutine::Stack stack = TakeStack();
+            task.calls = make_unique<CallStack>(stack.GetBase(), stack.GetSize(), task.max_depth);
+            task.coroutine = make_unique<Coroutine>(
+                [&task] {
+                    try {
+                        ObjectHolder object = task.object;
+                        task.result = object.TryAs<ClassInstance>()->Call(task.method, task.args, *task.context);
+                    } catch (const TaskCancelled&) {
+                    } catch (...) {
+                        task.error = current_exception();
+                    }
+                },
+                std::move(stack));
+        }
+        task.waiting = false;
+        Task::State* const previous = exchange(current_task, &task);
+        ++stats_.switches;
+        {
+            CallStack::Scope calls_scope(*task.calls);
+            task.coroutine->Resume();
+        }
+        current_task = previous;
+        if (task.coroutine->IsFinished()) {
+            task.done = true;
+            task.object = {};
+            task.args.clear();
+            if (free_stacks_.size() < MAX_FREE_STACKS) {
+                free_stacks_.push_back(task.coroutine->ReleaseStack());
+            }
+            task.coroutine.reset();
+            task.calls.reset();
+        }
+    }
+
+    void CoroutineScheduler::OnStalled(bool finishing) {
+        IsolateGroup* group = IsolateGroup::Current();
+        if (group != nullptr && group->HasRunningIsolates()) {
+            // Данные в каналы может отправить только изолят. Поток уступает ядро, а пул изолятов
+            // может добавить поток вместо ждущего
+            TaskScheduler::BlockingScope blocking;
+            this_thread::sleep_for(STALL_PAUSE);
+            return;
+        }
+        if (finishing && group != nullptr && !channels_closed_) {
+            // Программа закончилась, и больше в каналы никто не отправит: ждущие задачи получат None
+            channels_closed_ = true;
+            group->CloseChannels();
+            return;
+        }
+        throw runtime_error("Deadlock: every task is waiting"s);
+    }
+
+    Coroutine::Stack CoroutineScheduler::TakeStack() {
+        if (!free_stacks_.empty()) {
+            Coroutine::Stack stack = std::move(free_stacks_.back());
+            free_stacks_.pop_back();
+            return stack;
+        }
+        ++stats_.stacks;
+        return Coroutine::Stack(stack_size_);
+    }
+
+}  // namespace runtime
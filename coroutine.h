@@ -0,0 +1,199 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ucontext.h>
+
+namespace runtime {
+
+    /*
+     * Сопрограмма: функция со своим стеком, которую можно приостановить в любом месте и продолжить позже
+     * в том же потоке. Вызовы методов Mython выполняются рекурсией C++, поэтому приостановить задачу
+     * посреди цепочки вызовов можно, только сохранив весь её стек: у каждой сопрограммы он свой.
+     * На x86-64 стеки переключает короткая ассемблерная функция, которая сохраняет только регистры,
+     * сохраняемые вызываемой функцией: swapcontext на каждом переключении делает системный вызов
+     * для маски сигналов и в десятки раз медленнее. На других платформах и под TSan - swapcontext.
+     *
+     * Исключение, вышедшее из тела сопрограммы, завершает процесс через std::terminate.
+     * Разрушать можно сопрограмму, которая ещё не запускалась или уже завершилась
+     */
+    class Coroutine {
+    public:
+        // Размер стека по умолчанию. Память выделяется системой по мере использования стека
+        static constexpr size_t DEFAULT_STACK_SIZE = 1024 * 1024;
+
+        using Body = std::function<void()>;
+
+        // Стек сопрограммы с защитной страницей: переполнение стека завершает процесс, а не портит память
+        class Stack {
+        public:
+            explicit Stack(size_t size = DEFAULT_STACK_SIZE);
+            Stack(Stack&& other) noexcept;
+            Stack& operator=(Stack&& other) noexcept;
+            ~Stack();
+
+            [[nodiscard]] void* GetBase() const;
+            [[nodiscard]] size_t GetSize() const;
+
+        private:
+            void* memory_ = nullptr;
+            size_t mapped_ = 0;
+        };
+
+        Coroutine(Body body, Stack stack);
+        ~Coroutine();
+
+        Coroutine(const Coroutine&) = delete;
+        Coroutine& operator=(const Coroutine&) = delete;
+
+        // Выполняет сопрограмму до вызова Suspend внутри неё или до окончания тела
+        void Resume();
+        // Приостанавливает текущую сопрограмму и возвращает управление в вызвавший её Resume
+        static void Suspend();
+        // Возвращает сопрограмму, выполняющуюся в текущем потоке, либо nullptr
+        static Coroutine* Current();
+
+        [[nodiscard]] bool IsFinished() const;
+        // Забирает стек завершившейся сопрограммы для повторного использования
+        Stack ReleaseStack();
+
+    private:
+        static void Entry(unsigned int high, unsigned int low);
+        // Выполняет тело сопрограммы self и возвращает управление в Resume
+        [[noreturn]] static void Run(Coroutine* self) noexcept;
+        // Переключается в сопрограмму и обратно
+        void SwitchIn();
+        void SwitchOut();
+
+        Body body_;
+        Stack stack_;
+        // Состояния сопрограммы и вызвавшего её Resume для swapcontext
+        ucontext_t context_{};
+        ucontext_t caller_{};
+        // Вершины стеков сопрограммы и вызвавшего её Resume для ассемблерного переключения
+        void* stack_pointer_ = nullptr;
+        void* caller_stack_pointer_ = nullptr;
+        Coroutine* previous_ = nullptr;
+        bool finished_ = false;
+        // Данные для санитайзеров, которые должны знать о переключении стеков
+        void* fake_stack_ = nullptr;
+        const void* caller_bottom_ = nullptr;
+        size_t caller_size_ = 0;
+        void* fiber_ = nullptr;
+        void* caller_fiber_ = nullptr;
+    };
+
+    /*
+     * Задача - вызов метода экземпляра класса, который выполняется по очереди с программой и другими задачами
+     * в том же потоке, запускается в программе вызовом task(object.method, args...). В отличие от изолята
+     * (см. isolate.h), задача работает с теми же объектами, что и программа, без копирования.
+     * Задачи переключаются только в точках ожидания: в команде yield, в join, при получении из пустого канала.
+     *
+     * Методы в программе:
+     *   join() - дожидается завершения задачи, выполняя другие задачи, и возвращает результат метода.
+     *            Ошибка задачи выбрасывается из join;
+     *   done() - возвращает True, если задача завершилась
+     */
+    class Task : public NativeObject {
+    public:
+        struct State;
+
+        explicit Task(std::shared_ptr<State> state);
+
+        ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& args, Context& context) override;
+        void Print(std::ostream& os, Context& context) override;
+
+        ObjectHolder Join();
+
+    private:
+        std::shared_ptr<State> state_;
+    };
+
+    // Показатели планировщика задач
+    struct CoroutineStats {
+        // Число запущенных задач
+        uint64_t tasks = 0;
+        // Число переключений в задачи
+        uint64_t switches = 0;
+        // Число стеков, выделенных у системы; остальные задачи получили стеки завершившихся
+        uint64_t stacks = 0;
+    };
+
+    /*
+     * Кооперативный планировщик задач одного потока. Задачи стоят в общей очереди и выполняются по кругу:
+     * каждая - до своей следующей точки переключения. Круг выполняет поток программы, когда сам ждёт
+     * (yield, join, получение из канала), а по окончании программы Finish доводит оставшиеся задачи до конца.
+     *
+     * Если все задачи ждут и ожидание не может закончиться (нет работающих изолятов, которые могли бы
+     * что-то отправить в каналы), по окончании программы каналы закрываются (см. IsolateGroup), а при
+     * ожидании в программе выбрасывается runtime_error о взаимной блокировке
+     */
+    class CoroutineScheduler {
+    public:
+        explicit CoroutineScheduler(size_t stack_size = Coroutine::DEFAULT_STACK_SIZE);
+        // Прерывает незавершённые задачи: их стеки раскручиваются, как при исключении
+        ~CoroutineScheduler();
+
+        CoroutineScheduler(const CoroutineScheduler&) = delete;
+        CoroutineScheduler& operator=(const CoroutineScheduler&) = delete;
+
+        // Возвращает планировщик, подключённый к текущему потоку, либо nullptr
+        static CoroutineScheduler* Current();
+
+        // Подключает планировщик к текущему потоку на время своей жизни
+        class Scope {
+        public:
+            explicit Scope(CoroutineScheduler* scheduler);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            CoroutineScheduler* previous_;
+        };
+
+        // Ставит в очередь задачу, вызывающую object.method(args) с выводом в context.
+        // Если у object нет метода method с таким числом параметров, выбрасывает runtime_error
+        ObjectHolder Spawn(const ObjectHolder& object, const std::string& method, std::vector<ObjectHolder> args,
+                           Context& context);
+
+        // Точка переключения: задача уступает очередь остальным, а программа выполняет один круг задач
+        static void Yield();
+
+        // Ждёт, пока ready() не вернёт true: задача уступает очередь, а программа выполняет задачи.
+        // Возвращает false, если ждать нечего и поток должен ждать сам (нет задач, которые можно выполнить)
+        static bool WaitFor(const std::function<bool()>& ready);
+
+        // Выполняет оставшиеся задачи до конца. Выбрасывает ошибку задачи, для которой не вызывался join
+        void Finish();
+
+        [[nodiscard]] CoroutineStats GetStats() const;
+
+    private:
+        // Выполняет каждую задачу очереди до её следующей точки переключения.
+        // Возвращает true, если хотя бы одна задача не просто проверила условие ожидания
+        bool RunRound();
+        void Resume(Task::State& task);
+        // Вызывается, когда круг задач не продвинулся. При взаимной блокировке выбрасывает runtime_error
+        void OnStalled(bool finishing);
+        Coroutine::Stack TakeStack();
+
+        size_t stack_size_;
+        std::deque<std::shared_ptr<Task::State>> tasks_;
+        // Завершившиеся с ошибкой задачи, для которых ещё не вызывался join
+        std::vector<std::shared_ptr<Task::State>> finished_;
+        std::vector<Coroutine::Stack> free_stacks_;
+        bool channels_closed_ = false;
+        CoroutineStats stats_;
+    };
+
+}  // namespace runtime
@@ -0,0 +1,107 @@
+#include "bench_runner.h"
+#include "coroutine.h"
+#include "interpreter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+constexpr int SWITCHES = 1'000'000;
+
+void RunProgram(const string& program) {
+    ostringstream out;
+    SimpleContext context(out);
+    RunMythonProgram(program, context, RunOptions{});
+    DoNotOptimize(out);
+}
+
+// Стоимость пары переключений между стеками: в сопрограмму и обратно
+void BenchCoroutineSwitch(BenchRunner& br) {
+    const string name = "BenchCoroutineSwitch"s;
+    double best = 0;
+    br.RunBench(
+        [&] {
+            bool running = true;
+            int counter = 0;
+            Coroutine coroutine(
+                [&] {
+                    while (running) {
+                        ++counter;
+                        Coroutine::Suspend();
+                    }
+                },
+                Coroutine::Stack());
+            const auto start = chrono::steady_clock::now();
+            for (int i = 0; i < SWITCHES; ++i) {
+                coroutine.Resume();
+            }
+            const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+            running = false;
+            coroutine.Resume();
+            DoNotOptimize(counter);
+            const double per_switch = elapsed.count() / SWITCHES;
+            best = best == 0 ? per_switch : min(best, per_switch);
+        },
+        name);
+    br.Report(name, "round trip"s, best, "ns"s);
+}
+
+// Две задачи по 50000 раз уступают друг другу очередь: переключение вместе с работой планировщика и интерпретатора
+void BenchTaskPingPong() {
+    RunProgram(R"(
+class Player:
+  def play(n):
+    if n > 0:
+      yield
+      self.play(n - 1)
+
+  def rally(rounds, n):
+    if rounds > 0:
+      self.play(n)
+      self.rally(rounds - 1, n)
+
+p = Player()
+a = task(p.rally, 100, 500)
+b = task(p.rally, 100, 500)
+a.join()
+b.join()
+)"s);
+}
+
+// 10000 задач, каждая один раз уступает очередь: создание задач и повторное использование стеков
+void BenchManyTasks() {
+    string program = R"(
+class Worker:
+  def work(n):
+    yield
+    return n
+
+  def start(n):
+    if n > 0:
+      task(self.work, n)
+      self.start(n - 1)
+
+w = Worker()
+)"s;
+    for (int i = 0; i < 100; ++i) {
+        program += "w.start(100)\nyield\n"s;
+    }
+    RunProgram(program);
+}
+
+}  // namespace
+
+void RunCoroutineBenchmarks(BenchRunner& br) {
+    BenchCoroutineSwitch(br);
+    RUN_BENCH(br, BenchTaskPingPong);
+    RUN_BENCH(br, BenchManyTasks);
+}
+
+}  // namespace runtime
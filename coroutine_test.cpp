@@ -0,0 +1,328 @@
+#include "coroutine.h"
+#include "interpreter.h"
+#include "parse.h"
+#include "test_program.h"
+#include "test_runner.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestCoroutineSwitches() {
+    vector<int> trace;
+    Coroutine coroutine(
+        [&] {
+            trace.push_back(1);
+            Coroutine::Suspend();
+            trace.push_back(3);
+        },
+        Coroutine::Stack());
+    ASSERT(Coroutine::Current() == nullptr);
+    coroutine.Resume();
+    trace.push_back(2);
+    ASSERT(!coroutine.IsFinished());
+    coroutine.Resume();
+    ASSERT(coroutine.IsFinished());
+    ASSERT_EQUAL(trace, (vector<int>{1, 2, 3}));
+
+    // Стек завершившейся сопрограммы подходит для новой
+    Coroutine::Stack stack = coroutine.ReleaseStack();
+    ASSERT(stack.GetBase() != nullptr);
+    bool ran = false;
+    Coroutine next(
+        [&] {
+            ran = true;
+        },
+        std::move(stack));
+    next.Resume();
+    ASSERT(ran);
+    ASSERT(next.IsFinished());
+}
+
+void TestTasksInterleave() {
+    const string program = R"(
+class Counter:
+  def count(name, n):
+    if n > 0:
+      print name, n
+      yield
+      self.count(name, n - 1)
+    return name
+
+c = Counter()
+a = task(c.count, 'a', 3)
+b = task(c.count, 'b', 2)
+print 'main'
+print a.join(), b.join(), a.done()
+)"s;
+    // Задачи выполняются, только когда программа ждёт, и переключаются в yield
+    ASSERT_EQUAL(Run(program), "main\na 3\nb 2\na 2\nb 1\na 1\na b True\n"s);
+}
+
+void TestTasksShareObjects() {
+    const string program = R"(
+class Account:
+  def __init__():
+    self.total = 0
+
+  def add(amount, times):
+    if times > 0:
+      self.total = self.total + amount
+      yield
+      self.add(amount, times - 1)
+
+acc = Account()
+first = task(acc.add, 1, 100)
+second = task(acc.add, 10, 10)
+print acc.total
+first.join()
+second.join()
+print acc.total
+)"s;
+    // Задачи меняют те же объекты, что и программа
+    ASSERT_EQUAL(Run(program), "0\n200\n"s);
+}
+
+void TestChannelsConnectTasks() {
+    const string program = R"(
+class Producer:
+  def produce(ch, n):
+    if n > 0:
+      ch.send(n)
+      self.produce(ch, n - 1)
+
+class Consumer:
+  def consume(ch, n, total):
+    if n > 0:
+      return self.consume(ch, n - 1, total + ch.receive())
+    return total
+
+ch = Channel()
+p = Producer()
+c = Consumer()
+consumer = task(c.consume, ch, 100, 0)
+task(p.produce, ch, 100)
+print consumer.join()
+)"s;
+    ASSERT_EQUAL(Run(program), "5050\n"s);
+
+    // Программа тоже может ждать канал, пока задачи работают
+    const string main_receives = R"(
+class Pinger:
+  def ping(ch):
+    yield
+    ch.send('pong')
+
+ch = Channel()
+p = Pinger()
+task(p.ping, ch)
+print ch.receive()
+)"s;
+    ASSERT_EQUAL(Run(main_receives), "pong\n"s);
+}
+
+void TestTaskErrors() {
+    const string failing = R"(
+class Divider:
+  def divide(n):
+    yield
+    return 1 / n
+
+d = Divider()
+t = task(d.divide, 0)
+t.join()
+)"s;
+    try {
+        Run(failing);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("Div::Execute"s) != string::npos);
+    }
+
+    // Ошибка задачи, которую никто не ждал, завершает программу с ошибкой
+    const string unjoined = R"(
+class Divider:
+  def divide(n):
+    return 1 / n
+
+d = Divider()
+task(d.divide, 0)
+print 'main'
+)"s;
+    try {
+        Run(unjoined);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("Div::Execute"s) != string::npos);
+    }
+
+    const string deadlock = R"(
+class Waiter:
+  def wait(ch):
+    return ch.receive()
+
+ch = Channel()
+w = Waiter()
+t = task(w.wait, ch)
+t.join()
+)"s;
+    try {
+        Run(deadlock);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("Deadlock"s) != string::npos);
+    }
+
+    const string missing = R"(
+class Idle:
+  def run():
+    return 0
+
+i = Idle()
+task(i.missing)
+)"s;
+    try {
+        Run(missing);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("no method missing"s) != string::npos);
+    }
+
+    try {
+        Run("task(1)\n"s);
+        ASSERT(false);
+    } catch (const ParseError&) {
+    }
+}
+
+void TestProgramEndClosesChannelsForTasks() {
+    const string program = R"(
+class Waiter:
+  def wait(ch):
+    print 'got', ch.receive()
+
+ch = Channel()
+w = Waiter()
+task(w.wait, ch)
+print 'main done'
+)"s;
+    ASSERT_EQUAL(Run(program), "main done\ngot None\n"s);
+}
+
+void TestFailedProgramCancelsTasks() {
+    const string program = R"(
+class Sleeper:
+  def __init__():
+    self.steps = 0
+
+  def run(n):
+    if n > 0:
+      self.steps = self.steps + 1
+      yield
+      self.run(n - 1)
+
+s = Sleeper()
+t = task(s.run, 100)
+yield
+yield
+x = 1 / 0
+)"s;
+    ostringstream out;
+    SimpleContext context(out);
+    try {
+        RunMythonProgram(program, context, RunOptions{});
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("Div::Execute"s) != string::npos);
+    }
+}
+
+void TestManyTasks() {
+    string program = R"(
+class Worker:
+  def work(n):
+    yield
+    return n * 2
+
+w = Worker()
+total = 0
+)"s;
+    for (int i = 0; i < 1000; ++i) {
+        program += "t"s + to_string(i) + " = task(w.work, "s + to_string(i) + ")\n"s;
+    }
+    for (int i = 0; i < 1000; ++i) {
+        program += "total = total + t"s + to_string(i) + ".join()\n"s;
+    }
+    program += "print total\n"s;
+    ASSERT_EQUAL(Run(program), "999000\n"s);
+}
+
+// Метод, который уступает очередь заданное число раз
+class YieldingBody : public Executable {
+public:
+    explicit YieldingBody(int times)
+        : times_(times) {
+    }
+
+    ObjectHolder Execute([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) override {
+        for (int i = 0; i < times_; ++i) {
+            CoroutineScheduler::Yield();
+        }
+        return ObjectHolder::Own(Number(times_));
+    }
+
+private:
+    int times_;
+};
+
+void TestSchedulerReusesStacks() {
+    vector<Method> methods;
+    methods.push_back(Method{"run"s, {}, make_unique<YieldingBody>(3)});
+    Class cls("Runner"s, std::move(methods), nullptr);
+    ObjectHolder runner = ObjectHolder::Make<ClassInstance>(cls);
+    ostringstream out;
+    SimpleContext context(out);
+
+    CoroutineScheduler scheduler;
+    CoroutineScheduler::Scope scope(&scheduler);
+    for (int round = 0; round < 3; ++round) {
+        vector<ObjectHolder> tasks;
+        for (int i = 0; i < 10; ++i) {
+            tasks.push_back(scheduler.Spawn(runner, "run"s, {}, context));
+        }
+        for (const ObjectHolder& task : tasks) {
+            ASSERT_EQUAL(task.TryAs<Task>()->Join().TryAs<Number>()->GetValue(), 3);
+        }
+    }
+    scheduler.Finish();
+    const CoroutineStats stats = scheduler.GetStats();
+    ASSERT_EQUAL(stats.tasks, 30U);
+    // Каждая задача переключалась при старте и после каждого из трёх yield
+    ASSERT_EQUAL(stats.switches, 120U);
+    // Задачи второго и третьего круга получили стеки задач первого
+    ASSERT_EQUAL(stats.stacks, 10U);
+    ASSERT_THROWS(scheduler.Spawn(runner, "missing"s, {}, context), runtime_error);
+}
+
+}  // namespace
+
+void RunCoroutineTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestCoroutineSwitches);
+    RUN_TEST(tr, runtime::TestTasksInterleave);
+    RUN_TEST(tr, runtime::TestTasksShareObjects);
+    RUN_TEST(tr, runtime::TestChannelsConnectTasks);
+    RUN_TEST(tr, runtime::TestTaskErrors);
+    RUN_TEST(tr, runtime::TestProgramEndClosesChannelsForTasks);
+    RUN_TEST(tr, runtime::TestFailedProgramCancelsTasks);
+    RUN_TEST(tr, runtime::TestManyTasks);
+    RUN_TEST(tr, runtime::TestSchedulerReusesStacks);
+}
+
+}  // namespace runtime
@@ -0,0 +1,252 @@
+#include "dict.h"
+
+#include "list.h"
+
+#include <algorithm>
+#include <functional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        const string HASH_METHOD = "__hash__"s;
+
+        // Наименьшее число слотов непустой таблицы
+        constexpr size_t MIN_CAPACITY = 8;
+
+        // Словари, которые выводятся в текущем потоке, от внешнего к вложенному
+        thread_local vector<const Dict*> printing;
+
+        // Перемешивает биты хеша (финализатор MurmurHash3): номер слота берётся из младших битов,
+        // и без перемешивания ключи, кратные степени двойки, попадали бы в один слот
+        uint32_t Mix(uint32_t hash) {
+            hash ^= hash >> 16;
+            hash *= 0x85ebca6bU;
+            hash ^= hash >> 13;
+            hash *= 0xc2b2ae35U;
+            hash ^= hash >> 16;
+            return hash;
+        }
+
+        uint32_t Fold(size_t hash) {
+            return static_cast<uint32_t>(static_cast<uint64_t>(hash) ^ (static_cast<uint64_t>(hash) >> 32));
+        }
+
+        // Ключ, который равен только самому себе и хешируется по адресу
+        bool HasIdentityHash(const ObjectHolder& key) {
+            if (const auto* instance = key.TryAs<ClassInstance>()) {
+                return !instance->HasMethod(HASH_METHOD, 0);
+            }
+            return key.TryAs<Class>() != nullptr || key.TryAs<NativeObject>() != nullptr;
+        }
+
+        uint32_t IdentityHash(const ObjectHolder& key) {
+            return Mix(Fold(reinterpret_cast<uintptr_t>(key.Get())));
+        }
+
+        bool KeysEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+            if (lhs.Get() == rhs.Get()) {
+                return true;
+            }
+            if (const auto* number = lhs.TryAs<Number>()) {
+                return rhs.TryAs<Number>() != nullptr && number->GetValue() == rhs.TryAs<Number>()->GetValue();
+            }
+            if (const auto* str = lhs.TryAs<String>()) {
+                return rhs.TryAs<String>() != nullptr && str->GetValue() == rhs.TryAs<String>()->GetValue();
+            }
+            if (const auto* boolean = lhs.TryAs<Bool>()) {
+                return rhs.TryAs<Bool>() != nullptr && boolean->GetValue() == rhs.TryAs<Bool>()->GetValue();
+            }
+            if (lhs.TryAs<ClassInstance>() != nullptr && rhs.TryAs<ClassInstance>() != nullptr
+                && !HasIdentityHash(lhs)) {
+                // __eq__ может изменить словарь, поэтому ключ удерживается на время вызова
+                const ObjectHolder held = lhs;
+                return Equal(held, rhs, context);
+            }
+            return false;
+        }
+
+        void PrintValue(const ObjectHolder& value, ostream& os, Context& context) {
+            if (value) {
+                value->Print(os, context);
+            }
+            else {
+                os << "None"sv;
+            }
+        }
+    }  // namespace
+
+    Dict::Dict()
+        : entries_(PoolAllocator<Entry>(MemoryKind::Dict))
+        , slots_(PoolAllocator<Slot>(MemoryKind::Dict)) {
+    }
+
+    ObjectHolder Dict::Call(const string& method, const vector<ObjectHolder>& args, Context& context) {
+        if (method == "get"sv) {
+            if (args.empty() || args.size() > 2) {
+                throw runtime_error("Dict.get takes 1 or 2 argument(s), "s + to_string(args.size()) + " given"s);
+            }
+            if (const ObjectHolder* value = Find(args.front(), context)) {
+                return *value;
+            }
+            return args.size() == 2 ? args.back() : ObjectHolder::None();
+        }
+        if (method == "keys"sv || method == "values"sv) {
+            if (!args.empty()) {
+                throw runtime_error("Dict."s + method + " takes 0 argument(s), "s + to_string(args.size()) + " given"s);
+            }
+            vector<ObjectHolder> items;
+            items.reserve(entries_.size());
+            for (const Entry& entry : entries_) {
+                items.push_back(method == "keys"sv ? entry.key : entry.value);
+            }
+            return ObjectHolder::Make<List>(std::move(items));
+        }
+        throw runtime_error("Dict has no method "s + method);
+    }
+
+    void Dict::Print(ostream& os, Context& context) {
+        if (find(printing.begin(), printing.end(), this) != printing.end()) {
+            os << "{...}"sv;
+            return;
+        }
+        printing.push_back(this);
+        try {
+            os << '{';
+            for (size_t i = 0; i < entries_.size(); ++i) {
+                if (i > 0) {
+                    os << ", "sv;
+                }
+                PrintValue(entries_[i].key, os, context);
+                os << ": "sv;
+                PrintValue(entries_[i].value, os, context);
+            }
+            os << '}';
+        } catch (...) {
+            printing.pop_back();
+            throw;
+        }
+        printing.pop_back();
+    }
+
+    const ObjectHolder* Dict::Find(const ObjectHolder& key, Context& context) const {
+        const size_t index = FindEntry(key, Hash(key, context), context);
+        return index == NOT_FOUND ? nullptr : &entries_[index].value;
+    }
+
+    const ObjectHolder& Dict::At(const ObjectHolder& key, Context& context) const {
+        if (const ObjectHolder* value = Find(key, context)) {
+            return *value;
+        }
+        ostringstream message;
+        message << "Key "sv;
+        PrintValue(key, message, context);
+        message << " not found in dict"sv;
+        throw runtime_error(message.str());
+    }
+
+    void Dict::Set(ObjectHolder key, ObjectHolder value, Context& context) {
+        const uint32_t hash = Hash(key, context);
+        if (const size_t index = FindEntry(key, hash, context); index != NOT_FOUND) {
+            entries_[index].value = std::move(value);
+            return;
+        }
+        Insert(std::move(key), std::move(value), hash);
+    }
+
+    void Dict::Restore(ObjectHolder key, ObjectHolder value, uint32_t hash) {
+        if (HasIdentityHash(key)) {
+            hash = IdentityHash(key);
+        }
+        Insert(std::move(key), std::move(value), hash);
+    }
+
+    uint32_t Dict::Hash(const ObjectHolder& key, Context& context) {
+        if (!key) {
+            return Mix(0);
+        }
+        if (const auto* number = key.TryAs<Number>()) {
+            return Mix(static_cast<uint32_t>(number->GetValue()));
+        }
+        if (const auto* str = key.TryAs<String>()) {
+            return Mix(Fold(hash<string_view>{}(str->GetValue())));
+        }
+        if (const auto* boolean = key.TryAs<Bool>()) {
+            return Mix(boolean->GetValue() ? 1 : 0);
+        }
+        if (key.TryAs<List>() != nullptr) {
+            throw runtime_error("List can not be a dict key"s);
+        }
+        if (key.TryAs<Dict>() != nullptr) {
+            throw runtime_error("Dict can not be a dict key"s);
+        }
+        if (HasIdentityHash(key)) {
+            return IdentityHash(key);
+        }
+        const ObjectHolder result = key.TryAs<ClassInstance>()->Call(HASH_METHOD, {}, context);
+        if (const auto* number = result.TryAs<Number>()) {
+            return Mix(static_cast<uint32_t>(number->GetValue()));
+        }
+        throw runtime_error("Method __hash__ must return a number"s);
+    }
+
+    size_t Dict::FindEntry(const ObjectHolder& key, uint32_t hash, Context& context) const {
+        if (slots_.empty()) {
+            return NOT_FOUND;
+        }
+        size_t position = hash & (slots_.size() - 1);
+        for (size_t distance = 0;; ++distance) {
+            // Маска перечитывается на каждом шаге: __eq__ ключа может добавить пары и перестроить таблицу
+            const size_t mask = slots_.size() - 1;
+            const Slot slot = slots_[position];
+            // У слота, который ближе к своему месту, чем искомый ключ к своему, ключа дальше быть не может
+            if (slot.entry == EMPTY || ((position - slot.hash) & mask) < distance) {
+                return NOT_FOUND;
+            }
+            if (slot.hash == hash && KeysEqual(entries_[slot.entry].key, key, context)) {
+                return slot.entry;
+            }
+            position = (position + 1) & mask;
+        }
+    }
+
+    void Dict::Insert(ObjectHolder key, ObjectHolder value, uint32_t hash) {
+        // Таблица заполнена не больше чем на 80%: дальше цепочки проб быстро удлиняются
+        if ((entries_.size() + 1) * 5 > slots_.size() * 4) {
+            Rehash(max(MIN_CAPACITY, slots_.size() * 2));
+        }
+        entries_.push_back(Entry{std::move(key), std::move(value), hash});
+        PlaceSlot(Slot{hash, static_cast<uint32_t>(entries_.size() - 1)});
+    }
+
+    void Dict::PlaceSlot(Slot slot) {
+        const size_t mask = slots_.size() - 1;
+        size_t position = slot.hash & mask;
+        size_t distance = 0;
+        while (slots_[position].entry != EMPTY) {
+            // Robin Hood: слот уступает место ключу, который дальше от своего места
+            const size_t existing = (position - slots_[position].hash) & mask;
+            if (existing < distance) {
+                swap(slot, slots_[position]);
+                distance = existing;
+            }
+            position = (position + 1) & mask;
+            ++distance;
+        }
+        slots_[position] = slot;
+    }
+
+    void Dict::Rehash(size_t capacity) {
+        slots_.assign(capacity, Slot{0, EMPTY});
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            PlaceSlot(Slot{entries_[i].hash, static_cast<uint32_t>(i)});
+        }
+    }
+
+}  // namespace runtime
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace runtime {
+
+    /*
+     * Словарь Mython: {'one': 1, 2: 'two'}. Ключом может быть число, строка, логическое значение, None,
+     * класс или экземпляр класса. Экземпляр с методом __hash__() хешируется результатом этого метода
+     * и сравнивается с другими ключами методом __eq__, экземпляр без __hash__ равен только самому себе.
+     * Списки и словари не могут быть ключами.
+     *
+     * Пары хранятся подряд в порядке добавления, а поиск идёт по отдельной таблице с открытой адресацией
+     * и линейным пробированием в духе Robin Hood: слот таблицы - 32-битный хеш ключа и номер пары, всего
+     * 8 байт, поэтому проба по соседним слотам не трогает сами пары, а ключ сравнивается только при
+     * совпадении хеша. Память под пары и таблицу выделяется из ObjectPool и учитывается как MemoryKind::Dict.
+     * Методы в программе:
+     *   get(key[, default]) - значение по ключу либо default (None), если ключа нет;
+     *   keys(), values() - списки ключей и значений в порядке добавления.
+     * Значение возвращает индексация dict[key], добавляет или заменяет присваивание dict[key] = value,
+     * отсутствующий ключ при чтении - ошибка. Наличие ключа проверяет оператор in, число пар - функция len,
+     * ключи в порядке добавления перебирает цикл for.
+     * Словарь истинен, если не пуст, и равен другому словарю с теми же ключами и равными значениями
+     */
+    class Dict : public NativeObject {
+    public:
+        struct Entry {
+            ObjectHolder key;
+            ObjectHolder value;
+            uint32_t hash = 0;
+        };
+        using Entries = std::vector<Entry, PoolAllocator<Entry>>;
+
+        Dict();
+
+        ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& args, Context& context) override;
+        // Выводит пары key: value через запятую в фигурных скобках. Словарь, вложенный сам в себя, выводится как {...}
+        void Print(std::ostream& os, Context& context) override;
+
+        [[nodiscard]] size_t GetSize() const {
+            return entries_.size();
+        }
+
+        // Возвращает значение по ключу key или nullptr, если ключа нет.
+        // Указатель действителен до следующего изменения словаря
+        [[nodiscard]] const ObjectHolder* Find(const ObjectHolder& key, Context& context) const;
+        // Возвращает значение по ключу key. Если ключа нет, выбрасывает runtime_error
+        [[nodiscard]] const ObjectHolder& At(const ObjectHolder& key, Context& context) const;
+        // Связывает key со значением value. Для ключа, который нельзя хешировать, выбрасывает runtime_error
+        void Set(ObjectHolder key, ObjectHolder value, Context& context);
+
+        // Добавляет пару из копии словаря, ключи которой заведомо различны. Хеш экземпляров без __hash__
+        // зависит от адреса и пересчитывается, остальные ключи сохраняют хеш hash, вычисленный в оригинале
+        void Restore(ObjectHolder key, ObjectHolder value, uint32_t hash);
+
+        [[nodiscard]] const Entries& GetEntries() const {
+            return entries_;
+        }
+
+        // Возвращает хеш ключа key, вызывая у экземпляра метод __hash__.
+        // Для списков, словарей и экземпляров, __hash__ которых вернул не число, выбрасывает runtime_error
+        static uint32_t Hash(const ObjectHolder& key, Context& context);
+
+    private:
+        struct Slot {
+            uint32_t hash;
+            uint32_t entry;
+        };
+
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+        static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+        [[nodiscard]] size_t FindEntry(const ObjectHolder& key, uint32_t hash, Context& context) const;
+        void Insert(ObjectHolder key, ObjectHolder value, uint32_t hash);
+        void PlaceSlot(Slot slot);
+        void Rehash(size_t capacity);
+
+        Entries entries_;
+        std::vector<Slot, PoolAllocator<Slot>> slots_;
+    };
+
+}  // namespace runtime
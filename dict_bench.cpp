@@ -0,0 +1,69 @@
+#include "bench_runner.h"
+#include "interpreter.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void RunProgram(const string& program) {
+    ostringstream out;
+    SimpleContext context(out);
+    RunMythonProgram(program, context, RunOptions{});
+    DoNotOptimize(out);
+}
+
+// Заполняет словарь 100 строковыми ключами и 5000 раз ищет в нём ключи
+void BenchDictLookup() {
+    RunProgram(R"(
+index = {}
+i = 0
+while i < 100:
+  index['key' + str(i)] = i
+  i = i + 1
+total = 0
+i = 0
+while i < 5000:
+  total = total + index['key' + str(i - i / 100 * 100)]
+  i = i + 1
+print total
+)"s);
+}
+
+// Тот же поиск перебором списка ключей, как его писали программы без словарей
+void BenchLinearLookup() {
+    RunProgram(R"(
+keys = []
+values = []
+i = 0
+while i < 100:
+  keys.append('key' + str(i))
+  values.append(i)
+  i = i + 1
+total = 0
+i = 0
+while i < 5000:
+  wanted = 'key' + str(i - i / 100 * 100)
+  position = 0
+  for key in keys:
+    if key == wanted:
+      break
+    position = position + 1
+  total = total + values[position]
+  i = i + 1
+print total
+)"s);
+}
+
+}  // namespace
+
+void RunDictBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, BenchDictLookup);
+    RUN_BENCH(br, BenchLinearLookup);
+}
+
+}  // namespace runtime
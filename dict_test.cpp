@@ -0,0 +1,267 @@
+#include "dict.h"
+#include "heap.h"
+#include "interpreter.h"
+#include "isolate.h"
+#include "lexer.h"
+#include "memory_budget.h"
+#include "test_program.h"
+#include "test_runner.h"
+
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestDictLiteralsAndAccess() {
+    const string program = R"(
+empty = {}
+ages = {'ann': 31, 'bob': 25, 'ann': 32}
+print empty, ages, len(empty), len(ages)
+ages['cid'] = 40
+ages['bob'] = ages['bob'] + 1
+print ages, ages['bob'], ages.get('eve'), ages.get('eve', 0), ages.get('cid', 0)
+keys = ages.keys()
+values = ages.values()
+print keys, values
+mixed = {1: 'number', '1': 'string', True: 'bool', None: 'none'}
+print mixed[1], mixed['1'], mixed[True], mixed[None], len(mixed)
+)"s;
+    ASSERT_EQUAL(Run(program), "{} {ann: 32, bob: 25} 0 2\n"
+                               "{ann: 32, bob: 26, cid: 40} 26 None 0 40\n"
+                               "[ann, bob, cid] [32, 26, 40]\n"
+                               "number string bool none 4\n"s);
+
+    ASSERT_THROWS(Run("d = {'a': 1}\nprint d['b']\n"s), runtime_error);
+    ASSERT_THROWS(Run("d = {}\nd[[1]] = 2\n"s), runtime_error);
+    ASSERT_THROWS(Run("d = {{}: 1}\n"s), runtime_error);
+    ASSERT_THROWS(Run("d = {}\nprint d.get()\n"s), runtime_error);
+    ASSERT_THROWS(Run("d = {}\nd.pop(1)\n"s), runtime_error);
+    ASSERT_THROWS(Run("d = {'a' 1}\n"s), parse::LexerError);
+    ASSERT_THROWS(Run("d = {'a': 1\n"s), parse::LexerError);
+}
+
+void TestInOperator() {
+    const string program = R"(
+d = {'a': 1, 2: 'b'}
+xs = [1, 'two', None, [3]]
+print 'a' in d, 1 in d, 2 in d, 'b' not in d
+print 1 in xs, 'two' in xs, None in xs, [3] in xs, 2 in xs, 'one' not in xs
+print 'th' in 'mython', 'x' in 'mython', '' in ''
+if 'a' in d and 5 not in d:
+  print 'found'
+)"s;
+    ASSERT_EQUAL(Run(program), "True False True True\nTrue True True True False True\nTrue False True\nfound\n"s);
+    ASSERT_THROWS(Run("print 1 in 5\n"s), runtime_error);
+    ASSERT_THROWS(Run("print 1 in 'abc'\n"s), runtime_error);
+    ASSERT_THROWS(Run("print 1 not 2\n"s), parse::LexerError);
+}
+
+void TestForOverDict() {
+    const string program = R"(
+d = {'c': 3, 'a': 1, 'b': 2}
+total = 0
+for key in d:
+  if key == 'a':
+    continue
+  total = total + d[key]
+print total, key
+grow = {0: 0}
+for n in grow:
+  if n < 4:
+    grow[n + 1] = n * n
+print grow
+)"s;
+    ASSERT_EQUAL(Run(program), "5 b\n{0: 0, 1: 0, 2: 1, 3: 4, 4: 9}\n"s);
+}
+
+void TestInstanceKeys() {
+    const string program = R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+  def __hash__():
+    return self.x * 31 + self.y
+  def __eq__(other):
+    return self.x == other.x and self.y == other.y
+  def __str__():
+    return '(' + str(self.x) + ', ' + str(self.y) + ')'
+
+class Token:
+  def __init__(name):
+    self.name = name
+
+names = {Point(1, 2): 'a', Point(2, 1): 'b'}
+names[Point(1, 2)] = 'c'
+print len(names), names[Point(1, 2)], names[Point(2, 1)], Point(3, 3) in names
+print names
+
+t1 = Token('t')
+t2 = Token('t')
+tokens = {t1: 1}
+print t1 in tokens, t2 in tokens, tokens.get(t2, 'other')
+)"s;
+    ASSERT_EQUAL(Run(program), "2 c b False\n{(1, 2): c, (2, 1): b}\nTrue False other\n"s);
+
+    const string bad_hash = R"(
+class Bad:
+  def __hash__():
+    return 'not a number'
+
+d = {Bad(): 1}
+)"s;
+    ASSERT_THROWS(Run(bad_hash), runtime_error);
+}
+
+void TestManyKeys() {
+    const string program = R"(
+class Filler:
+  def fill(d, n, step):
+    i = 0
+    while i < n:
+      d[i * step] = i
+      d['k' + str(i)] = -i
+      i = i + 1
+    return d
+
+  def check(d, n, step):
+    i = 0
+    bad = 0
+    while i < n:
+      if d[i * step] != i:
+        bad = bad + 1
+      if d['k' + str(i)] != -i:
+        bad = bad + 1
+      i = i + 1
+    return bad
+
+f = Filler()
+d = f.fill({}, 3000, 1024)
+bad = f.check(d, 3000, 1024)
+print len(d), bad, -1024 in d, 3000 * 1024 in d
+)"s;
+    ASSERT_EQUAL(Run(program), "6000 0 False False\n"s);
+
+    // Пары и таблица учитываются в бюджете памяти и освобождаются вместе со словарём
+    MemoryBudget budget;
+    RunOptions options;
+    options.memory_budget = &budget;
+    ASSERT_EQUAL(Run(program, options), "6000 0 False False\n"s);
+    ASSERT(budget.GetPeakBytes(MemoryKind::Dict) >= 6000 * sizeof(Dict::Entry));
+    ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+}
+
+void TestDictTruthAndEquality() {
+    const string program = R"(
+empty = {}
+if empty:
+  print 'empty is true'
+if {0: 0}:
+  print 'full is true'
+a = {'x': [1, 2], 'y': {'z': 3}}
+b = {'y': {'z': 3}, 'x': [1, 2]}
+c = {'x': [1, 2], 'y': {'z': 4}}
+print a == b, a == c, a != c, {} == {}, {1: 1} == {1: 1, 2: 2}, {1: 1} == {2: 1}
+a['self'] = a
+print a
+)"s;
+    ASSERT_EQUAL(Run(program), "full is true\nTrue False True True False False\n"
+                               "{x: [1, 2], y: {z: 3}, self: {...}}\n"s);
+}
+
+// __eq__ значения, добавляющий пары в сравниваемый словарь, не должен читать перемещённые элементы
+void TestEqualityWhileDictGrows() {
+    const string program = R"(
+class Grow:
+  def __init__(target):
+    self.target = target
+
+  def __eq__(other):
+    i = 0
+    while i < 100:
+      self.target[i] = i
+      i = i + 1
+    return True
+
+rhs = {}
+rhs['k'] = Grow({})
+lhs = {'k': Grow(rhs)}
+print lhs == rhs, len(rhs)
+)"s;
+    ASSERT_EQUAL(Run(program), "True 101\n"s);
+}
+
+void TestCyclesThroughDictsAreCollected() {
+    Heap& heap = Heap::Current();
+    Class cls("Node"s, {}, nullptr);
+    DummyContext context;
+    const size_t before = heap.GetStats().objects;
+    {
+        // Родитель держит детей в словаре, дети ссылаются на родителя; один из детей - ключ
+        ObjectHolder parent = ObjectHolder::Own(ClassInstance(cls));
+        ObjectHolder children = ObjectHolder::Make<Dict>();
+        for (int i = 0; i < 3; ++i) {
+            ObjectHolder child = ObjectHolder::Own(ClassInstance(cls));
+            child.TryAs<ClassInstance>()->Fields()["parent"s] = parent;
+            children.TryAs<Dict>()->Set(ObjectHolder::Own(Number(i)), child, context);
+        }
+        ObjectHolder key = ObjectHolder::Own(ClassInstance(cls));
+        key.TryAs<ClassInstance>()->Fields()["parent"s] = parent;
+        children.TryAs<Dict>()->Set(key, ObjectHolder::None(), context);
+        parent.TryAs<ClassInstance>()->Fields()["children"s] = children;
+    }
+    ASSERT_EQUAL(heap.GetStats().objects, before + 5);
+    ASSERT_EQUAL(heap.Collect(), 5U);
+    ASSERT_EQUAL(heap.GetStats().objects, before);
+}
+
+void TestDictsAreCopiedBetweenIsolates() {
+    Class box_class("Box"s, {}, nullptr);
+    DummyContext context;
+    ObjectHolder box = ObjectHolder::Own(ClassInstance(box_class));
+    ObjectHolder dict = ObjectHolder::Make<Dict>();
+    auto* original = dict.TryAs<Dict>();
+    original->Set(ObjectHolder::Own(String("one"s)), ObjectHolder::Own(Number(1)), context);
+    original->Set(box, dict, context);
+    box.TryAs<ClassInstance>()->Fields()["owner"s] = dict;
+
+    const Message message = Message::Pack(dict);
+    original->Set(ObjectHolder::Own(String("one"s)), ObjectHolder::Own(Number(2)), context);
+
+    ObjectHolder copy = message.Unpack();
+    const auto* copied = copy.TryAs<Dict>();
+    ASSERT(copied != nullptr && copied != original);
+    ASSERT_EQUAL(copied->GetSize(), 2U);
+    ASSERT_EQUAL(copied->At(ObjectHolder::Own(String("one"s)), context).TryAs<Number>()->GetValue(), 1);
+    // Копия экземпляра-ключа находится по новому адресу, а оригинал в копии словаря не ключ
+    const ObjectHolder copied_box = copied->GetEntries()[1].key;
+    ASSERT(copied_box.Get() != box.Get());
+    ASSERT(copied->Find(box, context) == nullptr);
+    ASSERT(copied->At(copied_box, context).Get() == copied);
+    ASSERT(copied_box.TryAs<ClassInstance>()->Fields().at("owner"s).Get() == copied);
+
+    // Разорвать циклы, чтобы копия и оригинал освободились подсчётом ссылок
+    box.TryAs<ClassInstance>()->Fields().clear();
+    copied_box.TryAs<ClassInstance>()->Fields().clear();
+    original->Set(box, {}, context);
+    copy.TryAs<Dict>()->Set(copied_box, {}, context);
+}
+
+}  // namespace
+
+void RunDictTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestDictLiteralsAndAccess);
+    RUN_TEST(tr, runtime::TestInOperator);
+    RUN_TEST(tr, runtime::TestForOverDict);
+    RUN_TEST(tr, runtime::TestInstanceKeys);
+    RUN_TEST(tr, runtime::TestManyKeys);
+    RUN_TEST(tr, runtime::TestDictTruthAndEquality);
+    RUN_TEST(tr, runtime::TestEqualityWhileDictGrows);
+    RUN_TEST(tr, runtime::TestCyclesThroughDictsAreCollected);
+    RUN_TEST(tr, runtime::TestDictsAreCopiedBetweenIsolates);
+}
+
+}  // namespace runtime
@@ -0,0 +1,61 @@
+#include "execution_limits.h"
+
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+    void ExecutionLimits::SetStepLimit(uint64_t steps) {
+        step_limit_ = steps;
+    }
+
+    void ExecutionLimits::SetDeadline(Clock::time_point deadline) {
+        has_deadline_ = true;
+        deadline_ = deadline;
+    }
+
+    void ExecutionLimits::SetTimeout(Clock::duration timeout) {
+        SetDeadline(Clock::now() + timeout);
+    }
+
+    void ExecutionLimits::SetParent(ExecutionLimits* parent) {
+        parent_ = parent;
+    }
+
+    void ExecutionLimits::Interrupt() noexcept {
+        interrupted_.store(true, memory_order_relaxed);
+    }
+
+    uint64_t ExecutionLimits::GetSteps() const {
+        return steps_.load(memory_order_relaxed);
+    }
+
+    void ExecutionLimits::AddSteps(uint64_t steps) noexcept {
+        steps_.fetch_add(steps, memory_order_relaxed);
+        if (parent_ != nullptr) {
+            parent_->AddSteps(steps);
+        }
+    }
+
+    uint32_t ExecutionLimits::Check(uint32_t steps) {
+        const uint64_t total = steps_.fetch_add(steps, memory_order_relaxed) + steps;
+        if (interrupted_.load(memory_order_relaxed)) {
+            throw ExecutionStopped(StopReason::Interrupt, "Execution interrupted"s);
+        }
+        const uint32_t batch = parent_ != nullptr ? parent_->Check(steps) : CHECK_INTERVAL;
+        if (has_deadline_ && Clock::now() >= deadline_) {
+            throw ExecutionStopped(StopReason::Deadline, "Execution deadline exceeded"s);
+        }
+        if (step_limit_ == 0) {
+            return batch;
+        }
+        if (total > step_limit_) {
+            throw ExecutionStopped(StopReason::Steps, "Step limit of "s + to_string(step_limit_) + " exceeded"s);
+        }
+        // Следующая проверка приходится на шаг, превышающий бюджет
+        const uint64_t remaining = step_limit_ - total + 1;
+        return remaining < batch ? static_cast<uint32_t>(remaining) : batch;
+    }
+
+}  // namespace runtime
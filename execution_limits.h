@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace runtime {
+
+    // Причина остановки программы по ограничениям выполнения
+    enum class StopReason : uint8_t {
+        Steps,      // исчерпан бюджет шагов
+        Deadline,   // наступил крайний срок
+        Interrupt,  // выполнение прервано вызовом ExecutionLimits::Interrupt
+    };
+
+    // Ошибка выполнения программы, остановленной по ограничениям выполнения
+    class ExecutionStopped : public std::runtime_error {
+    public:
+        ExecutionStopped(StopReason reason, const std::string& message)
+            : std::runtime_error(message)
+            , reason_(reason) {
+        }
+
+        [[nodiscard]] StopReason GetReason() const {
+            return reason_;
+        }
+
+    private:
+        StopReason reason_;
+    };
+
+    /*
+     * Ограничения выполнения программы: бюджет шагов, крайний срок и флаг прерывания.
+     * Шагом считается выполнение инструкции составной инструкции или верхнего уровня и вызов метода.
+     * Шаги считает контекст выполнения (см. Context::Step), а ограничения проверяются пачками не чаще чем
+     * раз в CHECK_INTERVAL шагов, поэтому крайний срок и прерывание срабатывают с задержкой не больше пачки.
+     * Бюджет шагов соблюдается точно, пока его расходует один поток.
+     *
+     * Изоляты программы выполняются со своими ограничениями, подчинёнными ограничениям прогона (SetParent).
+     * Их шаги расходуют общий бюджет, поэтому при нескольких потоках он может быть превышен не больше
+     * чем на пачку шагов каждого потока.
+     *
+     * Interrupt и Check можно вызывать из любого потока, остальные методы - из потока, выполняющего
+     * программу, либо до её запуска
+     */
+    class ExecutionLimits {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr uint32_t CHECK_INTERVAL = 1024;
+
+        ExecutionLimits() = default;
+        ExecutionLimits(const ExecutionLimits&) = delete;
+        ExecutionLimits& operator=(const ExecutionLimits&) = delete;
+
+        // Задаёт наибольшее число шагов программы. 0 снимает ограничение
+        void SetStepLimit(uint64_t steps);
+        // Задаёт момент, после которого выполнение останавливается
+        void SetDeadline(Clock::time_point deadline);
+        // Задаёт крайний срок через timeout от текущего момента
+        void SetTimeout(Clock::duration timeout);
+
+        // Подчиняет ограничения ограничениям parent: шаги учитываются и в parent, а бюджет шагов,
+        // крайний срок и прерывание parent действуют наряду с собственными. parent должен пережить
+        // эти ограничения
+        void SetParent(ExecutionLimits* parent);
+
+        // Просит остановить выполнение программы
+        void Interrupt() noexcept;
+
+        // Возвращает число учтённых шагов
+        [[nodiscard]] uint64_t GetSteps() const;
+        // Учитывает steps шагов без проверки ограничений
+        void AddSteps(uint64_t steps) noexcept;
+
+        // Учитывает steps выполненных шагов и проверяет ограничения. Выбрасывает ExecutionStopped,
+        // если выполнение нужно остановить, иначе возвращает число шагов до следующей проверки
+        uint32_t Check(uint32_t steps);
+
+    private:
+        uint64_t step_limit_ = 0;
+        std::atomic<uint64_t> steps_{0};
+        bool has_deadline_ = false;
+        Clock::time_point deadline_;
+        std::atomic<bool> interrupted_{false};
+        ExecutionLimits* parent_ = nullptr;
+    };
+
+}  // namespace runtime
@@ -0,0 +1,56 @@
+#include "bench_runner.h"
+#include "execution_limits.h"
+#include "interpreter.h"
+#include "runtime.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Программа из коротких вызовов методов: шаги учитываются на каждом вызове и каждой инструкции
+const string CALL_PROGRAM = R"(
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+f = Fib()
+print f.calc(25)
+)"s;
+
+void RunCallProgram(ExecutionLimits* limits) {
+    ostringstream output;
+    SimpleContext context(output);
+    RunOptions options;
+    options.limits = limits;
+    RunMythonProgram(CALL_PROGRAM, context, options);
+    DoNotOptimize(output);
+}
+
+// Без ограничений: только уменьшение счётчика шагов в контексте
+void BenchCallsWithoutLimits() {
+    RunCallProgram(nullptr);
+}
+
+// С бюджетом шагов и крайним сроком: проверка раз в пачку шагов
+void BenchCallsWithLimits() {
+    ExecutionLimits limits;
+    limits.SetStepLimit(uint64_t{1} << 40);
+    limits.SetTimeout(std::chrono::hours(1));
+    RunCallProgram(&limits);
+}
+
+}  // namespace
+
+void RunExecutionLimitsBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, runtime::BenchCallsWithoutLimits);
+    RUN_BENCH(br, runtime::BenchCallsWithLimits);
+}
+
+}  // namespace runtime
@@ -0,0 +1,147 @@
+#include "execution_limits.h"
+#include "interpreter.h"
+#include "runtime.h"
+#include "test_runner.h"
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Программа, которая не завершится за разумное время: 2^40 вызовов при глубине рекурсии 40
+const string ENDLESS_PROGRAM = R"(
+class Tree:
+  def walk(n):
+    if n > 0:
+      self.walk(n - 1)
+      self.walk(n - 1)
+
+t = Tree()
+print 'start'
+t.walk(40)
+print 'done'
+)"s;
+
+// Запускает program с ограничениями limits и возвращает причину остановки
+StopReason RunUntilStopped(const string& program, ExecutionLimits& limits, string& output) {
+    ostringstream out;
+    SimpleContext context(out);
+    RunOptions options;
+    options.limits = &limits;
+    try {
+        RunMythonProgram(program, context, options);
+    } catch (const ExecutionStopped& e) {
+        output = out.str();
+        return e.GetReason();
+    }
+    ASSERT(false);
+    return StopReason::Interrupt;
+}
+
+void TestStepLimitIsExact() {
+    string program;
+    for (int i = 0; i < 10; ++i) {
+        program += "print "s + to_string(i) + "\n"s;
+    }
+    ExecutionLimits limits;
+    limits.SetStepLimit(4);
+    string output;
+    ASSERT(RunUntilStopped(program, limits, output) == StopReason::Steps);
+    ASSERT_EQUAL(output, "0\n1\n2\n3\n"s);
+
+    // Бюджет, которого хватает, не мешает программе
+    ExecutionLimits enough;
+    enough.SetStepLimit(10);
+    ostringstream out;
+    SimpleContext context(out);
+    RunOptions options;
+    options.limits = &enough;
+    options.streaming = true;
+    RunMythonProgram(program, context, options);
+    ASSERT_EQUAL(enough.GetSteps(), 10U);
+}
+
+void TestStepsCountMethodCalls() {
+    const string program = R"(
+class Counter:
+  def add(n):
+    if n > 0:
+      return self.add(n - 1) + 1
+    return 0
+
+c = Counter()
+print c.add(100)
+)"s;
+    ExecutionLimits limits;
+    ostringstream out;
+    SimpleContext context(out);
+    RunOptions options;
+    options.limits = &limits;
+    RunMythonProgram(program, context, options);
+    ASSERT_EQUAL(out.str(), "100\n"s);
+    // Каждый из 101 вызовов - шаг вызова и шаги инструкций тела
+    ASSERT(limits.GetSteps() > 202U);
+
+    ExecutionLimits tight;
+    tight.SetStepLimit(100);
+    string output;
+    ASSERT(RunUntilStopped(program, tight, output) == StopReason::Steps);
+    ASSERT_EQUAL(output, ""s);
+}
+
+void TestStepsCountLoopIterations() {
+    // Бесконечные циклы останавливаются бюджетом шагов, даже если тело сразу переходит к условию
+    ExecutionLimits limits;
+    limits.SetStepLimit(1000);
+    string output;
+    ASSERT(RunUntilStopped("print 'start'\nwhile True:\n  x = 1\n"s, limits, output) == StopReason::Steps);
+    ASSERT_EQUAL(output, "start\n"s);
+
+    ExecutionLimits skipping;
+    skipping.SetStepLimit(1000);
+    ASSERT(RunUntilStopped("while True:\n  continue\n"s, skipping, output) == StopReason::Steps);
+
+    ExecutionLimits deadline;
+    deadline.SetTimeout(50ms);
+    ASSERT(RunUntilStopped("while 1 < 2:\n  x = 1\n"s, deadline, output) == StopReason::Deadline);
+}
+
+void TestDeadline() {
+    ExecutionLimits limits;
+    limits.SetTimeout(50ms);
+    const auto start = chrono::steady_clock::now();
+    string output;
+    ASSERT(RunUntilStopped(ENDLESS_PROGRAM, limits, output) == StopReason::Deadline);
+    ASSERT(chrono::steady_clock::now() - start < 5s);
+    ASSERT_EQUAL(output, "start\n"s);
+}
+
+void TestInterruptFromAnotherThread() {
+    ExecutionLimits limits;
+    thread canceller([&limits] {
+        this_thread::sleep_for(50ms);
+        limits.Interrupt();
+    });
+    string output;
+    const StopReason reason = RunUntilStopped(ENDLESS_PROGRAM, limits, output);
+    canceller.join();
+    ASSERT(reason == StopReason::Interrupt);
+    ASSERT_EQUAL(output, "start\n"s);
+}
+
+}  // namespace
+
+void RunExecutionLimitsTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestStepLimitIsExact);
+    RUN_TEST(tr, runtime::TestStepsCountMethodCalls);
+    RUN_TEST(tr, runtime::TestStepsCountLoopIterations);
+    RUN_TEST(tr, runtime::TestDeadline);
+    RUN_TEST(tr, runtime::TestInterruptFromAnotherThread);
+}
+
+}  // namespace runtime
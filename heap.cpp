@@ -0,0 +1,193 @@
+#include "heap.h"
+
+#include "dict.h"
+#include "list.h"
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        // Внешние ссылки экземпляра, который не принадлежит ни одному ObjectHolder (например, лежит на стеке)
+        constexpr long UNOWNED = numeric_limits<long>::max();
+    }  // namespace
+
+    ostream& operator<<(ostream& os, const HeapStats& stats) {
+        using chrono::duration_cast;
+        using chrono::microseconds;
+        return os << "objects="sv << stats.objects << " peak_objects="sv << stats.peak_objects
+                  << " collections="sv << stats.collections << " collected="sv << stats.collected_objects
+                  << " last_pause_us="sv << duration_cast<microseconds>(stats.last_pause).count()
+                  << " max_pause_us="sv << duration_cast<microseconds>(stats.max_pause).count()
+                  << " total_pause_us="sv << duration_cast<microseconds>(stats.total_pause).count();
+    }
+
+    Heap::~Heap() {
+        // Экземпляры, пережившие поток, больше не обращаются к его куче
+        for (ClassInstance* instance : instances_) {
+            instance->heap_ = nullptr;
+        }
+    }
+
+    template <typename Visitor>
+    void Heap::ForEachReference(const ClassInstance& instance, Visitor&& visit) {
+        // Списки и словари, которыми экземпляр владеет один, - часть экземпляра: их элементы считаются его полями.
+        // На элементы контейнера, на который ссылаются и из других мест, этот контейнер ссылается как внешний владелец
+        vector<const List*> lists;
+        vector<const Dict*> dicts;
+        auto visit_value = [&](const ObjectHolder& value) {
+            if (value.data_.use_count() == 1) {
+                if (const auto* list = value.TryAs<List>()) {
+                    lists.push_back(list);
+                    return;
+                }
+                if (const auto* dict = value.TryAs<Dict>()) {
+                    dicts.push_back(dict);
+                    return;
+                }
+            }
+            visit(value);
+        };
+        for (const auto& [name, field] : instance.Fields()) {
+            visit_value(field);
+        }
+        while (!lists.empty() || !dicts.empty()) {
+            if (!lists.empty()) {
+                const List* list = lists.back();
+                lists.pop_back();
+                // Упакованные списки чисел и логических значений не ссылаются на объекты
+                for (const ObjectHolder& item : list->GetObjects()) {
+                    visit_value(item);
+                }
+                continue;
+            }
+            const Dict* dict = dicts.back();
+            dicts.pop_back();
+            for (const Dict::Entry& entry : dict->GetEntries()) {
+                visit_value(entry.key);
+                visit_value(entry.value);
+            }
+        }
+    }
+
+    Heap& Heap::Current() {
+        thread_local Heap heap;
+        return heap;
+    }
+
+    void Heap::Track(ClassInstance& instance) {
+        instance.heap_ = this;
+        instance.heap_index_ = instances_.size();
+        instances_.push_back(&instance);
+
+        stats_.peak_objects = max(stats_.peak_objects, instances_.size());
+        if (auto_collect_ && !collecting_ && instances_.size() >= next_collection_) {
+            Collect();
+        }
+    }
+
+    void Heap::Untrack(ClassInstance& instance) {
+        ClassInstance* last = instances_.back();
+        last->heap_index_ = instance.heap_index_;
+        instances_[instance.heap_index_] = last;
+        instances_.pop_back();
+    }
+
+    size_t Heap::Collect() {
+        if (collecting_) {
+            return 0;
+        }
+        collecting_ = true;
+        const auto start = chrono::steady_clock::now();
+
+        const size_t count = instances_.size();
+        unordered_map<const Object*, size_t> index;
+        index.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            index.emplace(instances_[i], i);
+        }
+
+        // Внешние ссылки: владеющие ссылки за вычетом ссылок из полей других экземпляров
+        vector<long> external(count);
+        vector<weak_ptr<ClassInstance>> owners(count);
+        for (size_t i = 0; i < count; ++i) {
+            owners[i] = instances_[i]->weak_from_this();
+            external[i] = owners[i].expired() ? UNOWNED : owners[i].use_count();
+        }
+        for (const ClassInstance* instance : instances_) {
+            ForEachReference(*instance, [&](const ObjectHolder& field) {
+                const auto it = index.find(field.Get());
+                if (it == index.end() || external[it->second] == UNOWNED) {
+                    return;
+                }
+                // Невладеющие ссылки (ObjectHolder::Share) не входят в счётчик владельца
+                const weak_ptr<ClassInstance>& owner = owners[it->second];
+                if (!field.data_.owner_before(owner) && !owner.owner_before(field.data_)) {
+                    --external[it->second];
+                }
+            });
+        }
+
+        // Пометка всего, что достижимо из экземпляров с внешними ссылками
+        vector<bool> reachable(count);
+        vector<size_t> pending;
+        for (size_t i = 0; i < count; ++i) {
+            if (external[i] > 0) {
+                reachable[i] = true;
+                pending.push_back(i);
+            }
+        }
+        while (!pending.empty()) {
+            const ClassInstance* instance = instances_[pending.back()];
+            pending.pop_back();
+            ForEachReference(*instance, [&](const ObjectHolder& field) {
+                const auto it = index.find(field.Get());
+                if (it != index.end() && !reachable[it->second]) {
+                    reachable[it->second] = true;
+                    pending.push_back(it->second);
+                }
+            });
+        }
+
+        // Недостижимые экземпляры удерживаются, пока очищаются их поля, и освобождаются все вместе
+        vector<shared_ptr<ClassInstance>> garbage;
+        for (size_t i = 0; i < count; ++i) {
+            if (!reachable[i]) {
+                garbage.push_back(owners[i].lock());
+            }
+        }
+        owners.clear();
+        for (const auto& instance : garbage) {
+            instance->Fields().clear();
+        }
+        const size_t collected = garbage.size();
+        garbage.clear();
+
+        const auto pause = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        ++stats_.collections;
+        stats_.collected_objects += collected;
+        stats_.last_pause = pause;
+        stats_.max_pause = max(stats_.max_pause, pause);
+        stats_.total_pause += pause;
+        next_collection_ = max(MIN_COLLECTION_THRESHOLD, 2 * instances_.size());
+
+        collecting_ = false;
+        return collected;
+    }
+
+    void Heap::SetAutoCollect(bool enabled) {
+        auto_collect_ = enabled;
+    }
+
+    HeapStats Heap::GetStats() const {
+        HeapStats stats = stats_;
+        stats.objects = instances_.size();
+        return stats;
+    }
+
+}  // namespace runtime
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace runtime {
+
+    // Показатели кучи экземпляров классов и работы сборщика циклов
+    struct HeapStats {
+        // Число живых экземпляров классов
+        size_t objects = 0;
+        // Наибольшее число живых экземпляров за время работы
+        size_t peak_objects = 0;
+        // Число выполненных сборок
+        size_t collections = 0;
+        // Число экземпляров, освобождённых сборщиком
+        size_t collected_objects = 0;
+        // Длительность последней, самой долгой и всех сборок вместе
+        std::chrono::nanoseconds last_pause{0};
+        std::chrono::nanoseconds max_pause{0};
+        std::chrono::nanoseconds total_pause{0};
+    };
+
+    // Выводит показатели stats в os в виде "имя=значение" через пробел
+    std::ostream& operator<<(std::ostream& os, const HeapStats& stats);
+
+    /*
+     * Куча экземпляров классов текущего потока и сборщик циклических ссылок между ними.
+     * Экземпляры освобождаются подсчётом ссылок (ObjectHolder::Own), сборщик находит только циклы,
+     * недостижимые из программы, например после a.peer = b и b.peer = a.
+     *
+     * Сборка выполняется пробным удалением: для каждого экземпляра из числа владеющих ссылок вычитаются ссылки
+     * из полей других экземпляров. Экземпляры, на которые остались внешние ссылки (из переменных, аргументов
+     * и временных значений выполняющихся методов), считаются корнями. Всё, что недостижимо из корней через поля,
+     * является мусором: у таких экземпляров очищаются поля, и циклы распадаются.
+     * Поэтому сборку можно запускать в любой момент выполнения программы.
+     * Список или словарь, на который ссылается только поле экземпляра, сборщик считает частью экземпляра, поэтому
+     * находит и циклы через контейнеры (a.items = [b], b.owner = a). Контейнер, на который ссылаются ещё
+     * и переменные, удерживает свои элементы как внешняя ссылка.
+     *
+     * Сборка запускается автоматически, когда число живых экземпляров вдвое превышает число переживших
+     * предыдущую сборку (но не меньше MIN_COLLECTION_THRESHOLD).
+     * Экземпляры не должны переходить из потока, в котором созданы, в другие потоки
+     */
+    class Heap {
+    public:
+        static constexpr size_t MIN_COLLECTION_THRESHOLD = 4096;
+
+        Heap() = default;
+        Heap(const Heap&) = delete;
+        Heap& operator=(const Heap&) = delete;
+        ~Heap();
+
+        // Возвращает кучу текущего потока
+        static Heap& Current();
+
+        // Освобождает недостижимые циклы. Возвращает число освобождённых экземпляров
+        size_t Collect();
+
+        // Включает или отключает автоматический запуск сборки
+        void SetAutoCollect(bool enabled);
+
+        [[nodiscard]] HeapStats GetStats() const;
+
+    private:
+        friend class ClassInstance;
+
+        void Track(ClassInstance& instance);
+        void Untrack(ClassInstance& instance);
+
+        // Вызывает visit для каждой ссылки экземпляра на другие объекты: полей и элементов списков и словарей в полях
+        template <typename Visitor>
+        static void ForEachReference(const ClassInstance& instance, Visitor&& visit);
+
+        std::vector<ClassInstance*> instances_;
+        HeapStats stats_;
+        size_t next_collection_ = MIN_COLLECTION_THRESHOLD;
+        bool auto_collect_ = true;
+        bool collecting_ = false;
+    };
+
+}  // namespace runtime
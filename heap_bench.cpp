@@ -0,0 +1,63 @@
+#include "bench_runner.h"
+#include "heap.h"
+#include "interpreter.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Пауза сборки при большом числе живых экземпляров, связанных в список
+void BenchCollectLiveHeap() {
+    static const Class cls("Node"s, {}, nullptr);
+    Heap& heap = Heap::Current();
+    heap.SetAutoCollect(false);
+
+    ObjectHolder head;
+    for (int i = 0; i < 100000; ++i) {
+        ObjectHolder node = ObjectHolder::Own(ClassInstance(cls));
+        node.TryAs<ClassInstance>()->Fields()["next"s] = head;
+        head = node;
+    }
+    DoNotOptimize(heap.Collect());
+
+    // Список освобождается по частям, чтобы не исчерпать стек рекурсивными деструкторами
+    while (head) {
+        ObjectHolder next = head.TryAs<ClassInstance>()->Fields()["next"s];
+        head.TryAs<ClassInstance>()->Fields().clear();
+        head = next;
+    }
+    heap.SetAutoCollect(true);
+}
+
+// Программа, на каждом шаге порождающая циклический мусор
+void BenchCyclicGarbageProgram() {
+    static const string program = [] {
+        string result = "class Peer:\n  def __init__():\n    self.peer = None\n"s
+            + "class Maker:\n  def run(k):\n    a = Peer()\n    b = Peer()\n"s
+            + "    a.peer = b\n    b.peer = a\n    return k + 1\n"s
+            + "m = Maker()\n"s;
+        for (int i = 0; i < 50000; ++i) {
+            result += "x = m.run("s + to_string(i) + ")\n"s;
+        }
+        return result;
+    }();
+
+    istringstream input(program);
+    ostringstream output;
+    RunMythonProgram(input, output);
+    DoNotOptimize(output);
+}
+
+}  // namespace
+
+void RunHeapBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, runtime::BenchCollectLiveHeap);
+    RUN_BENCH(br, runtime::BenchCyclicGarbageProgram);
+}
+
+}  // namespace runtime
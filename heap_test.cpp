@@ -0,0 +1,133 @@
+#include "heap.h"
+#include "interpreter.h"
+#include "test_runner.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Экземпляр класса без методов, созданный в куче
+ObjectHolder NewObject(const Class& cls) {
+    return ObjectHolder::Own(ClassInstance(cls));
+}
+
+ClassInstance& Instance(const ObjectHolder& holder) {
+    return *holder.TryAs<ClassInstance>();
+}
+
+void TestCollectsUnreachableCycles() {
+    Heap& heap = Heap::Current();
+    Class cls("Peer"s, {}, nullptr);
+    const size_t before = heap.GetStats().objects;
+    {
+        ObjectHolder a = NewObject(cls);
+        ObjectHolder b = NewObject(cls);
+        Instance(a).Fields()["peer"s] = b;
+        Instance(b).Fields()["peer"s] = a;
+
+        // Цикл, от которого висит цепочка объектов, недостижимая иначе как через цикл
+        ObjectHolder tail = NewObject(cls);
+        Instance(tail).Fields()["next"s] = NewObject(cls);
+        Instance(a).Fields()["tail"s] = tail;
+
+        // Самоцикл
+        ObjectHolder self = NewObject(cls);
+        Instance(self).Fields()["self"s] = self;
+    }
+    ASSERT_EQUAL(heap.GetStats().objects, before + 5);
+
+    const size_t collections = heap.GetStats().collections;
+    ASSERT_EQUAL(heap.Collect(), 5U);
+    ASSERT_EQUAL(heap.GetStats().objects, before);
+    ASSERT_EQUAL(heap.GetStats().collections, collections + 1);
+    ASSERT(heap.GetStats().total_pause >= heap.GetStats().last_pause);
+    ASSERT_EQUAL(heap.Collect(), 0U);
+}
+
+void TestKeepsReachableObjects() {
+    Heap& heap = Heap::Current();
+    Class cls("Node"s, {}, nullptr);
+
+    ObjectHolder root = NewObject(cls);
+    {
+        ObjectHolder a = NewObject(cls);
+        ObjectHolder b = NewObject(cls);
+        Instance(a).Fields()["peer"s] = b;
+        Instance(b).Fields()["peer"s] = a;
+        Instance(root).Fields()["child"s] = a;
+        Instance(root).Fields()["number"s] = ObjectHolder::Own(Number(42));
+    }
+    // Невладеющая ссылка на себя не мешает освобождению подсчётом ссылок и не считается владеющей
+    ObjectHolder shared = NewObject(cls);
+    Instance(shared).Fields()["me"s] = ObjectHolder::Share(*shared);
+
+    // Поля экземпляра, не принадлежащего ObjectHolder, тоже корни
+    ClassInstance on_stack(cls);
+    {
+        ObjectHolder a = NewObject(cls);
+        Instance(a).Fields()["self"s] = a;
+        on_stack.Fields()["cycle"s] = a;
+    }
+
+    ASSERT_EQUAL(heap.Collect(), 0U);
+    ClassInstance& a = Instance(Instance(root).Fields().at("child"s));
+    ClassInstance& b = Instance(a.Fields().at("peer"s));
+    ASSERT(b.Fields().at("peer"s).Get() == &a);
+    ASSERT_EQUAL(Instance(root).Fields().at("number"s).TryAs<Number>()->GetValue(), 42);
+    ASSERT(Instance(shared).Fields().at("me"s).Get() == shared.Get());
+    ASSERT(on_stack.Fields().at("cycle"s));
+
+    // После потери корня цикл становится мусором
+    Instance(root).Fields().erase("child"s);
+    on_stack.Fields().clear();
+    ASSERT_EQUAL(heap.Collect(), 3U);
+}
+
+void TestAutomaticCollection() {
+    ostringstream program;
+    program << R"(
+class Peer:
+  def __init__():
+    self.peer = None
+
+class Maker:
+  def run(k):
+    a = Peer()
+    b = Peer()
+    a.peer = b
+    b.peer = a
+    return k + 1
+
+m = Maker()
+)";
+    const size_t pairs = Heap::MIN_COLLECTION_THRESHOLD * 2;
+    for (size_t i = 0; i < pairs; ++i) {
+        program << "x = m.run(" << i << ")\n";
+    }
+
+    Heap& heap = Heap::Current();
+    const HeapStats before = heap.GetStats();
+    istringstream input(program.str());
+    ostringstream output;
+    RunMythonProgram(input, output);
+    const HeapStats after = heap.GetStats();
+
+    ASSERT(after.collections > before.collections + 1);
+    ASSERT_EQUAL(after.collected_objects - before.collected_objects, pairs * 2);
+    ASSERT_EQUAL(after.objects, before.objects);
+    ASSERT(after.peak_objects <= before.objects + Heap::MIN_COLLECTION_THRESHOLD * 2);
+}
+
+}  // namespace
+
+void RunHeapTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestCollectsUnreachableCycles);
+    RUN_TEST(tr, runtime::TestKeepsReachableObjects);
+    RUN_TEST(tr, runtime::TestAutomaticCollection);
+}
+
+}  // namespace runtime
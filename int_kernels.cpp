@@ -0,0 +1,248 @@
+#include "int_kernels.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define INT_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        // Сложение и умножение без знака не переполняются, а приведение к int берёт младшие 32 бита
+        int WrapAdd(int lhs, int rhs) {
+            return static_cast<int>(static_cast<unsigned>(lhs) + static_cast<unsigned>(rhs));
+        }
+
+        int WrapMul(int lhs, int rhs) {
+            return static_cast<int>(static_cast<unsigned>(lhs) * static_cast<unsigned>(rhs));
+        }
+
+        int SumScalar(const int* data, size_t size, int total) {
+            for (size_t i = 0; i < size; ++i) {
+                total = WrapAdd(total, data[i]);
+            }
+            return total;
+        }
+
+        int DotScalar(const int* lhs, const int* rhs, size_t size, int total) {
+            for (size_t i = 0; i < size; ++i) {
+                total = WrapAdd(total, WrapMul(lhs[i], rhs[i]));
+            }
+            return total;
+        }
+
+        size_t CountScalar(const int* data, size_t size, int value) {
+            return static_cast<size_t>(count(data, data + size, value));
+        }
+
+#ifdef INT_KERNELS_AVX2
+        constexpr size_t LANES = 8;
+
+        bool CpuHasAvx2() {
+            return __builtin_cpu_supports("avx2");
+        }
+
+        __attribute__((target("avx2"))) void StoreLanes(__m256i value, int (&lanes)[LANES]) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), value);
+        }
+
+        __attribute__((target("avx2"))) __m256i Load(const int* data) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        }
+
+        __attribute__((target("avx2"))) int SumAvx2(const int* data, size_t size) {
+            __m256i total = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + LANES <= size; i += LANES) {
+                total = _mm256_add_epi32(total, Load(data + i));
+            }
+            int lanes[LANES];
+            StoreLanes(total, lanes);
+            return SumScalar(data + i, size - i, SumScalar(lanes, LANES, 0));
+        }
+
+        __attribute__((target("avx2"))) int MinAvx2(const int* data, size_t size) {
+            __m256i result = _mm256_set1_epi32(data[0]);
+            size_t i = 0;
+            for (; i + LANES <= size; i += LANES) {
+                result = _mm256_min_epi32(result, Load(data + i));
+            }
+            int lanes[LANES];
+            StoreLanes(result, lanes);
+            int found = *min_element(lanes, lanes + LANES);
+            for (; i < size; ++i) {
+                found = min(found, data[i]);
+            }
+            return found;
+        }
+
+        __attribute__((target("avx2"))) int MaxAvx2(const int* data, size_t size) {
+            __m256i result = _mm256_set1_epi32(data[0]);
+            size_t i = 0;
+            for (; i + LANES <= size; i += LANES) {
+                result = _mm256_max_epi32(result, Load(data + i));
+            }
+            int lanes[LANES];
+            StoreLanes(result, lanes);
+            int found = *max_element(lanes, lanes + LANES);
+            for (; i < size; ++i) {
+                found = max(found, data[i]);
+            }
+            return found;
+        }
+
+        __attribute__((target("avx2"))) int DotAvx2(const int* lhs, const int* rhs, size_t size) {
+            __m256i total = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + LANES <= size; i += LANES) {
+                total = _mm256_add_epi32(total, _mm256_mullo_epi32(Load(lhs + i), Load(rhs + i)));
+            }
+            int lanes[LANES];
+            StoreLanes(total, lanes);
+            return DotScalar(lhs + i, rhs + i, size - i, SumScalar(lanes, LANES, 0));
+        }
+
+        __attribute__((target("avx2"))) void AddAvx2(const int* lhs, const int* rhs, int* out, size_t size) {
+            size_t i = 0;
+            for (; i + LANES <= size; i += LANES) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi32(Load(lhs + i), Load(rhs + i)));
+            }
+            for (; i < size; ++i) {
+                out[i] = WrapAdd(lhs[i], rhs[i]);
+            }
+        }
+
+        __attribute__((target("avx2"))) void MulAvx2(const int* lhs, const int* rhs, int* out, size_t size) {
+            size_t i = 0;
+            for (; i + LANES <= size; i += LANES) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                                    _mm256_mullo_epi32(Load(lhs + i), Load(rhs + i)));
+            }
+            for (; i < size; ++i) {
+                out[i] = WrapMul(lhs[i], rhs[i]);
+            }
+        }
+
+        __attribute__((target("avx2"))) size_t CountAvx2(const int* data, size_t size, int value) {
+            const __m256i wanted = _mm256_set1_epi32(value);
+            // Совпавшая дорожка сравнения равна -1, поэтому вычитание считает совпадения.
+            // Счётчики дорожек сбрасываются в общий итог, пока не переполнились
+            constexpr size_t BLOCK = LANES * (1U << 30);
+            size_t found = 0;
+            size_t i = 0;
+            while (i + LANES <= size) {
+                __m256i counts = _mm256_setzero_si256();
+                const size_t end = i + min(BLOCK, (size - i) / LANES * LANES);
+                for (; i < end; i += LANES) {
+                    counts = _mm256_sub_epi32(counts, _mm256_cmpeq_epi32(Load(data + i), wanted));
+                }
+                int lanes[LANES];
+                StoreLanes(counts, lanes);
+                for (const int lane : lanes) {
+                    found += static_cast<unsigned>(lane);
+                }
+            }
+            return found + CountScalar(data + i, size - i, value);
+        }
+#else
+        bool CpuHasAvx2() {
+            return false;
+        }
+#endif
+
+        atomic<KernelIsa>& CurrentIsa() {
+            static atomic<KernelIsa> isa(CpuHasAvx2() ? KernelIsa::Avx2 : KernelIsa::Scalar);
+            return isa;
+        }
+
+        bool UseAvx2() {
+            return CurrentIsa().load(memory_order_relaxed) == KernelIsa::Avx2;
+        }
+    }  // namespace
+
+    KernelIsa GetKernelIsa() {
+        return CurrentIsa().load(memory_order_relaxed);
+    }
+
+    KernelIsa SetKernelIsa(KernelIsa isa) {
+        if (isa == KernelIsa::Avx2 && !CpuHasAvx2()) {
+            return GetKernelIsa();
+        }
+        return CurrentIsa().exchange(isa, memory_order_relaxed);
+    }
+
+    int SumInts(const int* data, size_t size) {
+#ifdef INT_KERNELS_AVX2
+        if (UseAvx2()) {
+            return SumAvx2(data, size);
+        }
+#endif
+        return SumScalar(data, size, 0);
+    }
+
+    int MinInts(const int* data, size_t size) {
+#ifdef INT_KERNELS_AVX2
+        if (UseAvx2()) {
+            return MinAvx2(data, size);
+        }
+#endif
+        return *min_element(data, data + size);
+    }
+
+    int MaxInts(const int* data, size_t size) {
+#ifdef INT_KERNELS_AVX2
+        if (UseAvx2()) {
+            return MaxAvx2(data, size);
+        }
+#endif
+        return *max_element(data, data + size);
+    }
+
+    int DotInts(const int* lhs, const int* rhs, size_t size) {
+#ifdef INT_KERNELS_AVX2
+        if (UseAvx2()) {
+            return DotAvx2(lhs, rhs, size);
+        }
+#endif
+        return DotScalar(lhs, rhs, size, 0);
+    }
+
+    void AddInts(const int* lhs, const int* rhs, int* out, size_t size) {
+#ifdef INT_KERNELS_AVX2
+        if (UseAvx2()) {
+            AddAvx2(lhs, rhs, out, size);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = WrapAdd(lhs[i], rhs[i]);
+        }
+    }
+
+    void MulInts(const int* lhs, const int* rhs, int* out, size_t size) {
+#ifdef INT_KERNELS_AVX2
+        if (UseAvx2()) {
+            MulAvx2(lhs, rhs, out, size);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = WrapMul(lhs[i], rhs[i]);
+        }
+    }
+
+    size_t CountInts(const int* data, size_t size, int value) {
+#ifdef INT_KERNELS_AVX2
+        if (UseAvx2()) {
+            return CountAvx2(data, size, value);
+        }
+#endif
+        return CountScalar(data, size, value);
+    }
+
+}  // namespace runtime
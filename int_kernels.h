@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+namespace runtime {
+
+    /*
+     * Векторные функции над массивами значений чисел Mython, на которых работают встроенные функции списков
+     * (sum, min, max, dot, add, mul и метод count). Сложение и умножение переполняются по модулю 2^32 так же,
+     * как операции + и * над числами в программе, поэтому результат не зависит от порядка суммирования.
+     * На процессорах с AVX2 функции обрабатывают по 8 чисел за инструкцию, на остальных - обычными циклами
+     */
+    enum class KernelIsa {
+        Scalar,
+        Avx2,
+    };
+
+    // Возвращает набор инструкций, которым сейчас выполняются функции
+    KernelIsa GetKernelIsa();
+    // Переключает функции на набор isa, если процессор его поддерживает, и возвращает прежний набор.
+    // Нужна тестам и замерам, чтобы сравнить обе реализации
+    KernelIsa SetKernelIsa(KernelIsa isa);
+
+    int SumInts(const int* data, size_t size);
+    // Наименьшее и наибольшее из size > 0 чисел
+    int MinInts(const int* data, size_t size);
+    int MaxInts(const int* data, size_t size);
+    // Сумма попарных произведений lhs[i] * rhs[i]
+    int DotInts(const int* lhs, const int* rhs, size_t size);
+    // out[i] = lhs[i] + rhs[i] и out[i] = lhs[i] * rhs[i]; out может совпадать с lhs или rhs
+    void AddInts(const int* lhs, const int* rhs, int* out, size_t size);
+    void MulInts(const int* lhs, const int* rhs, int* out, size_t size);
+    // Число элементов, равных value
+    size_t CountInts(const int* data, size_t size, int value);
+
+}  // namespace runtime
@@ -0,0 +1,104 @@
+#include "int_kernels.h"
+#include "test_runner.h"
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Числа с переполнениями и экстремальными значениями, детерминированные для воспроизводимости
+vector<int> MakeValues(size_t size, uint32_t seed) {
+    vector<int> values(size);
+    uint32_t state = seed;
+    for (size_t i = 0; i < size; ++i) {
+        state = state * 1664525U + 1013904223U;
+        values[i] = static_cast<int>(state);
+    }
+    if (size > 3) {
+        values[size / 3] = INT_MIN;
+        values[size / 2] = INT_MAX;
+    }
+    return values;
+}
+
+int Wrap(int64_t value) {
+    return static_cast<int>(static_cast<uint32_t>(static_cast<uint64_t>(value)));
+}
+
+// Проверяет функции текущего набора инструкций на массивах всех длин от 0 до 70:
+// векторная часть, остаток и их сочетания
+void CheckKernels() {
+    for (size_t size = 0; size <= 70; ++size) {
+        const vector<int> lhs = MakeValues(size, 7);
+        const vector<int> rhs = MakeValues(size, 11);
+
+        int64_t sum = 0;
+        int64_t dot = 0;
+        size_t count = 0;
+        for (size_t i = 0; i < size; ++i) {
+            sum += lhs[i];
+            dot = Wrap(dot + static_cast<int64_t>(lhs[i]) * rhs[i]);
+            count += lhs[i] == INT_MIN ? 1 : 0;
+        }
+        ASSERT_EQUAL(SumInts(lhs.data(), size), Wrap(sum));
+        ASSERT_EQUAL(DotInts(lhs.data(), rhs.data(), size), Wrap(dot));
+        ASSERT_EQUAL(CountInts(lhs.data(), size, INT_MIN), count);
+        ASSERT_EQUAL(CountInts(lhs.data(), size, 12345), 0U);
+
+        if (size > 0) {
+            int lowest = lhs[0];
+            int highest = lhs[0];
+            for (const int value : lhs) {
+                lowest = min(lowest, value);
+                highest = max(highest, value);
+            }
+            ASSERT_EQUAL(MinInts(lhs.data(), size), lowest);
+            ASSERT_EQUAL(MaxInts(lhs.data(), size), highest);
+        }
+
+        vector<int> sums(size);
+        vector<int> products = lhs;
+        AddInts(lhs.data(), rhs.data(), sums.data(), size);
+        MulInts(products.data(), rhs.data(), products.data(), size);
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_EQUAL(sums[i], Wrap(static_cast<int64_t>(lhs[i]) + rhs[i]));
+            ASSERT_EQUAL(products[i], Wrap(static_cast<int64_t>(lhs[i]) * rhs[i]));
+        }
+    }
+
+    // Наименьшее и наибольшее значения в последней, невекторной части массива
+    vector<int> tail(19, 5);
+    tail.back() = -100;
+    tail[17] = 100;
+    ASSERT_EQUAL(MinInts(tail.data(), tail.size()), -100);
+    ASSERT_EQUAL(MaxInts(tail.data(), tail.size()), 100);
+    ASSERT_EQUAL(CountInts(tail.data(), tail.size(), 5), 17U);
+}
+
+void TestScalarKernels() {
+    const KernelIsa previous = SetKernelIsa(KernelIsa::Scalar);
+    ASSERT(GetKernelIsa() == KernelIsa::Scalar);
+    CheckKernels();
+    SetKernelIsa(previous);
+}
+
+void TestVectorKernels() {
+    // Без AVX2 набор не переключается, и проверка повторяет обычные циклы
+    const KernelIsa previous = SetKernelIsa(KernelIsa::Avx2);
+    CheckKernels();
+    SetKernelIsa(previous);
+}
+
+}  // namespace
+
+void RunIntKernelsTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestScalarKernels);
+    RUN_TEST(tr, runtime::TestVectorKernels);
+}
+
+}  // namespace runtime
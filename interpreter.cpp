@@ -0,0 +1,212 @@
+#include "interpreter.h"
+
+#include "call_stack.h"
+#include "coroutine.h"
+#include "heap.h"
+#include "isolate.h"
+#include "lexer.h"
+#include "mapped_file.h"
+#include "memory_budget.h"
+#include "parse.h"
+#include "program_cache.h"
+#include "runtime.h"
+#include "serialize.h"
+
+using namespace std;
+
+namespace {
+
+// Изоляты и задачи, запущенные программой, завершаются вместе с ней, пока дерево программы ещё живо.
+// Изоляты подчиняются ограничениям выполнения limits
+void Execute(runtime::Executable& program, runtime::Closure& closure, runtime::Context& context,
+             runtime::ExecutionLimits* limits) {
+    runtime::IsolateGroup isolates(limits);
+    runtime::IsolateGroup::Scope isolates_scope(&isolates);
+    runtime::CoroutineScheduler tasks;
+    runtime::CoroutineScheduler::Scope tasks_scope(&tasks);
+    program.Execute(closure, context);
+    tasks.Finish();
+    isolates.Finish(context);
+    context.Flush();
+}
+
+// Выполняет инструкции по мере их разбора. Выполненная инструкция сразу освобождается
+void ExecuteStreaming(StatementReader& reader, runtime::Closure& closure, runtime::Context& context,
+                      runtime::ExecutionLimits* limits) {
+    runtime::IsolateGroup isolates(limits);
+    runtime::IsolateGroup::Scope isolates_scope(&isolates);
+    runtime::CoroutineScheduler tasks;
+    runtime::CoroutineScheduler::Scope tasks_scope(&tasks);
+    while (auto statement = reader.Next()) {
+        context.Step();
+        statement->Execute(closure, context);
+    }
+    tasks.Finish();
+    isolates.Finish(context);
+    context.Flush();
+}
+
+// Освобождает глобальные переменные завершившейся программы вместе с оставшимися от неё циклами,
+// в том числе когда программа прервана исключением
+class GlobalsGuard {
+public:
+    explicit GlobalsGuard(runtime::Closure& globals)
+        : globals_(globals) {
+    }
+
+    GlobalsGuard(const GlobalsGuard&) = delete;
+    GlobalsGuard& operator=(const GlobalsGuard&) = delete;
+
+    ~GlobalsGuard() {
+        globals_.clear();
+        runtime::Heap::Current().Collect();
+    }
+
+private:
+    runtime::Closure& globals_;
+};
+
+// Подключает ограничения выполнения к контексту на время прогона
+class LimitsScope {
+public:
+    LimitsScope(runtime::Context& context, runtime::ExecutionLimits* limits)
+        : context_(context) {
+        context_.SetLimits(limits);
+    }
+
+    LimitsScope(const LimitsScope&) = delete;
+    LimitsScope& operator=(const LimitsScope&) = delete;
+
+    ~LimitsScope() {
+        context_.SetLimits(nullptr);
+    }
+
+private:
+    runtime::Context& context_;
+};
+
+// Задаёт наибольшую глубину вызовов на время прогона. По окончании освобождает кадры, сохранённые
+// стеком вызовов для повторного использования, пока подключён бюджет памяти прогона
+class CallDepthScope {
+public:
+    explicit CallDepthScope(size_t max_depth)
+        : stack_(runtime::CallStack::Current())
+        , previous_(stack_.GetMaxDepth()) {
+        stack_.SetMaxDepth(max_depth != 0 ? max_depth : runtime::CallStack::DEFAULT_MAX_DEPTH);
+    }
+
+    CallDepthScope(const CallDepthScope&) = delete;
+    CallDepthScope& operator=(const CallDepthScope&) = delete;
+
+    ~CallDepthScope() {
+        stack_.SetMaxDepth(previous_);
+        stack_.ReleaseFrames();
+    }
+
+private:
+    runtime::CallStack& stack_;
+    size_t previous_;
+};
+
+// Загружает снимок из файла path. При пустом пути возвращает пустое состояние
+ast::Snapshot LoadSnapshot(const string& path) {
+    if (path.empty()) {
+        return {};
+    }
+    parse::MappedFile file(path);
+    return ast::DeserializeSnapshot(file.Data());
+}
+
+// Параметры разбора программы, которой доступны классы снимка
+ParseOptions MakeParseOptions(const RunOptions& options, const ast::Snapshot& snapshot) {
+    ParseOptions result;
+    result.lazy_methods = options.lazy_methods;
+    result.classes.reserve(snapshot.classes.size());
+    for (const runtime::ObjectHolder& cls : snapshot.classes) {
+        result.classes.push_back(cls.TryAs<runtime::Class>());
+    }
+    return result;
+}
+
+}  // namespace
+
+void RunMythonProgram(istream& input, runtime::Context& context) {
+    RunMythonProgram(input, context, RunOptions{});
+}
+
+void RunMythonProgram(istream& input, runtime::Context& context, const RunOptions& options) {
+    // Бюджет подключён, пока не освобождены все объекты прогона
+    runtime::MemoryBudget::Scope budget_scope(options.memory_budget);
+    LimitsScope limits_scope(context, options.limits);
+    CallDepthScope depth_scope(options.max_depth);
+    // Снимок объявлен раньше программы: её узлы и объекты ссылаются на классы снимка
+    ast::Snapshot snapshot = LoadSnapshot(options.snapshot_path);
+    GlobalsGuard globals_guard(snapshot.globals);
+    const ParseOptions parse_options = MakeParseOptions(options, snapshot);
+
+    parse::Lexer lexer(input);
+    if (options.streaming) {
+        StatementReader reader(lexer, {}, parse_options);
+        ExecuteStreaming(reader, snapshot.globals, context, options.limits);
+        return;
+    }
+    auto program = ParseProgram(lexer, parse_options);
+    Execute(*program, snapshot.globals, context, options.limits);
+}
+
+void RunMythonProgram(istream& input, ostream& output) {
+    runtime::SimpleContext context{output};
+    RunMythonProgram(input, context);
+}
+
+void RunMythonProgram(string_view source, runtime::Context& context, const RunOptions& options) {
+    runtime::MemoryBudget::Scope budget_scope(options.memory_budget);
+    LimitsScope limits_scope(context, options.limits);
+    CallDepthScope depth_scope(options.max_depth);
+    ast::Snapshot snapshot = LoadSnapshot(options.snapshot_path);
+    GlobalsGuard globals_guard(snapshot.globals);
+    const ParseOptions parse_options = MakeParseOptions(options, snapshot);
+
+    if (options.streaming) {
+        parse::MemoryInputStream input(source);
+        parse::Lexer lexer(input);
+        StatementReader reader(lexer, source, parse_options);
+        ExecuteStreaming(reader, snapshot.globals, context, options.limits);
+        return;
+    }
+    // Дерево из кэша не может ссылаться на классы снимка, а тела методов в нём разобраны
+    auto program = options.cache_dir.empty() || options.lazy_methods || !options.snapshot_path.empty()
+        ? ParseProgram(source, parse_options)
+        : ast::ProgramCache(options.cache_dir).Load(source);
+    Execute(*program, snapshot.globals, context, options.limits);
+}
+
+void SaveSnapshot(string_view source, runtime::Context& context, const string& snapshot_path) {
+    auto program = ParseProgram(source, ParseOptions{});
+    runtime::Closure globals;
+    GlobalsGuard globals_guard(globals);
+    Execute(*program, globals, context, nullptr);
+    ast::WriteFileAtomically(snapshot_path, ast::SerializeSnapshot(*program, globals));
+}
+
+CompiledProgram::CompiledProgram(string source, const RunOptions& options)
+    : source_(std::move(source)) {
+    if (options.cache_dir.empty() || options.lazy_methods) {
+        ParseOptions parse_options;
+        parse_options.lazy_methods = options.lazy_methods;
+        program_ = ParseProgram(source_, parse_options);
+    }
+    else {
+        program_ = ast::ProgramCache(options.cache_dir).Load(source_);
+    }
+}
+
+CompiledProgram::~CompiledProgram() = default;
+
+void CompiledProgram::Run(runtime::Closure& globals, runtime::Context& context, const RunOptions& options) const {
+    runtime::MemoryBudget::Scope budget_scope(options.memory_budget);
+    LimitsScope limits_scope(context, options.limits);
+    CallDepthScope depth_scope(options.max_depth);
+    GlobalsGuard globals_guard(globals);
+    Execute(*program_, globals, context, options.limits);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Параметры запуска программы
+struct RunOptions {
+    // Каталог кэша разобранных программ (см. ast::ProgramCache). Пустая строка отключает кэш
+    std::string cache_dir;
+    // Разбирать тела методов при первом вызове (см. ParseOptions::lazy_methods).
+    // Кэш в этом режиме не используется: программа из кэша загружается целиком
+    bool lazy_methods = false;
+    // Выполнять каждую инструкцию верхнего уровня сразу после её разбора и освобождать её после выполнения.
+    // Вывод появляется до окончания разбора, а память не растёт с длиной линейной программы.
+    // Синтаксическая ошибка прерывает программу после выполнения предшествующих ей инструкций.
+    // Кэш в этом режиме не используется
+    bool streaming = false;
+    // Файл снимка, созданного SaveSnapshot. Если задан, программа начинает выполнение с восстановленных
+    // глобальных переменных и может использовать классы снимка. Кэш в этом режиме не используется
+    std::string snapshot_path;
+    // Бюджет памяти прогона. Если задан, в нём учитывается память объектов, созданных при загрузке снимка,
+    // разборе и выполнении программы, а при превышении его ограничения выполнение прерывается исключением
+    // runtime::MemoryLimitError. После прогона в бюджете остаётся наибольший объём памяти по видам
+    runtime::MemoryBudget* memory_budget = nullptr;
+    // Ограничения выполнения прогона: бюджет шагов, крайний срок и прерывание из другого потока.
+    // На время прогона подключаются к контексту, при их нарушении выбрасывается runtime::ExecutionStopped
+    runtime::ExecutionLimits* limits = nullptr;
+    // Наибольшая глубина вызовов методов (см. runtime::CallStack), 0 - runtime::CallStack::DEFAULT_MAX_DEPTH.
+    // При превышении выбрасывается runtime::RecursionError
+    size_t max_depth = 0;
+};
+
+// Разбирает программу на языке Mython из потока input и выполняет её, направляя вывод в context.
+// По окончании работы вызывает context.Flush()
+void RunMythonProgram(std::istream& input, runtime::Context& context);
+
+// Разбирает программу из потока input и выполняет её с параметрами options, направляя вывод в context.
+// Для потока не учитываются options.cache_dir и options.lazy_methods
+void RunMythonProgram(std::istream& input, runtime::Context& context, const RunOptions& options);
+
+// Выполняет программу из потока input, выводя результат в поток output
+void RunMythonProgram(std::istream& input, std::ostream& output);
+
+// Выполняет программу с исходным кодом source, направляя вывод в context.
+// При заданном options.cache_dir дерево программы берётся из кэша либо сохраняется в него после разбора,
+// если не заданы options.lazy_methods и options.snapshot_path
+void RunMythonProgram(std::string_view source, runtime::Context& context, const RunOptions& options);
+
+// Выполняет программу-пролог с исходным кодом source и сохраняет в файл snapshot_path её глобальные переменные,
+// классы и все достижимые из переменных объекты (см. ast::SerializeSnapshot). Вывод пролога направляется в context
+void SaveSnapshot(std::string_view source, runtime::Context& context, const std::string& snapshot_path);
+
+/*
+ * Разобранная программа, которую можно выполнять одновременно в нескольких потоках.
+ * После разбора дерево программы не изменяется: константы и классы только читаются (счётчики ссылок на них
+ * атомарны), а ленивые тела методов разбираются один раз под std::call_once. Всё изменяемое состояние
+ * прогона - глобальные переменные, контекст вывода, куча экземпляров, пул объектов, бюджет памяти
+ * и ограничения выполнения - принадлежит прогону и потоку, в котором он выполняется
+ */
+class CompiledProgram {
+public:
+    // Разбирает программу с исходным кодом source.
+    // Учитываются options.cache_dir и options.lazy_methods (с ним кэш не используется), снимки не поддерживаются
+    CompiledProgram(std::string source, const RunOptions& options);
+    ~CompiledProgram();
+
+    CompiledProgram(const CompiledProgram&) = delete;
+    CompiledProgram& operator=(const CompiledProgram&) = delete;
+
+    // Выполняет программу в текущем потоке, начиная с глобальных переменных globals, и направляет вывод
+    // в context. По окончании globals очищаются. Учитываются options.memory_budget и options.limits
+    void Run(runtime::Closure& globals, runtime::Context& context, const RunOptions& options) const;
+
+    [[nodiscard]] const std::string& GetSource() const {
+        return source_;
+    }
+
+private:
+    // Исходный код нужен ленивым телам методов
+    std::string source_;
+    std::unique_ptr<runtime::Executable> program_;
+};
@@ -0,0 +1,246 @@
+#include "bench_runner.h"
+#include "interpreter.h"
+#include "runtime.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Фиксированные затраты на запуск короткого скрипта: разбор и выполнение без самотестирования
+void BenchShortScriptLatency() {
+    const string program = "x = 1\nprint x + 1\n"s;
+    for (int i = 0; i < 10000; ++i) {
+        istringstream input(program);
+        ostringstream output;
+        RunMythonProgram(input, output);
+        DoNotOptimize(output);
+    }
+}
+
+// Большой сгенерированный скрипт, из которого вызывается только один метод
+const string& LargeScript() {
+    static const string program = [] {
+        string result;
+        for (int i = 0; i < 200; ++i) {
+            const string n = to_string(i);
+            result += "class C"s + n + ":\n  def __init__(v):\n    self.v = v\n"s
+                + "  def get():\n    if self.v > 0:\n      return self.v * 2 + 1\n    return 0\n"s;
+        }
+        for (int i = 0; i < 2000; ++i) {
+            result += "x"s + to_string(i) + " = "s + to_string(i) + " + 1\n"s;
+        }
+        result += "c = C0(1)\nprint c.get()\n"s;
+        return result;
+    }();
+    return program;
+}
+
+// Разбор большого сгенерированного скрипта
+void BenchParseLargeScript() {
+    istringstream input(LargeScript());
+    ostringstream output;
+    RunMythonProgram(input, output);
+    DoNotOptimize(output);
+}
+
+// Тот же скрипт с отложенным разбором тел методов
+void BenchParseLargeScriptLazy() {
+    ostringstream output;
+    runtime::SimpleContext context(output);
+    RunOptions options;
+    options.lazy_methods = true;
+    RunMythonProgram(LargeScript(), context, options);
+    DoNotOptimize(output);
+}
+
+// Длинный линейный скрипт, какие порождают генераторы кода
+const string& LinearScript() {
+    static const string program = [] {
+        string result;
+        for (int i = 0; i < 50000; ++i) {
+            const string n = to_string(i);
+            result += "x = "s + n + " * 2 + 1\nprint 'line', x\n"s;
+        }
+        return result;
+    }();
+    return program;
+}
+
+void RunLinearScript(bool streaming) {
+    ostringstream output;
+    runtime::SimpleContext context(output);
+    RunOptions options;
+    options.streaming = streaming;
+    RunMythonProgram(LinearScript(), context, options);
+    DoNotOptimize(output);
+}
+
+// Линейный скрипт, разобранный целиком перед выполнением
+void BenchLinearScript() {
+    RunLinearScript(false);
+}
+
+// Линейный скрипт, выполняемый по мере разбора
+void BenchLinearScriptStreaming() {
+    RunLinearScript(true);
+}
+
+// Пролог, объявляющий общие классы и строящий объекты конфигурации
+const string& Prelude() {
+    static const string prelude = [] {
+        string result;
+        for (int i = 0; i < 300; ++i) {
+            const string n = to_string(i);
+            result += "class P"s + n + ":\n  def __init__(v):\n    self.v = v\n    self.name = 'p"s + n + "'\n"s
+                + "  def get():\n    return self.v + "s + n + "\n"s;
+        }
+        for (int i = 0; i < 300; ++i) {
+            const string n = to_string(i);
+            result += "config"s + n + " = P"s + n + "("s + n + ")\n"s;
+        }
+        return result;
+    }();
+    return prelude;
+}
+
+const string SNAPSHOT_MAIN = "print config7.get(), config299.name\n"s;
+
+// Запуск, повторно выполняющий пролог перед основной программой
+void BenchPreludeFromSource() {
+    ostringstream output;
+    runtime::SimpleContext context(output);
+    RunOptions options;
+    options.lazy_methods = true;
+    RunMythonProgram(Prelude() + SNAPSHOT_MAIN, context, options);
+    DoNotOptimize(output);
+}
+
+// Запуск с состояния, восстановленного из снимка пролога
+void BenchPreludeFromSnapshot() {
+    static const string path = [] {
+        const string result = "/tmp/mython_bench.snap"s;
+        ostringstream output;
+        runtime::SimpleContext context(output);
+        SaveSnapshot(Prelude(), context, result);
+        return result;
+    }();
+
+    ostringstream output;
+    runtime::SimpleContext context(output);
+    RunOptions options;
+    options.snapshot_path = path;
+    RunMythonProgram(SNAPSHOT_MAIN, context, options);
+    DoNotOptimize(output);
+}
+
+void RunScript(const string& program) {
+    ostringstream output;
+    runtime::SimpleContext context(output);
+    RunMythonProgram(program, context, RunOptions{});
+    DoNotOptimize(output);
+}
+
+// Рекурсивное вычисление fib(22): около 57 тысяч вызовов методов с возвратом значения
+void BenchRecursiveFib() {
+    RunScript(R"(
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+f = Fib()
+print f.calc(22)
+)"s);
+}
+
+// Функция Аккермана A(2, 300): около 180 тысяч вызовов при глубине до 600
+void BenchAckermann() {
+    RunScript(R"(
+class Ackermann:
+  def calc(m, n):
+    if m == 0:
+      return n + 1
+    if n == 0:
+      return self.calc(m - 1, 1)
+    return self.calc(m - 1, self.calc(m, n - 1))
+
+a = Ackermann()
+print a.calc(2, 300)
+)"s);
+}
+
+// Счёт до 10 миллионов циклом while
+void BenchWhileCount() {
+    RunScript(R"(
+i = 0
+while i < 10000000:
+  i = i + 1
+print i
+)"s);
+}
+
+// Тот же счёт рекурсией, по вызову метода на шаг (хвостовые вызовы не растят стек)
+void BenchRecursiveCount() {
+    RunScript(R"(
+class Counter:
+  def count(i, n):
+    if i < n:
+      return self.count(i + 1, n)
+    return i
+
+c = Counter()
+print c.count(0, 10000000)
+)"s);
+}
+
+// Строка "Rect(120x45)" 200000 раз собирается выражением label
+string LabelScript(const string& label) {
+    return R"(
+class Rect:
+  def __init__(w, h):
+    self.w = w
+    self.h = h
+
+  def label():
+    return )"s + label + R"(
+
+r = Rect(120, 45)
+i = 0
+while i < 200000:
+  s = r.label()
+  i = i + 1
+print s
+)"s;
+}
+
+// Сцеплением строк: промежуточная строка на каждый + и str
+void BenchLabelConcat() {
+    RunScript(LabelScript(R"("Rect(" + str(self.w) + 'x' + str(self.h) + ')')"s));
+}
+
+// Форматной строкой: одна строка на результат
+void BenchLabelFormat() {
+    RunScript(LabelScript(R"--(f"Rect({self.w}x{self.h})")--"s));
+}
+
+}  // namespace
+
+void RunInterpreterBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, BenchShortScriptLatency);
+    RUN_BENCH(br, BenchParseLargeScript);
+    RUN_BENCH(br, BenchParseLargeScriptLazy);
+    RUN_BENCH(br, BenchLinearScript);
+    RUN_BENCH(br, BenchLinearScriptStreaming);
+    RUN_BENCH(br, BenchPreludeFromSource);
+    RUN_BENCH(br, BenchPreludeFromSnapshot);
+    RUN_BENCH(br, BenchRecursiveFib);
+    RUN_BENCH(br, BenchAckermann);
+    RUN_BENCH(br, BenchWhileCount);
+    RUN_BENCH(br, BenchRecursiveCount);
+    RUN_BENCH(br, BenchLabelConcat);
+    RUN_BENCH(br, BenchLabelFormat);
+}
@@ -0,0 +1,294 @@
+#include "interpreter.h"
+#include "lexer.h"
+#include "program_cache.h"
+#include "runtime.h"
+#include "test_runner.h"
+
+#include <cstdlib>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+void TestSimplePrints() {
+    istringstream input(R"(
+print 57
+print 10, 24, -8
+print 'hello'
+print "world"
+print True, False
+print
+print None
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
+}
+
+void TestAssignments() {
+    istringstream input(R"(
+x = 57
+print x
+x = 'C++ black belt'
+print x
+y = False
+x = y
+print x
+x = None
+print x, y
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
+}
+
+void TestArithmetics() {
+    istringstream input("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
+}
+
+void TestVariablesArePointers() {
+    istringstream input(R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add():
+    self.value = self.value + 1
+
+class Dummy:
+  def do_add(counter):
+    counter.add()
+
+x = Counter()
+y = x
+
+x.add()
+y.add()
+
+print x.value
+
+d = Dummy()
+d.do_add(x)
+
+print y.value
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "2\n3\n");
+}
+
+void TestStreamingExecution() {
+    const string program = R"(
+class Shape:
+  def __str__():
+    return 'Shape'
+
+class Rect(Shape):
+  def __init__(w):
+    self.w = w
+
+  def area():
+    return self.w * self.w
+
+r = Rect(3)
+print r, r.area()
+Shape = None
+Rect = 'gone'
+print r, r.area(), Rect
+)"s;
+    const string expected = "Shape 9\nShape 9 gone\n"s;
+
+    {
+        istringstream input(program);
+        ostringstream output;
+        runtime::SimpleContext context(output);
+        RunOptions options;
+        options.streaming = true;
+        RunMythonProgram(input, context, options);
+        ASSERT_EQUAL(output.str(), expected);
+    }
+    {
+        ostringstream output;
+        runtime::SimpleContext context(output);
+        RunOptions options;
+        options.streaming = true;
+        options.lazy_methods = true;
+        RunMythonProgram(program, context, options);
+        ASSERT_EQUAL(output.str(), expected);
+    }
+}
+
+// Ленивый разбор действует и при заданном каталоге кэша, как у интерпретатора по умолчанию:
+// синтаксическая ошибка в невызванном методе не мешает выполнению
+void TestLazyMethodsBypassCache() {
+    const string program = R"(
+class Broken:
+  def fine():
+    return 'fine'
+
+  def broken():
+    return = =
+
+b = Broken()
+print b.fine()
+)"s;
+    char dir_template[] = "/tmp/mython_lazy_XXXXXX";
+    ASSERT(mkdtemp(dir_template) != nullptr);
+    const string dir = dir_template;
+
+    RunOptions options;
+    options.cache_dir = dir;
+    options.lazy_methods = true;
+    ostringstream output;
+    runtime::SimpleContext context(output);
+    RunMythonProgram(program, context, options);
+    ASSERT_EQUAL(output.str(), "fine\n"s);
+
+    output.str({});
+    runtime::Closure globals;
+    CompiledProgram(program, options).Run(globals, context, options);
+    ASSERT_EQUAL(output.str(), "fine\n"s);
+
+    ASSERT(access(ast::ProgramCache(dir).EntryPath(program).c_str(), R_OK) != 0);
+    options.lazy_methods = false;
+    ASSERT_THROWS(RunMythonProgram(program, context, options), runtime_error);
+    rmdir(dir.c_str());
+}
+
+void TestStreamingRunsStatementsBeforeSyntaxError() {
+    istringstream input("print 1\nprint 2\nx = = 3\nprint 4\n"s);
+    ostringstream output;
+    runtime::SimpleContext context(output);
+    RunOptions options;
+    options.streaming = true;
+    ASSERT_THROWS(RunMythonProgram(input, context, options), parse::LexerError);
+    ASSERT_EQUAL(output.str(), "1\n2\n"s);
+
+    // Без потокового режима программа с ошибкой не выполняется совсем
+    istringstream whole("print 1\nprint 2\nx = = 3\nprint 4\n"s);
+    ostringstream whole_output;
+    ASSERT_THROWS(RunMythonProgram(whole, whole_output), parse::LexerError);
+    ASSERT_EQUAL(whole_output.str(), ""s);
+}
+
+void TestSnapshotStartup() {
+    char path[] = "/tmp/mython_snapshot_XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT(fd >= 0);
+    close(fd);
+
+    ostringstream prelude_output;
+    runtime::SimpleContext prelude_context(prelude_output);
+    SaveSnapshot(R"(
+class Counter:
+  def __init__(start):
+    self.value = start
+  def add():
+    self.value = self.value + 1
+    return self.value
+
+counter = Counter(10)
+greeting = 'hello'
+print 'prelude'
+)"sv, prelude_context, path);
+    ASSERT_EQUAL(prelude_output.str(), "prelude\n"s);
+
+    const string program = R"(
+print greeting, counter.add(), counter.add()
+class Twice(Counter):
+  def add():
+    self.value = self.value + 2
+    return self.value
+t = Twice(0)
+c = Counter(5)
+print t.add(), c.add()
+)"s;
+    const string expected = "hello 11 12\n2 6\n"s;
+
+    RunOptions options;
+    options.snapshot_path = path;
+    for (const bool streaming : {false, true}) {
+        options.streaming = streaming;
+        ostringstream output;
+        runtime::SimpleContext context(output);
+        RunMythonProgram(program, context, options);
+        ASSERT_EQUAL(output.str(), expected);
+
+        // Каждый запуск начинается с исходного состояния снимка
+        istringstream input(program);
+        ostringstream stream_output;
+        runtime::SimpleContext stream_context(stream_output);
+        RunMythonProgram(input, stream_context, options);
+        ASSERT_EQUAL(stream_output.str(), expected);
+    }
+
+    // Без снимка классы и переменные пролога недоступны
+    istringstream input(program);
+    ostringstream output;
+    ASSERT_THROWS(RunMythonProgram(input, output), runtime_error);
+
+    unlink(path);
+}
+
+void TestFormatStrings() {
+    const string program = R"--(
+class Rect:
+  def __init__(w, h):
+    self.w = w
+    self.h = h
+
+  def __str__():
+    return f"Rect({self.w}x{self.h})"
+
+  def describe(unit):
+    return f'{self} is {self.w * self.h} {unit}{{2}}, square: {self.w == self.h}'
+
+r = Rect(3, 4)
+d = {'key': [1, 2]}
+print r, r.describe('cm')
+print f"", f"no values", f"{d['key']} {d} {None} {-7} {f'{1 + 1}'} {Rect(1, 1)}"
+)--"s;
+    const string expected = "Rect(3x4) Rect(3x4) is 12 cm{2}, square: False\n"
+                            " no values [1, 2] {key: [1, 2]} None -7 2 Rect(1x1)\n"s;
+    RunOptions options;
+    for (const bool lazy : {false, true}) {
+        options.lazy_methods = lazy;
+        ostringstream output;
+        runtime::SimpleContext context(output);
+        RunMythonProgram(program, context, options);
+        ASSERT_EQUAL(output.str(), expected);
+    }
+
+    for (const string& bad : {"print f'{1 +}'\n"s, "print f'{x y}'\n"s, "print f'{x}\n"s, "print f'{Unknown()}'\n"s}) {
+        ostringstream output;
+        runtime::SimpleContext context(output);
+        ASSERT_THROWS(RunMythonProgram(bad, context, {}), runtime_error);
+    }
+}
+
+}  // namespace
+
+void RunInterpreterTests(TestRunner& tr) {
+    RUN_TEST(tr, TestSimplePrints);
+    RUN_TEST(tr, TestAssignments);
+    RUN_TEST(tr, TestArithmetics);
+    RUN_TEST(tr, TestVariablesArePointers);
+    RUN_TEST(tr, TestStreamingExecution);
+    RUN_TEST(tr, TestStreamingRunsStatementsBeforeSyntaxError);
+    RUN_TEST(tr, TestLazyMethodsBypassCache);
+    RUN_TEST(tr, TestSnapshotStartup);
+    RUN_TEST(tr, TestFormatStrings);
+}
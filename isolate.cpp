@@ -0,0 +1,536 @@
+#include "isolate.h"
+
+#include "call_stack.h"
+#include "coroutine.h"
+#include "dict.h"
+#include "heap.h"
+#include "list.h"
+#include "memory_budget.h"
+#include "output_context.h"
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        thread_local IsolateGroup* current_group = nullptr;
+
+        // Контекст изолята, накапливающий вывод команд print до вызова join
+        class IsolateContext : public Context {
+        public:
+            ostream& GetOutputStream() override {
+                return stream_;
+            }
+
+            void Write(string_view data) override {
+                output_.append(data);
+            }
+
+            void Flush() override {
+            }
+
+            string TakeOutput() {
+                return std::move(output_);
+            }
+
+        private:
+            string output_;
+            ContextStreamBuf stream_buf_{*this};
+            ostream stream_{&stream_buf_};
+        };
+
+        void CheckArgumentCount(const char* name, const vector<ObjectHolder>& args, size_t expected) {
+            if (args.size() != expected) {
+                throw runtime_error(string(name) + " takes "s + to_string(expected) + " argument(s), "s
+                                    + to_string(args.size()) + " given"s);
+            }
+        }
+    }  // namespace
+
+    enum class IsolatePhase : uint8_t {
+        Queued,
+        Running,
+        Done,
+    };
+
+    struct Isolate::State {
+        IsolateGroup* group = nullptr;
+        std::atomic<IsolatePhase> phase{IsolatePhase::Queued};
+        // Вызов, который выполняет изолят. Освобождается после выполнения
+        Message object;
+        std::string method;
+        std::vector<Message> args;
+        // Ограничения изолята подчинены ограничениям прогона. Через них группа прерывает изолят,
+        // если программа завершилась с ошибкой
+        ExecutionLimits limits;
+        // Бюджет памяти прогона либо nullptr
+        MemoryBudget* budget = nullptr;
+
+        std::mutex lock;
+        std::condition_variable done;
+        // Итог выполнения, доступен после перехода в IsolatePhase::Done
+        Message result;
+        bool failed = false;
+        std::string error;
+        // Причина остановки, если изолят остановлен ограничениями выполнения
+        std::optional<StopReason> stop_reason;
+        std::string output;
+        bool output_taken = false;
+    };
+
+    namespace {
+        void Complete(Isolate::State& state, Message result, bool failed, string error, string output,
+                      optional<StopReason> stop_reason = nullopt) {
+            {
+                lock_guard guard(state.lock);
+                state.object = {};
+                state.args.clear();
+                state.result = std::move(result);
+                state.failed = failed;
+                state.error = std::move(error);
+                state.stop_reason = stop_reason;
+                state.output = std::move(output);
+                state.phase.store(IsolatePhase::Done);
+            }
+            state.done.notify_all();
+        }
+
+        // Выполняет изолят в текущем потоке, если его ещё никто не начал выполнять
+        void RunIsolate(Isolate::State& state) {
+            IsolatePhase expected = IsolatePhase::Queued;
+            if (!state.phase.compare_exchange_strong(expected, IsolatePhase::Running)) {
+                return;
+            }
+            IsolateGroup::Scope scope(state.group);
+            MemoryBudget::Scope budget_scope(state.budget);
+            Message result;
+            bool failed = false;
+            string error;
+            optional<StopReason> stop_reason;
+            string output;
+            {
+                IsolateContext context;
+                // Задачи, запущенные изолятом, завершаются вместе с ним
+                CoroutineScheduler tasks;
+                CoroutineScheduler::Scope tasks_scope(&tasks);
+                try {
+                    context.SetLimits(&state.limits);
+                    ObjectHolder object = state.object.Unpack();
+                    vector<ObjectHolder> args;
+                    args.reserve(state.args.size());
+                    for (const Message& arg : state.args) {
+                        args.push_back(arg.Unpack());
+                    }
+                    ObjectHolder returned = object.TryAs<ClassInstance>()->Call(state.method, args, context);
+                    tasks.Finish();
+                    result = Message::Pack(returned);
+                } catch (const ExecutionStopped& e) {
+                    failed = true;
+                    error = e.what();
+                    stop_reason = e.GetReason();
+                } catch (const exception& e) {
+                    failed = true;
+                    error = e.what();
+                }
+                context.SetLimits(nullptr);
+                output = context.TakeOutput();
+            }
+            // Циклы, оставшиеся от изолята, не должны ждать следующей автоматической сборки,
+            // а кадры, сохранённые потоком пула, - держать память бюджета прогона
+            Heap::Current().Collect();
+            CallStack::Current().ReleaseFrames();
+            Complete(state, std::move(result), failed, std::move(error), std::move(output), stop_reason);
+        }
+
+        // Завершает изолят, который ещё не начал выполняться, не выполняя его
+        void CancelIsolate(Isolate::State& state) {
+            IsolatePhase expected = IsolatePhase::Queued;
+            if (state.phase.compare_exchange_strong(expected, IsolatePhase::Running)) {
+                Complete(state, {}, true, "Isolate cancelled"s, {});
+            }
+        }
+
+        void WaitIsolate(Isolate::State& state) {
+            unique_lock lock(state.lock);
+            if (state.phase.load() != IsolatePhase::Done) {
+                TaskScheduler::BlockingScope blocking;
+                state.done.wait(lock, [&state] {
+                    return state.phase.load() == IsolatePhase::Done;
+                });
+            }
+        }
+
+        // Возвращает вывод изолята, если его ещё никто не забрал
+        string TakeOutput(Isolate::State& state) {
+            lock_guard guard(state.lock);
+            if (state.output_taken) {
+                return {};
+            }
+            state.output_taken = true;
+            return std::move(state.output);
+        }
+    }  // namespace
+
+    Message Message::Pack(const ObjectHolder& value) {
+        Message message;
+        unordered_map<const Object*, size_t> indices;
+        // Экземпляры, списки и словари в порядке номеров; их содержимое запоминается после всех ранее найденных
+        vector<const Object*> found;
+
+        auto pack_value = [&](const ObjectHolder& object) -> Value {
+            if (object.TryAs<ClassInstance>() != nullptr || object.TryAs<List>() != nullptr
+                || object.TryAs<Dict>() != nullptr) {
+                const auto [it, inserted] = indices.emplace(object.Get(), found.size());
+                if (inserted) {
+                    found.push_back(object.Get());
+                }
+                return Value{{}, it->second};
+            }
+            if (object.TryAs<Isolate>() != nullptr) {
+                throw runtime_error("Isolate can not be passed to another isolate"s);
+            }
+            if (object.TryAs<Task>() != nullptr) {
+                throw runtime_error("Task can not be passed to another isolate"s);
+            }
+            return Value{object, NO_INSTANCE};
+        };
+
+        message.root_ = pack_value(value);
+        // Обход в ширину не углубляет стек на длинных цепочках экземпляров
+        for (size_t i = 0; i < found.size(); ++i) {
+            Instance packed;
+            if (const auto* list = dynamic_cast<const List*>(found[i])) {
+                packed.kind = Kind::List;
+                packed.items.reserve(list->GetSize());
+                for (size_t j = 0; j < list->GetSize(); ++j) {
+                    packed.items.push_back(pack_value(list->Get(j)));
+                }
+            }
+            else if (const auto* dict = dynamic_cast<const Dict*>(found[i])) {
+                packed.kind = Kind::Dict;
+                packed.items.reserve(dict->GetSize() * 2);
+                packed.hashes.reserve(dict->GetSize());
+                for (const Dict::Entry& entry : dict->GetEntries()) {
+                    packed.items.push_back(pack_value(entry.key));
+                    packed.items.push_back(pack_value(entry.value));
+                    packed.hashes.push_back(entry.hash);
+                }
+            }
+            else {
+                const auto* instance = static_cast<const ClassInstance*>(found[i]);
+                packed.cls = &instance->GetClass();
+                packed.fields.reserve(instance->Fields().size());
+                for (const auto& [name, field] : instance->Fields()) {
+                    packed.fields.emplace_back(name, pack_value(field));
+                }
+            }
+            message.instances_.push_back(std::move(packed));
+        }
+        return message;
+    }
+
+    ObjectHolder Message::Unpack() const {
+        vector<ObjectHolder> instances;
+        instances.reserve(instances_.size());
+        for (const Instance& instance : instances_) {
+            switch (instance.kind) {
+                case Kind::Instance:
+                    instances.push_back(ObjectHolder::Make<ClassInstance>(*instance.cls));
+                    break;
+                case Kind::List:
+                    instances.push_back(ObjectHolder::Make<List>());
+                    break;
+                case Kind::Dict:
+                    instances.push_back(ObjectHolder::Make<Dict>());
+                    break;
+            }
+        }
+        auto unpack_value = [&instances](const Value& value) {
+            return value.instance == NO_INSTANCE ? value.shared : instances[value.instance];
+        };
+        for (size_t i = 0; i < instances_.size(); ++i) {
+            if (instances_[i].kind == Kind::List) {
+                auto* list = instances[i].TryAs<List>();
+                for (const Value& item : instances_[i].items) {
+                    list->Append(unpack_value(item));
+                }
+                continue;
+            }
+            if (instances_[i].kind == Kind::Dict) {
+                // Методы __hash__ ключей не вызываются: у получателя нет контекста, а хеши уже известны
+                auto* dict = instances[i].TryAs<Dict>();
+                const vector<Value>& items = instances_[i].items;
+                for (size_t j = 0; j < instances_[i].hashes.size(); ++j) {
+                    dict->Restore(unpack_value(items[2 * j]), unpack_value(items[2 * j + 1]), instances_[i].hashes[j]);
+                }
+                continue;
+            }
+            Closure& fields = instances[i].TryAs<ClassInstance>()->Fields();
+            fields.reserve(instances_[i].fields.size());
+            for (const auto& [name, value] : instances_[i].fields) {
+                fields.emplace(name, unpack_value(value));
+            }
+        }
+        return unpack_value(root_);
+    }
+
+    Channel::Channel()
+        : state_(make_shared<State>()) {
+        if (IsolateGroup* group = IsolateGroup::Current()) {
+            group->AddChannel(state_);
+        }
+    }
+
+    ObjectHolder Channel::Call(const string& method, const vector<ObjectHolder>& args, [[maybe_unused]] Context& context) {
+        if (method == "send"sv) {
+            CheckArgumentCount("Channel.send", args, 1);
+            Send(Message::Pack(args.front()));
+            return ObjectHolder::None();
+        }
+        if (method == "receive"sv) {
+            CheckArgumentCount("Channel.receive", args, 0);
+            optional<Message> message = Receive();
+            return message ? message->Unpack() : ObjectHolder::None();
+        }
+        if (method == "close"sv) {
+            CheckArgumentCount("Channel.close", args, 0);
+            Close();
+            return ObjectHolder::None();
+        }
+        throw runtime_error("Channel has no method "s + method);
+    }
+
+    void Channel::Print(ostream& os, [[maybe_unused]] Context& context) {
+        os << "Channel"sv;
+    }
+
+    void Channel::Send(Message message) {
+        {
+            lock_guard guard(state_->lock);
+            if (state_->closed) {
+                throw runtime_error("Send to a closed channel"s);
+            }
+            state_->messages.push_back(std::move(message));
+        }
+        state_->ready.notify_one();
+    }
+
+    optional<Message> Channel::Receive() {
+        // Задачи этого потока ждут, уступая очередь друг другу, и не блокируют поток
+        CoroutineScheduler::WaitFor([this] {
+            lock_guard guard(state_->lock);
+            return !state_->messages.empty() || state_->closed;
+        });
+        unique_lock lock(state_->lock);
+        if (state_->messages.empty() && !state_->closed) {
+            TaskScheduler::BlockingScope blocking;
+            state_->ready.wait(lock, [this] {
+                return !state_->messages.empty() || state_->closed;
+            });
+        }
+        if (state_->messages.empty()) {
+            return nullopt;
+        }
+        Message message = std::move(state_->messages.front());
+        state_->messages.pop_front();
+        return message;
+    }
+
+    void Channel::Close() {
+        {
+            lock_guard guard(state_->lock);
+            state_->closed = true;
+        }
+        state_->ready.notify_all();
+    }
+
+    Isolate::Isolate(shared_ptr<State> state)
+        : state_(std::move(state)) {
+    }
+
+    ObjectHolder Isolate::Call(const string& method, const vector<ObjectHolder>& args, Context& context) {
+        if (method == "join"sv) {
+            CheckArgumentCount("Isolate.join", args, 0);
+            return Join(context);
+        }
+        throw runtime_error("Isolate has no method "s + method);
+    }
+
+    void Isolate::Print(ostream& os, [[maybe_unused]] Context& context) {
+        os << "Isolate"sv;
+    }
+
+    ObjectHolder Isolate::Join(Context& context) {
+        // Изолят из очереди выполняется здесь же: ожидание не занимает поток пула.
+        // Задача так не делает: её стек рассчитан на её собственные вызовы
+        if (Coroutine::Current() == nullptr) {
+            RunIsolate(*state_);
+        }
+        CoroutineScheduler::WaitFor([this] {
+            return state_->phase.load() == IsolatePhase::Done;
+        });
+        WaitIsolate(*state_);
+        if (const string output = TakeOutput(*state_); !output.empty()) {
+            context.Write(output);
+        }
+        if (state_->stop_reason) {
+            throw ExecutionStopped(*state_->stop_reason, state_->error);
+        }
+        if (state_->failed) {
+            throw runtime_error("Isolate failed: "s + state_->error);
+        }
+        return state_->result.Unpack();
+    }
+
+    IsolateGroup::~IsolateGroup() {
+        if (!finished_) {
+            WaitAll(nullptr);
+        }
+    }
+
+    IsolateGroup* IsolateGroup::Current() {
+        return current_group;
+    }
+
+    IsolateGroup::Scope::Scope(IsolateGroup* group)
+        : previous_(current_group) {
+        current_group = group;
+    }
+
+    IsolateGroup::Scope::~Scope() {
+        current_group = previous_;
+    }
+
+    void IsolateGroup::Finish(Context& context) {
+        finished_ = true;
+        if (optional<ExecutionStopped> stopped = WaitAll(&context)) {
+            throw *stopped;
+        }
+    }
+
+    ObjectHolder IsolateGroup::Spawn(const ObjectHolder& object, const string& method, const vector<ObjectHolder>& args) {
+        const auto* instance = object.TryAs<ClassInstance>();
+        if (instance == nullptr || !instance->HasMethod(method, args.size())) {
+            throw runtime_error("spawn: object has no method "s + method + " with "s + to_string(args.size())
+                                + " parameter(s)"s);
+        }
+        // Изолят учитывает память в бюджете прогона, а числа и строки программы передаются ему
+        // без копирования и могут освободиться в его потоке
+        MemoryBudget* budget = MemoryBudget::Current();
+        if (budget != nullptr) {
+            budget->Share();
+        }
+        auto state = make_shared<Isolate::State>();
+        state->group = this;
+        state->limits.SetParent(limits_);
+        state->budget = budget;
+        state->object = Message::Pack(object);
+        state->method = method;
+        state->args.reserve(args.size());
+        for (const ObjectHolder& arg : args) {
+            state->args.push_back(Message::Pack(arg));
+        }
+        {
+            lock_guard guard(lock_);
+            isolates_.push_back(state);
+        }
+        TaskScheduler::Shared().Submit([state] {
+            RunIsolate(*state);
+        });
+        return ObjectHolder::Make<Isolate>(std::move(state));
+    }
+
+    void IsolateGroup::AddChannel(const shared_ptr<Channel::State>& channel) {
+        lock_guard guard(lock_);
+        channels_.push_back(channel);
+    }
+
+    bool IsolateGroup::HasRunningIsolates() {
+        lock_guard guard(lock_);
+        return any_of(isolates_.begin(), isolates_.end(), [](const auto& isolate) {
+            return isolate->phase.load() != IsolatePhase::Done;
+        });
+    }
+
+    void IsolateGroup::CloseChannels() {
+        vector<shared_ptr<Channel::State>> channels;
+        {
+            lock_guard guard(lock_);
+            for (const auto& channel : channels_) {
+                if (auto alive = channel.lock()) {
+                    channels.push_back(std::move(alive));
+                }
+            }
+            channels_.clear();
+        }
+        for (const auto& channel : channels) {
+            {
+                lock_guard guard(channel->lock);
+                channel->closed = true;
+            }
+            channel->ready.notify_all();
+        }
+    }
+
+    void IsolateGroup::InterruptAll() {
+        lock_guard guard(lock_);
+        for (const auto& isolate : isolates_) {
+            CancelIsolate(*isolate);
+            isolate->limits.Interrupt();
+        }
+    }
+
+    optional<ExecutionStopped> IsolateGroup::WaitAll(Context* context) {
+        optional<ExecutionStopped> stopped;
+        bool aborted = context == nullptr;
+        if (aborted) {
+            InterruptAll();
+        }
+        for (size_t waited = 0;; ++waited) {
+            // Изоляты, ждущие данных из каналов, получают None и могут завершиться
+            CloseChannels();
+            shared_ptr<Isolate::State> isolate;
+            {
+                lock_guard guard(lock_);
+                if (waited < isolates_.size()) {
+                    isolate = isolates_[waited];
+                }
+            }
+            if (!isolate) {
+                break;
+            }
+            if (aborted) {
+                // Изоляты, запущенные после прерывания, не выполняются
+                CancelIsolate(*isolate);
+                isolate->limits.Interrupt();
+            }
+            else {
+                RunIsolate(*isolate);
+            }
+            WaitIsolate(*isolate);
+            if (aborted) {
+                continue;
+            }
+            if (const string output = TakeOutput(*isolate); !output.empty()) {
+                context->Write(output);
+            }
+            // Ограничения прогона исчерпаны: остальные изоляты прерываются, как при ошибке программы
+            if (isolate->stop_reason) {
+                stopped.emplace(*isolate->stop_reason, isolate->error);
+                aborted = true;
+                InterruptAll();
+            }
+        }
+        lock_guard guard(lock_);
+        isolates_.clear();
+        return stopped;
+    }
+
+}  // namespace runtime
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "execution_limits.h"
+#include "runtime.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace runtime {
+
+    /*
+     * Значение, переданное из одного изолята в другой.
+     * Экземпляры классов нельзя передавать между потоками (см. Heap), поэтому они копируются вместе со всеми
+     * экземплярами, достижимыми через поля: Pack запоминает граф экземпляров в потоке отправителя, а Unpack
+     * создаёт его копию в куче потока получателя. Списки и словари изменяемы и тоже копируются вместе с элементами.
+     * Общие ссылки и циклы между экземплярами, списками и словарями сохраняются.
+     * Числа, строки и логические значения не изменяются, а каналы синхронизированы, поэтому они передаются
+     * без копирования. Классы экземпляров тоже не копируются: их определения неизменны и разделяются
+     * всеми изолятами программы
+     */
+    class Message {
+    public:
+        // Запоминает value. Если value ссылается на изолят, выбрасывает runtime_error
+        [[nodiscard]] static Message Pack(const ObjectHolder& value);
+        // Создаёт копию значения в текущем потоке. Одно сообщение можно распаковать несколько раз
+        [[nodiscard]] ObjectHolder Unpack() const;
+
+    private:
+        static constexpr size_t NO_INSTANCE = static_cast<size_t>(-1);
+
+        // Значение без копирования либо номер экземпляра, списка или словаря в instances_
+        struct Value {
+            ObjectHolder shared;
+            size_t instance = NO_INSTANCE;
+        };
+
+        enum class Kind : uint8_t {
+            Instance,
+            List,
+            Dict,
+        };
+
+        // Экземпляр класса cls с полями fields, список с элементами items либо словарь,
+        // ключи и значения которого чередуются в items, а хеши ключей лежат в hashes
+        struct Instance {
+            Kind kind = Kind::Instance;
+            const Class* cls = nullptr;
+            std::vector<std::pair<std::string, Value>> fields;
+            std::vector<Value> items;
+            std::vector<uint32_t> hashes;
+        };
+
+        Value root_;
+        std::vector<Instance> instances_;
+    };
+
+    class IsolateGroup;
+
+    /*
+     * Канал для обмена значениями между изолятами, создаётся в программе вызовом Channel().
+     * Методы в программе:
+     *   send(value) - передаёт копию value (см. Message). Отправка в закрытый канал - ошибка;
+     *   receive() - возвращает очередное значение, дожидаясь его. Из закрытого пустого канала возвращает None;
+     *   close() - закрывает канал.
+     * Канал не ограничивает число ожидающих значений. Его можно передавать в другие изоляты
+     */
+    class Channel : public NativeObject {
+    public:
+        // Создаёт канал. Канал закрывается при завершении программы, если создан внутри группы изолятов
+        Channel();
+
+        ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& args, Context& context) override;
+        void Print(std::ostream& os, Context& context) override;
+
+        // Отправляет сообщение. Если канал закрыт, выбрасывает runtime_error
+        void Send(Message message);
+        // Возвращает очередное сообщение либо nullopt, если канал закрыт и пуст
+        std::optional<Message> Receive();
+        void Close();
+
+    private:
+        friend class IsolateGroup;
+
+        struct State {
+            std::mutex lock;
+            std::condition_variable ready;
+            std::deque<Message> messages;
+            bool closed = false;
+        };
+
+        std::shared_ptr<State> state_;
+    };
+
+    /*
+     * Изолят - вызов метода экземпляра класса в отдельном потоке пула (см. TaskScheduler), запускается
+     * в программе вызовом spawn(object.method, args...). Экземпляр и параметры копируются в изолят (см. Message),
+     * поэтому изолят работает со своей кучей экземпляров и не видит переменных программы. Значения между
+     * программой и изолятами передаются через каналы и результат метода.
+     *
+     * Метод join() дожидается завершения изолята и возвращает копию результата метода. Если изолят
+     * ещё не начал выполняться, join выполняет его в своём потоке. Вывод команд print изолята накапливается
+     * и добавляется в вывод того, кто первым вызвал join. Ошибка изолята выбрасывается из join.
+     *
+     * Изоляты подчиняются ограничениям выполнения прогона: их шаги расходуют общий бюджет шагов,
+     * а крайний срок и прерывание прогона останавливают и их (см. ExecutionLimits::SetParent).
+     * Объекты изолята учитываются в бюджете памяти прогона. Изолят, остановленный ограничениями,
+     * останавливает всю программу: join выбрасывает ExecutionStopped, как и завершение программы
+     */
+    class Isolate : public NativeObject {
+    public:
+        struct State;
+
+        explicit Isolate(std::shared_ptr<State> state);
+
+        ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& args, Context& context) override;
+        void Print(std::ostream& os, Context& context) override;
+
+        // Дожидается завершения изолята и возвращает копию результата. Вывод изолята передаётся в context
+        ObjectHolder Join(Context& context);
+
+    private:
+        std::shared_ptr<State> state_;
+    };
+
+    /*
+     * Группа изолятов и каналов одного прогона программы. Изоляты и каналы, созданные при выполнении
+     * программы и её изолятов, попадают в группу, подключённую к потоку через Scope.
+     * Изоляты выполняют методы классов из дерева программы, поэтому группа должна завершиться раньше,
+     * чем дерево будет освобождено
+     */
+    class IsolateGroup {
+    public:
+        // Группа, изоляты которой подчиняются ограничениям выполнения limits. nullptr - без ограничений
+        explicit IsolateGroup(ExecutionLimits* limits = nullptr)
+            : limits_(limits) {
+        }
+        // Если Finish не вызван (программа прервана), прерывает оставшиеся изоляты, закрывает каналы
+        // и дожидается завершения изолятов
+        ~IsolateGroup();
+
+        IsolateGroup(const IsolateGroup&) = delete;
+        IsolateGroup& operator=(const IsolateGroup&) = delete;
+
+        // Возвращает группу, подключённую к текущему потоку, либо nullptr
+        static IsolateGroup* Current();
+
+        // Подключает группу к текущему потоку на время своей жизни
+        class Scope {
+        public:
+            explicit Scope(IsolateGroup* group);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            IsolateGroup* previous_;
+        };
+
+        // Завершает программу: закрывает каналы и дожидается изолятов. Вывод изолятов, для которых
+        // не вызывался join, добавляется в context в порядке их запуска. Если изолят остановлен ограничениями
+        // выполнения, прерывает остальные и выбрасывает ExecutionStopped
+        void Finish(Context& context);
+
+        // Запускает в группе изолят, вызывающий object.method(args). Если у object нет метода method
+        // с таким числом параметров, выбрасывает runtime_error
+        ObjectHolder Spawn(const ObjectHolder& object, const std::string& method, const std::vector<ObjectHolder>& args);
+
+        // Возвращает true, если есть изоляты, которые ещё не завершились
+        [[nodiscard]] bool HasRunningIsolates();
+        // Закрывает каналы группы. Ожидающие получатели получают None
+        void CloseChannels();
+
+    private:
+        friend class Channel;
+
+        void AddChannel(const std::shared_ptr<Channel::State>& channel);
+        // Закрывает каналы и дожидается всех изолятов, в том числе запущенных во время ожидания.
+        // Возвращает ошибку первого изолята, остановленного ограничениями выполнения
+        std::optional<ExecutionStopped> WaitAll(Context* context);
+        // Отменяет изоляты, которые ещё не начали выполняться, и прерывает выполняющиеся
+        void InterruptAll();
+
+        ExecutionLimits* limits_;
+        std::mutex lock_;
+        std::vector<std::shared_ptr<Isolate::State>> isolates_;
+        std::vector<std::weak_ptr<Channel::State>> channels_;
+        bool finished_ = false;
+    };
+
+}  // namespace runtime
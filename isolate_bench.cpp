@@ -0,0 +1,98 @@
+#include "bench_runner.h"
+#include "interpreter.h"
+#include "isolate.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+const string FIB_CLASS = R"(
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+  def chain(k, n):
+    if k > 0:
+      return self.calc(n) + self.chain(k - 1, n)
+    return 0
+
+f = Fib()
+)"s;
+
+// Число одинаковых вычислений: по два на ядро
+size_t Jobs() {
+    return 2 * max(thread::hardware_concurrency(), 1U);
+}
+
+void RunProgram(const string& program) {
+    ostringstream out;
+    SimpleContext context(out);
+    RunMythonProgram(program, context, RunOptions{});
+    DoNotOptimize(out);
+}
+
+// Jobs() вычислений fib(20) подряд в программе и в изолятах. На одном ядре изоляты добавляют только
+// стоимость копирования и планирования, на нескольких - ускоряют программу почти пропорционально ядрам
+void BenchIsolatesScaling(BenchRunner& br) {
+    const string sequential = FIB_CLASS + "print f.chain("s + to_string(Jobs()) + ", 20)\n"s;
+    string parallel = FIB_CLASS;
+    for (size_t i = 0; i < Jobs(); ++i) {
+        parallel += "w"s + to_string(i) + " = spawn(f.calc, 20)\n"s;
+    }
+    for (size_t i = 0; i < Jobs(); ++i) {
+        parallel += "print w"s + to_string(i) + ".join()\n"s;
+    }
+    br.RunBench([&] { RunProgram(sequential); }, "BenchIsolatesScaling/sequential"s);
+    br.RunBench([&] { RunProgram(parallel); }, "BenchIsolatesScaling/isolates"s);
+}
+
+// Двадцать передач связного списка из 1000 экземпляров в изолят и обратно: упаковка графа экземпляров
+// и создание его копии в куче получателя
+void BenchChannelTransfer() {
+    string program = R"(
+class Node:
+  def __init__(value, next):
+    self.value = value
+    self.next = next
+
+class Builder:
+  def build(n, tail):
+    if n > 0:
+      return self.build(n - 1, Node(n, tail))
+    return tail
+
+class Relay:
+  def relay(input, output, times):
+    if times > 0:
+      output.send(input.receive())
+      self.relay(input, output, times - 1)
+
+b = Builder()
+list = b.build(1000, None)
+input = Channel()
+output = Channel()
+r = Relay()
+worker = spawn(r.relay, input, output, 20)
+)"s;
+    for (int i = 0; i < 20; ++i) {
+        program += "input.send(list)\ncopy = output.receive()\n"s;
+    }
+    RunProgram(program + "worker.join()\n"s);
+}
+
+}  // namespace
+
+void RunIsolateBenchmarks(BenchRunner& br) {
+    BenchIsolatesScaling(br);
+    RUN_BENCH(br, BenchChannelTransfer);
+}
+
+}  // namespace runtime
@@ -0,0 +1,347 @@
+#include "heap.h"
+#include "interpreter.h"
+#include "isolate.h"
+#include "memory_budget.h"
+#include "parse.h"
+#include "task_scheduler.h"
+#include "test_program.h"
+#include "test_runner.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestIsolatesReturnResults() {
+    const string program = R"(
+class Summer:
+  def __init__(base):
+    self.base = base
+
+  def sum(n):
+    if n > 0:
+      return n + self.sum(n - 1)
+    return self.base
+
+  def report(n):
+    print 'summing', n
+    return self.sum(n)
+
+s = Summer(1000)
+a = spawn(s.report, 10)
+b = spawn(s.sum, 100)
+print 'main'
+print a.join(), b.join()
+print a.join()
+)"s;
+    // Вывод изолята появляется в месте первого join, а не вперемешку с выводом программы
+    ASSERT_EQUAL(Run(program), "main\nsumming 10\n1055 6050\n1055\n"s);
+}
+
+void TestIsolateWorksOnCopy() {
+    const string program = R"(
+class Node:
+  def __init__(value):
+    self.value = value
+    self.next = None
+
+  def bump():
+    self.value = self.value + 1
+    other = self.next
+    other.value = other.value + 1
+    return self
+
+a = Node(1)
+b = Node(10)
+a.next = b
+b.next = a
+i = spawn(a.bump)
+r = i.join()
+n = r.next
+m = n.next
+print a.value, b.value
+print r.value, n.value, m.value
+)"s;
+    ASSERT_EQUAL(Run(program), "1 10\n2 11 2\n"s);
+}
+
+void TestMessagePreservesSharingAndCycles() {
+    Class cls("Pair"s, {}, nullptr);
+    ObjectHolder first = ObjectHolder::Make<ClassInstance>(cls);
+    ObjectHolder second = ObjectHolder::Make<ClassInstance>(cls);
+    ObjectHolder text = ObjectHolder::Own(String("shared"s));
+    first.TryAs<ClassInstance>()->Fields()["peer"s] = second;
+    first.TryAs<ClassInstance>()->Fields()["text"s] = text;
+    second.TryAs<ClassInstance>()->Fields()["peer"s] = first;
+    second.TryAs<ClassInstance>()->Fields()["same"s] = first;
+
+    const Message message = Message::Pack(first);
+    ObjectHolder copy = message.Unpack();
+    auto* copy_first = copy.TryAs<ClassInstance>();
+    ASSERT(copy_first != nullptr);
+    ASSERT(copy_first != first.TryAs<ClassInstance>());
+    ASSERT_EQUAL(&copy_first->GetClass(), &cls);
+    // Неизменяемые значения не копируются
+    ASSERT_EQUAL(copy_first->Fields().at("text"s).Get(), text.Get());
+
+    auto* copy_second = copy_first->Fields().at("peer"s).TryAs<ClassInstance>();
+    ASSERT(copy_second != second.TryAs<ClassInstance>());
+    ASSERT_EQUAL(copy_second->Fields().at("peer"s).Get(), copy.Get());
+    ASSERT_EQUAL(copy_second->Fields().at("same"s).Get(), copy.Get());
+
+    // Каждая распаковка создаёт новую копию
+    ObjectHolder another = message.Unpack();
+    ASSERT(another.Get() != copy.Get());
+
+    for (const ObjectHolder& holder : {first, second, copy, another}) {
+        holder.TryAs<ClassInstance>()->Fields().clear();
+    }
+}
+
+void TestChannelsConnectIsolates() {
+    const string program = R"(
+class Producer:
+  def produce(ch, n):
+    if n > 0:
+      ch.send(n)
+      self.produce(ch, n - 1)
+    else:
+      ch.close()
+
+class Consumer:
+  def consume(ch, n):
+    if n > 0:
+      return ch.receive() + self.consume(ch, n - 1)
+    return 0
+
+ch = Channel()
+consumer = Consumer()
+c = spawn(consumer.consume, ch, 100)
+producer = Producer()
+spawn(producer.produce, ch, 100)
+print c.join()
+print ch.receive()
+)"s;
+    ASSERT_EQUAL(Run(program), "5050\nNone\n"s);
+}
+
+void TestIsolateErrors() {
+    const string failing = R"(
+class Divider:
+  def divide(n):
+    print 'dividing'
+    return 1 / n
+
+d = Divider()
+ok = spawn(d.divide, 4)
+failed = spawn(d.divide, 0)
+print ok.join()
+print failed.join()
+)"s;
+    ostringstream out;
+    SimpleContext context(out);
+    try {
+        RunMythonProgram(failing, context, RunOptions{});
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("Isolate failed"s) != string::npos);
+    }
+    ASSERT_EQUAL(out.str(), "dividing\n0\ndividing\n"s);
+
+    const string send_isolate = R"(
+class Idle:
+  def run():
+    return 0
+
+i = Idle()
+ch = Channel()
+ch.send(spawn(i.run))
+)"s;
+    try {
+        Run(send_isolate);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("Isolate can not be passed"s) != string::npos);
+    }
+
+    try {
+        Run("class A:\n  def run():\n    return 0\n\na = A()\nspawn(a.missing)\n"s);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("no method missing"s) != string::npos);
+    }
+
+    try {
+        Run("x = spawn(1)\n"s);
+        ASSERT(false);
+    } catch (const ParseError&) {
+    }
+}
+
+void TestProgramEndFinishesIsolates() {
+    const string program = R"(
+class Waiter:
+  def wait(ch):
+    print 'got', ch.receive()
+
+w = Waiter()
+ch = Channel()
+spawn(w.wait, ch)
+print 'main done'
+)"s;
+    // Канал закрывается по окончании программы, и ожидающий изолят получает None
+    ASSERT_EQUAL(Run(program), "main done\ngot None\n"s);
+}
+
+void TestFailedProgramInterruptsIsolates() {
+    const string program = R"(
+class Tree:
+  def walk(n):
+    if n > 0:
+      self.walk(n - 1)
+      self.walk(n - 1)
+
+t = Tree()
+spawn(t.walk, 40)
+print 1 / 0
+)"s;
+    const auto start = chrono::steady_clock::now();
+    try {
+        Run(program);
+        ASSERT(false);
+    } catch (const runtime_error&) {
+    }
+    ASSERT(chrono::steady_clock::now() - start < 10s);
+}
+
+// Изолят с бесконечным циклом останавливается ограничениями прогона, а не подвешивает завершение программы
+void TestIsolatesObeyRunLimits() {
+    const string program = R"(
+class Worker:
+  def loop():
+    x = 0
+    while True:
+      x = x + 1
+
+w = Worker()
+spawn(w.loop)
+print 'spawned'
+)"s;
+    for (const StopReason reason : {StopReason::Steps, StopReason::Deadline}) {
+        ExecutionLimits limits;
+        if (reason == StopReason::Steps) {
+            limits.SetStepLimit(100000);
+        }
+        else {
+            limits.SetTimeout(50ms);
+        }
+        RunOptions options;
+        options.limits = &limits;
+        const auto start = chrono::steady_clock::now();
+        try {
+            Run(program, options);
+            ASSERT(false);
+        } catch (const ExecutionStopped& e) {
+            ASSERT(e.GetReason() == reason);
+        }
+        ASSERT(chrono::steady_clock::now() - start < 10s);
+    }
+}
+
+// Память изолята учитывается в бюджете прогона
+void TestIsolatesChargeRunBudget() {
+    const string program = R"(
+class Grow:
+  def run(s, n):
+    if n > 0:
+      return self.run(s + s, n - 1)
+    return s
+
+g = Grow()
+t = spawn(g.run, 'abcdefgh', 20)
+print len(t.join())
+)"s;
+    MemoryBudget budget(1 << 20);
+    RunOptions options;
+    options.memory_budget = &budget;
+    try {
+        Run(program, options);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT(string(e.what()).find("Memory limit"s) != string::npos);
+    }
+    ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+    ASSERT(budget.GetPeakBytes(MemoryKind::String) > budget.GetLimit() / 4);
+}
+
+void TestSchedulerAddsThreadsForBlockedTasks() {
+    TaskScheduler scheduler(1);
+    mutex lock;
+    condition_variable changed;
+    bool ready = false;
+    bool done = false;
+    scheduler.Submit([&] {
+        TaskScheduler::BlockingScope blocking;
+        unique_lock guard(lock);
+        changed.wait(guard, [&] {
+            return ready;
+        });
+        done = true;
+        changed.notify_all();
+    });
+    // Единственный поток пула занят ожиданием, вторую задачу выполняет добавленный поток
+    scheduler.Submit([&] {
+        lock_guard guard(lock);
+        ready = true;
+        changed.notify_all();
+    });
+    unique_lock guard(lock);
+    ASSERT(changed.wait_for(guard, 10s, [&] {
+        return done;
+    }));
+    ASSERT(scheduler.GetThreadCount() >= 2U);
+}
+
+void TestSchedulerRunsNestedTasks() {
+    TaskScheduler scheduler(4);
+    atomic<int> counter{0};
+    for (int i = 0; i < 100; ++i) {
+        scheduler.Submit([&] {
+            for (int j = 0; j < 10; ++j) {
+                scheduler.Submit([&] {
+                    counter.fetch_add(1);
+                });
+            }
+        });
+    }
+    while (counter.load() < 1000) {
+        this_thread::yield();
+    }
+    ASSERT_EQUAL(counter.load(), 1000);
+}
+
+}  // namespace
+
+void RunIsolateTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestIsolatesReturnResults);
+    RUN_TEST(tr, runtime::TestIsolateWorksOnCopy);
+    RUN_TEST(tr, runtime::TestMessagePreservesSharingAndCycles);
+    RUN_TEST(tr, runtime::TestChannelsConnectIsolates);
+    RUN_TEST(tr, runtime::TestIsolateErrors);
+    RUN_TEST(tr, runtime::TestProgramEndFinishesIsolates);
+    RUN_TEST(tr, runtime::TestFailedProgramInterruptsIsolates);
+    RUN_TEST(tr, runtime::TestIsolatesObeyRunLimits);
+    RUN_TEST(tr, runtime::TestIsolatesChargeRunBudget);
+    RUN_TEST(tr, runtime::TestSchedulerAddsThreadsForBlockedTasks);
+    RUN_TEST(tr, runtime::TestSchedulerRunsNestedTasks);
+}
+
+}  // namespace runtime
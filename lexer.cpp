@@ -23,6 +23,9 @@ namespace parse {
         if (lhs.Is<String>()) {
             return lhs.As<String>().value == rhs.As<String>().value;
         }
+        if (lhs.Is<FormatString>()) {
+            return lhs.As<FormatString>().parts == rhs.As<FormatString>().parts;
+        }
         if (lhs.Is<Id>()) {
             return lhs.As<Id>().value == rhs.As<Id>().value;
         }
@@ -46,6 +49,14 @@ namespace parse {
 
 #undef VALUED_OUTPUT
 
+        if (auto p = rhs.TryAs<FormatString>()) {
+            os << "FormatString{"sv;
+            for (size_t i = 0; i < p->parts.size(); ++i) {
+                os << (i % 2 == 1 ? "{"sv : ""sv) << p->parts[i] << (i % 2 == 1 ? "}"sv : ""sv);
+            }
+            return os << '}';
+        }
+
 #define UNVALUED_OUTPUT(type) \
     if (rhs.Is<type>()) return os << #type;
 
@@ -68,6 +79,12 @@ namespace parse {
         UNVALUED_OUTPUT(None);
         UNVALUED_OUTPUT(True);
         UNVALUED_OUTPUT(False);
+        UNVALUED_OUTPUT(Yield);
+        UNVALUED_OUTPUT(While);
+        UNVALUED_OUTPUT(Break);
+        UNVALUED_OUTPUT(Continue);
+        UNVALUED_OUTPUT(For);
+        UNVALUED_OUTPUT(In);
         UNVALUED_OUTPUT(Eof);
 
 #undef UNVALUED_OUTPUT
@@ -88,6 +105,10 @@ namespace parse {
         return token_;
     }
 
+    std::streamoff Lexer::InputPosition() const {
+        return input_.tellg();
+    }
+
     void Lexer::LoadNewline() {
         if (!new_line_) {
             new_line_ = true;
@@ -175,6 +196,14 @@ namespace parse {
             [[fallthrough]];
         case ')':
             [[fallthrough]];
+        case '[':
+            [[fallthrough]];
+        case ']':
+            [[fallthrough]];
+        case '{':
+            [[fallthrough]];
+        case '}':
+            [[fallthrough]];
         case '!':
             [[fallthrough]];
         case ':':
@@ -212,7 +241,10 @@ namespace parse {
         new_line_ = false;
         std::string word = GetString();
 
-        if (tokens.find(word) != tokens.end()) {
+        if (word == "f"sv && (input_.peek() == '"' || input_.peek() == '\'')) {
+            LoadFormatString(static_cast<char>(input_.get()));
+        }
+        else if (tokens.find(word) != tokens.end()) {
             token_ = tokens.at(word);
         }
         else {
@@ -268,25 +300,94 @@ namespace parse {
             if (c == first) {
                 break;
             }
-            if (c == '\\' && (input_.peek() == '\"' || input_.peek() == '\'')) {
-                result.push_back(input_.get());
+            AppendStringChar(c, result);
+        }
+
+        token_type::String s;
+        s.value = result;
+        token_ = s;
+    }
+
+    void Lexer::AppendStringChar(char c, std::string& result) {
+        if (c == '\\' && (input_.peek() == '\"' || input_.peek() == '\'')) {
+            result.push_back(static_cast<char>(input_.get()));
+        }
+        else if (c == '\\' && input_.peek() == 'n') {
+            input_.get();
+            result.push_back('\n');
+        }
+        else if (c == '\\' && input_.peek() == 't') {
+            input_.get();
+            result.push_back('\t');
+        }
+        else {
+            result.push_back(c);
+        }
+    }
+
+    // Фигурные скобки удваиваются, чтобы попасть в строку: f"{{x}}" - это строка {x}
+    void Lexer::LoadFormatString(char first) {
+        char c;
+        token_type::FormatString s;
+        s.parts.emplace_back();
+
+        new_line_ = false;
+
+        while (input_.get(c)) {
+            if (c == first) {
+                break;
             }
-            else if (c == '\\' && input_.peek() == 'n') {
+            if ((c == '{' || c == '}') && input_.peek() == c) {
                 input_.get();
-                result.push_back('\n');
+                s.parts.back().push_back(c);
             }
-            else if (c == '\\' && input_.peek() == 't') {
-                input_.get();
-                result.push_back('\t');
+            else if (c == '{') {
+                s.parts.push_back(LoadFormatExpression(first));
+                s.parts.emplace_back();
+            }
+            else if (c == '}') {
+                throw LexerError("Single '}' in format string"s);
             }
             else {
-                result.push_back(c);
+                AppendStringChar(c, s.parts.back());
             }
         }
 
-        token_type::String s;
-        s.value = result;
-        token_ = s;
+        token_ = std::move(s);
+    }
+
+    // Выражение может содержать скобки и строковые константы в кавычках, отличных от кавычек самой строки.
+    // Закрывающая фигурная скобка внутри них выражение не заканчивает
+    std::string Lexer::LoadFormatExpression(char quote) {
+        std::string result;
+        int depth = 0;
+        char in_string = 0;
+        char c;
+        while (true) {
+            if (!input_.get(c) || c == '\n' || c == quote) {
+                throw LexerError("Unterminated expression in format string"s);
+            }
+            if (in_string != 0) {
+                in_string = c == in_string ? 0 : in_string;
+            }
+            else if (c == '\'' || c == '"') {
+                in_string = c;
+            }
+            else if (c == '(' || c == '[' || c == '{') {
+                ++depth;
+            }
+            else if (c == ')' || c == ']' || (c == '}' && depth > 0)) {
+                --depth;
+            }
+            else if (c == '}') {
+                break;
+            }
+            result.push_back(c);
+        }
+        if (result.find_first_not_of(' ') == std::string::npos) {
+            throw LexerError("Empty expression in format string"s);
+        }
+        return result;
     }
 
     void Lexer::LoadComment() {
@@ -7,6 +7,7 @@
 #include <stdexcept>
 #include <string>
 #include <variant>
+#include <vector>
 
 namespace parse {
 
@@ -27,6 +28,12 @@ namespace parse {
             std::string value;
         };
 
+        struct FormatString {  // Лексема «форматная строка» f"Rect({self.w}x{self.h})"
+            // Постоянные части строки на чётных местах и исходный текст выражений в фигурных скобках на нечётных:
+            // {"Rect(", "self.w", "x", "self.h", ")"}
+            std::vector<std::string> parts;
+        };
+
         struct Class {};    // Лексема «class»
         struct Return {};   // Лексема «return»
         struct If {};       // Лексема «if»
@@ -47,15 +54,22 @@ namespace parse {
         struct None {};         // Лексема «None»
         struct True {};         // Лексема «True»
         struct False {};        // Лексема «False»
+        struct Yield {};        // Лексема «yield»
+        struct While {};        // Лексема «while»
+        struct Break {};        // Лексема «break»
+        struct Continue {};     // Лексема «continue»
+        struct For {};          // Лексема «for»
+        struct In {};           // Лексема «in»
     }  // namespace token_type
 
     using TokenBase
-        = std::variant<token_type::Number, token_type::Id, token_type::Char, token_type::String,
+        = std::variant<token_type::Number, token_type::Id, token_type::Char, token_type::String, token_type::FormatString,
         token_type::Class, token_type::Return, token_type::If, token_type::Else,
         token_type::Def, token_type::Newline, token_type::Print, token_type::Indent,
         token_type::Dedent, token_type::And, token_type::Or, token_type::Not,
         token_type::Eq, token_type::NotEq, token_type::LessOrEq, token_type::GreaterOrEq,
-        token_type::None, token_type::True, token_type::False, token_type::Eof>;
+        token_type::None, token_type::True, token_type::False, token_type::Yield, token_type::While,
+        token_type::Break, token_type::Continue, token_type::For, token_type::In, token_type::Eof>;
 
     struct Token : TokenBase {
         using TokenBase::TokenBase;
@@ -96,6 +110,10 @@ namespace parse {
         // Возвращает следующий токен, либо token_type::Eof, если поток токенов закончился
         Token NextToken();
 
+        // Возвращает смещение во входном потоке, с которого продолжится чтение,
+        // либо -1, если поток не поддерживает позиционирование или уже исчерпан
+        [[nodiscard]] std::streamoff InputPosition() const;
+
         // Если текущий токен имеет тип T, метод возвращает ссылку на него.
         // В противном случае метод выбрасывает исключение LexerError
         template <typename T>
@@ -151,6 +169,12 @@ namespace parse {
         void LoadNumber();
 
         void LoadString(char first);
+        // Читает форматную строку после префикса f и открывающей кавычки first
+        void LoadFormatString(char first);
+        // Добавляет к result символ c строковой константы, заменяя экранированную последовательность
+        void AppendStringChar(char c, std::string& result);
+        // Читает выражение форматной строки до закрывающей фигурной скобки
+        std::string LoadFormatExpression(char quote);
 
         void LoadComment();
 
@@ -162,17 +186,23 @@ namespace parse {
         using namespace std::literals;
         const std::map<std::string, Token> tokens{
             {"and"s, token_type::And()},
+            {"break"s, token_type::Break()},
             {"class"s, token_type::Class()},
+            {"continue"s, token_type::Continue()},
             {"def"s, token_type::Def()},
             {"else"s, token_type::Else()},
             {"False"s, token_type::False()},
+            {"for"s, token_type::For()},
             {"if"s, token_type::If()},
+            {"in"s, token_type::In()},
             {"None"s, token_type::None()},
             {"not"s, token_type::Not()},
             {"or"s, token_type::Or()},
             {"print"s, token_type::Print()},
             {"return"s, token_type::Return()},
-            {"True"s, token_type::True()}
+            {"True"s, token_type::True()},
+            {"while"s, token_type::While()},
+            {"yield"s, token_type::Yield()}
         };
     }
 
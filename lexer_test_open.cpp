@@ -77,6 +77,25 @@ void TestStrings() {
                  Token(token_type::String{"another long string with single quote ' inside"s}));
 }
 
+void TestFormatStrings() {
+    istringstream input(R"--(f"Rect({self.w}x{self.h})" f'' f'{{a}} {d["}"]} \'{f(x, [1])}' f x)--"s);
+    Lexer lexer(input);
+
+    ASSERT_EQUAL(lexer.CurrentToken(),
+                 Token(token_type::FormatString{{"Rect("s, "self.w"s, "x"s, "self.h"s, ")"s}}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::FormatString{{""s}}));
+    ASSERT_EQUAL(lexer.NextToken(),
+                 Token(token_type::FormatString{{"{a} "s, R"(d["}"])"s, " '"s, "f(x, [1])"s, ""s}}));
+    // Без кавычки сразу после f это обычный идентификатор
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"f"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"x"s}));
+
+    for (const string& bad : {"f'{x'"s, "f'{'"s, "f'a}b'"s, "f'{}'"s, "f'{  }'"s, "f'{x\n}'"s}) {
+        istringstream bad_input(bad);
+        ASSERT_THROWS(Lexer{bad_input}, LexerError);
+    }
+}
+
 void TestOperations() {
     istringstream input("+-*/= > < != == <> <= >="s);
     Lexer lexer(input);
@@ -359,6 +378,7 @@ void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestNumbers);
     RUN_TEST(tr, parse::TestIds);
     RUN_TEST(tr, parse::TestStrings);
+    RUN_TEST(tr, parse::TestFormatStrings);
     RUN_TEST(tr, parse::TestOperations);
     RUN_TEST(tr, parse::TestIndentsAndNewlines);
     RUN_TEST(tr, parse::TestEmptyLinesAreIgnored);
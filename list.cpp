@@ -0,0 +1,390 @@
+#include "list.h"
+
+#include "int_kernels.h"
+
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        // Списки, которые выводятся в текущем потоке, от внешнего к вложенному
+        thread_local vector<const List*> printing;
+
+        // Находит значения чисел списка: упакованный массив самого списка либо их копию в scratch.
+        // Возвращает false, если не все элементы списка - числа
+        bool FindNumbers(const List& list, vector<int>& scratch, const int*& data) {
+            if (list.GetStorage() == List::Storage::Numbers) {
+                data = list.GetNumbers().data();
+                return true;
+            }
+            if (list.GetStorage() == List::Storage::Bools && list.GetSize() > 0) {
+                return false;
+            }
+            scratch.clear();
+            scratch.reserve(list.GetSize());
+            for (const ObjectHolder& item : list.GetObjects()) {
+                const auto* number = item.TryAs<Number>();
+                if (number == nullptr) {
+                    return false;
+                }
+                scratch.push_back(number->GetValue());
+            }
+            data = scratch.data();
+            return true;
+        }
+
+        const int* NumbersOf(const List& list, vector<int>& scratch, const char* function) {
+            const int* data = nullptr;
+            if (!FindNumbers(list, scratch, data)) {
+                throw runtime_error(function + " expects a list of numbers"s);
+            }
+            return data;
+        }
+
+        void CheckSameSize(const List& lhs, const List& rhs, const char* function) {
+            if (lhs.GetSize() != rhs.GetSize()) {
+                throw runtime_error(function + " expects lists of the same size, got "s + to_string(lhs.GetSize())
+                                    + " and "s + to_string(rhs.GetSize()));
+            }
+        }
+
+        // Наименьший (для Less) или наибольший элемент непустого списка
+        template <typename Better>
+        ObjectHolder Extreme(const List& list, Context& context, const char* function, int (*kernel)(const int*, size_t),
+                             Better better) {
+            if (list.GetSize() == 0) {
+                throw runtime_error(function + " of an empty list"s);
+            }
+            vector<int> scratch;
+            if (const int* data = nullptr; FindNumbers(list, scratch, data)) {
+                return ObjectHolder::Own(Number(kernel(data, list.GetSize())));
+            }
+            // Индекс, а не итератор: __lt__ элементов может изменить список
+            ObjectHolder found = list.Get(0);
+            for (size_t i = 1; i < list.GetSize(); ++i) {
+                ObjectHolder item = list.Get(i);
+                if (better(item, found, context)) {
+                    found = std::move(item);
+                }
+            }
+            return found;
+        }
+
+        ObjectHolder Elementwise(const List& lhs, const List& rhs, const char* function,
+                                 void (*kernel)(const int*, const int*, int*, size_t)) {
+            CheckSameSize(lhs, rhs, function);
+            vector<int> lhs_scratch;
+            vector<int> rhs_scratch;
+            const int* lhs_data = NumbersOf(lhs, lhs_scratch, function);
+            const int* rhs_data = NumbersOf(rhs, rhs_scratch, function);
+            List::Numbers result(lhs.GetSize(), PoolAllocator<int>(MemoryKind::List));
+            kernel(lhs_data, rhs_data, result.data(), result.size());
+            return ObjectHolder::Make<List>(std::move(result));
+        }
+    }  // namespace
+
+    List::List()
+        : objects_(PoolAllocator<ObjectHolder>(MemoryKind::List))
+        , numbers_(PoolAllocator<int>(MemoryKind::List))
+        , bools_(PoolAllocator<bool>(MemoryKind::List)) {
+    }
+
+    List::List(vector<ObjectHolder> items)
+        : List() {
+        const auto all = [&items](auto is_type) {
+            return !items.empty() && all_of(items.begin(), items.end(), is_type);
+        };
+        if (all([](const ObjectHolder& item) { return item.TryAs<Number>() != nullptr; })) {
+            storage_ = Storage::Numbers;
+            numbers_.reserve(items.size());
+            for (const ObjectHolder& item : items) {
+                numbers_.push_back(item.TryAs<Number>()->GetValue());
+            }
+        }
+        else if (all([](const ObjectHolder& item) { return item.TryAs<Bool>() != nullptr; })) {
+            storage_ = Storage::Bools;
+            bools_.reserve(items.size());
+            for (const ObjectHolder& item : items) {
+                bools_.push_back(item.TryAs<Bool>()->GetValue());
+            }
+        }
+        else {
+            objects_.assign(make_move_iterator(items.begin()), make_move_iterator(items.end()));
+        }
+    }
+
+    List::List(Numbers numbers)
+        : List() {
+        storage_ = Storage::Numbers;
+        numbers_ = std::move(numbers);
+    }
+
+    ObjectHolder List::Call(const string& method, const vector<ObjectHolder>& args, Context& context) {
+        if (method == "append"sv) {
+            if (args.size() != 1) {
+                throw runtime_error("List.append takes 1 argument(s), "s + to_string(args.size()) + " given"s);
+            }
+            Append(args.front());
+            return ObjectHolder::None();
+        }
+        if (method == "count"sv) {
+            if (args.size() != 1) {
+                throw runtime_error("List.count takes 1 argument(s), "s + to_string(args.size()) + " given"s);
+            }
+            return ObjectHolder::Own(Number(static_cast<int>(Count(args.front(), context))));
+        }
+        if (method == "sort"sv) {
+            if (!args.empty()) {
+                throw runtime_error("List.sort takes 0 argument(s), "s + to_string(args.size()) + " given"s);
+            }
+            Sort(context);
+            return ObjectHolder::None();
+        }
+        throw runtime_error("List has no method "s + method);
+    }
+
+    void List::Print(ostream& os, Context& context) {
+        if (find(printing.begin(), printing.end(), this) != printing.end()) {
+            os << "[...]"sv;
+            return;
+        }
+        printing.push_back(this);
+        try {
+            os << '[';
+            for (size_t i = 0; i < GetSize(); ++i) {
+                if (i > 0) {
+                    os << ", "sv;
+                }
+                if (storage_ == Storage::Numbers) {
+                    os << numbers_[i];
+                }
+                else if (storage_ == Storage::Bools) {
+                    os << (bools_[i] ? "True"sv : "False"sv);
+                }
+                else if (objects_[i]) {
+                    objects_[i]->Print(os, context);
+                }
+                else {
+                    os << "None"sv;
+                }
+            }
+            os << ']';
+        } catch (...) {
+            printing.pop_back();
+            throw;
+        }
+        printing.pop_back();
+    }
+
+    size_t List::GetSize() const {
+        switch (storage_) {
+            case Storage::Numbers:
+                return numbers_.size();
+            case Storage::Bools:
+                return bools_.size();
+            case Storage::Objects:
+                break;
+        }
+        return objects_.size();
+    }
+
+    ObjectHolder List::Get(size_t i) const {
+        switch (storage_) {
+            case Storage::Numbers:
+                return ObjectHolder::Own(Number(numbers_[i]));
+            case Storage::Bools:
+                return ObjectHolder::Own(Bool(bools_[i]));
+            case Storage::Objects:
+                break;
+        }
+        return objects_[i];
+    }
+
+    ObjectHolder List::At(int index) const {
+        return Get(Position(index));
+    }
+
+    void List::Set(int index, ObjectHolder value) {
+        const size_t position = Position(index);
+        if (storage_ == Storage::Numbers) {
+            if (const auto* number = value.TryAs<Number>()) {
+                numbers_[position] = number->GetValue();
+                return;
+            }
+            Generalize();
+        }
+        else if (storage_ == Storage::Bools) {
+            if (const auto* boolean = value.TryAs<Bool>()) {
+                bools_[position] = boolean->GetValue();
+                return;
+            }
+            Generalize();
+        }
+        objects_[position] = std::move(value);
+    }
+
+    void List::Append(ObjectHolder value) {
+        if (GetSize() == 0) {
+            ChooseStorage(value);
+        }
+        if (storage_ == Storage::Numbers) {
+            if (const auto* number = value.TryAs<Number>()) {
+                numbers_.push_back(number->GetValue());
+                return;
+            }
+            Generalize();
+        }
+        else if (storage_ == Storage::Bools) {
+            if (const auto* boolean = value.TryAs<Bool>()) {
+                bools_.push_back(boolean->GetValue());
+                return;
+            }
+            Generalize();
+        }
+        objects_.push_back(std::move(value));
+    }
+
+    void List::AppendGeneral(ObjectHolder value) {
+        if (GetSize() == 0) {
+            storage_ = Storage::Objects;
+        }
+        else if (storage_ != Storage::Objects) {
+            Generalize();
+        }
+        objects_.push_back(std::move(value));
+    }
+
+    size_t List::Count(const ObjectHolder& value, Context& context) const {
+        if (const auto* number = value.TryAs<Number>()) {
+            vector<int> scratch;
+            if (const int* data = nullptr; FindNumbers(*this, scratch, data)) {
+                return CountInts(data, GetSize(), number->GetValue());
+            }
+        }
+        if (storage_ == Storage::Numbers) {
+            return 0;
+        }
+        if (storage_ == Storage::Bools) {
+            const auto* boolean = value.TryAs<Bool>();
+            return boolean != nullptr ? static_cast<size_t>(count(bools_.begin(), bools_.end(), boolean->GetValue())) : 0;
+        }
+        size_t found = 0;
+        // Индекс, а не итератор: __eq__ элементов может изменить список
+        for (size_t i = 0; i < objects_.size(); ++i) {
+            const ObjectHolder item = objects_[i];
+            found += SameValue(value, item, context) ? 1 : 0;
+        }
+        return found;
+    }
+
+    bool List::Contains(const ObjectHolder& value, Context& context) const {
+        if (storage_ == Storage::Numbers) {
+            const auto* number = value.TryAs<Number>();
+            return number != nullptr && find(numbers_.begin(), numbers_.end(), number->GetValue()) != numbers_.end();
+        }
+        if (storage_ == Storage::Bools) {
+            const auto* boolean = value.TryAs<Bool>();
+            return boolean != nullptr && find(bools_.begin(), bools_.end(), boolean->GetValue()) != bools_.end();
+        }
+        for (size_t i = 0; i < objects_.size(); ++i) {
+            const ObjectHolder item = objects_[i];
+            if (SameValue(value, item, context)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void List::Sort(Context& context) {
+        if (storage_ == Storage::Numbers) {
+            sort(numbers_.begin(), numbers_.end());
+            return;
+        }
+        if (storage_ == Storage::Bools) {
+            const auto falses = count(bools_.begin(), bools_.end(), false);
+            fill(bools_.begin(), bools_.begin() + falses, false);
+            fill(bools_.begin() + falses, bools_.end(), true);
+            return;
+        }
+        // Сортируется копия: исключение из __lt__ посреди сортировки не должно терять элементы списка
+        vector<ObjectHolder> sorted(objects_.begin(), objects_.end());
+        stable_sort(sorted.begin(), sorted.end(), [&context](const ObjectHolder& lhs, const ObjectHolder& rhs) {
+            return Less(lhs, rhs, context);
+        });
+        objects_.assign(make_move_iterator(sorted.begin()), make_move_iterator(sorted.end()));
+    }
+
+    size_t List::Position(int index) const {
+        const long long size = static_cast<long long>(GetSize());
+        const long long position = index < 0 ? size + index : index;
+        if (position < 0 || position >= size) {
+            throw runtime_error("List index "s + to_string(index) + " out of range for list of "s
+                                + to_string(size) + " items"s);
+        }
+        return static_cast<size_t>(position);
+    }
+
+    void List::ChooseStorage(const ObjectHolder& value) {
+        if (value.TryAs<Number>() != nullptr) {
+            storage_ = Storage::Numbers;
+        }
+        else if (value.TryAs<Bool>() != nullptr) {
+            storage_ = Storage::Bools;
+        }
+        else {
+            storage_ = Storage::Objects;
+        }
+    }
+
+    void List::Generalize() {
+        // Объекты создаются до смены представления: нехватка памяти оставляет список прежним
+        Objects objects(PoolAllocator<ObjectHolder>(MemoryKind::List));
+        objects.reserve(GetSize() + 1);
+        for (size_t i = 0; i < GetSize(); ++i) {
+            objects.push_back(Get(i));
+        }
+        objects_ = std::move(objects);
+        numbers_ = Numbers(PoolAllocator<int>(MemoryKind::List));
+        bools_ = Bools(PoolAllocator<bool>(MemoryKind::List));
+        storage_ = Storage::Objects;
+    }
+
+    ObjectHolder ListSum(const List& list) {
+        vector<int> scratch;
+        return ObjectHolder::Own(Number(SumInts(NumbersOf(list, scratch, "sum"), list.GetSize())));
+    }
+
+    ObjectHolder ListMin(const List& list, Context& context) {
+        return Extreme(list, context, "min", MinInts, [](const ObjectHolder& item, const ObjectHolder& found, Context& ctx) {
+            return Less(item, found, ctx);
+        });
+    }
+
+    ObjectHolder ListMax(const List& list, Context& context) {
+        return Extreme(list, context, "max", MaxInts, [](const ObjectHolder& item, const ObjectHolder& found, Context& ctx) {
+            return Less(found, item, ctx);
+        });
+    }
+
+    ObjectHolder ListDot(const List& lhs, const List& rhs) {
+        CheckSameSize(lhs, rhs, "dot");
+        vector<int> lhs_scratch;
+        vector<int> rhs_scratch;
+        const int* lhs_data = NumbersOf(lhs, lhs_scratch, "dot");
+        const int* rhs_data = NumbersOf(rhs, rhs_scratch, "dot");
+        return ObjectHolder::Own(Number(DotInts(lhs_data, rhs_data, lhs.GetSize())));
+    }
+
+    ObjectHolder ListAdd(const List& lhs, const List& rhs) {
+        return Elementwise(lhs, rhs, "add", AddInts);
+    }
+
+    ObjectHolder ListMul(const List& lhs, const List& rhs) {
+        return Elementwise(lhs, rhs, "mul", MulInts);
+    }
+
+}  // namespace runtime
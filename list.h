@@ -0,0 +1,115 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace runtime {
+
+    /*
+     * Список Mython: [1, 'two', obj]. Элементы лежат подряд в одном векторе, память под который выделяется
+     * из ObjectPool и учитывается в бюджете как MemoryKind::List; при добавлении вектор растёт с запасом.
+     *
+     * Список выбирает представление элементов сам. Пока все элементы - числа, хранятся только их значения
+     * (4 байта на элемент вместо ссылки и отдельного объекта Number), пока все элементы - логические
+     * значения, хранится битовый массив. Первый элемент другого типа переводит список в общее представление
+     * ссылками на объекты, и обратно список уже не переходит. Пустой список выбирает представление по типу
+     * первого добавленного элемента. Элемент упакованного списка при чтении создаётся заново, поэтому
+     * прочитанные числа равны записанным, но не являются теми же объектами.
+     *
+     * Методы в программе:
+     *   append(value) - добавляет value в конец списка;
+     *   count(value) - число элементов, равных value по SameValue;
+     *   sort() - упорядочивает элементы по возрастанию функцией Less, равные элементы сохраняют порядок.
+     * Элемент возвращает индексация list[i], меняет присваивание list[i] = value. Отрицательный индекс
+     * отсчитывается от конца списка, индекс за границами списка - ошибка. Длину возвращает функция len,
+     * элементы по порядку перебирает цикл for.
+     * Список истинен, если не пуст, и равен другому списку той же длины с равными элементами
+     */
+    class List : public NativeObject {
+    public:
+        enum class Storage : uint8_t {
+            Objects,    // ссылки на объекты любых типов
+            Numbers,    // значения чисел
+            Bools,      // битовый массив логических значений
+        };
+
+        using Objects = std::vector<ObjectHolder, PoolAllocator<ObjectHolder>>;
+        using Numbers = std::vector<int, PoolAllocator<int>>;
+        using Bools = std::vector<bool, PoolAllocator<bool>>;
+
+        List();
+        explicit List(std::vector<ObjectHolder> items);
+        // Список чисел numbers; память под numbers должна учитываться как MemoryKind::List
+        explicit List(Numbers numbers);
+
+        ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& args, Context& context) override;
+        // Выводит элементы через запятую в квадратных скобках. Список, вложенный сам в себя, выводится как [...]
+        void Print(std::ostream& os, Context& context) override;
+
+        [[nodiscard]] size_t GetSize() const;
+
+        [[nodiscard]] Storage GetStorage() const {
+            return storage_;
+        }
+
+        // Возвращает элемент с номером i < GetSize()
+        [[nodiscard]] ObjectHolder Get(size_t i) const;
+        // Возвращает элемент с индексом index. Если индекса нет в списке, выбрасывает runtime_error
+        [[nodiscard]] ObjectHolder At(int index) const;
+        // Заменяет элемент с индексом index. Если индекса нет в списке, выбрасывает runtime_error
+        void Set(int index, ObjectHolder value);
+        void Append(ObjectHolder value);
+        // Добавляет value, не упаковывая список: так копия списка сохраняет общее представление оригинала
+        void AppendGeneral(ObjectHolder value);
+        // Число элементов, равных value по SameValue
+        [[nodiscard]] size_t Count(const ObjectHolder& value, Context& context) const;
+        // Возвращает true, если в списке есть элемент, равный value по SameValue
+        [[nodiscard]] bool Contains(const ObjectHolder& value, Context& context) const;
+        // Упорядочивает элементы (см. метод sort). Если Less выбросит исключение, список не меняется
+        void Sort(Context& context);
+
+        // Ссылки на элементы в общем представлении; пусто, если список упакован
+        [[nodiscard]] const Objects& GetObjects() const {
+            return objects_;
+        }
+
+        // Значения чисел в представлении Numbers; пусто в остальных представлениях
+        [[nodiscard]] const Numbers& GetNumbers() const {
+            return numbers_;
+        }
+
+    private:
+        [[nodiscard]] size_t Position(int index) const;
+        // Выбирает представление пустого списка по первому элементу value
+        void ChooseStorage(const ObjectHolder& value);
+        // Переводит упакованный список в общее представление
+        void Generalize();
+
+        Storage storage_ = Storage::Objects;
+        Objects objects_;
+        Numbers numbers_;
+        Bools bools_;
+    };
+
+    /*
+     * Встроенные функции над списками. Список, все элементы которого - числа, обрабатывается векторными
+     * функциями из int_kernels.h; числа переполняются так же, как при сложении и умножении в программе.
+     * Для остальных списков sum, dot, add и mul выбрасывают runtime_error, а min и max сравнивают элементы
+     * функцией Less
+     */
+    // sum(xs): сумма чисел списка, 0 для пустого списка
+    ObjectHolder ListSum(const List& list);
+    // min(xs) и max(xs): наименьший и наибольший элемент непустого списка
+    ObjectHolder ListMin(const List& list, Context& context);
+    ObjectHolder ListMax(const List& list, Context& context);
+    // dot(xs, ys): сумма попарных произведений чисел списков одной длины
+    ObjectHolder ListDot(const List& lhs, const List& rhs);
+    // add(xs, ys) и mul(xs, ys): новый список попарных сумм и произведений чисел списков одной длины
+    ObjectHolder ListAdd(const List& lhs, const List& rhs);
+    ObjectHolder ListMul(const List& lhs, const List& rhs);
+
+}  // namespace runtime
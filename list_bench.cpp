@@ -0,0 +1,275 @@
+#include "bench_runner.h"
+#include "interpreter.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void RunProgram(const string& program) {
+    ostringstream out;
+    SimpleContext context(out);
+    RunMythonProgram(program, context, RunOptions{});
+    DoNotOptimize(out);
+}
+
+// Список из 20000 чисел, который 20 раз перебирается циклом for
+void BenchListSum() {
+    RunProgram(R"(
+items = []
+i = 0
+while i < 20000:
+  items.append(i)
+  i = i + 1
+rounds = 0
+while rounds < 20:
+  total = 0
+  for item in items:
+    total = total + item
+  rounds = rounds + 1
+print total
+)"s);
+}
+
+// Те же числа в связном списке из экземпляров классов, какие строили программы без списков
+void BenchLinkedListSum() {
+    RunProgram(R"(
+class Node:
+  def __init__(value, next):
+    self.value = value
+    self.next = next
+
+head = None
+i = 20000
+while i > 0:
+  i = i - 1
+  head = Node(i, head)
+rounds = 0
+while rounds < 20:
+  total = 0
+  node = head
+  i = 0
+  while i < 20000:
+    total = total + node.value
+    node = node.next
+    i = i + 1
+  rounds = rounds + 1
+print total
+)"s);
+}
+
+// Списки xs и ys по 20000 чисел, которые замеры ниже обрабатывают 10 раз телом body
+string NumbersProgram(const string& body) {
+    return R"(
+xs = []
+ys = []
+i = 0
+while i < 20000:
+  xs.append(i * 7 - i / 3 * 20)
+  ys.append(i - i / 5 * 5)
+  i = i + 1
+n = len(xs)
+rounds = 0
+while rounds < 10:
+)"s + body + R"(
+  rounds = rounds + 1
+)"s;
+}
+
+// Заполнение списков без обработки: общая часть замеров встроенных функций и их аналогов на Mython
+void BenchNumbersSetup() {
+    RunProgram(NumbersProgram("  idle = 0"s));
+}
+
+void BenchSumBuiltin() {
+    RunProgram(NumbersProgram("  total = sum(xs)"s));
+}
+
+void BenchSumLoop() {
+    RunProgram(NumbersProgram(R"(
+  total = 0
+  for x in xs:
+    total = total + x)"s));
+}
+
+void BenchMinBuiltin() {
+    RunProgram(NumbersProgram("  lowest = min(xs)"s));
+}
+
+void BenchMinLoop() {
+    RunProgram(NumbersProgram(R"(
+  lowest = xs[0]
+  for x in xs:
+    if x < lowest:
+      lowest = x)"s));
+}
+
+void BenchMaxBuiltin() {
+    RunProgram(NumbersProgram("  highest = max(xs)"s));
+}
+
+void BenchMaxLoop() {
+    RunProgram(NumbersProgram(R"(
+  highest = xs[0]
+  for x in xs:
+    if x > highest:
+      highest = x)"s));
+}
+
+void BenchDotBuiltin() {
+    RunProgram(NumbersProgram("  total = dot(xs, ys)"s));
+}
+
+void BenchDotLoop() {
+    RunProgram(NumbersProgram(R"(
+  total = 0
+  i = 0
+  while i < n:
+    total = total + xs[i] * ys[i]
+    i = i + 1)"s));
+}
+
+void BenchAddBuiltin() {
+    RunProgram(NumbersProgram("  sums = add(xs, ys)"s));
+}
+
+void BenchAddLoop() {
+    RunProgram(NumbersProgram(R"(
+  sums = []
+  i = 0
+  while i < n:
+    sums.append(xs[i] + ys[i])
+    i = i + 1)"s));
+}
+
+void BenchMulBuiltin() {
+    RunProgram(NumbersProgram("  products = mul(xs, ys)"s));
+}
+
+void BenchMulLoop() {
+    RunProgram(NumbersProgram(R"(
+  products = []
+  i = 0
+  while i < n:
+    products.append(xs[i] * ys[i])
+    i = i + 1)"s));
+}
+
+void BenchCountBuiltin() {
+    RunProgram(NumbersProgram("  found = ys.count(3)"s));
+}
+
+void BenchCountLoop() {
+    RunProgram(NumbersProgram(R"(
+  found = 0
+  for y in ys:
+    if y == 3:
+      found = found + 1)"s));
+}
+
+// Список xs из 100000 значений element(i), который обрабатывается один раз телом body. Если packed ложно,
+// список сначала содержит строку и остаётся в общем представлении после её замены первым значением
+string StorageProgram(bool packed, const string& element, const string& body) {
+    return "i = 0\nxs = ["s + (packed ? element : "'start'"s) + "]\nxs[0] = "s + element + R"(
+i = 1
+while i < 100000:
+  xs.append()"s + element + R"()
+  i = i + 1
+)"s + body + "\n"s;
+}
+
+const string NUMBER = "i * 7919 - i * 7919 / 100000 * 100000"s;
+const string BOOL = "i - i / 3 * 3 == 0"s;
+const string SORT = "xs.sort()"s;
+const string SCAN = R"(found = 0
+for x in xs:
+  if x:
+    found = found + 1)"s;
+
+void BenchPackedNumbersSetup() {
+    RunProgram(StorageProgram(true, NUMBER, ""s));
+}
+
+void BenchObjectNumbersSetup() {
+    RunProgram(StorageProgram(false, NUMBER, ""s));
+}
+
+void BenchPackedNumbersSort() {
+    RunProgram(StorageProgram(true, NUMBER, SORT));
+}
+
+void BenchObjectNumbersSort() {
+    RunProgram(StorageProgram(false, NUMBER, SORT));
+}
+
+void BenchPackedNumbersScan() {
+    RunProgram(StorageProgram(true, NUMBER, SCAN));
+}
+
+void BenchObjectNumbersScan() {
+    RunProgram(StorageProgram(false, NUMBER, SCAN));
+}
+
+void BenchPackedBoolsSetup() {
+    RunProgram(StorageProgram(true, BOOL, ""s));
+}
+
+void BenchObjectBoolsSetup() {
+    RunProgram(StorageProgram(false, BOOL, ""s));
+}
+
+void BenchPackedBoolsSort() {
+    RunProgram(StorageProgram(true, BOOL, SORT));
+}
+
+void BenchObjectBoolsSort() {
+    RunProgram(StorageProgram(false, BOOL, SORT));
+}
+
+void BenchPackedBoolsScan() {
+    RunProgram(StorageProgram(true, BOOL, SCAN));
+}
+
+void BenchObjectBoolsScan() {
+    RunProgram(StorageProgram(false, BOOL, SCAN));
+}
+
+}  // namespace
+
+void RunListBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, BenchListSum);
+    RUN_BENCH(br, BenchLinkedListSum);
+    RUN_BENCH(br, BenchNumbersSetup);
+    RUN_BENCH(br, BenchSumBuiltin);
+    RUN_BENCH(br, BenchSumLoop);
+    RUN_BENCH(br, BenchMinBuiltin);
+    RUN_BENCH(br, BenchMinLoop);
+    RUN_BENCH(br, BenchMaxBuiltin);
+    RUN_BENCH(br, BenchMaxLoop);
+    RUN_BENCH(br, BenchDotBuiltin);
+    RUN_BENCH(br, BenchDotLoop);
+    RUN_BENCH(br, BenchAddBuiltin);
+    RUN_BENCH(br, BenchAddLoop);
+    RUN_BENCH(br, BenchMulBuiltin);
+    RUN_BENCH(br, BenchMulLoop);
+    RUN_BENCH(br, BenchCountBuiltin);
+    RUN_BENCH(br, BenchCountLoop);
+    RUN_BENCH(br, BenchPackedNumbersSetup);
+    RUN_BENCH(br, BenchObjectNumbersSetup);
+    RUN_BENCH(br, BenchPackedNumbersSort);
+    RUN_BENCH(br, BenchObjectNumbersSort);
+    RUN_BENCH(br, BenchPackedNumbersScan);
+    RUN_BENCH(br, BenchObjectNumbersScan);
+    RUN_BENCH(br, BenchPackedBoolsSetup);
+    RUN_BENCH(br, BenchObjectBoolsSetup);
+    RUN_BENCH(br, BenchPackedBoolsSort);
+    RUN_BENCH(br, BenchObjectBoolsSort);
+    RUN_BENCH(br, BenchPackedBoolsScan);
+    RUN_BENCH(br, BenchObjectBoolsScan);
+}
+
+}  // namespace runtime
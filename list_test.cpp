@@ -0,0 +1,363 @@
+#include "heap.h"
+#include "interpreter.h"
+#include "isolate.h"
+#include "lexer.h"
+#include "list.h"
+#include "memory_budget.h"
+#include "parse.h"
+#include "test_program.h"
+#include "test_runner.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestListLiteralsAndIndexing() {
+    const string program = R"(
+empty = []
+xs = [1, 'two', 3 + 4, [5, 6]]
+first = xs[0]
+last = xs[-1]
+inner = xs[3][1]
+print empty, xs, len(empty), len(xs)
+print first, last, inner, -xs[2]
+xs[0] = 'one'
+xs[-1][0] = 50
+print xs
+word = 'mython'
+print word[0], word[-1], len(word)
+)"s;
+    ASSERT_EQUAL(Run(program), "[] [1, two, 7, [5, 6]] 0 4\n1 [5, 6] 6 -7\n[one, two, 7, [50, 6]]\nm n 6\n"s);
+
+    ASSERT_THROWS(Run("xs = [1, 2]\nprint xs[2]\n"s), runtime_error);
+    ASSERT_THROWS(Run("xs = [1, 2]\nprint xs[-3]\n"s), runtime_error);
+    ASSERT_THROWS(Run("xs = [1, 2]\nxs[5] = 1\n"s), runtime_error);
+    ASSERT_THROWS(Run("xs = [1, 2]\nprint xs['a']\n"s), runtime_error);
+    ASSERT_THROWS(Run("x = 1\nprint x[0]\n"s), runtime_error);
+    ASSERT_THROWS(Run("x = 1\nprint len(x)\n"s), runtime_error);
+    ASSERT_THROWS(Run("xs = [1, 2\n"s), parse::LexerError);
+    ASSERT_THROWS(Run("print len()\n"s), ParseError);
+}
+
+void TestListAppend() {
+    const string program = R"(
+class Squares:
+  def build(n):
+    result = []
+    i = 0
+    while i < n:
+      result.append(i * i)
+      i = i + 1
+    return result
+
+s = Squares()
+xs = s.build(1000)
+print len(xs), xs[999], xs[-1] == 998001
+)"s;
+    ASSERT_EQUAL(Run(program), "1000 998001 True\n"s);
+    ASSERT_THROWS(Run("xs = []\nxs.append()\n"s), runtime_error);
+    ASSERT_THROWS(Run("xs = []\nxs.push(1)\n"s), runtime_error);
+
+    // Вектор элементов учитывается в бюджете памяти и освобождается вместе со списком
+    MemoryBudget budget;
+    RunOptions options;
+    options.memory_budget = &budget;
+    ASSERT_EQUAL(Run(program, options), "1000 998001 True\n"s);
+    ASSERT(budget.GetPeakBytes(MemoryKind::List) >= 1000 * sizeof(int));
+    ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+
+    MemoryBudget small(4 << 10);
+    options.memory_budget = &small;
+    ASSERT_THROWS(Run(program, options), MemoryLimitError);
+}
+
+void TestForLoop() {
+    const string program = R"(
+total = 0
+for x in [1, 2, 3, 4, 5, 6]:
+  if x == 2:
+    continue
+  if x == 5:
+    break
+  total = total + x
+print total, x
+
+queue = [1]
+for n in queue:
+  if n < 5:
+    queue.append(n + 1)
+print queue
+
+class Finder:
+  def index_of(items, value):
+    i = 0
+    for item in items:
+      if item == value:
+        return i
+      i = i + 1
+    return -1
+
+f = Finder()
+found = f.index_of(['a', 'b', 'c'], 'c')
+missing = f.index_of([], 'c')
+print found, missing
+for y in []:
+  print 'never'
+)"s;
+    ASSERT_EQUAL(Run(program), "8 5\n[1, 2, 3, 4, 5]\n2 -1\n"s);
+    ASSERT_THROWS(Run("for x in 5:\n  print x\n"s), runtime_error);
+    ASSERT_THROWS(Run("for x in [1]:\n  print x\nbreak\n"s), ParseError);
+    ASSERT_THROWS(Run("for x [1]:\n  print x\n"s), parse::LexerError);
+}
+
+void TestNumericBuiltins() {
+    const string program = R"(
+xs = [3, -1, 4, 1, 5, 9, 2, 6, 5, 3, 5]
+ys = [1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2]
+print sum(xs), min(xs), max(xs), dot(xs, ys), xs.count(5), xs.count(7), xs.count('5')
+print add(xs, ys), mul(xs, ys)
+print sum([]), sum([2147483647, 1]), mul([65536], [65536])
+words = ['pear', 'apple', 'fig']
+gaps = [None, 1, None]
+print min(words), max(words), words.count('fig'), gaps.count(None)
+
+class Version:
+  def __init__(n):
+    self.n = n
+  def __lt__(other):
+    return self.n < other.n
+  def __eq__(other):
+    return self.n == other.n
+  def __str__():
+    return 'v' + str(self.n)
+
+versions = [Version(2), Version(7), Version(1)]
+oldest = min(versions)
+newest = max(versions)
+print oldest, newest, versions.count(Version(7))
+)"s;
+    ASSERT_EQUAL(Run(program), "42 -1 9 47 3 0 0\n[4, 0, 5, 2, 6, 10, 3, 7, 6, 4, 7] [3, -1, 4, 1, 5, 9, 2, 6, 5, 3, 10]\n"
+                               "0 -2147483648 [0]\napple pear 1 2\nv1 v7 1\n"s);
+
+    ASSERT_THROWS(Run("print sum([1, 'a'])\n"s), runtime_error);
+    ASSERT_THROWS(Run("print min([])\n"s), runtime_error);
+    ASSERT_THROWS(Run("print min([1, 'a'])\n"s), runtime_error);
+    ASSERT_THROWS(Run("print dot([1, 2], [1])\n"s), runtime_error);
+    ASSERT_THROWS(Run("print add([1], 1)\n"s), runtime_error);
+    ASSERT_THROWS(Run("print sum(1, 2)\n"s), ParseError);
+    ASSERT_THROWS(Run("print mul([1])\n"s), ParseError);
+}
+
+void TestListStorage() {
+    List numbers(vector<ObjectHolder>{ObjectHolder::Own(Number(1)), ObjectHolder::Own(Number(2))});
+    ASSERT(numbers.GetStorage() == List::Storage::Numbers);
+    numbers.Set(0, ObjectHolder::Own(Number(10)));
+    numbers.Append(ObjectHolder::Own(Number(3)));
+    ASSERT(numbers.GetStorage() == List::Storage::Numbers);
+    ASSERT_EQUAL(numbers.GetNumbers().size(), 3U);
+    // Первый элемент другого типа переводит список в общее представление с прежними значениями
+    numbers.Append(ObjectHolder::Own(String("four"s)));
+    ASSERT(numbers.GetStorage() == List::Storage::Objects);
+    ASSERT(numbers.GetNumbers().empty());
+    ASSERT_EQUAL(numbers.At(0).TryAs<Number>()->GetValue(), 10);
+    ASSERT_EQUAL(numbers.At(-1).TryAs<String>()->GetValue(), "four"s);
+    numbers.Set(-1, ObjectHolder::Own(Number(4)));
+    ASSERT(numbers.GetStorage() == List::Storage::Objects);
+
+    List bools;
+    bools.Append(ObjectHolder::Own(Bool(true)));
+    bools.Append(ObjectHolder::Own(Bool(false)));
+    ASSERT(bools.GetStorage() == List::Storage::Bools);
+    ASSERT(!bools.At(1).TryAs<Bool>()->GetValue());
+    bools.Set(1, ObjectHolder::Own(Number(0)));
+    ASSERT(bools.GetStorage() == List::Storage::Objects);
+    ASSERT(bools.At(0).TryAs<Bool>()->GetValue());
+    ASSERT_EQUAL(bools.At(1).TryAs<Number>()->GetValue(), 0);
+
+    List empty(vector<ObjectHolder>{});
+    empty.Append(ObjectHolder::Own(Number(5)));
+    ASSERT(empty.GetStorage() == List::Storage::Numbers);
+    List none;
+    none.Append(ObjectHolder::None());
+    ASSERT(none.GetStorage() == List::Storage::Objects);
+
+    // В программе представление незаметно: числа и логические значения ведут себя как объекты
+    const string program = R"(
+xs = [3, 1, 2]
+flags = [True, False, True]
+mixed = [2, 'b', 1]
+xs.sort()
+flags.sort()
+print xs, flags, xs == [1, 2, 3], 2 in xs, 'a' in xs, flags.count(True), True in flags, 1 in flags
+xs.append('z')
+flags[0] = None
+print xs, flags, xs[0] + 10, xs.count(2)
+words = ['pear', 'apple', 'fig']
+words.sort()
+print words
+mixed.sort()
+)"s;
+    try {
+        Run(program);
+        ASSERT(false);
+    } catch (const runtime_error&) {
+    }
+    ASSERT_EQUAL(Run(program.substr(0, program.rfind("mixed.sort()"s))),
+                 "[1, 2, 3] [False, True, True] True True False 2 True False\n"
+                 "[1, 2, 3, z] [None, True, True] 11 1\n[apple, fig, pear]\n"s);
+    ASSERT_THROWS(Run("xs = [1]\nxs.sort(1)\n"s), runtime_error);
+
+    // Список, который __lt__ не смог упорядочить, не меняется
+    const string failed_sort = R"(
+class Key:
+  def __init__(n):
+    self.n = n
+  def __lt__(other):
+    if other.n == 0:
+      return self.n < 'zero'
+    return self.n < other.n
+  def __str__():
+    return str(self.n)
+
+keys = [Key(3), Key(0), Key(2), Key(1)]
+print keys
+keys.sort()
+)"s;
+    ostringstream out;
+    SimpleContext context(out);
+    ASSERT_THROWS(RunMythonProgram(failed_sort, context, {}), runtime_error);
+    ASSERT_EQUAL(out.str(), "[3, 0, 2, 1]\n"s);
+}
+
+// Память списка из 10000 чисел в упакованном и общем представлениях
+void TestPackedListsSaveMemory() {
+    const string fill = R"(
+i = 1
+while i < 10000:
+  xs.append(i)
+  i = i + 1
+xs[0] = 0
+print len(xs), sum(xs)
+)"s;
+    const auto peak = [&fill](const string& first) {
+        MemoryBudget budget;
+        RunOptions options;
+        options.memory_budget = &budget;
+        ASSERT_EQUAL(Run("xs = ["s + first + "]\n"s + fill, options), "10000 49995000\n"s);
+        return budget.GetPeakBytes();
+    };
+    const size_t packed = peak("0"s);
+    const size_t objects = peak("'start'"s);
+    // При росте вектора старый и новый буферы живут одновременно
+    ASSERT(packed < 10000 * sizeof(int) * 3 + (4 << 10));
+    ASSERT(objects > packed * 4);
+}
+
+void TestListTruthEqualityAndPrinting() {
+    const string program = R"(
+class Point:
+  def __init__(x):
+    self.x = x
+  def __str__():
+    return 'P' + str(self.x)
+  def __eq__(other):
+    return self.x == other.x
+
+empty = []
+full = [0]
+if empty:
+  print 'empty is true'
+if full:
+  print 'full is true'
+a = [1, [2, 'three'], Point(4)]
+b = [1, [2, 'three'], Point(4)]
+c = [1, [2, 'three'], Point(5)]
+print a == b, a == c, a != c, [] == [], [1] == [1, 1]
+text = str(a)
+print text
+a.append(a)
+print a
+)"s;
+    ASSERT_EQUAL(Run(program), "full is true\nTrue False True True False\n[1, [2, three], P4]\n"
+                               "[1, [2, three], P4, [...]]\n"s);
+}
+
+void TestCyclesThroughListsAreCollected() {
+    Heap& heap = Heap::Current();
+    Class cls("Node"s, {}, nullptr);
+    const size_t before = heap.GetStats().objects;
+    ObjectHolder kept;
+    {
+        // Родитель держит детей в списке, дети ссылаются на родителя
+        ObjectHolder parent = ObjectHolder::Own(ClassInstance(cls));
+        ObjectHolder children = ObjectHolder::Make<List>();
+        for (int i = 0; i < 3; ++i) {
+            ObjectHolder child = ObjectHolder::Own(ClassInstance(cls));
+            child.TryAs<ClassInstance>()->Fields()["parent"s] = parent;
+            children.TryAs<List>()->Append(child);
+        }
+        children.TryAs<List>()->Append(ObjectHolder::Make<List>(vector<ObjectHolder>{parent}));
+        parent.TryAs<ClassInstance>()->Fields()["children"s] = children;
+
+        // Тот же цикл, но список доступен из переменной: все его элементы живы
+        ObjectHolder owner = ObjectHolder::Own(ClassInstance(cls));
+        kept = ObjectHolder::Make<List>(vector<ObjectHolder>{owner});
+        owner.TryAs<ClassInstance>()->Fields()["items"s] = kept;
+    }
+    ASSERT_EQUAL(heap.GetStats().objects, before + 5);
+    ASSERT_EQUAL(heap.Collect(), 4U);
+    ASSERT_EQUAL(heap.GetStats().objects, before + 1);
+
+    kept.TryAs<List>()->At(0).TryAs<ClassInstance>()->Fields().clear();
+    kept = {};
+    ASSERT_EQUAL(heap.GetStats().objects, before);
+}
+
+void TestListsAreCopiedBetweenIsolates() {
+    Class cls("Box"s, {}, nullptr);
+    ObjectHolder box = ObjectHolder::Own(ClassInstance(cls));
+    ObjectHolder list = ObjectHolder::Make<List>(vector<ObjectHolder>{ObjectHolder::Own(Number(1)), box, box});
+    list.TryAs<List>()->Append(list);
+    box.TryAs<ClassInstance>()->Fields()["owner"s] = list;
+
+    const Message message = Message::Pack(list);
+    list.TryAs<List>()->Set(0, ObjectHolder::Own(Number(2)));
+
+    ObjectHolder copy = message.Unpack();
+    const auto* copied = copy.TryAs<List>();
+    ASSERT(copied != nullptr && copied != list.TryAs<List>());
+    ASSERT_EQUAL(copied->GetSize(), 4U);
+    ASSERT_EQUAL(copied->At(0).TryAs<Number>()->GetValue(), 1);
+    // Общие ссылки и циклы сохраняются в копии
+    ASSERT(copied->At(1).Get() == copied->At(2).Get());
+    ASSERT(copied->At(1).Get() != box.Get());
+    ASSERT(copied->At(3).Get() == copied);
+    ASSERT(copied->At(1).TryAs<ClassInstance>()->Fields().at("owner"s).Get() == copied);
+
+    // Разорвать циклы, чтобы копия и оригинал освободились подсчётом ссылок
+    box.TryAs<ClassInstance>()->Fields().clear();
+    copied->At(1).TryAs<ClassInstance>()->Fields().clear();
+    list.TryAs<List>()->Set(3, {});
+    copy.TryAs<List>()->Set(3, {});
+}
+
+}  // namespace
+
+void RunListTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestListLiteralsAndIndexing);
+    RUN_TEST(tr, runtime::TestListAppend);
+    RUN_TEST(tr, runtime::TestForLoop);
+    RUN_TEST(tr, runtime::TestNumericBuiltins);
+    RUN_TEST(tr, runtime::TestListStorage);
+    RUN_TEST(tr, runtime::TestPackedListsSaveMemory);
+    RUN_TEST(tr, runtime::TestListTruthEqualityAndPrinting);
+    RUN_TEST(tr, runtime::TestCyclesThroughListsAreCollected);
+    RUN_TEST(tr, runtime::TestListsAreCopiedBetweenIsolates);
+}
+
+}  // namespace runtime
@@ -0,0 +1,204 @@
+#include "client.h"
+#include "mapped_file.h"
+#include "server.h"
+#include "server_protocol.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const string_view USAGE = "Usage: mython_load [--socket SOCKET] [--clients N] [--requests N] [--threads N] [program.py]\n"
+                          "Without --socket an in-process server with --threads workers is started\n"sv;
+
+// Программа по умолчанию: короткий скрипт, зависящий от входных данных
+const string DEFAULT_PROGRAM = R"(
+class Greeter:
+  def __init__(name):
+    self.name = name
+
+  def greet(times):
+    if times > 0:
+      return 'hello, ' + self.name + ' ' + self.greet(times - 1)
+    return '!'
+
+g = Greeter(input)
+print g.greet(10)
+)";
+
+using Clock = chrono::steady_clock;
+
+struct LoadOptions {
+    optional<string> socket_path;
+    size_t clients = 4;
+    size_t requests = 1000;
+    size_t threads = 0;
+    string source = DEFAULT_PROGRAM;
+};
+
+size_t ParseCount(string_view option, string_view text) {
+    size_t value = 0;
+    const auto [rest, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (error != errc{} || rest != text.data() + text.size() || value == 0) {
+        throw invalid_argument("Invalid value of "s + string(option) + ": "s + string(text));
+    }
+    return value;
+}
+
+LoadOptions ParseOptions(int argc, char* argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg == "--socket"sv && i + 1 < argc) {
+            options.socket_path = argv[++i];
+        }
+        else if (arg == "--clients"sv && i + 1 < argc) {
+            options.clients = ParseCount(arg, argv[++i]);
+        }
+        else if (arg == "--requests"sv && i + 1 < argc) {
+            options.requests = ParseCount(arg, argv[++i]);
+        }
+        else if (arg == "--threads"sv && i + 1 < argc) {
+            options.threads = ParseCount(arg, argv[++i]);
+        }
+        else if (arg.size() > 1 && arg.front() == '-') {
+            throw invalid_argument("Unknown option "s + string(arg) + "\n"s + string(USAGE));
+        }
+        else {
+            parse::MappedFile file{string(arg)};
+            options.source = string(file.Data());
+        }
+    }
+    return options;
+}
+
+// Задержки запросов одного клиента. Первый запрос передаёт исходный код, остальные - ключ программы
+struct ClientLatencies {
+    Clock::duration first{};
+    vector<Clock::duration> warm;
+    size_t failed = 0;
+};
+
+ClientLatencies RunClient(const string& socket_path, const LoadOptions& options, size_t id) {
+    ClientLatencies result;
+    result.warm.reserve(options.requests);
+    server::Client client(socket_path);
+    server::Request request;
+    request.source = options.source;
+    for (size_t i = 0; i < options.requests; ++i) {
+        request.input = "client"s + to_string(id) + "-"s + to_string(i);
+        const auto start = Clock::now();
+        server::Response response = client.Execute(request, {});
+        const auto latency = Clock::now() - start;
+        if (!response.error.empty()) {
+            ++result.failed;
+        }
+        if (i == 0) {
+            result.first = latency;
+            request.source.clear();
+            request.key = server::ProgramKey(options.source);
+        }
+        else {
+            result.warm.push_back(latency);
+        }
+    }
+    return result;
+}
+
+double Micros(Clock::duration duration) {
+    return chrono::duration<double, micro>(duration).count();
+}
+
+Clock::duration Percentile(const vector<Clock::duration>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return {};
+    }
+    const auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[min(index, sorted.size() - 1)];
+}
+
+void RunLoad(const LoadOptions& options) {
+    unique_ptr<server::Server> local_server;
+    thread server_thread;
+    string socket_path;
+    if (options.socket_path) {
+        socket_path = *options.socket_path;
+    }
+    else {
+        server::ServerOptions server_options;
+        server_options.socket_path = "/tmp/mython-load-"s + to_string(::getpid()) + ".sock"s;
+        server_options.threads = options.threads;
+        local_server = make_unique<server::Server>(server_options);
+        socket_path = local_server->GetSocketPath();
+        server_thread = thread([&local_server] { local_server->Run(); });
+    }
+
+    vector<ClientLatencies> results(options.clients);
+    const auto start = Clock::now();
+    {
+        vector<thread> clients;
+        for (size_t id = 0; id < options.clients; ++id) {
+            clients.emplace_back([&, id] {
+                try {
+                    results[id] = RunClient(socket_path, options, id);
+                } catch (const exception& e) {
+                    cerr << "client "sv << id << ": "sv << e.what() << endl;
+                    results[id].failed = options.requests;
+                }
+            });
+        }
+        for (thread& client : clients) {
+            client.join();
+        }
+    }
+    const auto elapsed = Clock::now() - start;
+
+    if (local_server) {
+        local_server->Stop();
+        server_thread.join();
+    }
+
+    vector<Clock::duration> warm;
+    Clock::duration first_max{};
+    size_t failed = 0;
+    for (const ClientLatencies& result : results) {
+        warm.insert(warm.end(), result.warm.begin(), result.warm.end());
+        first_max = max(first_max, result.first);
+        failed += result.failed;
+    }
+    sort(warm.begin(), warm.end());
+
+    const size_t total = options.clients * options.requests;
+    cout << fixed << setprecision(1) << "requests="sv << total << " failed="sv << failed
+         << " clients="sv << options.clients << " throughput="sv
+         << static_cast<double>(total) / chrono::duration<double>(elapsed).count() << " req/s\n"sv
+         << "first request (source) max="sv << Micros(first_max) << " us\n"sv
+         << "warm requests (key) p50="sv << Micros(Percentile(warm, 0.5)) << " us p90="sv
+         << Micros(Percentile(warm, 0.9)) << " us p99="sv << Micros(Percentile(warm, 0.99))
+         << " us max="sv << Micros(warm.empty() ? Clock::duration{} : warm.back()) << " us"sv << endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        RunLoad(ParseOptions(argc, argv));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
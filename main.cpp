@@ -1,140 +1,402 @@
-#include "lexer.h"
-#include "parse.h"
-#include "runtime.h"
-#include "statement.h"
-#include "test_runner.h"
-
+#include "batch_runner.h"
+#include "client.h"
+#include "heap.h"
+#include "interpreter.h"
+#include "execution_limits.h"
+#include "mapped_file.h"
+#include "memory_budget.h"
+#include "output_context.h"
+#include "server.h"
+
+#include <cerrno>
+#include <csignal>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
-using namespace std;
-
-namespace parse {
-void RunOpenLexerTests(TestRunner& tr);
-}  // namespace parse
+#include <fcntl.h>
+#include <unistd.h>
 
-namespace ast {
-void RunUnitTests(TestRunner& tr);
-}
-namespace runtime {
-void RunObjectHolderTests(TestRunner& tr);
-void RunObjectsTests(TestRunner& tr);
-}  // namespace runtime
-
-void TestParseProgram(TestRunner& tr);
+using namespace std;
 
 namespace {
 
-void RunMythonProgram(istream& input, ostream& output) {
-    parse::Lexer lexer(input);
-    auto program = ParseProgram(lexer);
+const string_view USAGE = "Usage: mython [--async-output] [--cache-dir DIR | --no-cache] [--lazy-methods] [--stream] [--gc-stats]\n"
+                          "              [--memory-limit BYTES[K|M|G]] [--memory-stats] [--max-steps N] [--timeout SECONDS]\n"
+                          "              [--max-depth N] [--batch N | --serve SOCKET] [--threads N]\n"
+                          "              [--connect SOCKET [--key KEY] [--input FILE] [--print-key]]\n"
+                          "              [--snapshot FILE | --save-snapshot FILE] [program.py [out.txt]]\n"sv;
 
-    runtime::SimpleContext context{output};
-    runtime::Closure closure;
-    program->Execute(closure, context);
+// Каталог кэша по умолчанию: $MYTHON_CACHE_DIR, $XDG_CACHE_HOME/mython или ~/.cache/mython
+string DefaultCacheDir() {
+    if (const char* dir = getenv("MYTHON_CACHE_DIR")) {
+        return dir;
+    }
+    if (const char* dir = getenv("XDG_CACHE_HOME"); dir && *dir) {
+        return dir + "/mython"s;
+    }
+    if (const char* home = getenv("HOME"); home && *home) {
+        return home + "/.cache/mython"s;
+    }
+    return {};
 }
 
-void TestSimplePrints() {
-    istringstream input(R"(
-print 57
-print 10, 24, -8
-print 'hello'
-print "world"
-print True, False
-print
-print None
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
+// Разбирает размер памяти в байтах с необязательным суффиксом K, M или G, например "64M"
+size_t ParseMemorySize(string_view text) {
+    size_t value = 0;
+    const auto [rest, error] = from_chars(text.data(), text.data() + text.size(), value);
+    const string_view suffix = text.substr(static_cast<size_t>(rest - text.data()));
+    size_t unit = 1;
+    if (suffix == "K"sv) {
+        unit = size_t{1} << 10;
+    }
+    else if (suffix == "M"sv) {
+        unit = size_t{1} << 20;
+    }
+    else if (suffix == "G"sv) {
+        unit = size_t{1} << 30;
+    }
+    else if (!suffix.empty()) {
+        unit = 0;
+    }
+    if (error != errc{} || unit == 0 || value == 0 || value > numeric_limits<size_t>::max() / unit) {
+        throw invalid_argument("Invalid memory size "s + string(text));
+    }
+    return value * unit;
 }
 
-void TestAssignments() {
-    istringstream input(R"(
-x = 57
-print x
-x = 'C++ black belt'
-print x
-y = False
-x = y
-print x
-x = None
-print x, y
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
+// Разбирает положительное число option из text
+template <typename T>
+T ParsePositive(string_view option, string_view text) {
+    T value{};
+    const auto [rest, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (error != errc{} || rest != text.data() + text.size() || !(value > T{})) {
+        throw invalid_argument("Invalid value of "s + string(option) + ": "s + string(text));
+    }
+    return value;
 }
 
-void TestArithmetics() {
-    istringstream input("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2");
+// Параметры командной строки интерпретатора
+struct Options {
+    optional<string> program_path;
+    optional<string> output_path;
+    bool async_output = false;
+    // Вывести в stderr показатели кучи и сборщика циклов после выполнения программы
+    bool gc_stats = false;
+    // Ограничение памяти объектов программы в байтах, 0 - без ограничения
+    size_t memory_limit = 0;
+    // Вывести в stderr учтённую память программы по видам
+    bool memory_stats = false;
+    // Наибольшее число шагов программы, 0 - без ограничения
+    uint64_t max_steps = 0;
+    // Наибольшее время выполнения программы в секундах, 0 - без ограничения
+    double timeout = 0;
+    // Число прогонов программы в пакетном режиме (см. RunBatch), 0 - обычный запуск
+    size_t batch_runs = 0;
+    // Число потоков пакетного режима и сервера, 0 - по числу ядер
+    size_t threads = 0;
+    // Сокет, на котором интерпретатор работает сервером (см. server::Server)
+    optional<string> serve_socket;
+    // Сокет сервера, которому передаётся программа, ключ ранее переданной программы и файл входных данных
+    optional<string> connect_socket;
+    optional<string> program_key;
+    optional<string> input_path;
+    // Вывести в stderr ключ программы, переданной серверу
+    bool print_key = false;
+    // Файл, в который сохраняется состояние после выполнения программы
+    optional<string> save_snapshot;
+    RunOptions run;
+};
+
+Options ParseOptions(int argc, char* argv[]) {
+    Options options;
+    options.run.cache_dir = DefaultCacheDir();
+    bool cache_dir_given = false;
+    vector<string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg == "--async-output"sv) {
+            options.async_output = true;
+        }
+        else if (arg == "--lazy-methods"sv) {
+            options.run.lazy_methods = true;
+        }
+        else if (arg == "--gc-stats"sv) {
+            options.gc_stats = true;
+        }
+        else if (arg == "--memory-stats"sv) {
+            options.memory_stats = true;
+        }
+        else if (arg == "--memory-limit"sv && i + 1 < argc) {
+            options.memory_limit = ParseMemorySize(argv[++i]);
+        }
+        else if (arg == "--max-steps"sv && i + 1 < argc) {
+            options.max_steps = ParsePositive<uint64_t>(arg, argv[++i]);
+        }
+        else if (arg == "--max-depth"sv && i + 1 < argc) {
+            options.run.max_depth = ParsePositive<size_t>(arg, argv[++i]);
+        }
+        else if (arg == "--timeout"sv && i + 1 < argc) {
+            options.timeout = ParsePositive<double>(arg, argv[++i]);
+        }
+        else if (arg == "--batch"sv && i + 1 < argc) {
+            options.batch_runs = ParsePositive<size_t>(arg, argv[++i]);
+        }
+        else if (arg == "--threads"sv && i + 1 < argc) {
+            options.threads = ParsePositive<size_t>(arg, argv[++i]);
+        }
+        else if (arg == "--serve"sv && i + 1 < argc) {
+            options.serve_socket = argv[++i];
+        }
+        else if (arg == "--connect"sv && i + 1 < argc) {
+            options.connect_socket = argv[++i];
+        }
+        else if (arg == "--key"sv && i + 1 < argc) {
+            options.program_key = argv[++i];
+        }
+        else if (arg == "--input"sv && i + 1 < argc) {
+            options.input_path = argv[++i];
+        }
+        else if (arg == "--print-key"sv) {
+            options.print_key = true;
+        }
+        else if (arg == "--stream"sv) {
+            options.run.streaming = true;
+        }
+        else if (arg == "--no-cache"sv) {
+            options.run.cache_dir.clear();
+        }
+        else if (arg == "--cache-dir"sv && i + 1 < argc) {
+            options.run.cache_dir = argv[++i];
+            cache_dir_given = true;
+        }
+        else if (arg == "--snapshot"sv && i + 1 < argc) {
+            options.run.snapshot_path = argv[++i];
+        }
+        else if (arg == "--save-snapshot"sv && i + 1 < argc) {
+            options.save_snapshot = argv[++i];
+        }
+        else if (arg.size() > 1 && arg.front() == '-') {
+            throw invalid_argument("Unknown option "s + string(arg) + "\n"s + string(USAGE));
+        }
+        else {
+            positional.emplace_back(arg);
+        }
+    }
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+    const int modes = (options.batch_runs != 0) + options.serve_socket.has_value() + options.connect_socket.has_value()
+        + options.save_snapshot.has_value();
+    const bool special_conflict = (options.batch_runs != 0 || options.serve_socket || options.connect_socket)
+        && (!options.run.snapshot_path.empty() || options.run.streaming);
+    const bool serve_conflict = options.serve_socket && !positional.empty();
+    // Кэш хранит программы с разобранными телами методов, поэтому ленивый разбор его не использует
+    if (options.run.lazy_methods && cache_dir_given) {
+        throw invalid_argument("--lazy-methods can not be used with --cache-dir\n"s + string(USAGE));
+    }
+    if (positional.size() > 2 || (options.save_snapshot && !options.run.snapshot_path.empty()) || modes > 1
+        || special_conflict || serve_conflict) {
+        throw invalid_argument(string(USAGE));
+    }
+    if (!positional.empty() && positional[0] != "-"sv) {
+        options.program_path = positional[0];
+    }
+    if (positional.size() == 2) {
+        options.output_path = positional[1];
+    }
+    return options;
+}
 
-    ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
+// Открывает файл вывода, при его отсутствии создаёт
+int OpenOutput(const string& path) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw system_error(errno, generic_category(), "Can not open "s + path);
+    }
+    return fd;
 }
 
-void TestVariablesArePointers() {
-    istringstream input(R"(
-class Counter:
-  def __init__():
-    self.value = 0
+// Читает исходный код программы из файла options.program_path либо из стандартного ввода
+string ReadSource(const Options& options) {
+    if (options.program_path) {
+        parse::MappedFile file(*options.program_path);
+        return string(file.Data());
+    }
+    return string(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+}
 
-  def add():
-    self.value = self.value + 1
+// Сервер, который останавливается по SIGINT и SIGTERM
+server::Server* running_server = nullptr;
 
-class Dummy:
-  def do_add(counter):
-    counter.add()
+extern "C" void StopServer(int /*signal*/) {
+    if (running_server != nullptr) {
+        running_server->Stop();
+    }
+}
 
-x = Counter()
-y = x
+// Работает сервером интерпретатора до получения SIGINT или SIGTERM
+void Serve(const Options& options) {
+    server::ServerOptions server_options;
+    server_options.socket_path = *options.serve_socket;
+    server_options.threads = options.threads;
+    server_options.lazy_methods = options.run.lazy_methods;
+    server_options.memory_limit = options.memory_limit;
+    server_options.max_steps = options.max_steps;
+    server_options.timeout = chrono::duration_cast<chrono::milliseconds>(chrono::duration<double>(options.timeout));
+
+    server::Server server(server_options);
+    running_server = &server;
+    struct sigaction action{};
+    action.sa_handler = StopServer;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    server.Run();
+    running_server = nullptr;
+    const server::ServerStats stats = server.GetStats();
+    cerr << "requests="sv << stats.requests << " failed="sv << stats.failed << " cache_hits="sv << stats.cache_hits
+         << endl;
+}
 
-x.add()
-y.add()
+// Передаёт программу или её ключ серверу и выводит результат её выполнения
+void RunRemote(const Options& options, runtime::Context& context) {
+    server::Request request;
+    if (options.program_key) {
+        request.key = *options.program_key;
+    }
+    else {
+        request.source = ReadSource(options);
+    }
+    if (options.input_path) {
+        parse::MappedFile input(*options.input_path);
+        request.input = string(input.Data());
+    }
 
-print x.value
+    server::Client client(*options.connect_socket);
+    const server::Response response = client.Execute(request, [&context](string_view output) {
+        context.Write(output);
+    });
+    context.Flush();
+    if (!response.error.empty()) {
+        throw runtime_error(response.error);
+    }
+    if (options.print_key) {
+        cerr << response.key << endl;
+    }
+}
 
-d = Dummy()
-d.do_add(x)
+// Выполняет программу options.batch_runs раз параллельно. Номер прогона доступен программе в переменной
+// batch_index, выводы прогонов записываются по порядку номеров
+void RunProgramBatch(const Options& options, runtime::Context& context) {
+    const CompiledProgram program(ReadSource(options), options.run);
+
+    BatchOptions batch;
+    batch.threads = options.threads;
+    batch.memory_limit = options.memory_limit;
+    batch.max_steps = options.max_steps;
+    const BatchResult result = RunBatch(program, options.batch_runs, [](size_t index, runtime::Closure& globals) {
+        globals["batch_index"s] = runtime::ObjectHolder::Own(runtime::Number(static_cast<int>(index)));
+    }, batch);
+
+    for (size_t i = 0; i < result.outputs.size(); ++i) {
+        context.Write(result.outputs[i]);
+        if (!result.errors[i].empty()) {
+            cerr << "run "sv << i << ": "sv << result.errors[i] << '\n';
+        }
+    }
+    context.Flush();
+    cerr << "runs="sv << result.outputs.size() << " failed="sv << result.failed << " threads="sv << result.threads
+         << " runs_per_second="sv << result.Throughput() << endl;
+    if (result.failed != 0) {
+        throw runtime_error(to_string(result.failed) + " of "s + to_string(result.outputs.size()) + " runs failed"s);
+    }
+}
+
+void RunProgram(const Options& options, const RunOptions& run, runtime::Context& context) {
+    if (options.batch_runs != 0) {
+        RunProgramBatch(options, context);
+    }
+    else if (options.connect_socket) {
+        RunRemote(options, context);
+    }
+    else if (options.save_snapshot) {
+        if (options.program_path) {
+            parse::MappedFile source(*options.program_path);
+            SaveSnapshot(source.Data(), context, *options.save_snapshot);
+        }
+        else {
+            const string source{istreambuf_iterator<char>(cin), istreambuf_iterator<char>()};
+            SaveSnapshot(source, context, *options.save_snapshot);
+        }
+    }
+    else if (options.program_path) {
+        parse::MappedFile source(*options.program_path);
+        RunMythonProgram(source.Data(), context, run);
+    }
+    else {
+        RunMythonProgram(cin, context, run);
+    }
+}
 
-print y.value
-)");
+void Run(const Options& options) {
+    if (options.serve_socket) {
+        Serve(options);
+        return;
+    }
+    const int fd = options.output_path ? OpenOutput(*options.output_path) : STDOUT_FILENO;
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+    runtime::MemoryBudget budget(options.memory_limit);
+    RunOptions run = options.run;
+    if (options.memory_limit != 0 || options.memory_stats) {
+        run.memory_budget = &budget;
+    }
+    runtime::ExecutionLimits limits;
+    if (options.max_steps != 0 || options.timeout != 0) {
+        limits.SetStepLimit(options.max_steps);
+        if (options.timeout != 0) {
+            limits.SetTimeout(chrono::duration_cast<runtime::ExecutionLimits::Clock::duration>(
+                chrono::duration<double>(options.timeout)));
+        }
+        run.limits = &limits;
+    }
 
-    ASSERT_EQUAL(output.str(), "2\n3\n");
-}
+    if (options.async_output) {
+        runtime::AsyncContext context(fd);
+        RunProgram(options, run, context);
+    }
+    else {
+        // В терминал вывод сбрасывается построчно, в файлы и каналы - полными буферами
+        runtime::BufferedContext context(fd, isatty(fd) ? runtime::FlushPolicy::Line : runtime::FlushPolicy::Full);
+        RunProgram(options, run, context);
+    }
 
-void TestAll() {
-    TestRunner tr;
-    parse::RunOpenLexerTests(tr);
-    runtime::RunObjectHolderTests(tr);
-    runtime::RunObjectsTests(tr);
-    ast::RunUnitTests(tr);
-    TestParseProgram(tr);
-
-    RUN_TEST(tr, TestSimplePrints);
-    RUN_TEST(tr, TestAssignments);
-    RUN_TEST(tr, TestArithmetics);
-    RUN_TEST(tr, TestVariablesArePointers);
+    if (options.output_path && ::close(fd) != 0) {
+        throw system_error(errno, generic_category(), "Can not close "s + *options.output_path);
+    }
+    if (options.gc_stats) {
+        cerr << runtime::Heap::Current().GetStats() << endl;
+    }
+    if (options.memory_stats) {
+        cerr << budget << endl;
+    }
 }
 
 }  // namespace
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        TestAll();
-
-        RunMythonProgram(cin, cout);
+        Run(ParseOptions(argc, argv));
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
-		return 1;
+        return 1;
     }
     return 0;
 }
@@ -0,0 +1,79 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace parse {
+
+    MappedFile::MappedFile(const string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw system_error(errno, generic_category(), "Can not open "s + path);
+        }
+
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw system_error(error, generic_category(), "Can not stat "s + path);
+        }
+
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                const int error = errno;
+                ::close(fd);
+                throw system_error(error, generic_category(), "Can not map "s + path);
+            }
+            // Исходный код читается лексером строго последовательно
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+        }
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    MemoryStreamBuf::MemoryStreamBuf(string_view data) {
+        char* begin = const_cast<char*>(data.data());
+        setg(begin, begin, begin + data.size());
+    }
+
+    MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which) {
+        if ((which & ios_base::in) == 0) {
+            return pos_type(off_type(-1));
+        }
+
+        off_type base = 0;
+        if (dir == ios_base::cur) {
+            base = gptr() - eback();
+        }
+        else if (dir == ios_base::end) {
+            base = egptr() - eback();
+        }
+
+        const off_type target = base + off;
+        if (target < 0 || target > egptr() - eback()) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), eback() + target, egptr());
+        return pos_type(target);
+    }
+
+    MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(pos_type pos, ios_base::openmode which) {
+        return seekoff(off_type(pos), ios_base::beg, which);
+    }
+
+}  // namespace parse
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace parse {
+
+    // Файл, отображённый в память только для чтения. Отображение снимается в деструкторе
+    class MappedFile {
+    public:
+        // Отображает файл path в память. Если файл не удаётся открыть, выбрасывает std::system_error
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Возвращает содержимое файла. Для пустого файла возвращается пустая строка
+        [[nodiscard]] std::string_view Data() const {
+            return { data_, size_ };
+        }
+
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Буфер потока ввода, читающий символы прямо из области памяти без копирования
+    class MemoryStreamBuf : public std::streambuf {
+    public:
+        explicit MemoryStreamBuf(std::string_view data);
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+    };
+
+    // Поток ввода поверх области памяти, например поверх MappedFile::Data()
+    class MemoryInputStream : public std::istream {
+    public:
+        explicit MemoryInputStream(std::string_view data)
+            : std::istream(nullptr)
+            , buf_(data) {
+            rdbuf(&buf_);
+        }
+
+    private:
+        MemoryStreamBuf buf_;
+    };
+
+}  // namespace parse
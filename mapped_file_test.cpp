@@ -0,0 +1,78 @@
+#include "lexer.h"
+#include "mapped_file.h"
+#include "test_runner.h"
+
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace parse {
+
+namespace {
+
+// Временный файл с заданным содержимым, удаляется в деструкторе
+class TempSource {
+public:
+    explicit TempSource(const string& content) {
+        char path[] = "/tmp/mython_test_XXXXXX";
+        const int fd = mkstemp(path);
+        if (fd < 0) {
+            throw runtime_error("Can not create temporary file"s);
+        }
+        close(fd);
+        path_ = path;
+        ofstream(path_, ios::binary) << content;
+    }
+
+    ~TempSource() {
+        remove(path_.c_str());
+    }
+
+    [[nodiscard]] const string& Path() const {
+        return path_;
+    }
+
+private:
+    string path_;
+};
+
+void TestMappedFileContent() {
+    TempSource source("x = 4\nprint x\n"s);
+    MappedFile file(source.Path());
+    ASSERT_EQUAL(file.Data(), "x = 4\nprint x\n"sv);
+
+    TempSource empty(""s);
+    ASSERT(MappedFile(empty.Path()).Data().empty());
+
+    ASSERT_THROWS(MappedFile("/nonexistent/mython/source.py"s), system_error);
+}
+
+void TestMemoryInputStream() {
+    MemoryInputStream input("x = 'a'\n"sv);
+    Lexer lexer(input);
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{"x"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{"a"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+
+    MemoryInputStream seekable("abcdef"sv);
+    seekable.get();
+    seekable.get();
+    ASSERT_EQUAL(static_cast<int>(seekable.tellg()), 2);
+    seekable.seekg(4);
+    ASSERT_EQUAL(seekable.get(), 'e');
+}
+
+}  // namespace
+
+void RunMappedFileTests(TestRunner& tr) {
+    RUN_TEST(tr, parse::TestMappedFileContent);
+    RUN_TEST(tr, parse::TestMemoryInputStream);
+}
+
+}  // namespace parse
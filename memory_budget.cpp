@@ -0,0 +1,76 @@
+#include "memory_budget.h"
+
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+    const char* MemoryKindName(MemoryKind kind) {
+        switch (kind) {
+            case MemoryKind::Number:
+                return "number";
+            case MemoryKind::String:
+                return "string";
+            case MemoryKind::Bool:
+                return "bool";
+            case MemoryKind::Instance:
+                return "instance";
+            case MemoryKind::Class:
+                return "class";
+            case MemoryKind::Closure:
+                return "closure";
+            case MemoryKind::List:
+                return "list";
+            case MemoryKind::Dict:
+                return "dict";
+            case MemoryKind::Other:
+                break;
+        }
+        return "other";
+    }
+
+    namespace {
+        void RaisePeak(atomic<size_t>& peak, size_t value) {
+            size_t current = peak.load(memory_order_relaxed);
+            while (value > current && !peak.compare_exchange_weak(current, value, memory_order_relaxed)) {
+            }
+        }
+    }  // namespace
+
+    void MemoryBudget::EnsureAvailable(size_t bytes) {
+        const MemoryBudget* budget = current_;
+        if (budget != nullptr && budget->limit_ != 0 && bytes > budget->limit_ - budget->GetLiveBytes()) {
+            budget->ThrowLimitExceeded(bytes);
+        }
+    }
+
+    void MemoryBudget::AddShared(MemoryKind kind, size_t bytes) {
+        // Память сначала учитывается, а потом проверяется: так два потока не займут один и тот же остаток
+        const size_t live = live_.fetch_add(bytes, memory_order_relaxed) + bytes;
+        if (limit_ != 0 && (bytes > limit_ || live > limit_)) {
+            live_.fetch_sub(bytes, memory_order_relaxed);
+            ThrowLimitExceeded(bytes);
+        }
+        RaisePeak(peak_, live);
+        Usage& usage = kinds_[static_cast<size_t>(kind)];
+        RaisePeak(usage.peak, usage.live.fetch_add(bytes, memory_order_relaxed) + bytes);
+    }
+
+    void MemoryBudget::ThrowLimitExceeded(size_t bytes) const {
+        throw MemoryLimitError("Memory limit of "s + to_string(limit_) + " bytes exceeded: "s
+                               + to_string(GetLiveBytes()) + " bytes in use, "s + to_string(bytes)
+                               + " more requested"s);
+    }
+
+    ostream& operator<<(ostream& os, const MemoryBudget& budget) {
+        os << "live_bytes="sv << budget.GetLiveBytes() << " peak_bytes="sv << budget.GetPeakBytes();
+        for (size_t i = 0; i < MEMORY_KIND_COUNT; ++i) {
+            const auto kind = static_cast<MemoryKind>(i);
+            os << ' ' << MemoryKindName(kind) << "_peak="sv << budget.GetPeakBytes(kind);
+        }
+        return os;
+    }
+
+}  // namespace runtime
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <stdexcept>
+
+namespace runtime {
+
+    // Вид памяти, который учитывает бюджет
+    enum class MemoryKind : uint8_t {
+        Number,
+        String,     // объекты-строки вместе с символами
+        Bool,
+        Instance,   // экземпляры классов без полей
+        Class,
+        Closure,    // поля экземпляров и локальные переменные методов
+        List,       // списки вместе с вектором ссылок на элементы
+        Dict,       // словари вместе с парами и таблицей поиска
+        Other,
+    };
+
+    constexpr size_t MEMORY_KIND_COUNT = static_cast<size_t>(MemoryKind::Other) + 1;
+
+    // Возвращает название вида памяти, например "string"
+    const char* MemoryKindName(MemoryKind kind);
+
+    // Ошибка выполнения программы, превысившей ограничение памяти
+    class MemoryLimitError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /*
+     * Учёт памяти объектов Mython, созданных в одном прогоне программы, и ограничение на её объём.
+     * Бюджет подключается к потоку объектом MemoryBudget::Scope. Пока он подключён, все объекты, поля
+     * и локальные переменные, память под которые выделяется через ObjectPool, и символы строк учитываются
+     * в бюджете, а при превышении ограничения выделение выбрасывает MemoryLimitError.
+     * Освобождённая память вычитается из того бюджета, в котором была учтена, независимо от потока и
+     * бюджета, подключённого в момент освобождения, поэтому бюджет должен пережить учтённые в нём объекты.
+     *
+     * Пока бюджетом пользуется один поток, счётчики изменяются без атомарных операций чтения-записи.
+     * Бюджет, которым начинают пользоваться другие потоки, сначала переводится в общий режим вызовом Share
+     */
+    class MemoryBudget {
+    public:
+        // Бюджет с ограничением limit байт. Нулевое ограничение означает учёт без ограничения
+        explicit MemoryBudget(size_t limit = 0)
+            : limit_(limit) {
+        }
+
+        MemoryBudget(const MemoryBudget&) = delete;
+        MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+        // Подключает бюджет к текущему потоку на время своего существования.
+        // Пустой указатель отключает учёт. По окончании восстанавливается предыдущий бюджет
+        class Scope {
+        public:
+            explicit Scope(MemoryBudget* budget)
+                : previous_(current_) {
+                current_ = budget;
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope() {
+                current_ = previous_;
+            }
+
+        private:
+            MemoryBudget* previous_;
+        };
+
+        // Возвращает бюджет, подключённый к текущему потоку, либо nullptr
+        static MemoryBudget* Current() {
+            return current_;
+        }
+
+        // Учитывает bytes байт вида kind в текущем бюджете потока и возвращает этот бюджет либо nullptr.
+        // Если память не помещается в ограничение, выбрасывает MemoryLimitError и ничего не учитывает
+        static MemoryBudget* Charge(MemoryKind kind, size_t bytes) {
+            MemoryBudget* budget = current_;
+            if (budget != nullptr) {
+                budget->Add(kind, bytes);
+            }
+            return budget;
+        }
+
+        // Вычитает bytes байт вида kind из бюджета budget, который вернул Charge при их учёте
+        static void Release(MemoryBudget* budget, MemoryKind kind, size_t bytes) noexcept {
+            if (budget != nullptr) {
+                budget->Remove(kind, bytes);
+            }
+        }
+
+        // Переводит бюджет в общий режим: после вызова учитывать и освобождать в нём память можно
+        // из любого потока. Вызывается до того, как бюджетом начнут пользоваться другие потоки
+        void Share() noexcept {
+            shared_.store(true, std::memory_order_relaxed);
+        }
+
+        // Проверяет, что в текущем бюджете потока есть bytes свободных байт, иначе выбрасывает MemoryLimitError.
+        // Вызывается перед операциями, которые выделяют память в обход ObjectPool
+        static void EnsureAvailable(size_t bytes);
+
+        [[nodiscard]] size_t GetLimit() const {
+            return limit_;
+        }
+
+        // Текущий и наибольший объём учтённой памяти, всего и по видам
+        [[nodiscard]] size_t GetLiveBytes() const {
+            return live_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] size_t GetPeakBytes() const {
+            return peak_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] size_t GetLiveBytes(MemoryKind kind) const {
+            return kinds_[static_cast<size_t>(kind)].live.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] size_t GetPeakBytes(MemoryKind kind) const {
+            return kinds_[static_cast<size_t>(kind)].peak.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Usage {
+            std::atomic<size_t> live{0};
+            std::atomic<size_t> peak{0};
+        };
+
+        // Счётчики единственного потока изменяются обычными чтением и записью
+        static void Increase(std::atomic<size_t>& live, std::atomic<size_t>& peak, size_t bytes) {
+            const size_t value = live.load(std::memory_order_relaxed) + bytes;
+            live.store(value, std::memory_order_relaxed);
+            if (value > peak.load(std::memory_order_relaxed)) {
+                peak.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        void Add(MemoryKind kind, size_t bytes) {
+            if (shared_.load(std::memory_order_relaxed)) {
+                AddShared(kind, bytes);
+                return;
+            }
+            if (limit_ != 0 && bytes > limit_ - live_.load(std::memory_order_relaxed)) {
+                ThrowLimitExceeded(bytes);
+            }
+            Increase(live_, peak_, bytes);
+            Usage& usage = kinds_[static_cast<size_t>(kind)];
+            Increase(usage.live, usage.peak, bytes);
+        }
+
+        void Remove(MemoryKind kind, size_t bytes) noexcept {
+            Usage& usage = kinds_[static_cast<size_t>(kind)];
+            // Освобождается только учтённая здесь память, поэтому счётчики не уходят в минус
+            assert(bytes <= usage.live.load(std::memory_order_relaxed));
+            if (shared_.load(std::memory_order_relaxed)) {
+                usage.live.fetch_sub(bytes, std::memory_order_relaxed);
+                live_.fetch_sub(bytes, std::memory_order_relaxed);
+                return;
+            }
+            usage.live.store(usage.live.load(std::memory_order_relaxed) - bytes, std::memory_order_relaxed);
+            live_.store(live_.load(std::memory_order_relaxed) - bytes, std::memory_order_relaxed);
+        }
+
+        void AddShared(MemoryKind kind, size_t bytes);
+
+        [[noreturn]] void ThrowLimitExceeded(size_t bytes) const;
+
+        static inline thread_local MemoryBudget* current_ = nullptr;
+
+        size_t limit_;
+        std::atomic<bool> shared_{false};
+        std::atomic<size_t> live_{0};
+        std::atomic<size_t> peak_{0};
+        Usage kinds_[MEMORY_KIND_COUNT];
+    };
+
+    // Выводит учтённую бюджетом память в os: всего и по видам
+    std::ostream& operator<<(std::ostream& os, const MemoryBudget& budget);
+
+}  // namespace runtime
@@ -0,0 +1,68 @@
+#include "bench_runner.h"
+#include "interpreter.h"
+#include "memory_budget.h"
+#include "runtime.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Программа с временными числами, строками и экземплярами
+const string& AllocatingProgram() {
+    static const string program = [] {
+        string result = R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+class Factory:
+  def make(n):
+    p = Point(n, n + 1)
+    s = 'point ' + str(p.x)
+    return p.y
+
+f = Factory()
+)"s;
+        for (int i = 0; i < 50000; ++i) {
+            result += "r = f.make("s + to_string(i) + ")\n"s;
+        }
+        return result;
+    }();
+    return program;
+}
+
+void RunAllocatingProgram(MemoryBudget* budget) {
+    ostringstream output;
+    SimpleContext context(output);
+    RunOptions options;
+    options.memory_budget = budget;
+    RunMythonProgram(AllocatingProgram(), context, options);
+    DoNotOptimize(output);
+}
+
+// Без учёта памяти
+void BenchProgramWithoutBudget() {
+    RunAllocatingProgram(nullptr);
+}
+
+// С учётом памяти по видам и проверкой ограничения на каждом выделении
+void BenchProgramWithBudget() {
+    MemoryBudget budget(1 << 30);
+    RunAllocatingProgram(&budget);
+    DoNotOptimize(budget);
+}
+
+}  // namespace
+
+void RunMemoryBudgetBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, runtime::BenchProgramWithoutBudget);
+    RUN_BENCH(br, runtime::BenchProgramWithBudget);
+}
+
+}  // namespace runtime
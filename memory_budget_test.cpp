@@ -0,0 +1,198 @@
+#include "interpreter.h"
+#include "memory_budget.h"
+#include "runtime.h"
+#include "test_runner.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Программа, удваивающая строку рекурсивными вызовами: строка длины 2^n
+const string DOUBLING_PROGRAM = R"(
+class Grow:
+  def run(s, n):
+    if n > 0:
+      return self.run(s + s, n - 1)
+    return s
+
+g = Grow()
+print 'start'
+s = g.run('abcdefgh', 20)
+print 'done'
+)"s;
+
+void TestChargesByKind() {
+    MemoryBudget budget;
+    Class cls("Point"s, {}, nullptr);
+    {
+        MemoryBudget::Scope scope(&budget);
+        ObjectHolder number = ObjectHolder::Own(Number(1));
+        ObjectHolder text = ObjectHolder::Own(String(string(1000, 'x')));
+        ObjectHolder point = ObjectHolder::Own(ClassInstance(cls));
+        point.TryAs<ClassInstance>()->Fields()["x"s] = number;
+
+        ASSERT(budget.GetLiveBytes(MemoryKind::Number) >= sizeof(Number));
+        // Символы длинной строки учитываются вместе с объектом
+        ASSERT(budget.GetLiveBytes(MemoryKind::String) > 1000);
+        ASSERT(budget.GetLiveBytes(MemoryKind::Instance) >= sizeof(ClassInstance));
+        ASSERT(budget.GetLiveBytes(MemoryKind::Closure) > 0);
+        ASSERT_EQUAL(budget.GetLiveBytes(MemoryKind::Class), 0U);
+
+        size_t total = 0;
+        for (size_t i = 0; i < MEMORY_KIND_COUNT; ++i) {
+            total += budget.GetLiveBytes(static_cast<MemoryKind>(i));
+        }
+        ASSERT_EQUAL(budget.GetLiveBytes(), total);
+    }
+    ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+    ASSERT(budget.GetPeakBytes(MemoryKind::String) > 1000);
+    ASSERT(budget.GetPeakBytes() >= budget.GetPeakBytes(MemoryKind::String));
+
+    // Вне области бюджета выделения не учитываются
+    ObjectHolder outside = ObjectHolder::Own(Number(2));
+    ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+}
+
+void TestLimitRejectsAllocation() {
+    MemoryBudget budget(256);
+    MemoryBudget::Scope scope(&budget);
+    vector<ObjectHolder> numbers;
+    try {
+        for (int i = 0; i < 100; ++i) {
+            numbers.push_back(ObjectHolder::Own(Number(i)));
+        }
+        ASSERT(false);
+    } catch (const MemoryLimitError&) {
+    }
+    ASSERT(!numbers.empty());
+    ASSERT(budget.GetLiveBytes() <= budget.GetLimit());
+    ASSERT_EQUAL(budget.GetPeakBytes(), budget.GetLiveBytes());
+
+    numbers.clear();
+    ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+    ASSERT_EQUAL(MemoryBudget::Current(), &budget);
+}
+
+void TestProgramExceedingLimit() {
+    for (const bool streaming : {false, true}) {
+        MemoryBudget budget(1 << 20);
+        ostringstream output;
+        SimpleContext context(output);
+        RunOptions options;
+        options.streaming = streaming;
+        options.memory_budget = &budget;
+        try {
+            RunMythonProgram(DOUBLING_PROGRAM, context, options);
+            ASSERT(false);
+        } catch (const MemoryLimitError&) {
+        }
+        // Инструкции до превышения выполнены, а вся память прогона освобождена
+        ASSERT_EQUAL(output.str(), "start\n"s);
+        ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+        ASSERT(budget.GetPeakBytes() <= budget.GetLimit());
+        ASSERT(budget.GetPeakBytes(MemoryKind::String) > budget.GetLimit() / 4);
+        ASSERT_EQUAL(MemoryBudget::Current(), nullptr);
+    }
+}
+
+void TestProgramWithinLimit() {
+    MemoryBudget budget(64 << 20);
+    istringstream input(DOUBLING_PROGRAM);
+    ostringstream output;
+    SimpleContext context(output);
+    RunOptions options;
+    options.memory_budget = &budget;
+    RunMythonProgram(input, context, options);
+
+    ASSERT_EQUAL(output.str(), "start\ndone\n"s);
+    ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+    ASSERT(budget.GetPeakBytes(MemoryKind::String) > (size_t{8} << 20));
+    ASSERT(budget.GetPeakBytes(MemoryKind::Class) > 0);
+    ASSERT(budget.GetPeakBytes(MemoryKind::Instance) > 0);
+    ASSERT(budget.GetPeakBytes(MemoryKind::Closure) > 0);
+}
+
+void TestInstancesExceedingLimit() {
+    const string program = R"(
+class Node:
+  def __init__(next):
+    self.next = next
+
+class Builder:
+  def build(head, n):
+    if n > 0:
+      # Не хвостовой вызов: кадр каждого шага остаётся в стеке
+      tail = self.build(Node(head), n - 1)
+      return tail
+    return head
+
+b = Builder()
+list = b.build(None, 1000)
+)"s;
+    MemoryBudget budget(16 << 10);
+    ostringstream output;
+    SimpleContext context(output);
+    RunOptions options;
+    options.memory_budget = &budget;
+    try {
+        RunMythonProgram(program, context, options);
+        ASSERT(false);
+    } catch (const MemoryLimitError&) {
+    }
+    ASSERT_EQUAL(budget.GetLiveBytes(), 0U);
+    ASSERT(budget.GetPeakBytes(MemoryKind::Instance) > 0);
+    ASSERT(budget.GetPeakBytes(MemoryKind::Closure) > budget.GetPeakBytes(MemoryKind::Instance));
+}
+
+// Память возвращается бюджету, в котором учтена, а не подключённому при освобождении
+void TestReleaseReturnsToChargingBudget() {
+    MemoryBudget first;
+    MemoryBudget second;
+    ObjectHolder text;
+    {
+        MemoryBudget::Scope scope(&first);
+        text = ObjectHolder::Own(String(string(1000, 'x')));
+    }
+    ObjectHolder outside = ObjectHolder::Own(Number(1));
+    const size_t charged = first.GetLiveBytes();
+    ASSERT(charged > 1000);
+    {
+        MemoryBudget::Scope scope(&second);
+        ObjectHolder number = ObjectHolder::Own(Number(2));
+        text = ObjectHolder();
+        outside = ObjectHolder();
+        ASSERT_EQUAL(first.GetLiveBytes(), 0U);
+        ASSERT(second.GetLiveBytes() > 0);
+    }
+    ASSERT_EQUAL(second.GetLiveBytes(), 0U);
+    ASSERT_EQUAL(first.GetPeakBytes(), charged);
+
+    // Бюджет в общем режиме учитывает память, освобождённую в другом потоке
+    first.Share();
+    {
+        MemoryBudget::Scope scope(&first);
+        text = ObjectHolder::Own(String(string(1000, 'y')));
+    }
+    thread([holder = std::move(text)]() mutable {
+        holder = ObjectHolder();
+    }).join();
+    ASSERT_EQUAL(first.GetLiveBytes(), 0U);
+}
+
+}  // namespace
+
+void RunMemoryBudgetTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestChargesByKind);
+    RUN_TEST(tr, runtime::TestLimitRejectsAllocation);
+    RUN_TEST(tr, runtime::TestProgramExceedingLimit);
+    RUN_TEST(tr, runtime::TestProgramWithinLimit);
+    RUN_TEST(tr, runtime::TestInstancesExceedingLimit);
+    RUN_TEST(tr, runtime::TestReleaseReturnsToChargingBudget);
+}
+
+}  // namespace runtime
@@ -0,0 +1,169 @@
+#include "object_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        // Признак того, что пул потока разрушен. Переменная тривиально разрушаемая,
+        // поэтому её можно читать и после разрушения пула
+        thread_local bool pool_destroyed = false;
+
+        constexpr size_t SIZE_CLASSES = ObjectPool::MAX_BLOCK_SIZE / ObjectPool::GRANULARITY;
+
+        // Куски памяти всех пулов и свободные блоки завершившихся потоков с их объёмом по классам размера.
+        // Кусок освобождается только целиком свободным: его блоки могли перейти в пулы других потоков
+        struct SharedState {
+            mutex lock;
+            unordered_set<char*> chunks;
+            void* orphans[SIZE_CLASSES] = {};
+            size_t orphan_bytes[SIZE_CLASSES] = {};
+        };
+
+        SharedState& Shared() {
+            // Не разрушается при завершении процесса: объекты статических переменных могут освобождаться позже
+            static auto* state = new SharedState;
+            return *state;
+        }
+
+        // Куски выровнены на свой размер, поэтому кусок блока находится по его адресу
+        uintptr_t ChunkOf(const void* block) {
+            return reinterpret_cast<uintptr_t>(block) & ~(ObjectPool::CHUNK_SIZE - 1);
+        }
+    }  // namespace
+
+    ObjectPool::~ObjectPool() {
+        pool_destroyed = true;
+
+        SharedState& shared = Shared();
+        lock_guard guard(shared.lock);
+        for (size_t size_class = 0; size_class < SIZE_CLASSES; ++size_class) {
+            while (FreeBlock* block = free_[size_class]) {
+                free_[size_class] = block->next;
+                shared.orphans[size_class] = new (block) FreeBlock{static_cast<FreeBlock*>(shared.orphans[size_class])};
+                shared.orphan_bytes[size_class] += (size_class + 1) * GRANULARITY;
+            }
+        }
+    }
+
+    ObjectPool* ObjectPool::Current() {
+        if (pool_destroyed) {
+            return nullptr;
+        }
+        thread_local ObjectPool pool;
+        return &pool;
+    }
+
+    PoolStats ObjectPool::GetStats() const {
+        return stats_;
+    }
+
+    void* ObjectPool::AllocateSlow(size_t size_class) {
+        const size_t size = (size_class + 1) * GRANULARITY;
+        if (static_cast<size_t>(bump_end_ - bump_) < size) {
+            SharedState& shared = Shared();
+            lock_guard guard(shared.lock);
+
+            // Сначала забираем свободные блоки завершившихся потоков
+            if (void* orphans = shared.orphans[size_class]) {
+                shared.orphans[size_class] = nullptr;
+                free_bytes_ += shared.orphan_bytes[size_class] - size;
+                shared.orphan_bytes[size_class] = 0;
+                auto* block = static_cast<FreeBlock*>(orphans);
+                free_[size_class] = block->next;
+                ++stats_.reused;
+                return block;
+            }
+
+            // Остаток текущего куска раздаётся по спискам, чтобы не пропадать. FreeBlockTo не подходит:
+            // Trim захватывает блокировку, которая уже взята
+            while (bump_ != bump_end_) {
+                const size_t rest_class = min(SizeClass(static_cast<size_t>(bump_end_ - bump_)), SIZE_CLASSES - 1);
+                const size_t rest_size = (rest_class + 1) * GRANULARITY;
+                free_[rest_class] = new (bump_) FreeBlock{free_[rest_class]};
+                free_bytes_ += rest_size;
+                bump_ += rest_size;
+            }
+
+            bump_ = static_cast<char*>(::operator new(CHUNK_SIZE, align_val_t{CHUNK_SIZE}));
+            shared.chunks.insert(bump_);
+            bump_end_ = bump_ + CHUNK_SIZE;
+            stats_.reserved_bytes += CHUNK_SIZE;
+        }
+
+        void* block = bump_;
+        bump_ += size;
+        return block;
+    }
+
+    void ObjectPool::FreeOrphan(void* block, size_t size_class) noexcept {
+        SharedState& shared = Shared();
+        lock_guard guard(shared.lock);
+        shared.orphans[size_class] = new (block) FreeBlock{static_cast<FreeBlock*>(shared.orphans[size_class])};
+        shared.orphan_bytes[size_class] += (size_class + 1) * GRANULARITY;
+    }
+
+    void ObjectPool::Trim() noexcept {
+        SharedState& shared = Shared();
+        lock_guard guard(shared.lock);
+        try {
+            // Объём свободных блоков каждого куска. Кусок свободен целиком, если этот объём равен его размеру:
+            // блоки, которые заняты или лежат в списках других живых потоков, в подсчёт не попадают
+            unordered_map<uintptr_t, size_t> free_in_chunk;
+            for (size_t size_class = 0; size_class < SIZE_CLASSES; ++size_class) {
+                const size_t size = (size_class + 1) * GRANULARITY;
+                for (FreeBlock* block = free_[size_class]; block != nullptr; block = block->next) {
+                    free_in_chunk[ChunkOf(block)] += size;
+                }
+                for (auto* block = static_cast<FreeBlock*>(shared.orphans[size_class]); block != nullptr;
+                     block = block->next) {
+                    free_in_chunk[ChunkOf(block)] += size;
+                }
+            }
+            for (auto it = free_in_chunk.begin(); it != free_in_chunk.end();) {
+                it = it->second == CHUNK_SIZE ? next(it) : free_in_chunk.erase(it);
+            }
+
+            if (!free_in_chunk.empty()) {
+                // Убирает из списка блоки освобождаемых кусков и возвращает их объём
+                const auto unlink = [&free_in_chunk](FreeBlock*& list, size_t size) {
+                    size_t removed = 0;
+                    for (FreeBlock** link = &list; *link != nullptr;) {
+                        if (free_in_chunk.count(ChunkOf(*link)) != 0) {
+                            *link = (*link)->next;
+                            removed += size;
+                        }
+                        else {
+                            link = &(*link)->next;
+                        }
+                    }
+                    return removed;
+                };
+                for (size_t size_class = 0; size_class < SIZE_CLASSES; ++size_class) {
+                    const size_t size = (size_class + 1) * GRANULARITY;
+                    free_bytes_ -= unlink(free_[size_class], size);
+                    auto* orphans = static_cast<FreeBlock*>(shared.orphans[size_class]);
+                    shared.orphan_bytes[size_class] -= unlink(orphans, size);
+                    shared.orphans[size_class] = orphans;
+                }
+                for (const auto& [chunk, size] : free_in_chunk) {
+                    auto* memory = reinterpret_cast<char*>(chunk);
+                    shared.chunks.erase(memory);
+                    ::operator delete(memory, align_val_t{CHUNK_SIZE});
+                    stats_.released_bytes += CHUNK_SIZE;
+                }
+            }
+        }
+        catch (const bad_alloc&) {
+            // Без памяти для подсчёта куски освобождаются при следующем просмотре
+        }
+        trim_threshold_ = max(TRIM_THRESHOLD, 2 * free_bytes_);
+    }
+
+}  // namespace runtime
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "memory_budget.h"
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+namespace runtime {
+
+    // Показатели пула объектов текущего потока
+    struct PoolStats {
+        // Число блоков, выданных пулом
+        size_t allocations = 0;
+        // Число блоков, выданных повторно из списков освобождённых
+        size_t reused = 0;
+        // Объём памяти, полученной пулом у системы, в байтах
+        size_t reserved_bytes = 0;
+        // Объём памяти, возвращённой пулом системе, в байтах
+        size_t released_bytes = 0;
+    };
+
+    /*
+     * Пул памяти для объектов Mython текущего потока.
+     * Новые блоки выделяются сдвигом указателя в текущем куске памяти, освобождённые блоки попадают
+     * в список своего класса размера и выдаются снова первыми. Временные значения (результаты арифметики,
+     * склеенные строки, экземпляры, возвращённые из __add__) освобождаются подсчётом ссылок сразу после
+     * использования, поэтому почти все выделения обслуживаются из горячего списка без обращения к malloc.
+     *
+     * Блок, освобождённый в другом потоке, попадает в пул этого потока, а свободные блоки завершившегося
+     * потока переходят к потокам, созданным позже. Когда в списках свободных блоков пула накапливается
+     * больше TRIM_THRESHOLD байт, пул возвращает системе куски памяти, все блоки которых свободны и лежат
+     * в его списках или в списках завершившихся потоков. Так память, освобождённая в одном классе размера,
+     * становится доступна другим. Порог после этого растёт вместе с оставшимися свободными блоками, чтобы
+     * просмотр списков занимал в среднем постоянное время на освобождение.
+     * Блоки больше MAX_BLOCK_SIZE выделяются operator new.
+     *
+     * Каждый блок учитывается в бюджете памяти потока (MemoryBudget) с полным размером блока.
+     * В конце блока хранится указатель на этот бюджет: при освобождении блок возвращается ему,
+     * в каком бы потоке и с каким бы подключённым бюджетом ни освобождался
+     */
+    class ObjectPool {
+    public:
+        static constexpr size_t GRANULARITY = 16;
+        static constexpr size_t MAX_BLOCK_SIZE = 512;
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+        static constexpr size_t TRIM_THRESHOLD = 4 * CHUNK_SIZE;
+
+        ObjectPool() = default;
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+        ~ObjectPool();
+
+        // Возвращает пул текущего потока либо nullptr, если поток уже завершается и пул разрушен
+        static ObjectPool* Current();
+
+        // Выделяет блок не меньше size байт, выровненный на GRANULARITY, и учитывает его как память вида kind.
+        // Если блок не помещается в бюджет памяти потока, выбрасывает MemoryLimitError
+        static void* Allocate(size_t size, MemoryKind kind = MemoryKind::Other);
+        // Освобождает блок, выделенный Allocate с теми же size и kind
+        static void Deallocate(void* block, size_t size, MemoryKind kind = MemoryKind::Other) noexcept;
+
+        [[nodiscard]] PoolStats GetStats() const;
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        static constexpr size_t SIZE_CLASSES = MAX_BLOCK_SIZE / GRANULARITY;
+
+        static constexpr size_t SizeClass(size_t size) {
+            return (size + GRANULARITY - 1) / GRANULARITY - 1;
+        }
+
+        // Смещение указателя на бюджет в блоке под объект из size байт
+        static constexpr size_t BudgetOffset(size_t size) {
+            return (size + alignof(MemoryBudget*) - 1) / alignof(MemoryBudget*) * alignof(MemoryBudget*);
+        }
+
+        // Число байт, которое занимают объект из size байт и указатель на бюджет
+        static constexpr size_t WithBudget(size_t size) {
+            return BudgetOffset(size) + sizeof(MemoryBudget*);
+        }
+
+        // Размер блока, который выдаётся на запрос size байт вместе с указателем на бюджет
+        static constexpr size_t BlockSize(size_t size) {
+            return size > MAX_BLOCK_SIZE ? size : (SizeClass(size) + 1) * GRANULARITY;
+        }
+
+        void* AllocateBlock(size_t size_class);
+        void* AllocateSlow(size_t size_class);
+        void FreeBlockTo(void* block, size_t size_class) noexcept;
+        // Возвращает системе куски памяти, все блоки которых свободны
+        void Trim() noexcept;
+        // Передаёт блок в общий список свободных блоков завершившихся потоков
+        static void FreeOrphan(void* block, size_t size_class) noexcept;
+
+        FreeBlock* free_[SIZE_CLASSES] = {};
+        char* bump_ = nullptr;
+        char* bump_end_ = nullptr;
+        // Объём блоков в списках free_ и порог, после которого вызывается Trim
+        size_t free_bytes_ = 0;
+        size_t trim_threshold_ = TRIM_THRESHOLD;
+        PoolStats stats_;
+    };
+
+    // Аллокатор для std::allocate_shared и контейнеров, выделяющий память из ObjectPool.
+    // Вид памяти для учёта в бюджете сохраняется при приведении к аллокатору другого типа
+    template <typename T>
+    class PoolAllocator {
+    public:
+        static_assert(alignof(T) <= ObjectPool::GRANULARITY, "ObjectPool does not support over-aligned types");
+
+        using value_type = T;
+
+        PoolAllocator() noexcept = default;
+
+        explicit PoolAllocator(MemoryKind kind) noexcept
+            : kind_(kind) {
+        }
+
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>& other) noexcept  // NOLINT(google-explicit-constructor)
+            : kind_(other.GetKind()) {
+        }
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(ObjectPool::Allocate(n * sizeof(T), kind_));
+        }
+
+        void deallocate(T* p, size_t n) noexcept {
+            ObjectPool::Deallocate(p, n * sizeof(T), kind_);
+        }
+
+        [[nodiscard]] MemoryKind GetKind() const noexcept {
+            return kind_;
+        }
+
+        template <typename U>
+        bool operator==(const PoolAllocator<U>& /*other*/) const noexcept {
+            return true;
+        }
+
+        template <typename U>
+        bool operator!=(const PoolAllocator<U>& /*other*/) const noexcept {
+            return false;
+        }
+
+    private:
+        MemoryKind kind_ = MemoryKind::Other;
+    };
+
+    inline void* ObjectPool::Allocate(size_t size, MemoryKind kind) {
+        const size_t full = WithBudget(size);
+        MemoryBudget* budget = MemoryBudget::Charge(kind, BlockSize(full));
+        void* block = nullptr;
+        if (full > MAX_BLOCK_SIZE) {
+            block = ::operator new(full);
+        }
+        else if (ObjectPool* pool = Current()) {
+            block = pool->AllocateBlock(SizeClass(full));
+        }
+        else {
+            block = ::operator new((SizeClass(full) + 1) * GRANULARITY);
+        }
+        std::memcpy(static_cast<char*>(block) + BudgetOffset(size), &budget, sizeof(budget));
+        return block;
+    }
+
+    inline void ObjectPool::Deallocate(void* block, size_t size, MemoryKind kind) noexcept {
+        const size_t full = WithBudget(size);
+        MemoryBudget* budget = nullptr;
+        std::memcpy(&budget, static_cast<char*>(block) + BudgetOffset(size), sizeof(budget));
+        MemoryBudget::Release(budget, kind, BlockSize(full));
+        if (full > MAX_BLOCK_SIZE) {
+            ::operator delete(block);
+            return;
+        }
+        if (ObjectPool* pool = Current()) {
+            pool->FreeBlockTo(block, SizeClass(full));
+        }
+        else {
+            FreeOrphan(block, SizeClass(full));
+        }
+    }
+
+    inline void* ObjectPool::AllocateBlock(size_t size_class) {
+        ++stats_.allocations;
+        if (FreeBlock* block = free_[size_class]) {
+            free_[size_class] = block->next;
+            free_bytes_ -= (size_class + 1) * GRANULARITY;
+            ++stats_.reused;
+            return block;
+        }
+        return AllocateSlow(size_class);
+    }
+
+    inline void ObjectPool::FreeBlockTo(void* block, size_t size_class) noexcept {
+        free_[size_class] = new (block) FreeBlock{free_[size_class]};
+        free_bytes_ += (size_class + 1) * GRANULARITY;
+        if (free_bytes_ > trim_threshold_) {
+            Trim();
+        }
+    }
+
+}  // namespace runtime
@@ -0,0 +1,105 @@
+#include "bench_runner.h"
+#include "interpreter.h"
+#include "runtime.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+constexpr int ALLOCATIONS = 1'000'000;
+
+// Временные значения через std::make_shared, как до появления пула
+void BenchMakeSharedTemporaries() {
+    for (int i = 0; i < ALLOCATIONS; ++i) {
+        shared_ptr<Object> number = make_shared<Number>(i);
+        shared_ptr<Object> text = make_shared<String>("temporary"s);
+        DoNotOptimize(number);
+        DoNotOptimize(text);
+    }
+}
+
+// Те же временные значения через ObjectHolder::Own и пул объектов
+void BenchPoolTemporaries() {
+    for (int i = 0; i < ALLOCATIONS; ++i) {
+        ObjectHolder number = ObjectHolder::Own(Number(i));
+        ObjectHolder text = ObjectHolder::Own(String("temporary"s));
+        DoNotOptimize(number);
+        DoNotOptimize(text);
+    }
+}
+
+// Программа, порождающая временные экземпляры в __add__, как в примере Fire/Matches из README
+void BenchTemporaryInstancesProgram() {
+    static const string program = [] {
+        string result = R"(
+class Fire:
+  def __init__(obj):
+    self.obj = obj
+
+class Matches:
+  def __init__(n):
+    self.n = n
+
+  def __add__(smth):
+    return Fire(self)
+
+m = Matches(1)
+)"s;
+        for (int i = 0; i < 50000; ++i) {
+            result += "f = m + "s + to_string(i) + "\no = f.obj\nx = o.n * 2 + 1\n"s;
+        }
+        return result;
+    }();
+
+    istringstream input(program);
+    ostringstream output;
+    RunMythonProgram(input, output);
+    DoNotOptimize(output);
+}
+
+// Создание множества небольших экземпляров с полями
+void BenchCreatePoints() {
+    static const string program = [] {
+        string result = R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+    self.z = 0
+
+class Factory:
+  def make(n):
+    p = Point(n, n + 1)
+    q = Point(p.x, p.y)
+    return q.y
+
+f = Factory()
+)"s;
+        for (int i = 0; i < 50000; ++i) {
+            result += "r = f.make("s + to_string(i) + ")\n"s;
+        }
+        return result;
+    }();
+
+    istringstream input(program);
+    ostringstream output;
+    RunMythonProgram(input, output);
+    DoNotOptimize(output);
+}
+
+}  // namespace
+
+void RunObjectPoolBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, runtime::BenchMakeSharedTemporaries);
+    RUN_BENCH(br, runtime::BenchPoolTemporaries);
+    RUN_BENCH(br, runtime::BenchTemporaryInstancesProgram);
+    RUN_BENCH(br, runtime::BenchCreatePoints);
+}
+
+}  // namespace runtime
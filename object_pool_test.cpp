@@ -0,0 +1,142 @@
+#include "lexer.h"
+#include "object_pool.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+#include "test_runner.h"
+
+#include <cstdint>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestBlocksAreReused() {
+    ObjectPool& pool = *ObjectPool::Current();
+    const PoolStats before = pool.GetStats();
+
+    void* first = ObjectPool::Allocate(33);
+    ASSERT_EQUAL(reinterpret_cast<uintptr_t>(first) % ObjectPool::GRANULARITY, 0U);
+    ObjectPool::Deallocate(first, 33);
+
+    // Блок того же класса размера выдаётся снова, блок другого класса - нет.
+    // Вместе с указателем на бюджет оба запроса занимают блок из 48 байт
+    void* same = ObjectPool::Allocate(40);
+    ASSERT(same == first);
+    void* other = ObjectPool::Allocate(64);
+    ASSERT(other != first);
+    ObjectPool::Deallocate(same, 40);
+    ObjectPool::Deallocate(other, 64);
+
+    const PoolStats after = pool.GetStats();
+    ASSERT_EQUAL(after.allocations - before.allocations, 3U);
+    ASSERT(after.reused - before.reused >= 1U);
+}
+
+void TestDistinctLiveBlocks() {
+    vector<void*> blocks;
+    set<void*> unique_blocks;
+    for (size_t size = 1; size <= ObjectPool::MAX_BLOCK_SIZE * 2; size += 7) {
+        void* block = ObjectPool::Allocate(size);
+        // Блок целиком доступен для записи
+        fill_n(static_cast<char*>(block), size, 'x');
+        blocks.push_back(block);
+        unique_blocks.insert(block);
+    }
+    ASSERT_EQUAL(unique_blocks.size(), blocks.size());
+
+    size_t size = 1;
+    for (void* block : blocks) {
+        ObjectPool::Deallocate(block, size);
+        size += 7;
+    }
+}
+
+void TestObjectsAcrossThreads() {
+    // Объект, созданный в одном потоке, может быть освобождён в другом
+    ObjectHolder text = ObjectHolder::Own(String("shared between threads"s));
+    thread([holder = std::move(text)]() mutable {
+        ASSERT_EQUAL(holder.TryAs<String>()->GetValue(), "shared between threads"s);
+        ObjectHolder local = ObjectHolder::Own(Number(1));
+        holder = ObjectHolder();
+    }).join();
+
+    // Объекты, пережившие поток, в котором созданы
+    ObjectHolder survivor;
+    thread([&survivor] {
+        survivor = ObjectHolder::Own(Number(57));
+    }).join();
+    ASSERT_EQUAL(survivor.TryAs<Number>()->GetValue(), 57);
+}
+
+void TestFreeChunksAreReleased() {
+    // Каждый раунд выделяет и освобождает мегабайт блоков своего класса размера. Без возврата свободных
+    // кусков память пула росла бы на мегабайт за раунд
+    constexpr size_t ROUND_BYTES = 1024 * 1024;
+    constexpr size_t ROUNDS = 64;
+    PoolStats before;
+    PoolStats after;
+    thread([&] {
+        const ObjectPool& pool = *ObjectPool::Current();
+        vector<void*> blocks;
+        for (size_t round = 0; round < ROUNDS; ++round) {
+            const size_t size = (round % 24 + 1) * ObjectPool::GRANULARITY;
+            for (size_t allocated = 0; allocated < ROUND_BYTES; allocated += size) {
+                blocks.push_back(ObjectPool::Allocate(size));
+            }
+            for (void* block : blocks) {
+                ObjectPool::Deallocate(block, size);
+            }
+            blocks.clear();
+            if (round == 1) {
+                before = pool.GetStats();
+            }
+        }
+        after = pool.GetStats();
+    }).join();
+
+    ASSERT(after.released_bytes > before.released_bytes);
+    const size_t held = after.reserved_bytes - after.released_bytes;
+    ASSERT(held <= before.reserved_bytes - before.released_bytes + 2 * ROUND_BYTES);
+}
+
+void TestInstanceFieldsAreReserved() {
+    istringstream input("class Point:\n  def __init__(x, y):\n    self.x = x\n    self.y = y\n    self.z = 0\n"s);
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+    DummyContext context;
+    Closure globals;
+    program->Execute(globals, context);
+    const auto& cls = *globals.at("Point"s).TryAs<Class>();
+    ASSERT_EQUAL(cls.GetFieldsHint(), 0U);
+
+    vector<unique_ptr<ast::Statement>> args;
+    args.push_back(make_unique<ast::NumericConst>(1));
+    args.push_back(make_unique<ast::NumericConst>(2));
+    ast::NewInstance first(cls, std::move(args));
+    ASSERT_EQUAL(first.Execute(globals, context).TryAs<ClassInstance>()->Fields().size(), 3U);
+    ASSERT_EQUAL(cls.GetFieldsHint(), 3U);
+
+    // Следующие экземпляры создаются с корзинами под все поля
+    ObjectHolder second = ObjectHolder::Make<ClassInstance>(cls);
+    const size_t buckets = second.TryAs<ClassInstance>()->Fields().bucket_count();
+    ASSERT(buckets * second.TryAs<ClassInstance>()->Fields().max_load_factor() >= 3);
+}
+
+}  // namespace
+
+void RunObjectPoolTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestBlocksAreReused);
+    RUN_TEST(tr, runtime::TestDistinctLiveBlocks);
+    RUN_TEST(tr, runtime::TestObjectsAcrossThreads);
+    RUN_TEST(tr, runtime::TestFreeChunksAreReleased);
+    RUN_TEST(tr, runtime::TestInstanceFieldsAreReserved);
+}
+
+}  // namespace runtime
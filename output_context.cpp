@@ -0,0 +1,250 @@
+#include "output_context.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        // Дописывает оба фрагмента одним вызовом writev, досылая остаток после частичной записи
+        void WriteAll(int fd, string_view first, string_view second) {
+            iovec parts[2] = {
+                { const_cast<char*>(first.data()), first.size() },
+                { const_cast<char*>(second.data()), second.size() },
+            };
+            iovec* current = parts;
+            int count = 2;
+
+            while (count > 0) {
+                const ssize_t written = ::writev(fd, current, count);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw system_error(errno, generic_category(), "writev"s);
+                }
+
+                size_t rest = static_cast<size_t>(written);
+                while (count > 0 && rest >= current->iov_len) {
+                    rest -= current->iov_len;
+                    ++current;
+                    --count;
+                }
+                if (count > 0) {
+                    current->iov_base = static_cast<char*>(current->iov_base) + rest;
+                    current->iov_len -= rest;
+                }
+            }
+        }
+    }  // namespace
+
+    ContextStreamBuf::int_type ContextStreamBuf::overflow(int_type ch) {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            const char c = traits_type::to_char_type(ch);
+            context_.Write({ &c, 1 });
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    streamsize ContextStreamBuf::xsputn(const char* s, streamsize count) {
+        context_.Write({ s, static_cast<size_t>(count) });
+        return count;
+    }
+
+    int ContextStreamBuf::sync() {
+        context_.Flush();
+        return 0;
+    }
+
+    void WriteAll(int fd, const char* data, size_t size) {
+        WriteAll(fd, string_view(data, size), string_view());
+    }
+
+    BufferedContext::BufferedContext(int fd, FlushPolicy policy, size_t capacity, size_t threshold)
+        : fd_(fd)
+        , policy_(policy)
+        , capacity_(max<size_t>(capacity, 1))
+        , threshold_(threshold == 0 ? capacity_ : min(threshold, capacity_))
+        , buffer_(make_unique<char[]>(capacity_)) {
+    }
+
+    BufferedContext::~BufferedContext() {
+        try {
+            Flush();
+        }
+        catch (...) {
+            // Деструктор не должен выбрасывать исключений, недописанный вывод теряется
+        }
+    }
+
+    ostream& BufferedContext::GetOutputStream() {
+        return stream_;
+    }
+
+    void BufferedContext::Write(string_view data) {
+        if (data.size() <= capacity_ - size_) {
+            memcpy(buffer_.get() + size_, data.data(), data.size());
+            size_ += data.size();
+        }
+        else {
+            // Данные не помещаются: буфер и новый фрагмент уходят одним системным вызовом
+            WriteAll(fd_, string_view(buffer_.get(), size_), data);
+            size_ = 0;
+            return;
+        }
+
+        if ((policy_ == FlushPolicy::Line && memchr(data.data(), '\n', data.size()) != nullptr)
+            || (policy_ == FlushPolicy::Threshold && size_ >= threshold_)
+            || size_ == capacity_) {
+            Flush();
+        }
+    }
+
+    void BufferedContext::Flush() {
+        if (size_ > 0) {
+            // Буфер считается сброшенным, даже если запись не удалась, чтобы не повторять её в деструкторе
+            const size_t size = size_;
+            size_ = 0;
+            WriteAll(fd_, buffer_.get(), size);
+        }
+    }
+
+    AsyncContext::AsyncContext(int fd, size_t buffer_size, size_t buffer_count)
+        : fd_(fd)
+        , buffer_size_(max<size_t>(buffer_size, 1))
+        , buffers_(max<size_t>(buffer_count, 2)) {
+        for (Buffer& buffer : buffers_) {
+            buffer.data = make_unique<char[]>(buffer_size_);
+        }
+        writer_ = thread([this] { WriterLoop(); });
+    }
+
+    AsyncContext::~AsyncContext() {
+        try {
+            Flush();
+        }
+        catch (...) {
+            // Деструктор не должен выбрасывать исключений, недописанный вывод теряется
+        }
+        {
+            lock_guard lock(mutex_);
+            stop_.store(true);
+        }
+        published_.notify_one();
+        writer_.join();
+    }
+
+    ostream& AsyncContext::GetOutputStream() {
+        return stream_;
+    }
+
+    void AsyncContext::Write(string_view data) {
+        while (!data.empty()) {
+            Buffer& buffer = buffers_[head_.load(memory_order_relaxed) % buffers_.size()];
+            const size_t chunk = min(data.size(), buffer_size_ - buffer.size);
+            memcpy(buffer.data.get() + buffer.size, data.data(), chunk);
+            buffer.size += chunk;
+            data.remove_prefix(chunk);
+
+            if (buffer.size == buffer_size_) {
+                Publish();
+            }
+        }
+    }
+
+    void AsyncContext::Flush() {
+        const size_t head = head_.load(memory_order_relaxed);
+        if (buffers_[head % buffers_.size()].size > 0) {
+            Publish();
+        }
+
+        const size_t published = head_.load(memory_order_relaxed);
+        WaitForWriter([this, published] {
+            return tail_.load() == published;
+        });
+        RethrowWriterError();
+    }
+
+    template <typename Ready>
+    void AsyncContext::WaitForWriter(Ready ready) {
+        if (ready() || failed_.load()) {
+            return;
+        }
+        unique_lock lock(mutex_);
+        producer_waiting_.store(true);
+        written_.wait(lock, [this, &ready] {
+            return ready() || failed_.load();
+        });
+        producer_waiting_.store(false);
+    }
+
+    void AsyncContext::Publish() {
+        RethrowWriterError();
+
+        const size_t next = head_.load(memory_order_relaxed) + 1;
+        head_.store(next);
+        if (writer_waiting_.load()) {
+            lock_guard lock(mutex_);
+            published_.notify_one();
+        }
+
+        // Следующий буфер свободен, когда писатель закончил с тем, что занимал его кругом раньше
+        WaitForWriter([this, next] {
+            return next - tail_.load() < buffers_.size();
+        });
+        RethrowWriterError();
+    }
+
+    void AsyncContext::RethrowWriterError() {
+        if (failed_.load()) {
+            // После ошибки вывод больше не принимается: повторная попытка бросит то же исключение
+            rethrow_exception(error_);
+        }
+    }
+
+    void AsyncContext::WriterLoop() {
+        size_t tail = tail_.load(memory_order_relaxed);
+        while (true) {
+            if (head_.load() == tail) {
+                unique_lock lock(mutex_);
+                writer_waiting_.store(true);
+                published_.wait(lock, [this, tail] {
+                    return head_.load() != tail || stop_.load();
+                });
+                writer_waiting_.store(false);
+                if (head_.load() == tail) {
+                    return;
+                }
+            }
+
+            Buffer& buffer = buffers_[tail % buffers_.size()];
+            try {
+                WriteAll(fd_, buffer.data.get(), buffer.size);
+            }
+            catch (...) {
+                error_ = current_exception();
+                {
+                    lock_guard lock(mutex_);
+                    failed_.store(true);
+                }
+                written_.notify_one();
+                return;
+            }
+            buffer.size = 0;
+
+            tail_.store(++tail);
+            if (producer_waiting_.load()) {
+                lock_guard lock(mutex_);
+                written_.notify_one();
+            }
+        }
+    }
+
+}  // namespace runtime
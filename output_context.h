@@ -0,0 +1,153 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+
+    // Адаптер, направляющий всё, что пишется в std::ostream, в метод Context::Write.
+    // Позволяет контекстам с собственным буфером реализовать GetOutputStream без второго буфера
+    class ContextStreamBuf : public std::streambuf {
+    public:
+        explicit ContextStreamBuf(Context& context)
+            : context_(context) {
+        }
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+        int sync() override;
+
+    private:
+        Context& context_;
+    };
+
+    // Политика сброса буфера вывода
+    enum class FlushPolicy {
+        Full,       // буфер сбрасывается только при заполнении и при вызове Flush()
+        Line,       // буфер сбрасывается после каждой записи, содержащей перевод строки
+        Threshold,  // буфер сбрасывается, как только в нём накопилось не меньше threshold байт
+    };
+
+    // Записывает size байт из data в файловый дескриптор fd целиком, повторяя write после
+    // частичной записи и EINTR. При ошибке выбрасывает std::system_error
+    void WriteAll(int fd, const char* data, size_t size);
+
+    /*
+     * Контекст, накапливающий вывод команд print в собственном байтовом буфере
+     * и сбрасывающий его в файловый дескриптор вызовами write/writev.
+     * Запись через Write не использует std::ostream. Поток из GetOutputStream пишет в тот же буфер,
+     * поэтому порядок вывода сохраняется. Деструктор сбрасывает остаток буфера, дескриптор не закрывается
+     */
+    class BufferedContext : public Context {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+        explicit BufferedContext(int fd, FlushPolicy policy = FlushPolicy::Full,
+                                 size_t capacity = DEFAULT_CAPACITY, size_t threshold = 0);
+        ~BufferedContext();
+
+        BufferedContext(const BufferedContext&) = delete;
+        BufferedContext& operator=(const BufferedContext&) = delete;
+
+        std::ostream& GetOutputStream() override;
+        void Write(std::string_view data) override;
+        void Flush() override;
+
+        // Возвращает количество байт, ожидающих сброса
+        [[nodiscard]] size_t BufferedSize() const {
+            return size_;
+        }
+
+    private:
+        int fd_;
+        FlushPolicy policy_;
+        size_t capacity_;
+        size_t threshold_;
+        std::unique_ptr<char[]> buffer_;
+        size_t size_ = 0;
+
+        ContextStreamBuf stream_buf_{*this};
+        std::ostream stream_{&stream_buf_};
+    };
+
+    /*
+     * Контекст, отдающий заполненные буферы вывода отдельному потоку-писателю.
+     * Буферы передаются через кольцо фиксированного размера с одним производителем и одним потребителем:
+     * позиции в кольце - атомарные счётчики, данные между потоками не копируются и не защищаются мьютексом.
+     * Передача буфера мьютекс не берёт. Сторона, которой нечего делать (писатель без заполненных буферов или
+     * интерпретатор без свободных), засыпает под мьютексом, выставив флаг ожидания, и только тогда другая
+     * сторона берёт мьютекс, чтобы её разбудить.
+     * Объём памяти ограничен buffer_count * buffer_size байт: при заполнении кольца интерпретатор ждёт писателя.
+     * Flush() дожидается, пока весь накопленный вывод будет записан, сохраняя порядок вывода.
+     * Ошибка записи в потоке-писателе выбрасывается в потоке интерпретатора при следующей передаче буфера или Flush()
+     */
+    class AsyncContext : public Context {
+    public:
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+        static constexpr size_t DEFAULT_BUFFER_COUNT = 8;
+
+        explicit AsyncContext(int fd, size_t buffer_size = DEFAULT_BUFFER_SIZE,
+                              size_t buffer_count = DEFAULT_BUFFER_COUNT);
+        // Сбрасывает остаток вывода и останавливает поток-писатель. Дескриптор не закрывается
+        ~AsyncContext();
+
+        AsyncContext(const AsyncContext&) = delete;
+        AsyncContext& operator=(const AsyncContext&) = delete;
+
+        std::ostream& GetOutputStream() override;
+        void Write(std::string_view data) override;
+        void Flush() override;
+
+    private:
+        struct Buffer {
+            std::unique_ptr<char[]> data;
+            size_t size = 0;
+        };
+
+        // Передаёт заполняемый буфер писателю и дожидается освобождения следующего
+        void Publish();
+        // Засыпает до ready() или ошибки писателя, выставив producer_waiting_
+        template <typename Ready>
+        void WaitForWriter(Ready ready);
+        void RethrowWriterError();
+        void WriterLoop();
+
+        int fd_;
+        size_t buffer_size_;
+        std::vector<Buffer> buffers_;
+
+        // Буферы с номерами [tail_, head_) заполнены и принадлежат писателю,
+        // буфер head_ % buffers_.size() заполняется интерпретатором
+        std::atomic<size_t> head_{0};
+        std::atomic<size_t> tail_{0};
+        std::atomic<bool> stop_{false};
+        std::atomic<bool> failed_{false};
+        // Писатель ждёт заполненного буфера, интерпретатор - свободного буфера или окончания записи.
+        // Флаг выставляется под mutex_ до проверки условия ожидания, а счётчики и флаги читаются и пишутся
+        // последовательно согласованно, поэтому сторона, сдвинувшая счётчик, видит флаг спящей стороны
+        std::atomic<bool> writer_waiting_{false};
+        std::atomic<bool> producer_waiting_{false};
+        std::exception_ptr error_;
+
+        std::mutex mutex_;
+        std::condition_variable published_;
+        std::condition_variable written_;
+
+        ContextStreamBuf stream_buf_{*this};
+        std::ostream stream_{&stream_buf_};
+        std::thread writer_;
+    };
+
+}  // namespace runtime
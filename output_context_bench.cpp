@@ -0,0 +1,105 @@
+#include "bench_runner.h"
+#include "interpreter.h"
+#include "output_context.h"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Программа, которая много считает и много печатает
+const string PRINT_HEAVY_PROGRAM = R"--(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+  def __str__():
+    return "Point(" + str(self.x) + ", " + str(self.y) + ")"
+
+class Printer:
+  def run(n):
+    if n > 0:
+      p = Point(n, n * n)
+      print n, p, "some padding to make the line longer", n * 3 + 1
+      self.run(n - 1)
+
+printer = Printer()
+)--"s + [] {
+    string lines;
+    for (int i = 0; i < 100; ++i) {
+        lines += "printer.run(200)\n"s;
+    }
+    return lines;
+}();
+
+// Медленный получатель: читает канал с минимальным буфером небольшими порциями с паузами,
+// так что ядро почти не сглаживает задержки записи
+class SlowPipe {
+public:
+    SlowPipe() {
+        if (pipe(fds_) != 0) {
+            throw runtime_error("pipe"s);
+        }
+        fcntl(fds_[1], F_SETPIPE_SZ, 4096);
+        reader_ = thread([fd = fds_[0]] {
+            char buffer[4096];
+            while (::read(fd, buffer, sizeof(buffer)) > 0) {
+                this_thread::sleep_for(chrono::microseconds(200));
+            }
+        });
+    }
+
+    ~SlowPipe() {
+        close(fds_[1]);
+        reader_.join();
+        close(fds_[0]);
+    }
+
+    [[nodiscard]] int WriteFd() const {
+        return fds_[1];
+    }
+
+private:
+    int fds_[2] = { -1, -1 };
+    thread reader_;
+};
+
+void BenchPrintToMemory() {
+    istringstream input(PRINT_HEAVY_PROGRAM);
+    ostringstream output;
+    RunMythonProgram(input, output);
+    DoNotOptimize(output);
+}
+
+void BenchPrintBufferedToSlowPipe() {
+    SlowPipe pipe;
+    BufferedContext context(pipe.WriteFd());
+    istringstream input(PRINT_HEAVY_PROGRAM);
+    RunMythonProgram(input, context);
+}
+
+void BenchPrintAsyncToSlowPipe() {
+    SlowPipe pipe;
+    AsyncContext context(pipe.WriteFd());
+    istringstream input(PRINT_HEAVY_PROGRAM);
+    RunMythonProgram(input, context);
+}
+
+}  // namespace
+
+void RunOutputContextBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, runtime::BenchPrintToMemory);
+    RUN_BENCH(br, runtime::BenchPrintBufferedToSlowPipe);
+    RUN_BENCH(br, runtime::BenchPrintAsyncToSlowPipe);
+}
+
+}  // namespace runtime
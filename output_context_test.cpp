@@ -0,0 +1,201 @@
+#include "output_context.h"
+#include "statement.h"
+#include "test_runner.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Временный файл, в который пишет проверяемый контекст
+class TempFile {
+public:
+    TempFile()
+        : file_(tmpfile()) {
+        if (file_ == nullptr) {
+            throw runtime_error("Can not create temporary file"s);
+        }
+    }
+
+    ~TempFile() {
+        fclose(file_);
+    }
+
+    [[nodiscard]] int Fd() const {
+        return fileno(file_);
+    }
+
+    // Возвращает всё, что было записано в файл на текущий момент
+    [[nodiscard]] string Content() const {
+        string result;
+        char buffer[4096];
+        off_t offset = 0;
+        ssize_t read = 0;
+        while ((read = pread(Fd(), buffer, sizeof(buffer), offset)) > 0) {
+            result.append(buffer, static_cast<size_t>(read));
+            offset += read;
+        }
+        return result;
+    }
+
+private:
+    FILE* file_;
+};
+
+void TestFullPolicyWritesOnFlush() {
+    TempFile file;
+    BufferedContext context(file.Fd(), FlushPolicy::Full, 16);
+
+    context.Write("hello\n"sv);
+    ASSERT_EQUAL(file.Content(), ""s);
+    ASSERT_EQUAL(context.BufferedSize(), 6U);
+
+    context.Flush();
+    ASSERT_EQUAL(file.Content(), "hello\n"s);
+    ASSERT_EQUAL(context.BufferedSize(), 0U);
+
+    // Запись, не помещающаяся в буфер, уходит вместе с его содержимым
+    context.Write("abc"sv);
+    context.Write("0123456789abcdefXYZ"sv);
+    ASSERT_EQUAL(file.Content(), "hello\nabc0123456789abcdefXYZ"s);
+    ASSERT_EQUAL(context.BufferedSize(), 0U);
+}
+
+void TestLinePolicy() {
+    TempFile file;
+    BufferedContext context(file.Fd(), FlushPolicy::Line);
+
+    context.Write("no newline"sv);
+    ASSERT_EQUAL(file.Content(), ""s);
+    context.Write(" yet\n"sv);
+    ASSERT_EQUAL(file.Content(), "no newline yet\n"s);
+}
+
+void TestThresholdPolicy() {
+    TempFile file;
+    BufferedContext context(file.Fd(), FlushPolicy::Threshold, 64, 4);
+
+    context.Write("ab"sv);
+    ASSERT_EQUAL(file.Content(), ""s);
+    context.Write("cd"sv);
+    ASSERT_EQUAL(file.Content(), "abcd"s);
+}
+
+void TestDestructorFlushes() {
+    TempFile file;
+    {
+        BufferedContext context(file.Fd());
+        context.Write("tail"sv);
+    }
+    ASSERT_EQUAL(file.Content(), "tail"s);
+}
+
+void TestStreamAndWriteKeepOrder() {
+    TempFile file;
+    {
+        BufferedContext context(file.Fd(), FlushPolicy::Full, 8);
+        context.Write("a"sv);
+        context.GetOutputStream() << 42 << ' ';
+        context.Write("b"sv);
+        context.GetOutputStream() << "long stream output"sv;
+    }
+    ASSERT_EQUAL(file.Content(), "a42 blong stream output"s);
+}
+
+void TestPrintStatement() {
+    TempFile file;
+    {
+        BufferedContext context(file.Fd());
+        Closure closure = { { "x"s, ObjectHolder::Own(Number(57)) } };
+        vector<unique_ptr<ast::Statement>> args;
+        args.push_back(make_unique<ast::VariableValue>("x"s));
+        args.push_back(make_unique<ast::StringConst>("hello"s));
+        args.push_back(make_unique<ast::BoolConst>(Bool(true)));
+        args.push_back(make_unique<ast::None>());
+        ast::Print(std::move(args)).Execute(closure, context);
+    }
+    ASSERT_EQUAL(file.Content(), "57 hello True None\n"s);
+}
+
+void TestAsyncKeepsOrderAcrossBuffers() {
+    TempFile file;
+    string expected;
+    {
+        // Маленькие буферы заставляют кольцо многократно переполняться
+        AsyncContext context(file.Fd(), 7, 2);
+        for (int i = 0; i < 1000; ++i) {
+            const string line = to_string(i) + (i % 3 == 0 ? "\n"s : " "s);
+            context.Write(line);
+            expected += line;
+        }
+        context.GetOutputStream() << "end"sv;
+        expected += "end"s;
+
+        context.Flush();
+        ASSERT_EQUAL(file.Content(), expected);
+
+        context.Write("tail"sv);
+        expected += "tail"s;
+    }
+    ASSERT_EQUAL(file.Content(), expected);
+}
+
+void TestAsyncWithSlowReader() {
+    int fds[2];
+    ASSERT(pipe(fds) == 0);
+
+    string received;
+    thread reader([&received, fd = fds[0]] {
+        char buffer[16];
+        ssize_t read = 0;
+        while ((read = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            received.append(buffer, static_cast<size_t>(read));
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+    });
+
+    string expected;
+    {
+        AsyncContext context(fds[1], 64, 3);
+        for (int i = 0; i < 2000; ++i) {
+            const string word = to_string(i) + ' ';
+            context.Write(word);
+            expected += word;
+        }
+    }
+    close(fds[1]);
+    reader.join();
+    close(fds[0]);
+
+    ASSERT_EQUAL(received, expected);
+}
+
+void TestAsyncReportsWriteError() {
+    AsyncContext context(-1, 4, 2);
+    context.Write("abc"sv);
+    ASSERT_THROWS(context.Flush(), system_error);
+    ASSERT_THROWS(context.Write("more than one buffer"sv), system_error);
+}
+
+}  // namespace
+
+void RunOutputContextTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestFullPolicyWritesOnFlush);
+    RUN_TEST(tr, runtime::TestLinePolicy);
+    RUN_TEST(tr, runtime::TestThresholdPolicy);
+    RUN_TEST(tr, runtime::TestDestructorFlushes);
+    RUN_TEST(tr, runtime::TestStreamAndWriteKeepOrder);
+    RUN_TEST(tr, runtime::TestPrintStatement);
+    RUN_TEST(tr, runtime::TestAsyncKeepsOrderAcrossBuffers);
+    RUN_TEST(tr, runtime::TestAsyncWithSlowReader);
+    RUN_TEST(tr, runtime::TestAsyncReportsWriteError);
+}
+
+}  // namespace runtime
@@ -1,8 +1,14 @@
 #include "parse.h"
 
 #include "lexer.h"
+#include "mapped_file.h"
 #include "statement.h"
 
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
 using namespace std;
 
 namespace TokenType = parse::token_type;
@@ -17,10 +23,75 @@ bool operator!=(const parse::Token& token, char c) {
     return !(token == c);
 }
 
+// Встроенные функции над списками
+const unordered_map<string_view, ast::ListFunction::Kind> LIST_FUNCTIONS = {
+    {"sum"sv, ast::ListFunction::Kind::Sum}, {"min"sv, ast::ListFunction::Kind::Min},
+    {"max"sv, ast::ListFunction::Kind::Max}, {"dot"sv, ast::ListFunction::Kind::Dot},
+    {"add"sv, ast::ListFunction::Kind::Add}, {"mul"sv, ast::ListFunction::Kind::Mul},
+};
+
+// Объявленный в программе класс и его порядковый номер среди объявлений
+struct DeclaredClass {
+    const runtime::Class* cls;
+    size_t index;
+};
+
+// Классы, объявленные в программе. Классами владеют узлы ClassDefinition, таблица хранит только ссылки,
+// поэтому её могут разделять отложенные тела методов, не продлевая жизнь классов
+using ClassTable = unordered_map<string, DeclaredClass>;
+
 class Parser {
 public:
     explicit Parser(parse::Lexer& lexer)
-        : lexer_(lexer) {
+        : lexer_(lexer)
+        , classes_(make_shared<ClassTable>()) {
+    }
+
+    // В режиме options.lazy_methods тела методов разбираются при первом вызове, source - исходный код,
+    // который читает lexer
+    Parser(parse::Lexer& lexer, std::string_view source, const ParseOptions& options)
+        : lexer_(lexer)
+        , source_(source)
+        , options_(options)
+        , classes_(make_shared<ClassTable>()) {
+        options_.lazy_methods = options_.lazy_methods && !source_.empty();
+        for (const runtime::Class* cls : options_.classes) {
+            classes_->emplace(cls->GetName(), DeclaredClass{cls, classes_->size()});
+        }
+    }
+
+    // Парсер тела метода, отложенного в ленивом режиме: ему видны visible_classes классов,
+    // объявленных до метода, и классы, которые он объявит сам
+    Parser(parse::Lexer& lexer, shared_ptr<ClassTable> classes, size_t visible_classes)
+        : lexer_(lexer)
+        , classes_(std::move(classes))
+        , visible_classes_(visible_classes)
+        , own_classes_(classes_->size()) {
+    }
+
+    // LazyBody -> INDENT+ (Statement)+ DEDENT+ EOF
+    // Тело метода, вырезанное из исходного кода вместе с отступами
+    unique_ptr<ast::Statement> ParseLazyBody() {
+        int indents = 0;
+        while (lexer_.CurrentToken().Is<TokenType::Indent>()) {
+            ++indents;
+            lexer_.NextToken();
+        }
+        if (indents == 0) {
+            throw ParseError("Method body must be indented"s);
+        }
+
+        auto result = make_unique<ast::Compound>();
+        while (!lexer_.CurrentToken().Is<TokenType::Dedent>()) {
+            result->AddStatement(ParseStatement());
+        }
+        for (; indents > 0; --indents) {
+            lexer_.Expect<TokenType::Dedent>();
+            lexer_.NextToken();
+        }
+        lexer_.Expect<TokenType::Eof>();
+
+        return result;
     }
 
     // Program -> eps
@@ -34,6 +105,14 @@ public:
         return result;
     }
 
+    // Возвращает очередную инструкцию верхнего уровня программы либо nullptr, если программа закончилась
+    unique_ptr<ast::Statement> ParseNextStatement() {
+        if (lexer_.CurrentToken().Is<TokenType::Eof>()) {
+            return nullptr;
+        }
+        return ParseStatement();
+    }
+
 private:
     // Suite -> NEWLINE INDENT (Statement)+ DEDENT
     unique_ptr<ast::Statement> ParseSuite()  // NOLINT
@@ -76,13 +155,80 @@ private:
             lexer_.ExpectNext<TokenType::Char>(':');
             lexer_.NextToken();
 
-            m.body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+            if (options_.lazy_methods) {
+                m.body = SkipSuite();
+            }
+            else {
+                // Тело метода не входит в циклы, внутри которых объявлен класс
+                const int loop_depth = std::exchange(loop_depth_, 0);
+                m.body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+                loop_depth_ = loop_depth;
+            }
 
             result.push_back(std::move(m));
         }
         return result;
     }
 
+    // Пропускает токены блока Suite, не строя дерево, и возвращает тело метода,
+    // которое разберёт этот блок при первом вызове
+    unique_ptr<ast::Statement> SkipSuite() {
+        lexer_.Expect<TokenType::Newline>();
+        const size_t begin = SourcePosition();
+
+        bool has_classes = false;
+        int depth = 0;
+        do {
+            const auto& tok = lexer_.NextToken();
+            if (tok.Is<TokenType::Indent>()) {
+                ++depth;
+            }
+            else if (tok.Is<TokenType::Dedent>()) {
+                --depth;
+            }
+            else if (tok.Is<TokenType::Class>()) {
+                has_classes = true;
+            }
+            else if (tok.Is<TokenType::Eof>() || depth == 0) {
+                throw ParseError("Method body must be an indented block"s);
+            }
+        } while (depth > 0);
+
+        // Лексер уже прочитал отступ строки, следующей за блоком: она в блок не входит
+        const size_t position = SourcePosition();
+        const size_t end = position >= source_.size() ? source_.size() : source_.rfind('\n', position - 1) + 1;
+        lexer_.NextToken();
+
+        auto parser = [source = source_.substr(begin, end - begin), classes = classes_,
+                       visible = classes_->size()] {
+            parse::MemoryInputStream input(source);
+            parse::Lexer lexer(input);
+            return Parser(lexer, classes, visible).ParseLazyBody();
+        };
+
+        if (has_classes) {
+            // Классы, объявленные внутри метода, должны быть видны коду, следующему за методом,
+            // поэтому такие тела разбираются сразу
+            return make_unique<ast::MethodBody>(parser());
+        }
+        return make_unique<ast::LazyMethodBody>(std::move(parser));
+    }
+
+    // Возвращает позицию в исходном коде, с которой лексер продолжит чтение
+    size_t SourcePosition() const {
+        const auto position = lexer_.InputPosition();
+        return position < 0 ? source_.size() : static_cast<size_t>(position);
+    }
+
+    // Возвращает класс name, если он объявлен и виден парсеру, иначе nullptr
+    const runtime::Class* FindClass(const string& name) const {
+        const auto it = classes_->find(name);
+        if (it == classes_->end() || (it->second.index >= visible_classes_ && it->second.index < own_classes_)) {
+            return nullptr;
+        }
+        return it->second.cls;
+    }
+
     // ClassDefinition -> Id ['(' Id ')'] : new_line indent MethodList dedent
     unique_ptr<ast::Statement> ParseClassDefinition()  // NOLINT
     {
@@ -96,11 +242,10 @@ private:
             lexer_.ExpectNext<TokenType::Char>(')');
             lexer_.NextToken();
 
-            auto it = declared_classes_.find(name);
-            if (it == declared_classes_.end()) {
+            base_class = FindClass(name);
+            if (base_class == nullptr) {
                 throw ParseError("Base class "s + name + " not found for class "s + class_name);
             }
-            base_class = static_cast<const runtime::Class*>(it->second.Get());  // NOLINT
         }
 
         lexer_.Expect<TokenType::Char>(':');
@@ -112,16 +257,15 @@ private:
         lexer_.Expect<TokenType::Dedent>();
         lexer_.NextToken();
 
-        auto [it, inserted] = declared_classes_.insert({
-            class_name,
-            runtime::ObjectHolder::Own(runtime::Class(class_name, std::move(methods), base_class)),
-        });
-
-        if (!inserted) {
+        if (classes_->count(class_name) > 0) {
             throw ParseError("Class "s + class_name + " already exists"s);
         }
 
-        return make_unique<ast::ClassDefinition>(it->second);
+        auto cls = runtime::ObjectHolder::Own(runtime::Class(class_name, std::move(methods), base_class));
+        classes_->emplace(class_name, DeclaredClass{cls.TryAs<runtime::Class>(), classes_->size()});
+        declared_classes_.push_back(cls);
+
+        return make_unique<ast::ClassDefinition>(std::move(cls));
     }
 
     vector<string> ParseDottedIds() {
@@ -135,6 +279,7 @@ private:
     }
 
     //  AssgnOrCall -> DottedIds = Expr
+    //               | DottedIds ('[' Expr ']')+ = Expr
     //               | DottedIds '(' ExprList ')'
     unique_ptr<ast::Statement> ParseAssignmentOrCall() {
         lexer_.Expect<TokenType::Id>();
@@ -152,10 +297,22 @@ private:
             return make_unique<ast::FieldAssignment>(ast::VariableValue{std::move(id_list)},
                                                      std::move(last_name), ParseTest());
         }
+        if (lexer_.CurrentToken() == '[') {
+            id_list.push_back(std::move(last_name));
+            unique_ptr<ast::Statement> object = make_unique<ast::VariableValue>(std::move(id_list));
+            unique_ptr<ast::Statement> index = ParseIndex();
+            while (lexer_.CurrentToken() == '[') {
+                object = make_unique<ast::Index>(std::move(object), std::move(index));
+                index = ParseIndex();
+            }
+            lexer_.Expect<TokenType::Char>('=');
+            lexer_.NextToken();
+            return make_unique<ast::IndexAssignment>(std::move(object), std::move(index), ParseTest());
+        }
         lexer_.Expect<TokenType::Char>('(');
         lexer_.NextToken();
 
-        if (id_list.empty()) {
+        if (id_list.empty() && last_name != "spawn"sv && last_name != "task"sv) {
             throw ParseError("Mython doesn't support functions, only methods: "s + last_name);
         }
 
@@ -166,6 +323,11 @@ private:
         lexer_.Expect<TokenType::Char>(')');
         lexer_.NextToken();
 
+        if (id_list.empty()) {
+            // Изолят или задачу можно запустить, не сохраняя их объект
+            return MakeBackgroundCall(last_name, std::move(args));
+        }
+
         return make_unique<ast::MethodCall>(make_unique<ast::VariableValue>(std::move(id_list)),
                                             std::move(last_name), std::move(args));
     }
@@ -204,16 +366,44 @@ private:
         return result;
     }
 
-    // Mult -> '(' Expr ')'
-    //       | NUMBER
-    //       | '-' Mult
-    //       | STRING
-    //       | NONE
-    //       | TRUE
-    //       | FALSE
-    //       | DottedIds '(' ExprList ')'
-    //       | DottedIds
+    // Mult -> '-' Mult
+    //       | Primary ('[' Expr ']')*
     unique_ptr<ast::Statement> ParseMult()  // NOLINT
+    {
+        if (lexer_.CurrentToken() == '-') {
+            lexer_.NextToken();
+            return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
+        }
+        auto result = ParsePrimary();
+        while (lexer_.CurrentToken() == '[') {
+            result = make_unique<ast::Index>(std::move(result), ParseIndex());
+        }
+        return result;
+    }
+
+    // Index -> '[' Expr ']'
+    unique_ptr<ast::Statement> ParseIndex()  // NOLINT
+    {
+        lexer_.Expect<TokenType::Char>('[');
+        lexer_.NextToken();
+        auto result = ParseTest();
+        lexer_.Expect<TokenType::Char>(']');
+        lexer_.NextToken();
+        return result;
+    }
+
+    // Primary -> '(' Expr ')'
+    //          | '[' [ExprList] ']'
+    //          | '{' [Expr ':' Expr (',' Expr ':' Expr)*] '}'
+    //          | NUMBER
+    //          | STRING
+    //          | FORMAT_STRING
+    //          | NONE
+    //          | TRUE
+    //          | FALSE
+    //          | DottedIds '(' ExprList ')'
+    //          | DottedIds
+    unique_ptr<ast::Statement> ParsePrimary()  // NOLINT
     {
         if (lexer_.CurrentToken() == '(') {
             lexer_.NextToken();
@@ -222,9 +412,32 @@ private:
             lexer_.NextToken();
             return result;
         }
-        if (lexer_.CurrentToken() == '-') {
+        if (lexer_.CurrentToken() == '[') {
+            vector<unique_ptr<ast::Statement>> items;
+            if (lexer_.NextToken() != ']') {
+                items = ParseTestList();
+            }
+            lexer_.Expect<TokenType::Char>(']');
             lexer_.NextToken();
-            return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
+            return make_unique<ast::NewList>(std::move(items));
+        }
+        if (lexer_.CurrentToken() == '{') {
+            ast::NewDict::Items items;
+            if (lexer_.NextToken() != '}') {
+                while (true) {
+                    auto key = ParseTest();
+                    lexer_.Expect<TokenType::Char>(':');
+                    lexer_.NextToken();
+                    items.emplace_back(std::move(key), ParseTest());
+                    if (lexer_.CurrentToken() != ',') {
+                        break;
+                    }
+                    lexer_.NextToken();
+                }
+            }
+            lexer_.Expect<TokenType::Char>('}');
+            lexer_.NextToken();
+            return make_unique<ast::NewDict>(std::move(items));
         }
         if (const auto* num = lexer_.CurrentToken().TryAs<TokenType::Number>()) {
             int result = num->value;
@@ -236,6 +449,21 @@ private:
             lexer_.NextToken();
             return make_unique<ast::StringConst>(std::move(result));
         }
+        if (const auto* format = lexer_.CurrentToken().TryAs<TokenType::FormatString>()) {
+            const vector<string> parts = format->parts;
+            lexer_.NextToken();
+            vector<string> literals;
+            vector<unique_ptr<ast::Statement>> values;
+            for (size_t i = 0; i < parts.size(); ++i) {
+                if (i % 2 == 0) {
+                    literals.push_back(parts[i]);
+                }
+                else {
+                    values.push_back(ParseFormatExpression(parts[i]));
+                }
+            }
+            return make_unique<ast::FormatString>(std::move(literals), std::move(values));
+        }
         if (lexer_.CurrentToken().Is<TokenType::True>()) {
             lexer_.NextToken();
             return make_unique<ast::BoolConst>(runtime::Bool(true));
@@ -252,6 +480,22 @@ private:
         return ParseDottedIdsInMultExpr();
     }
 
+    // FormatExpression -> Expr EOF
+    // Выражение из фигурных скобок форматной строки разбирает отдельный парсер, которому видны те же классы
+    unique_ptr<ast::Statement> ParseFormatExpression(string_view source) {
+        const size_t begin = source.find_first_not_of(' ');
+        source = source.substr(begin, source.find_last_not_of(' ') + 1 - begin);
+        parse::MemoryInputStream input(source);
+        parse::Lexer lexer(input);
+        Parser parser(lexer, classes_, visible_classes_);
+        parser.own_classes_ = own_classes_;
+        auto result = parser.ParseTest();
+        lexer.Expect<TokenType::Newline>();
+        lexer.NextToken();
+        lexer.Expect<TokenType::Eof>();
+        return result;
+    }
+
     std::unique_ptr<ast::Statement> ParseDottedIdsInMultExpr() {
         vector<string> names = ParseDottedIds();
 
@@ -272,9 +516,8 @@ private:
                     make_unique<ast::VariableValue>(std::move(names)), std::move(method_name),
                     std::move(args));
             }
-            if (auto it = declared_classes_.find(method_name); it != declared_classes_.end()) {
-                return make_unique<ast::NewInstance>(
-                    static_cast<const runtime::Class&>(*it->second), std::move(args));  // NOLINT
+            if (const runtime::Class* cls = FindClass(method_name)) {
+                return make_unique<ast::NewInstance>(*cls, std::move(args));
             }
             if (method_name == "str"sv) {
                 if (args.size() != 1) {
@@ -282,11 +525,52 @@ private:
                 }
                 return make_unique<ast::Stringify>(std::move(args.front()));
             }
+            if (method_name == "len"sv) {
+                if (args.size() != 1) {
+                    throw ParseError("Function len takes exactly one argument"s);
+                }
+                return make_unique<ast::Length>(std::move(args.front()));
+            }
+            if (const auto it = LIST_FUNCTIONS.find(method_name); it != LIST_FUNCTIONS.end()) {
+                const size_t arity = ast::ListFunction::GetArity(it->second);
+                if (args.size() != arity) {
+                    throw ParseError("Function "s + method_name + " takes "s + to_string(arity) + " argument(s)"s);
+                }
+                return make_unique<ast::ListFunction>(it->second, std::move(args));
+            }
+            if (method_name == "Channel"sv) {
+                if (!args.empty()) {
+                    throw ParseError("Channel() takes no arguments"s);
+                }
+                return make_unique<ast::NewChannel>();
+            }
+            if (method_name == "spawn"sv || method_name == "task"sv) {
+                return MakeBackgroundCall(method_name, std::move(args));
+            }
             throw ParseError("Unknown call to "s + method_name + "()"s);
         }
         return make_unique<ast::VariableValue>(std::move(names));
     }
 
+    // spawn(object.method, args...) и task(object.method, args...): первый аргумент задаёт объект и метод,
+    // который выполнит изолят или задача
+    static unique_ptr<ast::Statement> MakeBackgroundCall(string_view name, vector<unique_ptr<ast::Statement>> args) {
+        const auto* target = args.empty() ? nullptr : dynamic_cast<const ast::VariableValue*>(args.front().get());
+        if (target == nullptr || target->GetDottedIds().size() < 2) {
+            throw ParseError(string(name) + " expects object.method as the first argument"s);
+        }
+        vector<string> object = target->GetDottedIds();
+        string method = std::move(object.back());
+        object.pop_back();
+        args.erase(args.begin());
+        if (name == "task"sv) {
+            return make_unique<ast::StartTask>(make_unique<ast::VariableValue>(std::move(object)), std::move(method),
+                                               std::move(args));
+        }
+        return make_unique<ast::Spawn>(make_unique<ast::VariableValue>(std::move(object)), std::move(method),
+                                       std::move(args));
+    }
+
     vector<unique_ptr<ast::Statement>> ParseTestList()  // NOLINT
     {
         vector<unique_ptr<ast::Statement>> result;
@@ -323,6 +607,44 @@ private:
                                         std::move(else_body));
     }
 
+    // Loop -> while LogicalExpr: Suite
+    unique_ptr<ast::Statement> ParseLoop()  // NOLINT
+    {
+        lexer_.Expect<TokenType::While>();
+        lexer_.NextToken();
+
+        auto condition = ParseTest();
+
+        lexer_.Expect<TokenType::Char>(':');
+        lexer_.NextToken();
+
+        ++loop_depth_;
+        auto body = ParseSuite();
+        --loop_depth_;
+
+        return make_unique<ast::While>(std::move(condition), std::move(body));
+    }
+
+    // ForLoop -> for id in LogicalExpr: Suite
+    unique_ptr<ast::Statement> ParseForLoop()  // NOLINT
+    {
+        lexer_.Expect<TokenType::For>();
+        string var = lexer_.ExpectNext<TokenType::Id>().value;
+        lexer_.ExpectNext<TokenType::In>();
+        lexer_.NextToken();
+
+        auto iterable = ParseTest();
+
+        lexer_.Expect<TokenType::Char>(':');
+        lexer_.NextToken();
+
+        ++loop_depth_;
+        auto body = ParseSuite();
+        --loop_depth_;
+
+        return make_unique<ast::For>(std::move(var), std::move(iterable), std::move(body));
+    }
+
     // LogicalExpr -> AndTest [OR AndTest]
     // AndTest -> NotTest [AND NotTest]
     // NotTest -> [NOT] NotTest
@@ -357,6 +679,7 @@ private:
     }
 
     // Comparison -> Expr [COMP_OP Expr]
+    // COMP_OP -> '<' | '>' | '==' | '!=' | '<=' | '>=' | in | not in
     unique_ptr<ast::Statement> ParseComparison()  // NOLINT
     {
         auto result = ParseExpression();
@@ -393,12 +716,25 @@ private:
             return make_unique<ast::Comparison>(runtime::GreaterOrEqual, std::move(result),
                                                 ParseExpression());
         }
+        if (tok.Is<TokenType::In>()) {
+            lexer_.NextToken();
+            return make_unique<ast::Comparison>(runtime::Contains, std::move(result),
+                                                ParseExpression());
+        }
+        if (tok.Is<TokenType::Not>()) {
+            lexer_.ExpectNext<TokenType::In>();
+            lexer_.NextToken();
+            return make_unique<ast::Comparison>(runtime::NotContains, std::move(result),
+                                                ParseExpression());
+        }
         return result;
     }
 
     // Statement -> SimpleStatement Newline
     //           | class ClassDefinition
     //           | if Condition
+    //           | while Loop
+    //           | for ForLoop
     unique_ptr<ast::Statement> ParseStatement()  // NOLINT
     {
         const auto& tok = lexer_.CurrentToken();
@@ -410,6 +746,12 @@ private:
         if (tok.Is<TokenType::If>()) {
             return ParseCondition();
         }
+        if (tok.Is<TokenType::While>()) {
+            return ParseLoop();
+        }
+        if (tok.Is<TokenType::For>()) {
+            return ParseForLoop();
+        }
         auto result = ParseSimpleStatement();
         lexer_.Expect<TokenType::Newline>();
         lexer_.NextToken();
@@ -418,6 +760,9 @@ private:
 
     // StatementBody -> return Expression
     //               | print ExpressionList
+    //               | yield
+    //               | break
+    //               | continue
     //               | AssignmentOrCall
     unique_ptr<ast::Statement> ParseSimpleStatement() {
         const auto& tok = lexer_.CurrentToken();
@@ -434,11 +779,37 @@ private:
             }
             return make_unique<ast::Print>(std::move(args));
         }
+        if (tok.Is<TokenType::Yield>()) {
+            lexer_.NextToken();
+            return make_unique<ast::Yield>();
+        }
+        if (tok.Is<TokenType::Break>() || tok.Is<TokenType::Continue>()) {
+            const bool is_break = tok.Is<TokenType::Break>();
+            if (loop_depth_ == 0) {
+                throw ParseError((is_break ? "break"s : "continue"s) + " outside of a loop"s);
+            }
+            lexer_.NextToken();
+            if (is_break) {
+                return make_unique<ast::Break>();
+            }
+            return make_unique<ast::Continue>();
+        }
         return ParseAssignmentOrCall();
     }
 
     parse::Lexer& lexer_;
-    runtime::Closure declared_classes_;
+    std::string_view source_;
+    ParseOptions options_;
+    shared_ptr<ClassTable> classes_;
+    size_t visible_classes_ = numeric_limits<size_t>::max();
+    // Порядковый номер первого класса, объявленного этим парсером
+    size_t own_classes_ = 0;
+    // Число циклов, внутри которых находится разбираемая инструкция
+    int loop_depth_ = 0;
+    // Классы, объявленные этим парсером. Когда программа разбирается по одной инструкции,
+    // выполненные инструкции освобождаются, а классы должны жить, пока на них ссылаются
+    // наследники, экземпляры и таблица классов
+    vector<runtime::ObjectHolder> declared_classes_;
 };
 
 }  // namespace
@@ -446,3 +817,31 @@ private:
 unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer) {
     return Parser{lexer}.ParseProgram();
 }
+
+unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer, const ParseOptions& options) {
+    return Parser{lexer, {}, options}.ParseProgram();
+}
+
+unique_ptr<runtime::Executable> ParseProgram(string_view source, const ParseOptions& options) {
+    parse::MemoryInputStream input(source);
+    parse::Lexer lexer(input);
+    return Parser{lexer, source, options}.ParseProgram();
+}
+
+struct StatementReader::Impl {
+    Parser parser;
+};
+
+StatementReader::StatementReader(parse::Lexer& lexer)
+    : impl_(make_unique<Impl>(Impl{Parser{lexer}})) {
+}
+
+StatementReader::StatementReader(parse::Lexer& lexer, string_view source, const ParseOptions& options)
+    : impl_(make_unique<Impl>(Impl{Parser{lexer, source, options}})) {
+}
+
+StatementReader::~StatementReader() = default;
+
+unique_ptr<runtime::Executable> StatementReader::Next() {
+    return impl_->parser.ParseNextStatement();
+}
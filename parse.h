@@ -2,6 +2,8 @@
 
 #include <memory>
 #include <stdexcept>
+#include <string_view>
+#include <vector>
 
 namespace parse {
 class Lexer;
@@ -9,10 +11,53 @@ class Lexer;
 
 namespace runtime {
 class Executable;
+class Class;
 }
 
 struct ParseError : std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
+// Параметры разбора программы
+struct ParseOptions {
+    // Тела методов не разбираются заранее: парсер только пропускает их токены и запоминает
+    // положение в исходном коде, а разбор выполняется при первом вызове метода.
+    // Синтаксические ошибки в телах методов обнаруживаются при первом вызове
+    bool lazy_methods = false;
+    // Классы, объявленные до начала программы, например восстановленные из снимка.
+    // Программа может создавать их экземпляры и наследоваться от них, но не может объявить класс с тем же именем
+    std::vector<const runtime::Class*> classes;
+};
+
 std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
+
+// Разбирает программу, которую читает lexer. Параметр options.lazy_methods не учитывается:
+// для отложенного разбора нужен исходный код целиком
+std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer, const ParseOptions& options);
+
+// Разбирает программу с исходным кодом source.
+// При options.lazy_methods программа ссылается на source, и он должен оставаться доступным,
+// пока программа выполняется
+std::unique_ptr<runtime::Executable> ParseProgram(std::string_view source, const ParseOptions& options);
+
+/*
+ * Разбирает программу по одной инструкции верхнего уровня, не дожидаясь конца входных данных.
+ * Инструкции можно выполнять и освобождать по мере разбора. Объявленными классами владеет StatementReader,
+ * поэтому он должен жить, пока выполняется программа.
+ * Для разбора с options.lazy_methods lexer должен читать source
+ */
+class StatementReader {
+public:
+    explicit StatementReader(parse::Lexer& lexer);
+    // Параметр options.lazy_methods учитывается, только если source не пуст
+    StatementReader(parse::Lexer& lexer, std::string_view source, const ParseOptions& options);
+    ~StatementReader();
+
+    // Возвращает очередную инструкцию либо nullptr, если программа закончилась.
+    // При синтаксической ошибке выбрасывает ParseError или parse::LexerError
+    std::unique_ptr<runtime::Executable> Next();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -3,6 +3,8 @@
 #include "statement.h"
 #include "test_runner.h"
 
+#include <thread>
+
 using namespace std;
 
 namespace parse {
@@ -244,6 +246,148 @@ print r, c, t1, t2
                  "Rect(10x20) Circle(52) Triangle(3, 4, 5) Wrong triangle\n"s);
 }
 
+void TestLazyMethods() {
+    const string program = R"(
+class Shape:
+  def __str__():
+    return "Shape"
+
+  def broken():
+    x = = 1
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.w = w
+    if w > h:
+      self.h = h
+    else:
+      self.h = w
+    # комментарий внутри тела
+  def __str__():
+    return "Rect(" + str(self.w) + 'x' + str(self.h) + ')'
+
+  def forward():
+    return Later()
+
+class Factory:
+  def make():
+    class Made:
+      def __str__():
+        return 'made'
+    return Made()
+
+class Later:
+  def __str__():
+    return "later"
+
+f = Factory()
+m = f.make()
+print Rect(10, 20), Rect(5, 2), Shape(), m, Made()
+
+class Tail:
+  def last():
+    return 'tail')"s;
+
+    ASSERT_THROWS(ParseProgram(program, ParseOptions{}), runtime_error);
+
+    ParseOptions options;
+    options.lazy_methods = true;
+    auto tree = ParseProgram(program, options);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    tree->Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "Rect(10x10) Rect(5x2) Shape made made\n"s);
+
+    const auto* shape = closure.at("Shape"s).TryAs<runtime::Class>();
+    const auto* str_body = dynamic_cast<const ast::LazyMethodBody*>(shape->GetMethod("__str__"s)->body.get());
+    const auto* broken_body = dynamic_cast<const ast::LazyMethodBody*>(shape->GetMethod("broken"s)->body.get());
+    ASSERT(str_body != nullptr && str_body->IsParsed());
+    ASSERT(broken_body != nullptr && !broken_body->IsParsed());
+
+    // Скомпилированную программу выполняют несколько потоков: IsParsed читается одновременно с разбором
+    const auto* tail_class = closure.at("Tail"s).TryAs<runtime::Class>();
+    const auto* last_body = dynamic_cast<const ast::LazyMethodBody*>(tail_class->GetMethod("last"s)->body.get());
+    ASSERT(last_body != nullptr && !last_body->IsParsed());
+    thread parsing([last_body] {
+        last_body->GetBody();
+    });
+    while (!last_body->IsParsed()) {
+        this_thread::yield();
+    }
+    parsing.join();
+
+    // Ошибки в телах методов и ссылки на классы, объявленные позже метода, обнаруживаются при вызове
+    runtime::ClassInstance shape_instance(*shape);
+    ASSERT_THROWS(shape_instance.Call("broken"s, {}, context), runtime_error);
+    runtime::ClassInstance rect(*closure.at("Rect"s).TryAs<runtime::Class>());
+    ASSERT_THROWS(rect.Call("forward"s, {}, context), ParseError);
+
+    runtime::ClassInstance tail(*closure.at("Tail"s).TryAs<runtime::Class>());
+    ostringstream out;
+    tail.Call("last"s, {}, context)->Print(out, context);
+    ASSERT_EQUAL(out.str(), "tail"s);
+}
+
+void TestWhileLoop() {
+    const string program = R"(
+i = 0
+total = 0
+while i < 10:
+  i = i + 1
+  if i == 3:
+    continue
+  if i == 8:
+    break
+  total = total + i
+print i, total
+
+rows = 0
+cells = 0
+while rows < 3:
+  rows = rows + 1
+  col = 0
+  while True:
+    col = col + 1
+    if col > rows:
+      break
+    cells = cells + 1
+print rows, cells
+
+class Finder:
+  def first_square_above(n):
+    k = 0
+    while True:
+      k = k + 1
+      if k * k > n:
+        return k
+
+f = Finder()
+print f.first_square_above(50)
+while False:
+  print 'never'
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "8 25\n3 6\n8\n"s);
+
+    ASSERT_THROWS(ParseProgramFromString("break\n"s), ParseError);
+    ASSERT_THROWS(ParseProgramFromString("if True:\n  continue\n"s), ParseError);
+    // Метод класса, объявленного в цикле, не может прервать этот цикл
+    const string method_in_loop = R"(
+while True:
+  class Escape:
+    def run():
+      break
+  break
+)"s;
+    ASSERT_THROWS(ParseProgramFromString(method_in_loop), ParseError);
+}
+
 }  // namespace parse
 
 void TestParseProgram(TestRunner& tr) {
@@ -255,4 +399,6 @@ void TestParseProgram(TestRunner& tr) {
     RUN_TEST(tr, parse::TestRecursion2);
     RUN_TEST(tr, parse::TestComplexLogicalExpression);
     RUN_TEST(tr, parse::TestClassicalPolymorphism);
+    RUN_TEST(tr, parse::TestLazyMethods);
+    RUN_TEST(tr, parse::TestWhileLoop);
 }
@@ -0,0 +1,163 @@
+#include "program_cache.h"
+
+#include "lexer.h"
+#include "mapped_file.h"
+#include "parse.h"
+#include "serialize.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace ast {
+
+    namespace {
+        const string CACHE_SUFFIX = ".myc"s;
+
+        // Запись кэша: размер исходного кода (uint64 в порядке байт машины), исходный код и дерево программы
+        string MakeEntry(string_view source, string_view program) {
+            const uint64_t size = source.size();
+            string entry(sizeof(size), '\0');
+            memcpy(entry.data(), &size, sizeof(size));
+            entry.append(source);
+            entry.append(program);
+            return entry;
+        }
+
+        // Возвращает дерево программы из записи entry, если запись сделана для исходного кода source,
+        // иначе пустую строку
+        string_view EntryProgram(string_view entry, string_view source) {
+            uint64_t size = 0;
+            if (entry.size() < sizeof(size)) {
+                return {};
+            }
+            memcpy(&size, entry.data(), sizeof(size));
+            entry.remove_prefix(sizeof(size));
+            if (size != source.size() || entry.substr(0, source.size()) != source) {
+                return {};
+            }
+            return entry.substr(source.size());
+        }
+
+        // Создаёт каталог path вместе с недостающими родительскими каталогами
+        bool MakeDirectories(const string& path) {
+            for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+                const string prefix = path.substr(0, pos);
+                if (::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+                    return false;
+                }
+                if (pos == string::npos) {
+                    return true;
+                }
+            }
+        }
+    }  // namespace
+
+    void WriteFileAtomically(const string& path, string_view data) {
+        string temp_path = path + ".XXXXXX"s;
+        const int fd = ::mkstemp(temp_path.data());
+        if (fd < 0) {
+            throw system_error(errno, generic_category(), "Can not create "s + temp_path);
+        }
+
+        size_t written = 0;
+        while (written < data.size()) {
+            const ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(result);
+        }
+
+        const int error = written != data.size() ? errno : 0;
+        if (::close(fd) != 0 || error != 0 || ::rename(temp_path.c_str(), path.c_str()) != 0) {
+            const int saved = error != 0 ? error : errno;
+            ::unlink(temp_path.c_str());
+            throw system_error(saved, generic_category(), "Can not write "s + path);
+        }
+    }
+
+    uint64_t HashSource(string_view data) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (const char c : data) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    ProgramCache::ProgramCache(string directory)
+        : directory_(std::move(directory)) {
+    }
+
+    string ProgramCache::EntryPath(string_view source) const {
+        ostringstream path;
+        path << directory_ << '/' << hex << setw(16) << setfill('0') << HashSource(source) << '-' << dec
+             << source.size() << CACHE_SUFFIX;
+        return path.str();
+    }
+
+    unique_ptr<runtime::Executable> ProgramCache::Load(string_view source) {
+        const string path = EntryPath(source);
+        if (auto program = TryRead(path, source)) {
+            return program;
+        }
+
+        parse::MemoryInputStream input(source);
+        parse::Lexer lexer(input);
+        auto program = ParseProgram(lexer);
+        TryWrite(path, source, *program);
+        return program;
+    }
+
+    unique_ptr<runtime::Executable> ProgramCache::TryRead(const string& path, string_view source) const {
+        if (::access(path.c_str(), R_OK) != 0) {
+            return nullptr;
+        }
+        try {
+            parse::MappedFile file(path);
+            const string_view program = EntryProgram(file.Data(), source);
+            if (program.empty()) {
+                return nullptr;
+            }
+            return DeserializeProgram(program);
+        }
+        catch (const exception&) {
+            return nullptr;
+        }
+    }
+
+    void ProgramCache::TryWrite(const string& path, string_view source, const runtime::Executable& program) const {
+        string data;
+        try {
+            data = MakeEntry(source, SerializeProgram(program));
+        }
+        catch (const SerializeError&) {
+            return;
+        }
+
+        if (!MakeDirectories(directory_)) {
+            return;
+        }
+
+        try {
+            WriteFileAtomically(path, data);
+        }
+        catch (const system_error&) {
+            // Без записи в кэше программа просто будет разобрана при следующем запуске
+        }
+    }
+
+}  // namespace ast
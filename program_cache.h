@@ -0,0 +1,46 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace ast {
+
+    // Записывает data в файл path атомарно: через временный файл в том же каталоге и rename.
+    // При ошибке выбрасывает std::system_error, а файл path остаётся прежним
+    void WriteFileAtomically(const std::string& path, std::string_view data);
+
+    // Возвращает 64-битный хеш FNV-1a содержимого data
+    uint64_t HashSource(std::string_view data);
+
+    /*
+     * Кэш разобранных программ в локальном каталоге.
+     * Ключ - хеш исходного кода и его размер, значение - сам исходный код и результат SerializeProgram.
+     * Исходный код записи сравнивается с загружаемым, поэтому программа с тем же ключом из-за совпадения
+     * хешей разбирается заново, а не подменяется чужой.
+     * Файлы кэша записываются атомарно (через временный файл и rename) и читаются через mmap.
+     * Повреждённый, устаревший или чужой файл кэша игнорируется и перезаписывается.
+     * Ошибки доступа к каталогу кэша не мешают выполнению программы
+     */
+    class ProgramCache {
+    public:
+        explicit ProgramCache(std::string directory);
+
+        // Возвращает дерево программы с исходным кодом source: из кэша, если оно там есть,
+        // иначе разбирает source и сохраняет результат в кэш
+        std::unique_ptr<runtime::Executable> Load(std::string_view source);
+
+        // Возвращает путь к файлу кэша для исходного кода source
+        [[nodiscard]] std::string EntryPath(std::string_view source) const;
+
+    private:
+        std::unique_ptr<runtime::Executable> TryRead(const std::string& path, std::string_view source) const;
+        void TryWrite(const std::string& path, std::string_view source, const runtime::Executable& program) const;
+
+        std::string directory_;
+    };
+
+}  // namespace ast
@@ -1,8 +1,17 @@
 #include "runtime.h"
 
+#include "call_stack.h"
+#include "dict.h"
+#include "heap.h"
+#include "list.h"
+#include "text_kernels.h"
+
 #include <cassert>
+#include <charconv>
 #include <optional>
 #include <sstream>
+#include <string_view>
+#include <utility>
 
 using namespace std;
 
@@ -13,6 +22,12 @@ namespace runtime {
         const string LT_METHOD = "__lt__"s;
         const string STR_METHOD = "__str__"s;
 
+        // Байты, которые строка занимает вне объекта std::string. Короткие строки хранятся в самом объекте
+        size_t ExternalBytes(const string& str) {
+            static const size_t inline_capacity = string().capacity();
+            return str.capacity() > inline_capacity ? str.capacity() + 1 : 0;
+        }
+
         template <typename Predicate>
         bool Compare(const ObjectHolder& lhs, const ObjectHolder& rhs, const string method, Context& context, Predicate pred) {
 
@@ -40,6 +55,22 @@ namespace runtime {
             throw std::runtime_error("Can not compare objects"s);
         }
 
+        // Значения одного типа Mython, которые Equal сравнивает без ошибки
+        bool SameType(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+            return (lhs.TryAs<Number>() && rhs.TryAs<Number>()) || (lhs.TryAs<String>() && rhs.TryAs<String>())
+                || (lhs.TryAs<Bool>() && rhs.TryAs<Bool>()) || (lhs.TryAs<ClassInstance>() && rhs.TryAs<ClassInstance>())
+                || (lhs.TryAs<List>() && rhs.TryAs<List>()) || (lhs.TryAs<Dict>() && rhs.TryAs<Dict>());
+        }
+
+        // Заполняет переменные кадра для вызова method у instance
+        void BindArguments(Closure& locals, ClassInstance& instance, const Method& method,
+                           const std::vector<ObjectHolder>& args) {
+            locals["self"s] = ObjectHolder::Share(instance);
+            for (size_t i = 0; i < args.size(); ++i) {
+                locals[method.formal_params[i]] = args[i];
+            }
+        }
+
 
     }  // namespace
 
@@ -84,9 +115,34 @@ namespace runtime {
             object.TryAs<ClassInstance>() ||
             (object.TryAs<Bool>() && !object.TryAs<Bool>()->GetValue()) ||
             (object.TryAs<Number>() && !object.TryAs<Number>()->GetValue()) ||
-            (object.TryAs<String>() && object.TryAs<String>()->GetValue().empty()));
+            (object.TryAs<String>() && object.TryAs<String>()->GetValue().empty()) ||
+            (object.TryAs<List>() && object.TryAs<List>()->GetSize() == 0) ||
+            (object.TryAs<Dict>() && object.TryAs<Dict>()->GetSize() == 0));
     }
     
+    void PrintObject(const ObjectHolder& object, Context& context) {
+        if (!object) {
+            context.Write("None"sv);
+        }
+        else if (const auto* str = object.TryAs<String>()) {
+            context.Write(str->GetValue());
+        }
+        else if (const auto* num = object.TryAs<Number>()) {
+            char buffer[16];
+            const auto result = std::to_chars(std::begin(buffer), std::end(buffer), num->GetValue());
+            context.Write({ buffer, static_cast<size_t>(result.ptr - buffer) });
+        }
+        else if (const auto* boolean = object.TryAs<Bool>()) {
+            context.Write(boolean->GetValue() ? "True"sv : "False"sv);
+        }
+        else if (auto* instance = object.TryAs<ClassInstance>(); instance && instance->HasMethod(STR_METHOD, 0)) {
+            PrintObject(instance->Call(STR_METHOD, {}, context), context);
+        }
+        else {
+            object->Print(context.GetOutputStream(), context);
+        }
+    }
+
     void ClassInstance::Print(std::ostream& os, [[maybe_unused]] Context& context) {
         if (HasMethod(STR_METHOD, 0)) {
             Call(STR_METHOD, {}, context)->Print(os, context);
@@ -109,28 +165,70 @@ namespace runtime {
         return closure_;
     }
 
+    const Class& ClassInstance::GetClass() const {
+        return cls_;
+    }
+
     ClassInstance::ClassInstance(const Class& cls) : cls_(cls) {
+        closure_.reserve(cls.GetFieldsHint());
+        Heap::Current().Track(*this);
+    }
+
+    ClassInstance::ClassInstance(const ClassInstance& other)
+        : Object(other)
+        , enable_shared_from_this(other)
+        , cls_(other.cls_)
+        , closure_(other.closure_) {
+        Heap::Current().Track(*this);
     }
 
+    ClassInstance::ClassInstance(ClassInstance&& other)
+        : Object(std::move(other))
+        , enable_shared_from_this(std::move(other))
+        , cls_(other.cls_)
+        , closure_(std::move(other.closure_)) {
+        Heap::Current().Track(*this);
+    }
+
+    ClassInstance::~ClassInstance() {
+        if (heap_ != nullptr) {
+            heap_->Untrack(*this);
+        }
+    }
     ObjectHolder ClassInstance::Call(const std::string& method,
         const std::vector<ObjectHolder>& actual_args,
         Context& context) {
 
         const Method* q_method = cls_.GetMethod(method);
+        if (q_method == nullptr || q_method->formal_params.size() != actual_args.size()) {
+            throw std::runtime_error("Not implemented"s);
+        }
 
-        if (q_method && HasMethod(method, actual_args.size())) {
-            Closure closure;
-            closure["self"] = ObjectHolder::Share(*this);
-
-            for (size_t i = 0; i < actual_args.size(); ++i) {
-                closure[q_method->formal_params[i]] = actual_args[i];
+        context.Step();
+        CallStack::FrameGuard frame(CallStack::Current());
+        BindArguments(frame->locals, *this, *q_method, actual_args);
+        ObjectHolder result = q_method->body->Execute(frame->locals, context);
+
+        // Хвостовые вызовы выполняются здесь же, в кадре метода, поэтому стек не растёт
+        while (frame->tail_method != nullptr) {
+            const std::string& tail_method = *std::exchange(frame->tail_method, nullptr);
+            ObjectHolder target = std::move(frame->tail_object);
+            auto* instance = target.TryAs<ClassInstance>();
+            const Method* next = instance->cls_.GetMethod(tail_method);
+            if (next == nullptr || next->formal_params.size() != frame->tail_args.size()) {
+                throw std::runtime_error("Not implemented"s);
             }
-
-            return q_method->body->Execute(closure, context);
-        }
-        else {
-            throw std::runtime_error("Not implemented"s);
+            context.Step();
+            // Вызов метода self не владеет экземпляром: его держит вызывающий либо прежний callee
+            if (target.Get() != frame->callee.Get()) {
+                frame->callee = std::move(target);
+            }
+            frame->locals.clear();
+            BindArguments(frame->locals, *instance, *next, frame->tail_args);
+            frame->tail_args.clear();
+            result = next->body->Execute(frame->locals, context);
         }
+        return result;
     }
 
     Class::Class(std::string name, std::vector<Method> methods, const Class* parent)
@@ -139,6 +237,13 @@ namespace runtime {
         , parent_(parent) {
     }
 
+    Class::Class(Class&& other) noexcept
+        : name_(std::move(other.name_))
+        , methods_(std::move(other.methods_))
+        , parent_(other.parent_)
+        , fields_hint_(other.fields_hint_.load(memory_order_relaxed)) {
+    }
+
     const Method* Class::GetMethod(const std::string& name) const {
         for (const Method& method : methods_) {
             if (method.name == name) {
@@ -157,10 +262,73 @@ namespace runtime {
         return name_;
     }
 
+    const std::vector<Method>& Class::GetMethods() const {
+        return methods_;
+    }
+
+    const Class* Class::GetParent() const {
+        return parent_;
+    }
+
+    size_t Class::GetFieldsHint() const {
+        return fields_hint_.load(memory_order_relaxed);
+    }
+
+    void Class::NoteFieldCount(size_t field_count) const {
+        size_t hint = fields_hint_.load(memory_order_relaxed);
+        while (hint < field_count && !fields_hint_.compare_exchange_weak(hint, field_count, memory_order_relaxed)) {
+        }
+    }
+
     void Class::Print(ostream& os, [[maybe_unused]] Context& context) {
         os << "Class "sv << name_;
     }
 
+    void Context::SetLimits(ExecutionLimits* limits) {
+        if (limits_ != nullptr) {
+            limits_->AddSteps(step_batch_ - steps_until_check_);
+        }
+        limits_ = limits;
+        step_batch_ = limits_ != nullptr ? limits_->Check(0) : ExecutionLimits::CHECK_INTERVAL;
+        steps_until_check_ = step_batch_;
+    }
+
+    void Context::CheckLimits() {
+        // Пачка засчитывается до проверки: после остановки счётчик шагов не пересчитывается повторно
+        const uint32_t steps = step_batch_;
+        step_batch_ = ExecutionLimits::CHECK_INTERVAL;
+        steps_until_check_ = step_batch_;
+        if (limits_ != nullptr) {
+            step_batch_ = limits_->Check(steps);
+            steps_until_check_ = step_batch_;
+        }
+    }
+
+    String::String(string value)
+        : ValueObject(std::move(value))
+        , charged_(ExternalBytes(GetValue()))
+        , budget_(MemoryBudget::Charge(MemoryKind::String, charged_)) {
+    }
+
+    String::String(const String& other)
+        : ValueObject(other)
+        , charged_(ExternalBytes(GetValue()))
+        , budget_(MemoryBudget::Charge(MemoryKind::String, charged_)) {
+    }
+
+    String::String(String&& other) noexcept
+        : ValueObject(std::move(other))
+        , charged_(other.charged_)
+        , budget_(other.budget_) {
+        // Символы переходят вместе с буфером строки
+        other.charged_ = 0;
+        other.budget_ = nullptr;
+    }
+
+    String::~String() {
+        MemoryBudget::Release(budget_, MemoryKind::String, charged_);
+    }
+
     void Bool::Print(std::ostream& os, [[maybe_unused]] Context& context) {
         os << (GetValue() ? "True"sv : "False"sv);
     }
@@ -170,6 +338,52 @@ namespace runtime {
             return true;
         }
 
+        if (const auto* lhs_list = lhs.TryAs<List>()) {
+            if (const auto* rhs_list = rhs.TryAs<List>()) {
+                if (lhs_list == rhs_list) {
+                    return true;
+                }
+                if (lhs_list->GetSize() != rhs_list->GetSize()) {
+                    return false;
+                }
+                if (lhs_list->GetStorage() == List::Storage::Numbers && rhs_list->GetStorage() == List::Storage::Numbers) {
+                    return lhs_list->GetNumbers() == rhs_list->GetNumbers();
+                }
+                // Индекс, а не итератор: __eq__ элементов может изменить списки
+                for (size_t i = 0; i < lhs_list->GetSize() && i < rhs_list->GetSize(); ++i) {
+                    if (!Equal(lhs_list->Get(i), rhs_list->Get(i), context)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        }
+
+        if (const auto* lhs_dict = lhs.TryAs<Dict>()) {
+            if (const auto* rhs_dict = rhs.TryAs<Dict>()) {
+                if (lhs_dict == rhs_dict) {
+                    return true;
+                }
+                if (lhs_dict->GetSize() != rhs_dict->GetSize()) {
+                    return false;
+                }
+                // Индекс, а не итератор: __eq__ и __hash__ ключей могут изменить словари
+                for (size_t i = 0; i < lhs_dict->GetEntries().size(); ++i) {
+                    const Dict::Entry entry = lhs_dict->GetEntries()[i];
+                    const ObjectHolder* value = rhs_dict->Find(entry.key, context);
+                    if (value == nullptr) {
+                        return false;
+                    }
+                    // Копия: __eq__ значения может добавить пары в rhs_dict и переместить его элементы
+                    const ObjectHolder rhs_value = *value;
+                    if (!Equal(entry.value, rhs_value, context)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        }
+
         return Compare(lhs, rhs, EQ_METHOD, context, std::equal_to());
     }
 
@@ -192,4 +406,28 @@ namespace runtime {
     bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, [[maybe_unused]] Context& context) {
         return !Less(lhs, rhs, context);
     }
+
+    bool SameValue(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return lhs.Get() == rhs.Get() || (SameType(lhs, rhs) && Equal(lhs, rhs, context));
+    }
+
+    bool Contains(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        if (const auto* dict = rhs.TryAs<Dict>()) {
+            return dict->Find(lhs, context) != nullptr;
+        }
+        if (const auto* list = rhs.TryAs<List>()) {
+            return list->Contains(lhs, context);
+        }
+        if (const auto* str = rhs.TryAs<String>()) {
+            if (const auto* part = lhs.TryAs<String>()) {
+                return FindText(str->GetValue(), part->GetValue()) != string_view::npos;
+            }
+            throw runtime_error("Only a string can be searched in a string"s);
+        }
+        throw runtime_error("Operator in expects a dict, a list or a string"s);
+    }
+
+    bool NotContains(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return !Contains(lhs, rhs, context);
+    }
 }  // namespace runtime
\ No newline at end of file
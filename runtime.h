@@ -1,8 +1,14 @@
 #pragma once
 
+#include "execution_limits.h"
+#include "object_pool.h"
+
+#include <atomic>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -14,10 +20,46 @@ namespace runtime {
         // Возвращает поток вывода для команд print
         virtual std::ostream& GetOutputStream() = 0;
 
+        // Дописывает data в вывод команд print.
+        // Контексты с собственным буфером переопределяют метод, чтобы писать в обход std::ostream
+        virtual void Write(std::string_view data) {
+            GetOutputStream().write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+
+        // Передаёт накопленный вывод получателю
+        virtual void Flush() {
+            GetOutputStream().flush();
+        }
+
+        // Подключает ограничения выполнения программ в этом контексте. nullptr отключает их.
+        // Шаги, сделанные до вызова, учитываются в ранее подключённых ограничениях
+        void SetLimits(ExecutionLimits* limits);
+
+        // Учитывает шаг выполнения программы. Ограничения проверяются пачками шагов (см. ExecutionLimits),
+        // поэтому на горячем пути выполняется только уменьшение счётчика.
+        // При нарушении ограничений выбрасывает ExecutionStopped
+        void Step() {
+            if (--steps_until_check_ == 0) {
+                CheckLimits();
+            }
+        }
+
     protected:
         ~Context() = default;
+
+    private:
+        void CheckLimits();
+
+        ExecutionLimits* limits_ = nullptr;
+        // Размер текущей пачки шагов и число шагов до её окончания
+        uint32_t step_batch_ = ExecutionLimits::CHECK_INTERVAL;
+        uint32_t steps_until_check_ = ExecutionLimits::CHECK_INTERVAL;
     };
 
+    // Возвращает вид памяти, под которым объекты типа T учитываются в бюджете памяти (см. MemoryBudget)
+    template <typename T>
+    constexpr MemoryKind MemoryKindOf();
+
     // Базовый класс для всех объектов языка Mython
     class Object {
     public:
@@ -34,10 +76,18 @@ namespace runtime {
 
         // Возвращает ObjectHolder, владеющий объектом типа T
         // Тип T - конкретный класс-наследник Object.
-        // object копируется или перемещается в кучу
+        // object копируется или перемещается в пул объектов текущего потока (см. ObjectPool)
         template <typename T>
         [[nodiscard]] static ObjectHolder Own(T&& object) {
-            return ObjectHolder(std::make_shared<T>(std::forward<T>(object)));
+            return Make<std::decay_t<T>>(std::forward<T>(object));
+        }
+
+        // Возвращает ObjectHolder, владеющий объектом типа T, который создаётся прямо в пуле объектов
+        // из аргументов args, без промежуточной копии
+        template <typename T, typename... Args>
+        [[nodiscard]] static ObjectHolder Make(Args&&... args) {
+            return ObjectHolder(
+                std::allocate_shared<T>(PoolAllocator<T>(MemoryKindOf<T>()), std::forward<Args>(args)...));
         }
 
         // Создаёт ObjectHolder, не владеющий объектом (аналог слабой ссылки)
@@ -64,6 +114,8 @@ namespace runtime {
         explicit operator bool() const;
 
     private:
+        friend class Heap;
+
         explicit ObjectHolder(std::shared_ptr<Object> data);
         void AssertIsValid() const;
 
@@ -75,7 +127,7 @@ namespace runtime {
     class ValueObject : public Object {
     public:
         ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
-            : value_(v) {
+            : value_(std::move(v)) {
         }
 
         void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
@@ -90,11 +142,31 @@ namespace runtime {
         T value_;
     };
 
-    // Таблица символов, связывающая имя объекта с его значением
-    using Closure = std::unordered_map<std::string, ObjectHolder>;
+    // Аллокатор таблиц символов: память учитывается в бюджете как MemoryKind::Closure
+    template <typename T>
+    class ClosureAllocator : public PoolAllocator<T> {
+    public:
+        ClosureAllocator() noexcept
+            : PoolAllocator<T>(MemoryKind::Closure) {
+        }
+
+        template <typename U>
+        ClosureAllocator(const ClosureAllocator<U>& other) noexcept  // NOLINT(google-explicit-constructor)
+            : PoolAllocator<T>(other) {
+        }
+    };
+
+    // Таблица символов, связывающая имя объекта с его значением.
+    // Узлы и массив корзин выделяются из пула объектов потока, как и сами объекты
+    using Closure = std::unordered_map<std::string, ObjectHolder, std::hash<std::string>, std::equal_to<std::string>,
+                                       ClosureAllocator<std::pair<const std::string, ObjectHolder>>>;
+
+    // Выводит object в вывод контекста так же, как это делает команда print (None выводится как "None").
+    // Числа, строки и логические значения записываются через Context::Write без участия std::ostream
+    void PrintObject(const ObjectHolder& object, Context& context);
 
     // Проверяет, содержится ли в object значение, приводимое к True
-    // Для отличных от нуля чисел, True и непустых строк возвращается true. В остальных случаях - false.
+    // Для отличных от нуля чисел, True, непустых строк, списков и словарей возвращается true. В остальных случаях - false.
     bool IsTrue(const ObjectHolder& object);
 
     // Интерфейс для выполнения действий над объектами Mython
@@ -106,8 +178,24 @@ namespace runtime {
         virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
     };
 
-    // Строковое значение
-    using String = ValueObject<std::string>;
+    // Строковое значение. Символы, не поместившиеся в сам объект std::string,
+    // учитываются в бюджете памяти потока вместе с объектом
+    class String : public ValueObject<std::string> {
+    public:
+        String(std::string value);  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+        String(const String& other);
+        String(String&& other) noexcept;
+        String& operator=(const String&) = delete;
+        String& operator=(String&&) = delete;
+        ~String() override;
+
+    private:
+        // Число байт символов, учтённых в бюджете
+        size_t charged_;
+        // Бюджет, в котором учтены символы, либо nullptr
+        MemoryBudget* budget_;
+    };
+
     // Числовое значение
     using Number = ValueObject<int>;
 
@@ -134,6 +222,7 @@ namespace runtime {
         // Создаёт класс с именем name и набором методов methods, унаследованный от класса parent
         // Если parent равен nullptr, то создаётся базовый класс
         explicit Class(std::string name, std::vector<Method> methods, const Class* parent);
+        Class(Class&& other) noexcept;
 
         // Возвращает указатель на метод name или nullptr, если метод с таким именем отсутствует
         [[nodiscard]] const Method* GetMethod(const std::string& name) const;
@@ -141,6 +230,18 @@ namespace runtime {
         // Возвращает имя класса
         [[nodiscard]] const std::string& GetName() const;
 
+        // Возвращает собственные методы класса, без унаследованных
+        [[nodiscard]] const std::vector<Method>& GetMethods() const;
+
+        // Возвращает родительский класс или nullptr
+        [[nodiscard]] const Class* GetParent() const;
+
+        // Возвращает наибольшее число полей, которое экземпляры класса получали в __init__.
+        // Новые экземпляры сразу резервируют место под столько полей
+        [[nodiscard]] size_t GetFieldsHint() const;
+        // Учитывает, что экземпляр получил в __init__ field_count полей
+        void NoteFieldCount(size_t field_count) const;
+
         // Выводит в os строку "Class <имя класса>", например "Class cat"
         void Print(std::ostream& os, Context& context) override;
 
@@ -148,13 +249,22 @@ namespace runtime {
         std::string name_;
         std::vector<Method> methods_;
         const Class* parent_;
+        // Классы разделяются потоками, выполняющими одну программу, поэтому подсказка атомарная
+        mutable std::atomic<size_t> fields_hint_{0};
     };
 
-    // Экземпляр класса
-    class ClassInstance : public Object {
+    class Dict;
+    class Heap;
+    class List;
+
+    // Экземпляр класса. Экземпляры учитываются кучей потока, в котором созданы (см. Heap)
+    class ClassInstance : public Object, public std::enable_shared_from_this<ClassInstance> {
     public:
         explicit ClassInstance(const Class& cls);
-        
+        ClassInstance(const ClassInstance& other);
+        ClassInstance(ClassInstance&& other);
+        ~ClassInstance() override;
+
         /*
          * Если у объекта есть метод __str__, выводит в os результат, возвращённый этим методом.
          * В противном случае в os выводится адрес объекта.
@@ -175,14 +285,60 @@ namespace runtime {
         [[nodiscard]] Closure& Fields();
         // Возвращает константную ссылку на Closure, содержащую поля объекта
         [[nodiscard]] const Closure& Fields() const;
+        // Возвращает класс объекта
+        [[nodiscard]] const Class& GetClass() const;
 
     private:
+        friend class Heap;
+
         const Class& cls_;
         Closure closure_;
+        // Куча, учитывающая экземпляр, и его номер в ней
+        Heap* heap_ = nullptr;
+        size_t heap_index_ = 0;
+    };
+
+    // Встроенный объект, методы которого реализованы на C++ (например, каналы изолятов, см. isolate.h).
+    // Вызов метода такого объекта в программе передаётся в Call
+    class NativeObject : public Object {
+    public:
+        // Вызывает метод method с параметрами args. Для неизвестного метода выбрасывает runtime_error
+        virtual ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& args,
+                                  Context& context) = 0;
     };
-    
+
+    template <typename T>
+    constexpr MemoryKind MemoryKindOf() {
+        if constexpr (std::is_base_of_v<String, T>) {
+            return MemoryKind::String;
+        }
+        else if constexpr (std::is_base_of_v<Number, T>) {
+            return MemoryKind::Number;
+        }
+        else if constexpr (std::is_base_of_v<Bool, T>) {
+            return MemoryKind::Bool;
+        }
+        else if constexpr (std::is_base_of_v<ClassInstance, T>) {
+            return MemoryKind::Instance;
+        }
+        else if constexpr (std::is_base_of_v<Class, T>) {
+            return MemoryKind::Class;
+        }
+        else if constexpr (std::is_base_of_v<List, T>) {
+            return MemoryKind::List;
+        }
+        else if constexpr (std::is_base_of_v<Dict, T>) {
+            return MemoryKind::Dict;
+        }
+        else {
+            return MemoryKind::Other;
+        }
+    }
+
     /*
-     * Возвращает true, если lhs и rhs содержат одинаковые числа, строки или значения типа Bool.
+     * Возвращает true, если lhs и rhs содержат одинаковые числа, строки или значения типа Bool,
+     * если lhs и rhs - списки одной длины с попарно равными элементами, а также если lhs и rhs - словари
+     * с одинаковыми ключами и равными значениями.
      * Если lhs - объект с методом __eq__, функция возвращает результат вызова lhs.__eq__(rhs),
      * приведённый к типу Bool. Если lhs и rhs имеют значение None, функция возвращает true.
      * В остальных случаях функция выбрасывает исключение runtime_error.
@@ -209,6 +365,19 @@ namespace runtime {
     // Возвращает значение, противоположное Less(lhs, rhs, context)
     bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
 
+    // Возвращает true, если lhs и rhs - один объект либо значения одного типа, равные по Equal.
+    // Так элементы списков сравнивают оператор in и метод count
+    bool SameValue(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    /*
+     * Оператор lhs in rhs. Для словаря rhs проверяет наличие ключа lhs, для списка - наличие элемента,
+     * равного lhs по SameValue, для строки rhs - вхождение подстроки lhs.
+     * Для остальных rhs выбрасывает runtime_error
+     */
+    bool Contains(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+    // Оператор lhs not in rhs: значение, противоположное Contains(lhs, rhs, context)
+    bool NotContains(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
     // Контекст-заглушка, применяется в тестах.
     // В этом контексте весь вывод перенаправляется в строковый поток вывода output
     struct DummyContext : Context {
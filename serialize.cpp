@@ -0,0 +1,985 @@
+#include "serialize.h"
+
+#include "dict.h"
+#include "list.h"
+
+#include <cstdint>
+#include <typeinfo>
+#include <unordered_map>
+
+using namespace std;
+
+namespace ast {
+
+    using runtime::ObjectHolder;
+
+    namespace {
+        const string_view MAGIC = "MYTHONAST"sv;
+        const string_view SNAPSHOT_MAGIC = "MYTHONSNAP"sv;
+        // Версия общего формата дерева и снимка. 2: в таблице объектов снимка появились списки и словари
+        constexpr uint64_t FORMAT_VERSION = 2;
+
+        // Теги узлов. Значения записываются в файл, поэтому существующие теги менять нельзя
+        enum class NodeTag : uint8_t {
+            Null = 0,
+            NumericConst,
+            StringConst,
+            BoolConst,
+            None,
+            VariableValue,
+            Assignment,
+            FieldAssignment,
+            Print,
+            MethodCall,
+            NewInstance,
+            Stringify,
+            Add,
+            Sub,
+            Mult,
+            Div,
+            Or,
+            And,
+            Not,
+            Comparison,
+            Compound,
+            MethodBody,
+            Return,
+            ClassDefinition,
+            IfElse,
+            NewChannel,
+            Spawn,
+            StartTask,
+            Yield,
+            While,
+            Break,
+            Continue,
+            NewList,
+            Index,
+            IndexAssignment,
+            Length,
+            For,
+            NewDict,
+            ListFunction,
+            FormatString,
+        };
+
+        // Типы значений в снимке
+        enum class ValueTag : uint8_t {
+            None = 0,
+            Number,
+            String,
+            Bool,
+            Class,
+            Instance,
+            List,
+            Dict,
+        };
+
+        using ComparatorFn = bool (*)(const ObjectHolder&, const ObjectHolder&, runtime::Context&);
+
+        // Функции сравнения, которые может содержать узел Comparison. Номер функции записывается в файл
+        const ComparatorFn COMPARATORS[] = {
+            runtime::Equal,   runtime::NotEqual,    runtime::Less,
+            runtime::Greater, runtime::LessOrEqual, runtime::GreaterOrEqual,
+            runtime::Contains, runtime::NotContains,
+        };
+
+        class ProgramWriter {
+        public:
+            string Write(const runtime::Executable& program) {
+                WriteNode(&program);
+                return Finish(MAGIC);
+            }
+
+            // Снимок: объявления классов программы, таблица объектов (экземпляров с их классами, списков и словарей),
+            // содержимое объектов и глобальные переменные.
+            // Объекты нумеруются заранее, поэтому ссылки между ними не требуют рекурсии
+            string WriteSnapshot(const runtime::Executable& program, const runtime::Closure& globals) {
+                vector<const runtime::Class*> classes;
+                CollectClasses(program, classes);
+                WriteVarint(classes.size());
+                for (const runtime::Class* cls : classes) {
+                    WriteClass(*cls);
+                }
+
+                for (const auto& [name, value] : globals) {
+                    CollectObjects(value);
+                }
+                for (size_t i = 0; i < objects_.size(); ++i) {
+                    if (const auto* instance = dynamic_cast<const runtime::ClassInstance*>(objects_[i])) {
+                        for (const auto& [name, value] : instance->Fields()) {
+                            CollectObjects(value);
+                        }
+                    }
+                    else if (const auto* dict = dynamic_cast<const runtime::Dict*>(objects_[i])) {
+                        for (const runtime::Dict::Entry& entry : dict->GetEntries()) {
+                            CollectObjects(entry.key);
+                            CollectObjects(entry.value);
+                        }
+                    }
+                    else {
+                        // Упакованные списки не ссылаются на объекты
+                        for (const ObjectHolder& item : static_cast<const runtime::List*>(objects_[i])->GetObjects()) {
+                            CollectObjects(item);
+                        }
+                    }
+                }
+
+                WriteVarint(objects_.size());
+                for (const runtime::Object* object : objects_) {
+                    if (const auto* instance = dynamic_cast<const runtime::ClassInstance*>(object)) {
+                        WriteTag(ValueTag::Instance);
+                        WriteVarint(ClassIndex(instance->GetClass()));
+                    }
+                    else {
+                        WriteTag(dynamic_cast<const runtime::Dict*>(object) != nullptr ? ValueTag::Dict : ValueTag::List);
+                    }
+                }
+                for (const runtime::Object* object : objects_) {
+                    if (const auto* instance = dynamic_cast<const runtime::ClassInstance*>(object)) {
+                        WriteClosure(instance->Fields());
+                    }
+                    else if (const auto* dict = dynamic_cast<const runtime::Dict*>(object)) {
+                        WriteDict(*dict);
+                    }
+                    else {
+                        WriteList(*static_cast<const runtime::List*>(object));
+                    }
+                }
+                WriteClosure(globals);
+
+                return Finish(SNAPSHOT_MAGIC);
+            }
+
+        private:
+            string Finish(string_view magic) {
+                string result(magic);
+                AppendVarint(result, FORMAT_VERSION);
+                AppendVarint(result, strings_.size());
+                for (const string* str : strings_) {
+                    AppendVarint(result, str->size());
+                    result += *str;
+                }
+                result += body_;
+                return result;
+            }
+
+            static void AppendVarint(string& out, uint64_t value) {
+                while (value >= 0x80) {
+                    out.push_back(static_cast<char>(value | 0x80));
+                    value >>= 7;
+                }
+                out.push_back(static_cast<char>(value));
+            }
+
+            void WriteVarint(uint64_t value) {
+                AppendVarint(body_, value);
+            }
+
+            void WriteInt(int value) {
+                // zigzag-кодирование, чтобы небольшие отрицательные числа занимали один байт
+                const auto v = static_cast<int64_t>(value);
+                WriteVarint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+            }
+
+            void WriteTag(NodeTag tag) {
+                body_.push_back(static_cast<char>(tag));
+            }
+
+            void WriteTag(ValueTag tag) {
+                body_.push_back(static_cast<char>(tag));
+            }
+
+            void WriteString(const string& str) {
+                auto [it, inserted] = string_index_.emplace(str, strings_.size());
+                if (inserted) {
+                    strings_.push_back(&it->first);
+                }
+                WriteVarint(it->second);
+            }
+
+            void WriteStrings(const vector<string>& strings) {
+                WriteVarint(strings.size());
+                for (const string& str : strings) {
+                    WriteString(str);
+                }
+            }
+
+            void WriteNodes(const vector<unique_ptr<Statement>>& nodes) {
+                WriteVarint(nodes.size());
+                for (const auto& node : nodes) {
+                    WriteNode(node.get());
+                }
+            }
+
+            void WriteBinary(NodeTag tag, const BinaryOperation& operation) {
+                WriteTag(tag);
+                WriteNode(operation.GetLhs().get());
+                WriteNode(operation.GetRhs().get());
+            }
+
+            void WriteClass(const runtime::Class& cls) {
+                const uint64_t index = class_index_.size();
+                if (!class_index_.emplace(&cls, index).second) {
+                    throw SerializeError("Class "s + cls.GetName() + " is defined twice"s);
+                }
+
+                WriteString(cls.GetName());
+                if (const runtime::Class* parent = cls.GetParent()) {
+                    WriteVarint(ClassIndex(*parent) + 1);
+                }
+                else {
+                    WriteVarint(0);
+                }
+
+                WriteVarint(cls.GetMethods().size());
+                for (const runtime::Method& method : cls.GetMethods()) {
+                    WriteString(method.name);
+                    WriteStrings(method.formal_params);
+                    WriteNode(method.body.get());
+                }
+            }
+
+            // Собирает классы, объявленные инструкциями верхнего уровня program, в порядке объявления.
+            // Классы, объявленные внутри методов, сохраняются вместе с телами этих методов
+            static void CollectClasses(const runtime::Executable& program, vector<const runtime::Class*>& classes) {
+                if (const auto* definition = dynamic_cast<const ClassDefinition*>(&program)) {
+                    classes.push_back(definition->GetClass().TryAs<runtime::Class>());
+                }
+                else if (const auto* compound = dynamic_cast<const Compound*>(&program)) {
+                    for (const auto& statement : compound->GetStatements()) {
+                        CollectClasses(*statement, classes);
+                    }
+                }
+                else if (const auto* if_else = dynamic_cast<const IfElse*>(&program)) {
+                    CollectClasses(*if_else->GetIfBody(), classes);
+                    if (if_else->GetElseBody()) {
+                        CollectClasses(*if_else->GetElseBody(), classes);
+                    }
+                }
+                else if (const auto* loop = dynamic_cast<const While*>(&program)) {
+                    CollectClasses(*loop->GetBody(), classes);
+                }
+                else if (const auto* loop = dynamic_cast<const For*>(&program)) {
+                    CollectClasses(*loop->GetBody(), classes);
+                }
+            }
+
+            // Присваивает номер экземпляру класса, списку или словарю, если value - ещё не встречавшийся объект
+            void CollectObjects(const ObjectHolder& value) {
+                if (value.TryAs<runtime::ClassInstance>() != nullptr || value.TryAs<runtime::List>() != nullptr
+                    || value.TryAs<runtime::Dict>() != nullptr) {
+                    if (object_index_.emplace(value.Get(), objects_.size()).second) {
+                        objects_.push_back(value.Get());
+                    }
+                }
+            }
+
+            // Список записывается в своём представлении: упакованные числа и логические значения - без объектов
+            void WriteList(const runtime::List& list) {
+                WriteVarint(static_cast<uint64_t>(list.GetStorage()));
+                WriteVarint(list.GetSize());
+                switch (list.GetStorage()) {
+                case runtime::List::Storage::Numbers:
+                    for (const int number : list.GetNumbers()) {
+                        WriteInt(number);
+                    }
+                    break;
+                case runtime::List::Storage::Bools:
+                    for (size_t i = 0; i < list.GetSize(); ++i) {
+                        WriteVarint(list.Get(i).TryAs<runtime::Bool>()->GetValue() ? 1 : 0);
+                    }
+                    break;
+                case runtime::List::Storage::Objects:
+                    for (const ObjectHolder& item : list.GetObjects()) {
+                        WriteValue(item);
+                    }
+                    break;
+                }
+            }
+
+            // Пары словаря записываются в порядке добавления вместе с хешами ключей: при загрузке
+            // методы __hash__ не вызываются (см. runtime::Dict::Restore)
+            void WriteDict(const runtime::Dict& dict) {
+                WriteVarint(dict.GetSize());
+                for (const runtime::Dict::Entry& entry : dict.GetEntries()) {
+                    WriteValue(entry.key);
+                    WriteValue(entry.value);
+                    WriteVarint(entry.hash);
+                }
+            }
+
+            void WriteClosure(const runtime::Closure& closure) {
+                WriteVarint(closure.size());
+                for (const auto& [name, value] : closure) {
+                    WriteString(name);
+                    WriteValue(value);
+                }
+            }
+
+            void WriteValue(const ObjectHolder& value) {
+                if (!value) {
+                    WriteTag(ValueTag::None);
+                }
+                else if (const auto* num = value.TryAs<runtime::Number>()) {
+                    WriteTag(ValueTag::Number);
+                    WriteInt(num->GetValue());
+                }
+                else if (const auto* str = value.TryAs<runtime::String>()) {
+                    WriteTag(ValueTag::String);
+                    WriteString(str->GetValue());
+                }
+                else if (const auto* boolean = value.TryAs<runtime::Bool>()) {
+                    WriteTag(ValueTag::Bool);
+                    WriteVarint(boolean->GetValue() ? 1 : 0);
+                }
+                else if (const auto* cls = value.TryAs<runtime::Class>()) {
+                    WriteTag(ValueTag::Class);
+                    WriteVarint(ClassIndex(*cls));
+                }
+                else if (value.TryAs<runtime::ClassInstance>() != nullptr) {
+                    WriteTag(ValueTag::Instance);
+                    WriteVarint(object_index_.at(value.Get()));
+                }
+                else if (value.TryAs<runtime::List>() != nullptr) {
+                    WriteTag(ValueTag::List);
+                    WriteVarint(object_index_.at(value.Get()));
+                }
+                else if (value.TryAs<runtime::Dict>() != nullptr) {
+                    WriteTag(ValueTag::Dict);
+                    WriteVarint(object_index_.at(value.Get()));
+                }
+                else {
+                    throw SerializeError("Unsupported object type "s + typeid(*value).name());
+                }
+            }
+
+            uint64_t ClassIndex(const runtime::Class& cls) const {
+                const auto it = class_index_.find(&cls);
+                if (it == class_index_.end()) {
+                    throw SerializeError("Class "s + cls.GetName() + " is used before its definition"s);
+                }
+                return it->second;
+            }
+
+            void WriteNode(const runtime::Executable* node) {
+                if (node == nullptr) {
+                    WriteTag(NodeTag::Null);
+                }
+                else if (const auto* num = dynamic_cast<const NumericConst*>(node)) {
+                    WriteTag(NodeTag::NumericConst);
+                    WriteInt(num->GetValue().GetValue());
+                }
+                else if (const auto* str = dynamic_cast<const StringConst*>(node)) {
+                    WriteTag(NodeTag::StringConst);
+                    WriteString(str->GetValue().GetValue());
+                }
+                else if (const auto* boolean = dynamic_cast<const BoolConst*>(node)) {
+                    WriteTag(NodeTag::BoolConst);
+                    WriteVarint(boolean->GetValue().GetValue() ? 1 : 0);
+                }
+                else if (dynamic_cast<const None*>(node)) {
+                    WriteTag(NodeTag::None);
+                }
+                else if (const auto* variable = dynamic_cast<const VariableValue*>(node)) {
+                    WriteTag(NodeTag::VariableValue);
+                    WriteStrings(variable->GetDottedIds());
+                }
+                else if (const auto* assignment = dynamic_cast<const Assignment*>(node)) {
+                    WriteTag(NodeTag::Assignment);
+                    WriteString(assignment->GetVar());
+                    WriteNode(assignment->GetRv().get());
+                }
+                else if (const auto* field = dynamic_cast<const FieldAssignment*>(node)) {
+                    WriteTag(NodeTag::FieldAssignment);
+                    WriteStrings(field->GetObject().GetDottedIds());
+                    WriteString(field->GetFieldName());
+                    WriteNode(field->GetRv().get());
+                }
+                else if (const auto* print = dynamic_cast<const Print*>(node)) {
+                    WriteTag(NodeTag::Print);
+                    WriteNodes(print->GetArgs());
+                }
+                else if (const auto* call = dynamic_cast<const MethodCall*>(node)) {
+                    WriteTag(NodeTag::MethodCall);
+                    WriteNode(call->GetObject().get());
+                    WriteString(call->GetMethod());
+                    WriteNodes(call->GetArgs());
+                }
+                else if (const auto* instance = dynamic_cast<const NewInstance*>(node)) {
+                    WriteTag(NodeTag::NewInstance);
+                    WriteVarint(ClassIndex(instance->GetClass()));
+                    WriteNodes(instance->GetArgs());
+                }
+                else if (dynamic_cast<const NewChannel*>(node)) {
+                    WriteTag(NodeTag::NewChannel);
+                }
+                else if (const auto* spawn = dynamic_cast<const Spawn*>(node)) {
+                    WriteTag(NodeTag::Spawn);
+                    WriteNode(spawn->GetObject().get());
+                    WriteString(spawn->GetMethod());
+                    WriteNodes(spawn->GetArgs());
+                }
+                else if (const auto* start = dynamic_cast<const StartTask*>(node)) {
+                    WriteTag(NodeTag::StartTask);
+                    WriteNode(start->GetObject().get());
+                    WriteString(start->GetMethod());
+                    WriteNodes(start->GetArgs());
+                }
+                else if (dynamic_cast<const Yield*>(node)) {
+                    WriteTag(NodeTag::Yield);
+                }
+                else if (const auto* stringify = dynamic_cast<const Stringify*>(node)) {
+                    WriteTag(NodeTag::Stringify);
+                    WriteNode(stringify->GetArgument().get());
+                }
+                else if (const auto* add = dynamic_cast<const Add*>(node)) {
+                    WriteBinary(NodeTag::Add, *add);
+                }
+                else if (const auto* sub = dynamic_cast<const Sub*>(node)) {
+                    WriteBinary(NodeTag::Sub, *sub);
+                }
+                else if (const auto* mult = dynamic_cast<const Mult*>(node)) {
+                    WriteBinary(NodeTag::Mult, *mult);
+                }
+                else if (const auto* div = dynamic_cast<const Div*>(node)) {
+                    WriteBinary(NodeTag::Div, *div);
+                }
+                else if (const auto* or_node = dynamic_cast<const Or*>(node)) {
+                    WriteBinary(NodeTag::Or, *or_node);
+                }
+                else if (const auto* and_node = dynamic_cast<const And*>(node)) {
+                    WriteBinary(NodeTag::And, *and_node);
+                }
+                else if (const auto* not_node = dynamic_cast<const Not*>(node)) {
+                    WriteTag(NodeTag::Not);
+                    WriteNode(not_node->GetArgument().get());
+                }
+                else if (const auto* comparison = dynamic_cast<const Comparison*>(node)) {
+                    WriteBinary(NodeTag::Comparison, *comparison);
+                    WriteVarint(ComparatorIndex(comparison->GetComparator()));
+                }
+                else if (const auto* compound = dynamic_cast<const Compound*>(node)) {
+                    WriteTag(NodeTag::Compound);
+                    WriteNodes(compound->GetStatements());
+                }
+                else if (const auto* body = dynamic_cast<const MethodBody*>(node)) {
+                    WriteTag(NodeTag::MethodBody);
+                    WriteNode(body->GetBody().get());
+                }
+                else if (const auto* lazy = dynamic_cast<const LazyMethodBody*>(node)) {
+                    // Отложенное тело разбирается и сохраняется как обычное
+                    WriteNode(&lazy->GetBody());
+                }
+                else if (const auto* ret = dynamic_cast<const Return*>(node)) {
+                    WriteTag(NodeTag::Return);
+                    WriteNode(ret->GetStatement().get());
+                }
+                else if (const auto* definition = dynamic_cast<const ClassDefinition*>(node)) {
+                    WriteTag(NodeTag::ClassDefinition);
+                    WriteClass(*definition->GetClass().TryAs<runtime::Class>());
+                }
+                else if (const auto* if_else = dynamic_cast<const IfElse*>(node)) {
+                    WriteTag(NodeTag::IfElse);
+                    WriteNode(if_else->GetCondition().get());
+                    WriteNode(if_else->GetIfBody().get());
+                    WriteNode(if_else->GetElseBody().get());
+                }
+                else if (const auto* loop = dynamic_cast<const While*>(node)) {
+                    WriteTag(NodeTag::While);
+                    WriteNode(loop->GetCondition().get());
+                    WriteNode(loop->GetBody().get());
+                }
+                else if (dynamic_cast<const Break*>(node)) {
+                    WriteTag(NodeTag::Break);
+                }
+                else if (dynamic_cast<const Continue*>(node)) {
+                    WriteTag(NodeTag::Continue);
+                }
+                else if (const auto* loop = dynamic_cast<const For*>(node)) {
+                    WriteTag(NodeTag::For);
+                    WriteString(loop->GetVar());
+                    WriteNode(loop->GetIterable().get());
+                    WriteNode(loop->GetBody().get());
+                }
+                else if (const auto* list = dynamic_cast<const NewList*>(node)) {
+                    WriteTag(NodeTag::NewList);
+                    WriteNodes(list->GetItems());
+                }
+                else if (const auto* dict = dynamic_cast<const NewDict*>(node)) {
+                    WriteTag(NodeTag::NewDict);
+                    WriteVarint(dict->GetItems().size());
+                    for (const auto& [key, value] : dict->GetItems()) {
+                        WriteNode(key.get());
+                        WriteNode(value.get());
+                    }
+                }
+                else if (const auto* function = dynamic_cast<const ListFunction*>(node)) {
+                    WriteTag(NodeTag::ListFunction);
+                    WriteVarint(static_cast<uint64_t>(function->GetKind()));
+                    WriteNodes(function->GetArgs());
+                }
+                else if (const auto* format = dynamic_cast<const FormatString*>(node)) {
+                    WriteTag(NodeTag::FormatString);
+                    WriteStrings(format->GetLiterals());
+                    WriteNodes(format->GetValues());
+                }
+                else if (const auto* index = dynamic_cast<const Index*>(node)) {
+                    WriteBinary(NodeTag::Index, *index);
+                }
+                else if (const auto* assignment = dynamic_cast<const IndexAssignment*>(node)) {
+                    WriteTag(NodeTag::IndexAssignment);
+                    WriteNode(assignment->GetObject().get());
+                    WriteNode(assignment->GetIndex().get());
+                    WriteNode(assignment->GetRv().get());
+                }
+                else if (const auto* length = dynamic_cast<const Length*>(node)) {
+                    WriteTag(NodeTag::Length);
+                    WriteNode(length->GetArgument().get());
+                }
+                else {
+                    throw SerializeError("Unsupported statement type "s + typeid(*node).name());
+                }
+            }
+
+            static uint64_t ComparatorIndex(const Comparison::Comparator& comparator) {
+                if (const auto* fn = comparator.target<ComparatorFn>()) {
+                    for (size_t i = 0; i < size(COMPARATORS); ++i) {
+                        if (*fn == COMPARATORS[i]) {
+                            return i;
+                        }
+                    }
+                }
+                throw SerializeError("Unsupported comparator"s);
+            }
+
+            unordered_map<string, uint64_t> string_index_;
+            vector<const string*> strings_;
+            unordered_map<const runtime::Class*, uint64_t> class_index_;
+            unordered_map<const runtime::Object*, uint64_t> object_index_;
+            vector<const runtime::Object*> objects_;
+            string body_;
+        };
+
+        class ProgramReader {
+        public:
+            explicit ProgramReader(string_view data)
+                : data_(data) {
+            }
+
+            unique_ptr<runtime::Executable> Read() {
+                ReadHeader(MAGIC);
+                auto program = ReadNode();
+                if (!program || pos_ != data_.size()) {
+                    throw SerializeError("Corrupted serialized program"s);
+                }
+                return program;
+            }
+
+            Snapshot ReadSnapshot() {
+                ReadHeader(SNAPSHOT_MAGIC);
+                for (size_t count = ReadCount(); count > 0; --count) {
+                    ReadClass();
+                }
+
+                // Объекты создаются до чтения содержимого, чтобы поля и элементы могли ссылаться на любой из них
+                objects_.resize(ReadCount());
+                for (ObjectHolder& object : objects_) {
+                    switch (static_cast<ValueTag>(ReadByte())) {
+                    case ValueTag::Instance:
+                        object = ObjectHolder::Make<runtime::ClassInstance>(ClassAt(ReadVarint()));
+                        break;
+                    case ValueTag::List:
+                        object = ObjectHolder::Make<runtime::List>();
+                        break;
+                    case ValueTag::Dict:
+                        object = ObjectHolder::Make<runtime::Dict>();
+                        break;
+                    default:
+                        throw SerializeError("Corrupted object table"s);
+                    }
+                }
+                for (ObjectHolder& object : objects_) {
+                    if (auto* instance = object.TryAs<runtime::ClassInstance>()) {
+                        ReadClosure(instance->Fields());
+                    }
+                    else if (auto* dict = object.TryAs<runtime::Dict>()) {
+                        ReadDict(*dict);
+                    }
+                    else {
+                        ReadList(*object.TryAs<runtime::List>());
+                    }
+                }
+
+                Snapshot snapshot;
+                ReadClosure(snapshot.globals);
+                if (pos_ != data_.size()) {
+                    throw SerializeError("Corrupted snapshot"s);
+                }
+                snapshot.classes = std::move(classes_);
+                return snapshot;
+            }
+
+        private:
+            void ReadHeader(string_view magic) {
+                if (data_.substr(0, magic.size()) != magic) {
+                    throw SerializeError("Not a serialized Mython program"s);
+                }
+                pos_ = magic.size();
+                if (ReadVarint() != FORMAT_VERSION) {
+                    throw SerializeError("Unsupported serialized program version"s);
+                }
+
+                strings_.resize(ReadCount());
+                for (string_view& str : strings_) {
+                    const size_t size = ReadCount();
+                    str = data_.substr(pos_, size);
+                    pos_ += size;
+                }
+            }
+
+            void ReadClosure(runtime::Closure& closure) {
+                for (size_t count = ReadCount(); count > 0; --count) {
+                    string name = ReadString();
+                    closure[std::move(name)] = ReadValue();
+                }
+            }
+
+            void ReadList(runtime::List& list) {
+                const uint64_t storage = ReadVarint();
+                for (size_t count = ReadCount(); count > 0; --count) {
+                    switch (static_cast<runtime::List::Storage>(storage)) {
+                    case runtime::List::Storage::Numbers:
+                        list.Append(ObjectHolder::Own(runtime::Number(ReadInt())));
+                        break;
+                    case runtime::List::Storage::Bools:
+                        list.Append(ObjectHolder::Own(runtime::Bool(ReadVarint() != 0)));
+                        break;
+                    case runtime::List::Storage::Objects:
+                        list.AppendGeneral(ReadValue());
+                        break;
+                    default:
+                        throw SerializeError("Unknown list storage"s);
+                    }
+                }
+            }
+
+            void ReadDict(runtime::Dict& dict) {
+                for (size_t count = ReadCount(); count > 0; --count) {
+                    ObjectHolder key = ReadValue();
+                    ObjectHolder value = ReadValue();
+                    const uint64_t hash = ReadVarint();
+                    if (hash > UINT32_MAX) {
+                        throw SerializeError("Corrupted dict hash"s);
+                    }
+                    dict.Restore(std::move(key), std::move(value), static_cast<uint32_t>(hash));
+                }
+            }
+
+            // Объект из таблицы объектов снимка, который должен иметь тип T
+            template <typename T>
+            ObjectHolder ObjectAt(uint64_t index) const {
+                if (index >= objects_.size() || objects_[index].TryAs<T>() == nullptr) {
+                    throw SerializeError("Corrupted object reference"s);
+                }
+                return objects_[index];
+            }
+
+            ObjectHolder ReadValue() {
+                switch (static_cast<ValueTag>(ReadByte())) {
+                case ValueTag::None:
+                    return {};
+                case ValueTag::Number:
+                    return ObjectHolder::Own(runtime::Number(ReadInt()));
+                case ValueTag::String:
+                    return ObjectHolder::Own(runtime::String(ReadString()));
+                case ValueTag::Bool:
+                    return ObjectHolder::Own(runtime::Bool(ReadVarint() != 0));
+                case ValueTag::Class: {
+                    const uint64_t index = ReadVarint();
+                    ClassAt(index);
+                    return classes_[index];
+                }
+                case ValueTag::Instance:
+                    return ObjectAt<runtime::ClassInstance>(ReadVarint());
+                case ValueTag::List:
+                    return ObjectAt<runtime::List>(ReadVarint());
+                case ValueTag::Dict:
+                    return ObjectAt<runtime::Dict>(ReadVarint());
+                }
+                throw SerializeError("Unknown value tag"s);
+            }
+
+            uint8_t ReadByte() {
+                if (pos_ >= data_.size()) {
+                    throw SerializeError("Unexpected end of serialized program"s);
+                }
+                return static_cast<uint8_t>(data_[pos_++]);
+            }
+
+            uint64_t ReadVarint() {
+                uint64_t result = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    const uint8_t byte = ReadByte();
+                    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0) {
+                        return result;
+                    }
+                }
+                throw SerializeError("Malformed varint"s);
+            }
+
+            // Читает количество элементов, которое не может превышать объём оставшихся данных
+            size_t ReadCount() {
+                const uint64_t count = ReadVarint();
+                if (count > data_.size() - pos_) {
+                    throw SerializeError("Corrupted serialized program"s);
+                }
+                return static_cast<size_t>(count);
+            }
+
+            int ReadInt() {
+                const uint64_t v = ReadVarint();
+                return static_cast<int>(static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1));
+            }
+
+            string ReadString() {
+                const uint64_t index = ReadVarint();
+                if (index >= strings_.size()) {
+                    throw SerializeError("Corrupted string reference"s);
+                }
+                return string(strings_[index]);
+            }
+
+            vector<string> ReadStrings() {
+                vector<string> result(ReadCount());
+                for (string& str : result) {
+                    str = ReadString();
+                }
+                return result;
+            }
+
+            vector<unique_ptr<Statement>> ReadNodes() {
+                vector<unique_ptr<Statement>> result(ReadCount());
+                for (auto& node : result) {
+                    node = ReadNode();
+                }
+                return result;
+            }
+
+            // Читает обязательный узел
+            unique_ptr<Statement> ReadChild() {
+                auto node = ReadNode();
+                if (!node) {
+                    throw SerializeError("Corrupted serialized program: missing statement"s);
+                }
+                return node;
+            }
+
+            ObjectHolder ReadClass() {
+                // Номер класса занимается до чтения методов: в их телах могут объявляться другие классы
+                const size_t index = classes_.size();
+                classes_.emplace_back();
+
+                string name = ReadString();
+                const runtime::Class* parent = nullptr;
+                if (const uint64_t parent_index = ReadVarint(); parent_index != 0) {
+                    parent = &ClassAt(parent_index - 1);
+                }
+
+                vector<runtime::Method> methods(ReadCount());
+                for (runtime::Method& method : methods) {
+                    method.name = ReadString();
+                    method.formal_params = ReadStrings();
+                    method.body = ReadChild();
+                }
+
+                classes_[index] = ObjectHolder::Own(runtime::Class(std::move(name), std::move(methods), parent));
+                return classes_[index];
+            }
+
+            const runtime::Class& ClassAt(uint64_t index) const {
+                if (index >= classes_.size() || !classes_[index]) {
+                    throw SerializeError("Corrupted class reference"s);
+                }
+                return *classes_[index].TryAs<runtime::Class>();
+            }
+
+            template <typename T>
+            unique_ptr<Statement> ReadBinary() {
+                auto lhs = ReadChild();
+                auto rhs = ReadChild();
+                return make_unique<T>(std::move(lhs), std::move(rhs));
+            }
+
+            unique_ptr<Statement> ReadNode() {
+                switch (static_cast<NodeTag>(ReadByte())) {
+                case NodeTag::Null:
+                    return nullptr;
+                case NodeTag::NumericConst:
+                    return make_unique<NumericConst>(ReadInt());
+                case NodeTag::StringConst:
+                    return make_unique<StringConst>(ReadString());
+                case NodeTag::BoolConst:
+                    return make_unique<BoolConst>(runtime::Bool(ReadVarint() != 0));
+                case NodeTag::None:
+                    return make_unique<None>();
+                case NodeTag::VariableValue:
+                    return make_unique<VariableValue>(ReadStrings());
+                case NodeTag::Assignment: {
+                    string var = ReadString();
+                    return make_unique<Assignment>(std::move(var), ReadChild());
+                }
+                case NodeTag::FieldAssignment: {
+                    VariableValue object(ReadStrings());
+                    string field_name = ReadString();
+                    return make_unique<FieldAssignment>(std::move(object), std::move(field_name), ReadChild());
+                }
+                case NodeTag::Print:
+                    return make_unique<Print>(ReadNodes());
+                case NodeTag::MethodCall: {
+                    auto object = ReadChild();
+                    string method = ReadString();
+                    return make_unique<MethodCall>(std::move(object), std::move(method), ReadNodes());
+                }
+                case NodeTag::NewInstance: {
+                    const runtime::Class& cls = ClassAt(ReadVarint());
+                    return make_unique<NewInstance>(cls, ReadNodes());
+                }
+                case NodeTag::NewChannel:
+                    return make_unique<NewChannel>();
+                case NodeTag::Spawn: {
+                    auto object = ReadChild();
+                    string method = ReadString();
+                    return make_unique<Spawn>(std::move(object), std::move(method), ReadNodes());
+                }
+                case NodeTag::StartTask: {
+                    auto object = ReadChild();
+                    string method = ReadString();
+                    return make_unique<StartTask>(std::move(object), std::move(method), ReadNodes());
+                }
+                case NodeTag::Yield:
+                    return make_unique<Yield>();
+                case NodeTag::Stringify:
+                    return make_unique<Stringify>(ReadChild());
+                case NodeTag::Add:
+                    return ReadBinary<Add>();
+                case NodeTag::Sub:
+                    return ReadBinary<Sub>();
+                case NodeTag::Mult:
+                    return ReadBinary<Mult>();
+                case NodeTag::Div:
+                    return ReadBinary<Div>();
+                case NodeTag::Or:
+                    return ReadBinary<Or>();
+                case NodeTag::And:
+                    return ReadBinary<And>();
+                case NodeTag::Not:
+                    return make_unique<Not>(ReadChild());
+                case NodeTag::Comparison: {
+                    auto lhs = ReadChild();
+                    auto rhs = ReadChild();
+                    const uint64_t index = ReadVarint();
+                    if (index >= size(COMPARATORS)) {
+                        throw SerializeError("Corrupted comparator"s);
+                    }
+                    return make_unique<Comparison>(COMPARATORS[index], std::move(lhs), std::move(rhs));
+                }
+                case NodeTag::Compound: {
+                    auto compound = make_unique<Compound>();
+                    for (auto& statement : ReadNodes()) {
+                        compound->AddStatement(std::move(statement));
+                    }
+                    return compound;
+                }
+                case NodeTag::MethodBody:
+                    return make_unique<MethodBody>(ReadChild());
+                case NodeTag::Return:
+                    return make_unique<Return>(ReadChild());
+                case NodeTag::ClassDefinition:
+                    return make_unique<ClassDefinition>(ReadClass());
+                case NodeTag::IfElse: {
+                    auto condition = ReadChild();
+                    auto if_body = ReadChild();
+                    return make_unique<IfElse>(std::move(condition), std::move(if_body), ReadNode());
+                }
+                case NodeTag::While: {
+                    auto condition = ReadChild();
+                    return make_unique<While>(std::move(condition), ReadChild());
+                }
+                case NodeTag::Break:
+                    return make_unique<Break>();
+                case NodeTag::Continue:
+                    return make_unique<Continue>();
+                case NodeTag::For: {
+                    string var = ReadString();
+                    auto iterable = ReadChild();
+                    return make_unique<For>(std::move(var), std::move(iterable), ReadChild());
+                }
+                case NodeTag::NewList:
+                    return make_unique<NewList>(ReadNodes());
+                case NodeTag::NewDict: {
+                    NewDict::Items items(ReadCount());
+                    for (auto& [key, value] : items) {
+                        key = ReadChild();
+                        value = ReadChild();
+                    }
+                    return make_unique<NewDict>(std::move(items));
+                }
+                case NodeTag::ListFunction: {
+                    const uint64_t kind = ReadVarint();
+                    if (kind > static_cast<uint64_t>(ListFunction::Kind::Mul)) {
+                        throw SerializeError("Corrupted list function"s);
+                    }
+                    auto args = ReadNodes();
+                    if (args.size() != ListFunction::GetArity(static_cast<ListFunction::Kind>(kind))) {
+                        throw SerializeError("Corrupted list function arguments"s);
+                    }
+                    return make_unique<ListFunction>(static_cast<ListFunction::Kind>(kind), std::move(args));
+                }
+                case NodeTag::FormatString: {
+                    vector<string> literals = ReadStrings();
+                    auto values = ReadNodes();
+                    if (literals.size() != values.size() + 1) {
+                        throw SerializeError("Corrupted format string"s);
+                    }
+                    return make_unique<FormatString>(std::move(literals), std::move(values));
+                }
+                case NodeTag::Index:
+                    return ReadBinary<Index>();
+                case NodeTag::IndexAssignment: {
+                    auto object = ReadChild();
+                    auto index = ReadChild();
+                    return make_unique<IndexAssignment>(std::move(object), std::move(index), ReadChild());
+                }
+                case NodeTag::Length:
+                    return make_unique<Length>(ReadChild());
+                }
+                throw SerializeError("Unknown statement tag"s);
+            }
+
+            string_view data_;
+            size_t pos_ = 0;
+            vector<string_view> strings_;
+            vector<ObjectHolder> classes_;
+            vector<ObjectHolder> objects_;
+        };
+    }  // namespace
+
+    string SerializeProgram(const runtime::Executable& program) {
+        return ProgramWriter().Write(program);
+    }
+
+    unique_ptr<runtime::Executable> DeserializeProgram(string_view data) {
+        return ProgramReader(data).Read();
+    }
+
+    string SerializeSnapshot(const runtime::Executable& program, const runtime::Closure& globals) {
+        return ProgramWriter().WriteSnapshot(program, globals);
+    }
+
+    Snapshot DeserializeSnapshot(string_view data) {
+        return ProgramReader(data).ReadSnapshot();
+    }
+
+}  // namespace ast
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "statement.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ast {
+
+    // Ошибка сериализации дерева программы либо повреждённые данные при загрузке
+    struct SerializeError : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    /*
+     * Сериализует дерево программы, построенное ParseProgram, в компактный двоичный формат.
+     * Формат: заголовок с версией, таблица строк (все идентификаторы и строковые константы без повторов),
+     * затем узлы дерева в прямом порядке обхода. Числа записываются в формате varint.
+     * Классы сохраняются вместе с методами в том месте, где их объявляет ClassDefinition,
+     * NewInstance ссылается на класс по его порядковому номеру. Отложенные тела методов (LazyMethodBody)
+     * разбираются и сохраняются как обычные.
+     * Если в дереве встречается узел, не порождаемый парсером, выбрасывает SerializeError
+     */
+    std::string SerializeProgram(const runtime::Executable& program);
+
+    // Восстанавливает дерево программы из данных, полученных SerializeProgram.
+    // Данные разбираются за один линейный проход. При повреждённых данных выбрасывает SerializeError
+    std::unique_ptr<runtime::Executable> DeserializeProgram(std::string_view data);
+
+    // Состояние интерпретатора, восстановленное из снимка
+    struct Snapshot {
+        // Все классы снимка в порядке объявления, включая объявленные внутри методов
+        std::vector<runtime::ObjectHolder> classes;
+        // Глобальные переменные
+        runtime::Closure globals;
+    };
+
+    /*
+     * Сохраняет состояние интерпретатора после выполнения программы program: глобальные переменные globals,
+     * классы, объявленные в program, и все объекты, достижимые из globals, включая списки в их представлении
+     * (см. runtime::List) и словари с порядком пар. Общие объекты и циклические ссылки между объектами сохраняются. Сами инструкции программы, кроме объявлений классов, не сохраняются.
+     * Если globals содержит объект, который нельзя сохранить, или класс, не объявленный в program,
+     * выбрасывает SerializeError
+     */
+    std::string SerializeSnapshot(const runtime::Executable& program, const runtime::Closure& globals);
+
+    // Восстанавливает состояние, сохранённое SerializeSnapshot. При повреждённых данных выбрасывает SerializeError
+    Snapshot DeserializeSnapshot(std::string_view data);
+
+}  // namespace ast
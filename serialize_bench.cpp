@@ -0,0 +1,52 @@
+#include "bench_runner.h"
+#include "lexer.h"
+#include "parse.h"
+#include "serialize.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+
+// Большой сгенерированный скрипт из множества классов
+const string& LargeProgram() {
+    static const string program = [] {
+        string result;
+        for (int i = 0; i < 2000; ++i) {
+            const string n = to_string(i);
+            result += "class C"s + n + ":\n  def __init__(v):\n    self.v = v\n"s
+                + "  def get(k):\n    if self.v > k and k != 0:\n      return self.v * 2 + k\n"s
+                + "    return 'value ' + str(self.v)\n"s;
+        }
+        return result;
+    }();
+    return program;
+}
+
+void BenchParseProgram() {
+    istringstream input(LargeProgram());
+    parse::Lexer lexer(input);
+    DoNotOptimize(ParseProgram(lexer));
+}
+
+void BenchDeserializeProgram() {
+    static const string data = [] {
+        istringstream input(LargeProgram());
+        parse::Lexer lexer(input);
+        return SerializeProgram(*ParseProgram(lexer));
+    }();
+    DoNotOptimize(DeserializeProgram(data));
+}
+
+}  // namespace
+
+void RunSerializeBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, ast::BenchParseProgram);
+    RUN_BENCH(br, ast::BenchDeserializeProgram);
+}
+
+}  // namespace ast
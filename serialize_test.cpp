@@ -0,0 +1,357 @@
+#include "dict.h"
+#include "lexer.h"
+#include "list.h"
+#include "parse.h"
+#include "program_cache.h"
+#include "serialize.h"
+#include "mapped_file.h"
+#include "test_runner.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+
+const string PROGRAM = R"--(
+class Shape:
+  def __str__():
+    return "Shape"
+  def area():
+    return 'Not implemented'
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.w = w
+    self.h = h
+  def __str__():
+    return "Rect(" + str(self.w) + 'x' + str(self.h) + ')'
+  def area():
+    return self.w * self.h
+
+class Factory:
+  def make(n):
+    class Local:
+      def __init__(v):
+        self.v = v
+      def __str__():
+        return "Local " + str(self.v)
+    return Local(n)
+
+class Counter:
+  def __init__():
+    self.value = 0
+  def add(n):
+    if n <= 0 or n == 100:
+      return None
+    else:
+      self.value = self.value + n / 2 - -1
+    return self.value
+  def count_odd(n):
+    i = 0
+    result = 0
+    while True:
+      i = i + 1
+      if i > n:
+        break
+      if i / 2 * 2 == i:
+        continue
+      result = result + 1
+    return result
+
+r = Rect(10, 5)
+c = Counter()
+c.add(6)
+f = Factory()
+x = f.make(-7)
+print r, r.area(), Shape(), c.value, x, str(None), not True
+print 1 < 2, 1 > 2, 1 != 2, 3 >= 3, "a" == "a", True and False, None
+print c.count_odd(9)
+items = [c.count_odd(9), 'x']
+items[1] = len(items)
+for item in items:
+  print item, items[0]
+ages = {'ann': 31, 'bob': items[0]}
+ages['cid'] = 7
+print ages, 'bob' in ages, 'eve' not in ages
+print sum(items), min(items), max(items), dot(items, items), add(items, items), mul(items, items), items.count(2)
+print f"{r} has {len(items)} items, {{ok}}"
+)--"s;
+
+const string EXPECTED_OUTPUT = "Rect(10x5) 50 Shape 4 Local -7 None False\nTrue False True True True False None\n5\n5 5\n2 5\n{ann: 31, bob: 5, cid: 7} True True\n7 2 5 29 [10, 4] [25, 4] 1\nRect(10x5) has 2 items, {ok}\n"s;
+
+unique_ptr<runtime::Executable> Parse(const string& program) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    return ParseProgram(lexer);
+}
+
+string Run(runtime::Executable& program) {
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    program.Execute(closure, context);
+    return context.output.str();
+}
+
+void TestRoundTrip() {
+    auto program = Parse(PROGRAM);
+    ASSERT_EQUAL(Run(*program), EXPECTED_OUTPUT);
+
+    const string data = SerializeProgram(*program);
+    auto restored = DeserializeProgram(data);
+    ASSERT_EQUAL(Run(*restored), EXPECTED_OUTPUT);
+
+    // Повторная сериализация восстановленного дерева даёт те же байты
+    ASSERT_EQUAL(SerializeProgram(*restored), data);
+
+    // Отложенные тела методов сохраняются так же, как разобранные сразу
+    ParseOptions options;
+    options.lazy_methods = true;
+    ASSERT_EQUAL(SerializeProgram(*ParseProgram(PROGRAM, options)), data);
+}
+
+void TestCorruptedDataIsRejected() {
+    const string data = SerializeProgram(*Parse(PROGRAM));
+
+    ASSERT_THROWS(DeserializeProgram(""sv), SerializeError);
+    ASSERT_THROWS(DeserializeProgram("garbage"sv), SerializeError);
+    ASSERT_THROWS(DeserializeProgram(string_view(data).substr(0, data.size() / 2)), SerializeError);
+    ASSERT_THROWS(DeserializeProgram(data + "x"s), SerializeError);
+}
+
+void TestUnsupportedNode() {
+    class Custom : public runtime::Executable {
+    public:
+        runtime::ObjectHolder Execute(runtime::Closure& /*closure*/, runtime::Context& /*context*/) override {
+            return {};
+        }
+    };
+    ASSERT_THROWS(SerializeProgram(Custom()), SerializeError);
+}
+
+void TestProgramCache() {
+    char dir_template[] = "/tmp/mython_cache_XXXXXX";
+    ASSERT(mkdtemp(dir_template) != nullptr);
+    const string dir = dir_template + "/nested"s;
+
+    ProgramCache cache(dir);
+    const string entry = cache.EntryPath(PROGRAM);
+    ASSERT(access(entry.c_str(), R_OK) != 0);
+
+    ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), EXPECTED_OUTPUT);
+    ASSERT(access(entry.c_str(), R_OK) == 0);
+    ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), EXPECTED_OUTPUT);
+
+    // Повреждённая запись заменяется результатом нового разбора
+    FILE* file = fopen(entry.c_str(), "w");
+    fputs("broken", file);
+    fclose(file);
+    ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), EXPECTED_OUTPUT);
+    ASSERT(parse::MappedFile(entry).Data() != "broken"sv);
+
+    // Запись другой программы по тому же пути, как при совпадении хешей, не подменяет программу
+    const string other = cache.EntryPath("print 1\n"sv);
+    ASSERT(other != entry);
+    ASSERT_EQUAL(Run(*cache.Load("print 1\n"sv)), "1\n"s);
+    ASSERT(rename(other.c_str(), entry.c_str()) == 0);
+    ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), EXPECTED_OUTPUT);
+    ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), EXPECTED_OUTPUT);
+
+    remove(entry.c_str());
+    rmdir(dir.c_str());
+    rmdir(dir_template);
+}
+
+void TestSnapshot() {
+    const auto prelude = Parse(R"--(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+  def __str__():
+    return '(' + str(self.x) + ', ' + str(self.y) + ')'
+
+class Node:
+  def __init__(value):
+    self.value = value
+    self.next = None
+  def make():
+    class Local:
+      def __str__():
+        return 'Local'
+    return Local()
+
+origin = Point(0, -3)
+a = Node('a')
+b = Node(True)
+a.next = b
+b.next = a
+alias = origin
+local = a.make()
+kind = Point
+nothing = None
+)--"s);
+    runtime::DummyContext context;
+    runtime::Closure globals;
+    prelude->Execute(globals, context);
+
+    Snapshot snapshot = DeserializeSnapshot(SerializeSnapshot(*prelude, globals));
+    ASSERT_EQUAL(snapshot.classes.size(), 3U);
+    ASSERT_EQUAL(snapshot.globals.size(), globals.size());
+
+    auto& restored = snapshot.globals;
+    ASSERT(restored.at("origin"s).Get() == restored.at("alias"s).Get());
+    ASSERT(restored.at("kind"s).Get() == snapshot.classes.front().Get());
+    ASSERT(!restored.at("nothing"s));
+
+    auto* a = restored.at("a"s).TryAs<runtime::ClassInstance>();
+    auto* b = restored.at("b"s).TryAs<runtime::ClassInstance>();
+    ASSERT(a->Fields().at("next"s).Get() == b);
+    ASSERT(b->Fields().at("next"s).Get() == a);
+    ASSERT_EQUAL(a->Fields().at("value"s).TryAs<runtime::String>()->GetValue(), "a"s);
+    ASSERT(b->Fields().at("value"s).TryAs<runtime::Bool>()->GetValue());
+
+    ostringstream out;
+    restored.at("origin"s)->Print(out, context);
+    out << ' ';
+    restored.at("local"s)->Print(out, context);
+    ASSERT_EQUAL(out.str(), "(0, -3) Local"s);
+
+    // Циклы разрываются, чтобы освободить объекты
+    a->Fields().clear();
+    globals.at("a"s).TryAs<runtime::ClassInstance>()->Fields().clear();
+}
+
+// Списки сохраняются в своём представлении, ссылки из списков и на списки - вместе с общими объектами
+void TestSnapshotLists() {
+    const auto prelude = Parse(R"--(
+class Box:
+  def __init__(items):
+    self.items = items
+
+numbers = [1, -2, 3]
+flags = [True, False, True]
+general = [1, 2]
+general[0] = 'x'
+general[0] = 5
+mixed = [1, 'two', None]
+box = Box(mixed)
+mixed.append(box)
+mixed.append(numbers)
+empty = []
+)--"s);
+    runtime::DummyContext context;
+    runtime::Closure globals;
+    prelude->Execute(globals, context);
+
+    Snapshot snapshot = DeserializeSnapshot(SerializeSnapshot(*prelude, globals));
+    auto& restored = snapshot.globals;
+    const auto list = [&restored](const string& name) {
+        return restored.at(name).TryAs<runtime::List>();
+    };
+    ASSERT(list("numbers"s)->GetStorage() == runtime::List::Storage::Numbers);
+    ASSERT(list("flags"s)->GetStorage() == runtime::List::Storage::Bools);
+    // Список, ставший общим, не упаковывается обратно, даже если в нём остались одни числа
+    ASSERT(list("general"s)->GetStorage() == runtime::List::Storage::Objects);
+    ASSERT(list("mixed"s)->GetStorage() == runtime::List::Storage::Objects);
+    ASSERT_EQUAL(list("empty"s)->GetSize(), 0U);
+
+    auto* box = restored.at("box"s).TryAs<runtime::ClassInstance>();
+    ASSERT(box->Fields().at("items"s).Get() == list("mixed"s));
+    ASSERT(list("mixed"s)->Get(3).Get() == box);
+    ASSERT(list("mixed"s)->Get(4).Get() == list("numbers"s));
+
+    ostringstream out;
+    for (const string& name : {"numbers"s, "flags"s, "general"s}) {
+        restored.at(name)->Print(out, context);
+        out << ' ';
+    }
+    ASSERT_EQUAL(out.str(), "[1, -2, 3] [True, False, True] [5, 2] "s);
+
+    // Циклы разрываются, чтобы освободить объекты
+    box->Fields().clear();
+    globals.at("box"s).TryAs<runtime::ClassInstance>()->Fields().clear();
+}
+
+void TestSnapshotDicts() {
+    const auto prelude = Parse(R"--(
+class Key:
+  def __init__(name):
+    self.name = name
+
+class Node:
+  def __init__(table):
+    self.table = table
+
+key = Key('k')
+ages = {'bob': 30, 'ann': 25}
+ages['cid'] = 41
+table = {2: 'two', None: 'none', True: 'yes'}
+table[key] = ages
+node = Node(table)
+table['self'] = node
+empty = {}
+)--"s);
+    runtime::DummyContext context;
+    runtime::Closure globals;
+    prelude->Execute(globals, context);
+
+    Snapshot snapshot = DeserializeSnapshot(SerializeSnapshot(*prelude, globals));
+    auto& restored = snapshot.globals;
+    auto* table = restored.at("table"s).TryAs<runtime::Dict>();
+    auto* node = restored.at("node"s).TryAs<runtime::ClassInstance>();
+    ASSERT_EQUAL(table->GetSize(), 5U);
+    ASSERT(node->Fields().at("table"s).Get() == table);
+    ASSERT(table->At(restored.at("key"s), context).Get() == restored.at("ages"s).Get());
+    ASSERT(table->At(runtime::ObjectHolder::Own(runtime::String("self"s)), context).Get() == node);
+    ASSERT_EQUAL(restored.at("empty"s).TryAs<runtime::Dict>()->GetSize(), 0U);
+
+    // Пары сохраняют порядок добавления, ключи находятся по сохранённым хешам
+    ostringstream out;
+    restored.at("ages"s)->Print(out, context);
+    ASSERT_EQUAL(out.str(), "{bob: 30, ann: 25, cid: 41}"s);
+    const auto* ages = restored.at("ages"s).TryAs<runtime::Dict>();
+    const runtime::ObjectHolder ann = runtime::ObjectHolder::Own(runtime::String("ann"s));
+    ASSERT_EQUAL(ages->At(ann, context).TryAs<runtime::Number>()->GetValue(), 25);
+    ASSERT(table->Find(runtime::ObjectHolder::None(), context) != nullptr);
+    ASSERT(table->Find(runtime::ObjectHolder::Own(runtime::Bool(true)), context) != nullptr);
+
+    // Циклы разрываются, чтобы освободить объекты
+    node->Fields().clear();
+    globals.at("node"s).TryAs<runtime::ClassInstance>()->Fields().clear();
+}
+
+void TestSnapshotErrors() {
+    const auto program = Parse("class A:\n  def f():\n    return 1\nx = A()\n"s);
+    runtime::DummyContext context;
+    runtime::Closure globals;
+    program->Execute(globals, context);
+
+    // Класс, не объявленный в сохраняемой программе
+    ASSERT_THROWS(SerializeSnapshot(*Parse("print 1\n"s), globals), SerializeError);
+
+    const string data = SerializeSnapshot(*program, globals);
+    ASSERT_THROWS(DeserializeSnapshot(SerializeProgram(*program)), SerializeError);
+    ASSERT_THROWS(DeserializeSnapshot(string_view(data).substr(0, data.size() - 1)), SerializeError);
+    ASSERT_THROWS(DeserializeSnapshot(data + "x"s), SerializeError);
+}
+
+}  // namespace
+
+void RunSerializeTests(TestRunner& tr) {
+    RUN_TEST(tr, ast::TestRoundTrip);
+    RUN_TEST(tr, ast::TestCorruptedDataIsRejected);
+    RUN_TEST(tr, ast::TestUnsupportedNode);
+    RUN_TEST(tr, ast::TestProgramCache);
+    RUN_TEST(tr, ast::TestSnapshot);
+    RUN_TEST(tr, ast::TestSnapshotLists);
+    RUN_TEST(tr, ast::TestSnapshotDicts);
+    RUN_TEST(tr, ast::TestSnapshotErrors);
+}
+
+}  // namespace ast
@@ -0,0 +1,313 @@
+#include "server.h"
+
+#include "output_context.h"
+#include "server_protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace server {
+
+    namespace {
+        // Размер вывода, после накопления которого он отправляется клиенту
+        constexpr size_t OUTPUT_CHUNK_SIZE = 4096;
+        // Период, с которым простаивающее соединение проверяет, не остановлен ли сервер
+        constexpr int IDLE_POLL_MS = 100;
+        // Пауза перед следующим accept после ошибки, которая не проходит сразу, например нехватки дескрипторов
+        constexpr chrono::milliseconds ACCEPT_BACKOFF{50};
+
+        // Контекст, отправляющий вывод программы клиенту кадрами OUTPUT
+        class FrameContext : public runtime::Context {
+        public:
+            explicit FrameContext(int fd)
+                : fd_(fd) {
+            }
+
+            ostream& GetOutputStream() override {
+                return stream_;
+            }
+
+            void Write(string_view data) override {
+                buffer_.append(data);
+                if (buffer_.size() >= OUTPUT_CHUNK_SIZE) {
+                    Flush();
+                }
+            }
+
+            void Flush() override {
+                if (!buffer_.empty()) {
+                    WriteFrame(fd_, FrameType::Output, buffer_);
+                    buffer_.clear();
+                }
+            }
+
+        private:
+            int fd_;
+            string buffer_;
+            runtime::ContextStreamBuf stream_buf_{*this};
+            ostream stream_{&stream_buf_};
+        };
+
+        // Закрывает дескриптор при выходе из области видимости
+        class FdGuard {
+        public:
+            explicit FdGuard(int fd)
+                : fd_(fd) {
+            }
+
+            FdGuard(const FdGuard&) = delete;
+            FdGuard& operator=(const FdGuard&) = delete;
+
+            ~FdGuard() {
+                ::close(fd_);
+            }
+
+        private:
+            int fd_;
+        };
+
+        sockaddr_un MakeAddress(const string& path) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path)) {
+                throw invalid_argument("Socket path is too long: "s + path);
+            }
+            memcpy(address.sun_path, path.data(), path.size());
+            return address;
+        }
+    }  // namespace
+
+    Server::Server(ServerOptions options)
+        : options_(std::move(options)) {
+        if (options_.threads == 0) {
+            options_.threads = max(thread::hardware_concurrency(), 1U);
+        }
+        const sockaddr_un address = MakeAddress(options_.socket_path);
+
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            throw system_error(errno, generic_category(), "socket"s);
+        }
+        ::unlink(options_.socket_path.c_str());
+        if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+            || ::listen(listen_fd_, SOMAXCONN) != 0) {
+            const int error = errno;
+            ::close(listen_fd_);
+            throw system_error(error, generic_category(), "Can not listen on "s + options_.socket_path);
+        }
+    }
+
+    Server::~Server() {
+        Stop();
+        ::close(listen_fd_);
+        ::unlink(options_.socket_path.c_str());
+    }
+
+    void Server::Run() {
+        vector<thread> workers;
+        workers.reserve(options_.threads - 1);
+        for (size_t i = 1; i < options_.threads; ++i) {
+            workers.emplace_back([this] { WorkerLoop(); });
+        }
+        WorkerLoop();
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void Server::Stop() noexcept {
+        stopping_.store(true);
+        stop_limits_.Interrupt();
+        // Будит потоки, ожидающие в accept
+        ::shutdown(listen_fd_, SHUT_RDWR);
+    }
+
+    const string& Server::GetSocketPath() const {
+        return options_.socket_path;
+    }
+
+    ServerStats Server::GetStats() const {
+        ServerStats stats;
+        stats.requests = requests_.load();
+        stats.failed = failed_.load();
+        stats.cache_hits = cache_hits_.load();
+        return stats;
+    }
+
+    void Server::WorkerLoop() {
+        while (!stopping_.load()) {
+            const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                // Без паузы нехватка дескрипторов или памяти заставила бы потоки крутиться вхолостую
+                if (errno != EINTR && errno != ECONNABORTED) {
+                    this_thread::sleep_for(ACCEPT_BACKOFF);
+                }
+                continue;
+            }
+            FdGuard guard(fd);
+            // Клиент, не принимающий ответ, не должен держать поток в send
+            const auto io_timeout = chrono::duration_cast<chrono::microseconds>(options_.io_timeout).count();
+            const timeval send_timeout{static_cast<time_t>(io_timeout / 1000000),
+                                       static_cast<suseconds_t>(io_timeout % 1000000)};
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+            try {
+                HandleConnection(fd);
+            } catch (const exception&) {
+                // Сбой протокола или обрыв соединения касается только этого клиента
+            }
+        }
+    }
+
+    void Server::HandleConnection(int fd) {
+        // Соединение может передать несколько запросов подряд, но между ними не держит поток дольше idle_timeout
+        const auto idle_deadline = [this] {
+            return chrono::steady_clock::now() + options_.idle_timeout;
+        };
+        auto deadline = idle_deadline();
+        while (!stopping_.load()) {
+            int wait_ms = IDLE_POLL_MS;
+            if (options_.idle_timeout.count() != 0) {
+                const auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+                if (left.count() <= 0) {
+                    return;
+                }
+                wait_ms = static_cast<int>(min<chrono::milliseconds::rep>(left.count(), IDLE_POLL_MS));
+            }
+            pollfd waiting{fd, POLLIN, 0};
+            const int ready = ::poll(&waiting, 1, wait_ms);
+            if (ready < 0 && errno != EINTR) {
+                throw system_error(errno, generic_category(), "poll"s);
+            }
+            if (ready > 0) {
+                if (!HandleRequest(fd)) {
+                    return;
+                }
+                deadline = idle_deadline();
+            }
+        }
+    }
+
+    bool Server::HandleRequest(int fd) {
+        // Клиент, приславший часть запроса, не должен держать поток после истечения io_timeout и остановки сервера
+        ReadLimits read_limits;
+        if (options_.io_timeout.count() != 0) {
+            read_limits.deadline = chrono::steady_clock::now() + options_.io_timeout;
+        }
+        read_limits.stop = &stopping_;
+        Frame program_frame;
+        if (!ReadFrame(fd, program_frame, read_limits)) {
+            return false;
+        }
+        Frame input_frame;
+        if (!ReadFrame(fd, input_frame, read_limits) || input_frame.type != FrameType::Input) {
+            throw ProtocolError("Request has no input frame"s);
+        }
+        requests_.fetch_add(1);
+
+        FrameContext context(fd);
+        try {
+            string key;
+            shared_ptr<const CompiledProgram> program;
+            if (program_frame.type == FrameType::Source) {
+                key = ProgramKey(program_frame.data);
+                program = FindProgram(key, &program_frame.data);
+                if (!program) {
+                    StoredProgram stored = AddProgram(key, std::move(program_frame.data));
+                    program = std::move(stored.program);
+                    if (!stored.cached) {
+                        // По ключу программу не выполнить, поэтому клиент его не получает
+                        key.clear();
+                    }
+                }
+            }
+            else if (program_frame.type == FrameType::Key) {
+                key = std::move(program_frame.data);
+                program = FindProgram(key);
+                if (!program) {
+                    throw runtime_error("Unknown program key "s + key);
+                }
+            }
+            else {
+                throw ProtocolError("Request has no program frame"s);
+            }
+
+            runtime::MemoryBudget budget(options_.memory_limit);
+            runtime::ExecutionLimits limits;
+            limits.SetParent(&stop_limits_);
+            limits.SetStepLimit(options_.max_steps);
+            if (options_.timeout.count() != 0) {
+                limits.SetTimeout(options_.timeout);
+            }
+            RunOptions run;
+            run.memory_budget = options_.memory_limit != 0 ? &budget : nullptr;
+            run.limits = &limits;
+
+            runtime::Closure globals;
+            globals["input"s] = runtime::ObjectHolder::Own(runtime::String(std::move(input_frame.data)));
+            program->Run(globals, context, run);
+            WriteFrame(fd, FrameType::Done, key);
+            return true;
+        } catch (const ProtocolError&) {
+            throw;
+        } catch (const system_error&) {
+            // Клиент больше не принимает ответ
+            throw;
+        } catch (const exception& e) {
+            failed_.fetch_add(1);
+            context.Flush();
+            WriteFrame(fd, FrameType::Error, e.what());
+            return true;
+        }
+    }
+
+    shared_ptr<const CompiledProgram> Server::FindProgram(const string& key, const string* source) {
+        lock_guard guard(cache_lock_);
+        const auto it = cache_.find(key);
+        if (it == cache_.end() || (source != nullptr && it->second.program->GetSource() != *source)) {
+            return nullptr;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+        cache_hits_.fetch_add(1);
+        return it->second.program;
+    }
+
+    Server::StoredProgram Server::AddProgram(const string& key, string source) {
+        RunOptions options;
+        options.lazy_methods = options_.lazy_methods;
+        // Разбор идёт без блокировки: одну программу могут одновременно разобрать несколько потоков
+        auto program = make_shared<const CompiledProgram>(std::move(source), options);
+
+        lock_guard guard(cache_lock_);
+        if (const auto it = cache_.find(key); it != cache_.end()) {
+            if (it->second.program->GetSource() == program->GetSource()) {
+                return {it->second.program, true};
+            }
+            // Совпадение хешей: программу можно выполнить, но не сохранить
+            return {std::move(program), false};
+        }
+        if (options_.cache_capacity == 0) {
+            return {std::move(program), false};
+        }
+        while (cache_.size() >= options_.cache_capacity) {
+            cache_.erase(lru_.back());
+            lru_.pop_back();
+        }
+        lru_.push_front(key);
+        cache_.emplace(key, CacheEntry{program, lru_.begin()});
+        return {std::move(program), true};
+    }
+
+}  // namespace server
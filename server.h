@@ -0,0 +1,119 @@
+#pragma once
+
+#include "interpreter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace server {
+
+    // Параметры сервера интерпретатора
+    struct ServerOptions {
+        // Путь к локальному сокету. Существующий файл сокета заменяется
+        std::string socket_path;
+        // Число рабочих потоков. 0 - по числу ядер
+        size_t threads = 0;
+        // Наибольшее число разобранных программ, которые сервер хранит для запросов по ключу
+        size_t cache_capacity = 256;
+        // Разбирать тела методов при первом вызове (см. ParseOptions::lazy_methods)
+        bool lazy_methods = false;
+        // Ограничения каждого запроса: память объектов в байтах, шаги и время выполнения. 0 - без ограничения
+        size_t memory_limit = 0;
+        uint64_t max_steps = 0;
+        std::chrono::milliseconds timeout{0};
+        // Время, за которое клиент должен передать запрос целиком после его первого байта и принять
+        // очередной кадр ответа. Иначе соединение закрывается, чтобы не занимать рабочий поток. 0 - без ограничения
+        std::chrono::milliseconds io_timeout{10000};
+        // Время, в течение которого соединение может ждать следующего запроса. Соединение занимает рабочий
+        // поток, поэтому молчащий клиент отключается по его истечении. 0 - без ограничения
+        std::chrono::milliseconds idle_timeout{5000};
+    };
+
+    // Показатели сервера
+    struct ServerStats {
+        // Число обработанных запросов
+        uint64_t requests = 0;
+        // Число запросов, завершившихся ошибкой
+        uint64_t failed = 0;
+        // Число запросов, программа которых нашлась среди разобранных
+        uint64_t cache_hits = 0;
+    };
+
+    /*
+     * Сервер, выполняющий программы Mython по запросам через локальный сокет (см. server_protocol.h).
+     * Запросы обслуживает пул рабочих потоков, каждый из которых сам принимает соединения. Потоки живут
+     * всё время работы сервера, поэтому их пулы объектов и кучи прогреваются первыми запросами.
+     * Разобранные программы хранятся по ключу исходного кода (не больше cache_capacity, вытесняются давно
+     * не использованные) и выполняются без повторного разбора, в том числе параллельно (см. CompiledProgram).
+     * Вывод команд print отправляется клиенту частями по мере выполнения программы
+     */
+    class Server {
+        // Доступ тестов к кэшу программ
+        friend struct ServerTestAccess;
+
+    public:
+        // Создаёт сокет и начинает принимать соединения. При ошибке выбрасывает std::system_error
+        explicit Server(ServerOptions options);
+        // Останавливает сервер и удаляет файл сокета
+        ~Server();
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        // Обслуживает запросы в рабочих потоках до вызова Stop
+        void Run();
+
+        // Просит сервер остановиться. Выполняющиеся программы прерываются, и клиенты получают ошибку,
+        // а недочитанные запросы отбрасываются. Можно вызывать из любого потока и из обработчика сигнала
+        void Stop() noexcept;
+
+        [[nodiscard]] const std::string& GetSocketPath() const;
+        [[nodiscard]] ServerStats GetStats() const;
+
+    private:
+        struct CacheEntry {
+            std::shared_ptr<const CompiledProgram> program;
+            std::list<std::string>::iterator lru_position;
+        };
+
+        void WorkerLoop();
+        void HandleConnection(int fd);
+        // Выполняет запрос из соединения fd и возвращает true, если программа завершилась без ошибок
+        bool HandleRequest(int fd);
+
+        // Разобранная программа и признак того, что она сохранена по своему ключу
+        struct StoredProgram {
+            std::shared_ptr<const CompiledProgram> program;
+            bool cached = false;
+        };
+
+        // Возвращает разобранную программу по ключу либо nullptr. Если задан source, программа должна
+        // иметь этот исходный код: ключ - лишь хеш, и у разных программ он может совпасть
+        std::shared_ptr<const CompiledProgram> FindProgram(const std::string& key, const std::string* source = nullptr);
+        // Разбирает программу и сохраняет её по ключу key. Если по ключу уже сохранена другая программа
+        // или кэш отключён, новая программа не сохраняется
+        StoredProgram AddProgram(const std::string& key, std::string source);
+
+        ServerOptions options_;
+        int listen_fd_ = -1;
+        std::atomic<bool> stopping_{false};
+        // Общий родитель ограничений всех запросов: Stop прерывает через него выполняющиеся программы
+        runtime::ExecutionLimits stop_limits_;
+
+        std::mutex cache_lock_;
+        std::unordered_map<std::string, CacheEntry> cache_;
+        // Ключи программ от недавно использованной к давно не использованной
+        std::list<std::string> lru_;
+
+        std::atomic<uint64_t> requests_{0};
+        std::atomic<uint64_t> failed_{0};
+        std::atomic<uint64_t> cache_hits_{0};
+    };
+
+}  // namespace server
@@ -0,0 +1,126 @@
+#include "server_protocol.h"
+
+#include "program_cache.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace server {
+
+    namespace {
+        // Дожидается данных в fd в пределах limits
+        void WaitReadable(int fd, const ReadLimits& limits) {
+            using Clock = chrono::steady_clock;
+            while (true) {
+                if (limits.stop != nullptr && limits.stop->load()) {
+                    throw ProtocolError("Server is stopping"s);
+                }
+                const Clock::time_point now = Clock::now();
+                if (now >= limits.deadline) {
+                    throw ProtocolError("Timed out waiting for a frame"s);
+                }
+                auto wait = limits.deadline - now;
+                if (limits.stop != nullptr && wait > STOP_POLL_INTERVAL) {
+                    wait = STOP_POLL_INTERVAL;
+                }
+                // Округление вверх: poll с нулевым ожиданием до крайнего срока крутился бы вхолостую
+                const auto wait_ms = chrono::ceil<chrono::milliseconds>(wait).count();
+                pollfd waiting{fd, POLLIN, 0};
+                const int ready = ::poll(&waiting, 1, wait_ms > INT32_MAX ? -1 : static_cast<int>(wait_ms));
+                if (ready > 0) {
+                    return;
+                }
+                if (ready < 0 && errno != EINTR) {
+                    throw system_error(errno, generic_category(), "poll"s);
+                }
+            }
+        }
+
+        // Читает ровно size байт. Возвращает false, если соединение закрыто до первого байта
+        bool ReadExactly(int fd, char* data, size_t size, const ReadLimits& limits) {
+            const bool bounded = limits.stop != nullptr || limits.deadline != chrono::steady_clock::time_point::max();
+            size_t done = 0;
+            while (done < size) {
+                if (bounded) {
+                    WaitReadable(fd, limits);
+                }
+                const ssize_t count = ::read(fd, data + done, size - done);
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw system_error(errno, generic_category(), "read"s);
+                }
+                if (count == 0) {
+                    if (done == 0) {
+                        return false;
+                    }
+                    throw ProtocolError("Connection closed in the middle of a frame"s);
+                }
+                done += static_cast<size_t>(count);
+            }
+            return true;
+        }
+
+        // Отправляет size байт целиком. Закрытое собеседником соединение даёт EPIPE, а не SIGPIPE
+        void SendAll(int fd, const char* data, size_t size) {
+            while (size > 0) {
+                const ssize_t count = ::send(fd, data, size, MSG_NOSIGNAL);
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw system_error(errno, generic_category(), "send"s);
+                }
+                data += count;
+                size -= static_cast<size_t>(count);
+            }
+        }
+    }  // namespace
+
+    void WriteFrame(int fd, FrameType type, string_view data) {
+        if (data.size() > MAX_FRAME_SIZE) {
+            throw ProtocolError("Frame is too large"s);
+        }
+        char header[1 + sizeof(uint32_t)];
+        header[0] = static_cast<char>(type);
+        const auto size = static_cast<uint32_t>(data.size());
+        memcpy(header + 1, &size, sizeof(size));
+        SendAll(fd, header, sizeof(header));
+        SendAll(fd, data.data(), data.size());
+    }
+
+    bool ReadFrame(int fd, Frame& frame, const ReadLimits& limits) {
+        char header[1 + sizeof(uint32_t)];
+        if (!ReadExactly(fd, header, sizeof(header), limits)) {
+            return false;
+        }
+        uint32_t size = 0;
+        memcpy(&size, header + 1, sizeof(size));
+        if (size > MAX_FRAME_SIZE) {
+            throw ProtocolError("Frame is too large"s);
+        }
+        frame.type = static_cast<FrameType>(header[0]);
+        frame.data.resize(size);
+        if (size != 0 && !ReadExactly(fd, frame.data.data(), size, limits)) {
+            throw ProtocolError("Connection closed in the middle of a frame"s);
+        }
+        return true;
+    }
+
+    string ProgramKey(string_view source) {
+        ostringstream key;
+        key << hex << setw(16) << setfill('0') << ast::HashSource(source) << '-' << dec << source.size();
+        return key.str();
+    }
+
+}  // namespace server
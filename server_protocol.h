@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace server {
+
+    /*
+     * Протокол обмена с сервером интерпретатора (mython --serve) через локальный сокет.
+     * Обе стороны обмениваются кадрами: байт типа, длина данных (uint32 в порядке байт машины) и данные.
+     *
+     * Клиент отправляет один кадр программы и один кадр входных данных:
+     *   SOURCE <исходный код> | KEY <ключ ранее выполненной программы>
+     *   INPUT <входные данные, доступные программе в переменной input>
+     * Сервер отвечает кадрами вывода команд print по мере выполнения программы и одним завершающим кадром:
+     *   OUTPUT <часть вывода> ... DONE <ключ программы> | ERROR <текст ошибки>
+     * Ключ в кадре DONE пуст, если сервер не сохранил программу под её ключом: по ключу уже сохранена
+     * другая программа с тем же хешем или кэш программ отключён. Такую программу клиент отправляет
+     * исходным кодом
+     */
+    enum class FrameType : char {
+        Source = 'S',
+        Key = 'K',
+        Input = 'I',
+        Output = 'O',
+        Done = 'D',
+        Error = 'E',
+    };
+
+    // Наибольший размер данных кадра
+    constexpr uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+    // Ошибка протокола: неожиданный тип кадра, слишком большой кадр или обрыв соединения посреди кадра
+    class ProtocolError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    struct Frame {
+        FrameType type = FrameType::Error;
+        std::string data;
+    };
+
+    // Ограничения ожидания данных кадра. По умолчанию чтение ждёт данные сколько угодно
+    struct ReadLimits {
+        // Момент, к которому данные должны прийти целиком
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        // Флаг, установка которого прерывает ожидание. Проверяется не реже раза в STOP_POLL_INTERVAL
+        const std::atomic<bool>* stop = nullptr;
+    };
+
+    constexpr std::chrono::milliseconds STOP_POLL_INTERVAL{100};
+
+    // Отправляет кадр в сокет fd. При ошибке записи, в том числе закрытом соединении, выбрасывает std::system_error
+    void WriteFrame(int fd, FrameType type, std::string_view data);
+
+    // Читает кадр из сокета fd. Возвращает false, если соединение закрыто до начала кадра.
+    // Если данные не пришли к limits.deadline либо установлен limits.stop, выбрасывает ProtocolError
+    bool ReadFrame(int fd, Frame& frame, const ReadLimits& limits = {});
+
+    // Возвращает ключ программы с исходным кодом source: хеш и размер исходного кода
+    std::string ProgramKey(std::string_view source);
+
+}  // namespace server
@@ -0,0 +1,323 @@
+#include "client.h"
+#include "server.h"
+#include "server_protocol.h"
+#include "test_runner.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace server {
+
+// Заполняет кэш программ сервера в обход запросов
+struct ServerTestAccess {
+    static void AddProgram(Server& server, const string& key, string source) {
+        ASSERT(server.AddProgram(key, std::move(source)).cached);
+    }
+};
+
+namespace {
+
+const string PROGRAM = R"(
+class Echo:
+  def __init__(text):
+    self.text = text
+
+  def twice():
+    return self.text + self.text
+
+e = Echo(input)
+print 'got', e.twice()
+)"s;
+
+// Сервер, работающий в отдельном потоке на время теста
+class TestServer {
+public:
+    explicit TestServer(ServerOptions options)
+        : server_(Prepare(std::move(options)))
+        , thread_([this] { server_.Run(); }) {
+    }
+
+    ~TestServer() {
+        server_.Stop();
+        thread_.join();
+    }
+
+    Server& Get() {
+        return server_;
+    }
+
+private:
+    static ServerOptions Prepare(ServerOptions options) {
+        options.socket_path = "/tmp/mython-test-"s + to_string(::getpid()) + ".sock"s;
+        return options;
+    }
+
+    Server server_;
+    thread thread_;
+};
+
+// Подключается к серверу в обход Client, чтобы передать произвольные байты
+int ConnectRaw(const string& socket_path) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, socket_path.data(), socket_path.size());
+    ASSERT(::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+    return fd;
+}
+
+// Начало заголовка кадра без длины и данных
+void SendPartialFrame(int fd) {
+    const char part[] = {static_cast<char>(FrameType::Source), 1};
+    ASSERT_EQUAL(::write(fd, part, sizeof(part)), static_cast<ssize_t>(sizeof(part)));
+}
+
+Response Execute(Client& client, const Request& request, string& output) {
+    output.clear();
+    return client.Execute(request, [&output](string_view part) {
+        output.append(part);
+    });
+}
+
+void TestSourceThenKey() {
+    ServerOptions options;
+    options.threads = 2;
+    TestServer server(options);
+    Client client(server.Get().GetSocketPath());
+
+    Request request;
+    request.source = PROGRAM;
+    request.input = "ab"s;
+    string output;
+    Response response = Execute(client, request, output);
+    ASSERT_EQUAL(response.error, ""s);
+    ASSERT_EQUAL(response.key, ProgramKey(PROGRAM));
+    ASSERT_EQUAL(output, "got abab\n"s);
+
+    // Повторный запрос по ключу через то же соединение
+    request.source.clear();
+    request.key = response.key;
+    request.input = "xyz"s;
+    response = Execute(client, request, output);
+    ASSERT_EQUAL(response.error, ""s);
+    ASSERT_EQUAL(output, "got xyzxyz\n"s);
+
+    request.key = "unknown"s;
+    response = Execute(client, request, output);
+    ASSERT(response.error.find("Unknown program key"s) != string::npos);
+
+    const ServerStats stats = server.Get().GetStats();
+    ASSERT_EQUAL(stats.requests, 3U);
+    ASSERT_EQUAL(stats.failed, 1U);
+    ASSERT_EQUAL(stats.cache_hits, 1U);
+}
+
+// Программа, ключ которой совпал с ключом другой сохранённой программы, выполняется, но не сохраняется
+void TestKeyClash() {
+    ServerOptions options;
+    options.threads = 1;
+    TestServer server(options);
+    const string other = "print 'other', input\n"s;
+    ServerTestAccess::AddProgram(server.Get(), ProgramKey(PROGRAM), other);
+    Client client(server.Get().GetSocketPath());
+
+    Request request;
+    request.source = PROGRAM;
+    request.input = "ab"s;
+    string output;
+    Response response = Execute(client, request, output);
+    ASSERT_EQUAL(response.error, ""s);
+    ASSERT_EQUAL(response.key, ""s);
+    ASSERT_EQUAL(output, "got abab\n"s);
+
+    // По ключу по-прежнему выполняется сохранённая программа
+    request.source.clear();
+    request.key = ProgramKey(PROGRAM);
+    response = Execute(client, request, output);
+    ASSERT_EQUAL(response.error, ""s);
+    ASSERT_EQUAL(output, "other ab\n"s);
+
+    const ServerStats stats = server.Get().GetStats();
+    ASSERT_EQUAL(stats.requests, 2U);
+    ASSERT_EQUAL(stats.cache_hits, 1U);
+}
+
+void TestErrorsAndStreamedOutput() {
+    ServerOptions options;
+    options.threads = 1;
+    options.max_steps = 10000;
+    TestServer server(options);
+    Client client(server.Get().GetSocketPath());
+
+    Request request;
+    request.source = "print 'before'\nx = 1 / 0\n"s;
+    string output;
+    Response response = Execute(client, request, output);
+    // Вывод до ошибки доходит до клиента
+    ASSERT_EQUAL(output, "before\n"s);
+    ASSERT(!response.error.empty());
+
+    request.source = "x = (1 +\n"s;
+    response = Execute(client, request, output);
+    ASSERT(!response.error.empty());
+
+    request.source = R"(
+class Loop:
+  def run():
+    return self.run()
+
+l = Loop()
+l.run()
+)"s;
+    response = Execute(client, request, output);
+    ASSERT(response.error.find("Step limit"s) != string::npos);
+
+    // Большой вывод приходит несколькими частями
+    string program;
+    for (int i = 0; i < 2000; ++i) {
+        program += "print 'line number "s + to_string(i) + "'\n"s;
+    }
+    request.source = program;
+    size_t parts = 0;
+    output.clear();
+    response = client.Execute(request, [&](string_view part) {
+        ++parts;
+        output.append(part);
+    });
+    ASSERT_EQUAL(response.error, ""s);
+    ASSERT(parts > 1);
+    ASSERT(output.find("line number 1999\n"s) != string::npos);
+}
+
+void TestConcurrentClients() {
+    ServerOptions options;
+    options.threads = 4;
+    options.cache_capacity = 1;
+    TestServer server(options);
+
+    vector<thread> clients;
+    vector<size_t> failures(8);
+    for (size_t id = 0; id < failures.size(); ++id) {
+        clients.emplace_back([&, id] {
+            Client client(server.Get().GetSocketPath());
+            for (int i = 0; i < 20; ++i) {
+                Request request;
+                // Две программы при ёмкости кэша 1 заставляют вытеснять разобранные программы
+                request.source = id % 2 == 0 ? PROGRAM : PROGRAM + "print 'odd'\n"s;
+                request.input = to_string(id) + "-"s + to_string(i);
+                string output;
+                const Response response = Execute(client, request, output);
+                const string expected = "got "s + request.input + request.input + "\n"s
+                    + (id % 2 == 0 ? ""s : "odd\n"s);
+                failures[id] += !response.error.empty() || output != expected;
+            }
+        });
+    }
+    for (thread& client : clients) {
+        client.join();
+    }
+    for (size_t failed : failures) {
+        ASSERT_EQUAL(failed, 0U);
+    }
+    ASSERT_EQUAL(server.Get().GetStats().requests, 160U);
+}
+
+// Клиент, не дославший кадр, не занимает единственный рабочий поток дольше io_timeout
+// и не мешает серверу остановиться
+void TestStalledClient() {
+    {
+        ServerOptions options;
+        options.threads = 1;
+        options.io_timeout = 200ms;
+        TestServer server(options);
+        const int stalled = ConnectRaw(server.Get().GetSocketPath());
+        SendPartialFrame(stalled);
+
+        Client client(server.Get().GetSocketPath());
+        Request request;
+        request.source = PROGRAM;
+        request.input = "ok"s;
+        string output;
+        const Response response = Execute(client, request, output);
+        ASSERT_EQUAL(response.error, ""s);
+        ASSERT_EQUAL(output, "got okok\n"s);
+        // Сервер закрыл соединение с недосланным кадром
+        char byte = 0;
+        ASSERT_EQUAL(::read(stalled, &byte, 1), 0);
+        ::close(stalled);
+    }
+
+    auto server = make_unique<TestServer>(ServerOptions{});
+    const int stalled = ConnectRaw(server->Get().GetSocketPath());
+    SendPartialFrame(stalled);
+    this_thread::sleep_for(50ms);
+    const auto start = chrono::steady_clock::now();
+    server.reset();
+    ASSERT(chrono::steady_clock::now() - start < 2s);
+    ::close(stalled);
+}
+
+// Подключившийся, но молчащий клиент не занимает единственный рабочий поток дольше idle_timeout
+void TestIdleClient() {
+    ServerOptions options;
+    options.threads = 1;
+    options.idle_timeout = 200ms;
+    TestServer server(options);
+    const int idle = ConnectRaw(server.Get().GetSocketPath());
+
+    Client client(server.Get().GetSocketPath());
+    Request request;
+    request.source = PROGRAM;
+    request.input = "ok"s;
+    string output;
+    const Response response = Execute(client, request, output);
+    ASSERT_EQUAL(response.error, ""s);
+    ASSERT_EQUAL(output, "got okok\n"s);
+    // Сервер закрыл молчащее соединение
+    char byte = 0;
+    ASSERT_EQUAL(::read(idle, &byte, 1), 0);
+    ::close(idle);
+}
+
+// Stop прерывает выполняющуюся программу, и клиент получает ошибку
+void TestStopInterruptsRuns() {
+    ServerOptions options;
+    options.threads = 1;
+    TestServer server(options);
+    Response response;
+    thread client_thread([&server, &response] {
+        Client client(server.Get().GetSocketPath());
+        Request request;
+        request.source = "x = 0\nwhile True:\n  x = x + 1\n"s;
+        string output;
+        response = Execute(client, request, output);
+    });
+    this_thread::sleep_for(200ms);
+    server.Get().Stop();
+    client_thread.join();
+    ASSERT(response.error.find("interrupted"s) != string::npos);
+}
+
+}  // namespace
+
+void RunServerTests(TestRunner& tr) {
+    RUN_TEST(tr, server::TestSourceThenKey);
+    RUN_TEST(tr, server::TestKeyClash);
+    RUN_TEST(tr, server::TestErrorsAndStreamedOutput);
+    RUN_TEST(tr, server::TestConcurrentClients);
+    RUN_TEST(tr, server::TestStalledClient);
+    RUN_TEST(tr, server::TestIdleClient);
+    RUN_TEST(tr, server::TestStopInterruptsRuns);
+}
+
+}  // namespace server
@@ -1,5 +1,13 @@
 #include "statement.h"
 
+#include "call_stack.h"
+#include "coroutine.h"
+#include "dict.h"
+#include "isolate.h"
+#include "list.h"
+#include "string_methods.h"
+
+#include <charconv>
 #include <iostream>
 #include <sstream>
 
@@ -14,6 +22,51 @@ namespace ast {
     namespace {
         const string ADD_METHOD = "__add__"s;
         const string INIT_METHOD = "__init__"s;
+
+        // Обрабатывает команду перехода, выполненную телом цикла. Возвращает false, если цикл завершается
+        bool NextIteration(runtime::Frame& frame) {
+            switch (frame.jump) {
+                case runtime::Jump::None:
+                    return true;
+                case runtime::Jump::Return:
+                    return false;
+                case runtime::Jump::Break:
+                    frame.jump = runtime::Jump::None;
+                    return false;
+                case runtime::Jump::Continue:
+                    frame.jump = runtime::Jump::None;
+                    return true;
+            }
+            return true;
+        }
+
+        // Возвращает значение индекса списка или строки
+        int IndexValue(const ObjectHolder& index) {
+            if (const auto* number = index.TryAs<runtime::Number>()) {
+                return number->GetValue();
+            }
+            throw runtime_error("Index must be a number"s);
+        }
+
+        // Записывает в text значение value, отличное от строки, так же, как его выводит команда print.
+        // Числа, логические значения и None форматируются без std::ostream
+        void FormatValue(const ObjectHolder& value, Context& context, std::string& text) {
+            if (const auto* number = value.TryAs<runtime::Number>()) {
+                char digits[16];
+                text.assign(digits, to_chars(std::begin(digits), std::end(digits), number->GetValue()).ptr);
+            }
+            else if (const auto* boolean = value.TryAs<runtime::Bool>()) {
+                text = boolean->GetValue() ? "True"s : "False"s;
+            }
+            else if (!value) {
+                text = "None"s;
+            }
+            else {
+                std::ostringstream out;
+                value->Print(out, context);
+                text = out.str();
+            }
+        }
     }  // namespace
 
     Assignment::Assignment(std::string var, std::unique_ptr<Statement> rv)
@@ -26,6 +79,14 @@ namespace ast {
         return closure.at(var_);
     }
 
+    const std::string& Assignment::GetVar() const {
+        return var_;
+    }
+
+    const std::unique_ptr<Statement>& Assignment::GetRv() const {
+        return rv_;
+    }
+
     VariableValue::VariableValue(const std::string& var_name) {
         dotted_ids_.emplace_back(var_name);
     }
@@ -61,6 +122,10 @@ namespace ast {
         return object.TryAs<runtime::ClassInstance>()->Fields().at(dotted_ids_.back());
     }
 
+    const std::vector<std::string>& VariableValue::GetDottedIds() const {
+        return dotted_ids_;
+    }
+
     unique_ptr<Print> Print::Variable(const std::string& name) {
         return std::make_unique<Print>(std::make_unique<VariableValue>(name));
     }
@@ -77,21 +142,19 @@ namespace ast {
         bool first = true;
         for (const unique_ptr<Statement>& arg : args_) {
             if (!first) {
-                context.GetOutputStream() << ' ';
+                context.Write(" "sv);
             }
             first = false;
-            ObjectHolder object = arg->Execute(closure, context);
-            if (object) {
-                object->Print(context.GetOutputStream(), context);
-            }
-            else {
-                context.GetOutputStream() << "None";
-            }
+            runtime::PrintObject(arg->Execute(closure, context), context);
         }
-        context.GetOutputStream() << "\n";
+        context.Write("\n"sv);
         return {};
     }
 
+    const std::vector<std::unique_ptr<Statement>>& Print::GetArgs() const {
+        return args_;
+    }
+
     MethodCall::MethodCall(std::unique_ptr<Statement> object, std::string method, std::vector<std::unique_ptr<Statement>> args)
         : object_(std::move(object))
         , method_(method)
@@ -100,44 +163,209 @@ namespace ast {
     }
 
     ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
+        const std::vector<ObjectHolder> actual_args = EvaluateArgs(closure, context);
+        return Invoke(object_->Execute(closure, context), actual_args, context);
+    }
+
+    std::vector<ObjectHolder> MethodCall::EvaluateArgs(Closure& closure, Context& context) const {
         std::vector<ObjectHolder> actual_args;
+        actual_args.reserve(args_.size());
         for (const std::unique_ptr<Statement>& arg : args_) {
-            actual_args.emplace_back(std::move(arg->Execute(closure, context)));
+            actual_args.emplace_back(arg->Execute(closure, context));
         }
+        return actual_args;
+    }
 
-        ObjectHolder obj = object_->Execute(closure, context);
-        if (obj.TryAs<runtime::ClassInstance>()) {
-            return obj.TryAs<runtime::ClassInstance>()->Call(method_, actual_args, context);
+    ObjectHolder MethodCall::Invoke(const ObjectHolder& object, const std::vector<ObjectHolder>& args,
+                                    Context& context) const {
+        if (auto* instance = object.TryAs<runtime::ClassInstance>()) {
+            return instance->Call(method_, args, context);
+        }
+        if (auto* native = object.TryAs<runtime::NativeObject>()) {
+            return native->Call(method_, args, context);
+        }
+        if (object.TryAs<runtime::String>() != nullptr) {
+            return runtime::CallStringMethod(object, method_, args);
         }
 
         throw runtime_error("MethodCall::Execute");
     }
 
-    ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
-        const auto arg = GetArgument()->Execute(closure, context);
-        std::ostringstream out;
+    const std::unique_ptr<Statement>& MethodCall::GetObject() const {
+        return object_;
+    }
+
+    const std::string& MethodCall::GetMethod() const {
+        return method_;
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& MethodCall::GetArgs() const {
+        return args_;
+    }
 
-        if (const auto ptr = arg.TryAs<runtime::Number>()) {
-            ptr->Print(out, context);
-            return ObjectHolder::Own(runtime::String(out.str()));
+    NewList::NewList(std::vector<std::unique_ptr<Statement>> items)
+        : items_(std::move(items))
+    {
+    }
+
+    ObjectHolder NewList::Execute(Closure& closure, Context& context) {
+        std::vector<ObjectHolder> items;
+        items.reserve(items_.size());
+        for (const std::unique_ptr<Statement>& item : items_) {
+            items.push_back(item->Execute(closure, context));
         }
+        return ObjectHolder::Make<runtime::List>(std::move(items));
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& NewList::GetItems() const {
+        return items_;
+    }
+
+    NewDict::NewDict(Items items)
+        : items_(std::move(items))
+    {
+    }
 
-        if (const auto ptr = arg.TryAs<runtime::String>()) {
-            ptr->Print(out, context);
-            return ObjectHolder::Own(runtime::String(out.str()));
+    ObjectHolder NewDict::Execute(Closure& closure, Context& context) {
+        ObjectHolder result = ObjectHolder::Make<runtime::Dict>();
+        auto* dict = result.TryAs<runtime::Dict>();
+        for (const auto& [key, value] : items_) {
+            ObjectHolder key_value = key->Execute(closure, context);
+            dict->Set(std::move(key_value), value->Execute(closure, context), context);
         }
+        return result;
+    }
+
+    const NewDict::Items& NewDict::GetItems() const {
+        return items_;
+    }
+
+    ListFunction::ListFunction(Kind kind, std::vector<std::unique_ptr<Statement>> args)
+        : kind_(kind)
+        , args_(std::move(args))
+    {
+    }
 
-        if (const auto ptr = arg.TryAs<runtime::Bool>()) {
-            ptr->Print(out, context);
-            return ObjectHolder::Own(runtime::String(out.str()));
+    ObjectHolder ListFunction::Execute(Closure& closure, Context& context) {
+        std::vector<ObjectHolder> lists;
+        lists.reserve(args_.size());
+        for (const std::unique_ptr<Statement>& arg : args_) {
+            lists.push_back(arg->Execute(closure, context));
+            if (lists.back().TryAs<runtime::List>() == nullptr) {
+                throw runtime_error("List function expects list arguments"s);
+            }
         }
+        const runtime::List& lhs = *lists.front().TryAs<runtime::List>();
+        switch (kind_) {
+            case Kind::Sum:
+                return runtime::ListSum(lhs);
+            case Kind::Min:
+                return runtime::ListMin(lhs, context);
+            case Kind::Max:
+                return runtime::ListMax(lhs, context);
+            case Kind::Dot:
+                return runtime::ListDot(lhs, *lists.back().TryAs<runtime::List>());
+            case Kind::Add:
+                return runtime::ListAdd(lhs, *lists.back().TryAs<runtime::List>());
+            case Kind::Mul:
+                return runtime::ListMul(lhs, *lists.back().TryAs<runtime::List>());
+        }
+        throw runtime_error("Unknown list function"s);
+    }
 
-        if (const auto ptr = arg.TryAs<runtime::ClassInstance>()) {
-            ptr->Print(out, context);
-            return ObjectHolder::Own(runtime::String(out.str()));
+    ListFunction::Kind ListFunction::GetKind() const {
+        return kind_;
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& ListFunction::GetArgs() const {
+        return args_;
+    }
+
+    size_t ListFunction::GetArity(Kind kind) {
+        return kind == Kind::Sum || kind == Kind::Min || kind == Kind::Max ? 1 : 2;
+    }
+
+    ObjectHolder NewChannel::Execute([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) {
+        return ObjectHolder::Make<runtime::Channel>();
+    }
+
+    Spawn::Spawn(std::unique_ptr<Statement> object, std::string method, std::vector<std::unique_ptr<Statement>> args)
+        : object_(std::move(object))
+        , method_(std::move(method))
+        , args_(std::move(args)) {
+    }
+
+    ObjectHolder Spawn::Execute(Closure& closure, Context& context) {
+        runtime::IsolateGroup* group = runtime::IsolateGroup::Current();
+        if (group == nullptr) {
+            throw runtime_error("spawn is available only while a program is running"s);
+        }
+        std::vector<ObjectHolder> actual_args;
+        actual_args.reserve(args_.size());
+        for (const std::unique_ptr<Statement>& arg : args_) {
+            actual_args.push_back(arg->Execute(closure, context));
+        }
+        return group->Spawn(object_->Execute(closure, context), method_, actual_args);
+    }
+
+    const std::unique_ptr<Statement>& Spawn::GetObject() const {
+        return object_;
+    }
+
+    const std::string& Spawn::GetMethod() const {
+        return method_;
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& Spawn::GetArgs() const {
+        return args_;
+    }
+
+    StartTask::StartTask(std::unique_ptr<Statement> object, std::string method,
+                         std::vector<std::unique_ptr<Statement>> args)
+        : object_(std::move(object))
+        , method_(std::move(method))
+        , args_(std::move(args)) {
+    }
+
+    ObjectHolder StartTask::Execute(Closure& closure, Context& context) {
+        runtime::CoroutineScheduler* scheduler = runtime::CoroutineScheduler::Current();
+        if (scheduler == nullptr) {
+            throw runtime_error("task is available only while a program is running"s);
+        }
+        std::vector<ObjectHolder> actual_args;
+        actual_args.reserve(args_.size());
+        for (const std::unique_ptr<Statement>& arg : args_) {
+            actual_args.push_back(arg->Execute(closure, context));
         }
-        
-        return ObjectHolder::Own(runtime::String("None"));
+        return scheduler->Spawn(object_->Execute(closure, context), method_, std::move(actual_args), context);
+    }
+
+    const std::unique_ptr<Statement>& StartTask::GetObject() const {
+        return object_;
+    }
+
+    const std::string& StartTask::GetMethod() const {
+        return method_;
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& StartTask::GetArgs() const {
+        return args_;
+    }
+
+    ObjectHolder Yield::Execute([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) {
+        runtime::CoroutineScheduler::Yield();
+        return {};
+    }
+
+    ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
+        ObjectHolder arg = GetArgument()->Execute(closure, context);
+        // Строки неизменяемы, поэтому str от строки возвращает её саму
+        if (arg.TryAs<runtime::String>() != nullptr) {
+            return arg;
+        }
+        std::string text;
+        FormatValue(arg, context, text);
+        return ObjectHolder::Own(runtime::String(std::move(text)));
     }
 
     ObjectHolder Add::Execute(Closure& closure, Context& context) {
@@ -153,7 +381,11 @@ namespace ast {
         }
 
         if (lhs.TryAs<::runtime::String>() && rhs.TryAs<::runtime::String>()) {
-            return ObjectHolder::Own(::runtime::String(lhs.TryAs<::runtime::String>()->GetValue() + rhs.TryAs<::runtime::String>()->GetValue()));
+            const std::string& lhs_value = lhs.TryAs<::runtime::String>()->GetValue();
+            const std::string& rhs_value = rhs.TryAs<::runtime::String>()->GetValue();
+            // Длинная строка не должна выделяться целиком, если не помещается в бюджет памяти
+            runtime::MemoryBudget::EnsureAvailable(lhs_value.size() + rhs_value.size());
+            return ObjectHolder::Own(::runtime::String(lhs_value + rhs_value));
         }
 
         runtime::ClassInstance* cl = lhs.TryAs<runtime::ClassInstance>();
@@ -211,17 +443,59 @@ namespace ast {
     }
 
     ObjectHolder Compound::Execute(Closure& closure, Context& context) {
+        // Кадр не меняется, пока выполняются инструкции: вызванные методы убирают свои кадры
+        const runtime::Frame& frame = runtime::CallStack::Current().Top();
         for (const auto& statement : statements_) {
+            context.Step();
             statement->Execute(closure, context);
+            if (frame.jump != runtime::Jump::None) {
+                break;
+            }
         }
         return {};
     }
 
-    Return::Return(std::unique_ptr<Statement> statement) : statement_(std::move(statement)){
+    const std::vector<std::unique_ptr<Statement>>& Compound::GetStatements() const {
+        return statements_;
+    }
+
+    Return::Return(std::unique_ptr<Statement> statement)
+        : statement_(std::move(statement))
+        , tail_call_(dynamic_cast<const MethodCall*>(statement_.get())) {
     }
 
     ObjectHolder Return::Execute(Closure& closure, Context& context) {
-        throw statement_->Execute(closure, context);
+        runtime::CallStack& stack = runtime::CallStack::Current();
+        if (stack.GetDepth() == 0) {
+            throw runtime_error("return outside of a method"s);
+        }
+        ObjectHolder result;
+        if (tail_call_ != nullptr) {
+            std::vector<ObjectHolder> args = tail_call_->EvaluateArgs(closure, context);
+            ObjectHolder object = tail_call_->GetObject()->Execute(closure, context);
+            if (object.TryAs<runtime::ClassInstance>() == nullptr) {
+                result = tail_call_->Invoke(object, args, context);
+            }
+            else {
+                runtime::Frame& frame = stack.Top();
+                frame.tail_object = std::move(object);
+                frame.tail_method = &tail_call_->GetMethod();
+                frame.tail_args = std::move(args);
+                frame.jump = runtime::Jump::Return;
+                return {};
+            }
+        }
+        else {
+            result = statement_->Execute(closure, context);
+        }
+        runtime::Frame& frame = stack.Top();
+        frame.result = std::move(result);
+        frame.jump = runtime::Jump::Return;
+        return {};
+    }
+
+    const std::unique_ptr<Statement>& Return::GetStatement() const {
+        return statement_;
     }
 
     ClassDefinition::ClassDefinition(ObjectHolder cls) : cls_(std::move(cls)){
@@ -232,6 +506,10 @@ namespace ast {
         return cls_;
     }
 
+    const ObjectHolder& ClassDefinition::GetClass() const {
+        return cls_;
+    }
+
     FieldAssignment::FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv)
         :object_(std::move(object))
         , field_name_(std::move(field_name))
@@ -248,6 +526,18 @@ namespace ast {
         throw std::runtime_error("cls==nullptr");
     }
 
+    const VariableValue& FieldAssignment::GetObject() const {
+        return object_;
+    }
+
+    const std::string& FieldAssignment::GetFieldName() const {
+        return field_name_;
+    }
+
+    const std::unique_ptr<Statement>& FieldAssignment::GetRv() const {
+        return rv_;
+    }
+
     IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body, std::unique_ptr<Statement> else_body)
         : condition_(std::move(condition))
         , if_body_(std::move(if_body))
@@ -267,6 +557,92 @@ namespace ast {
         return {};
     }
 
+    const std::unique_ptr<Statement>& IfElse::GetCondition() const {
+        return condition_;
+    }
+
+    const std::unique_ptr<Statement>& IfElse::GetIfBody() const {
+        return if_body_;
+    }
+
+    const std::unique_ptr<Statement>& IfElse::GetElseBody() const {
+        return else_body_;
+    }
+
+    While::While(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> body)
+        : condition_(std::move(condition))
+        , body_(std::move(body))
+    {
+    }
+
+    ObjectHolder While::Execute(Closure& closure, Context& context) {
+        runtime::Frame& frame = runtime::CallStack::Current().Top();
+        while (IsTrue(condition_->Execute(closure, context))) {
+            body_->Execute(closure, context);
+            if (frame.jump != runtime::Jump::None && !NextIteration(frame)) {
+                break;
+            }
+        }
+        return {};
+    }
+
+    const std::unique_ptr<Statement>& While::GetCondition() const {
+        return condition_;
+    }
+
+    const std::unique_ptr<Statement>& While::GetBody() const {
+        return body_;
+    }
+
+    For::For(std::string var, std::unique_ptr<Statement> iterable, std::unique_ptr<Statement> body)
+        : var_(std::move(var))
+        , iterable_(std::move(iterable))
+        , body_(std::move(body))
+    {
+    }
+
+    ObjectHolder For::Execute(Closure& closure, Context& context) {
+        // Ссылка держит список, даже если тело цикла присвоит его переменной другое значение
+        const ObjectHolder iterable = iterable_->Execute(closure, context);
+        const auto* list = iterable.TryAs<runtime::List>();
+        const auto* dict = iterable.TryAs<runtime::Dict>();
+        if (list == nullptr && dict == nullptr) {
+            throw runtime_error("for loop expects a list or a dict"s);
+        }
+        runtime::Frame& frame = runtime::CallStack::Current().Top();
+        // Индекс, а не итератор: тело цикла может добавлять элементы, и вектор переезжает
+        for (size_t i = 0; i < (list != nullptr ? list->GetSize() : dict->GetSize()); ++i) {
+            closure[var_] = list != nullptr ? list->Get(i) : dict->GetEntries()[i].key;
+            body_->Execute(closure, context);
+            if (frame.jump != runtime::Jump::None && !NextIteration(frame)) {
+                break;
+            }
+        }
+        return {};
+    }
+
+    const std::string& For::GetVar() const {
+        return var_;
+    }
+
+    const std::unique_ptr<Statement>& For::GetIterable() const {
+        return iterable_;
+    }
+
+    const std::unique_ptr<Statement>& For::GetBody() const {
+        return body_;
+    }
+
+    ObjectHolder Break::Execute([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) {
+        runtime::CallStack::Current().Top().jump = runtime::Jump::Break;
+        return {};
+    }
+
+    ObjectHolder Continue::Execute([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) {
+        runtime::CallStack::Current().Top().jump = runtime::Jump::Continue;
+        return {};
+    }
+
     ObjectHolder Or::Execute(Closure& closure, Context& context) {
         ObjectHolder lhs = GetLhs()->Execute(closure, context);
 
@@ -290,6 +666,131 @@ namespace ast {
         return ObjectHolder::Own(::runtime::Bool(lhs.TryAs<::runtime::Bool>()->GetValue() && rhs.TryAs<::runtime::Bool>()->GetValue()));
     }
 
+    ObjectHolder Length::Execute(Closure& closure, Context& context) {
+        const ObjectHolder arg = GetArgument()->Execute(closure, context);
+        if (const auto* list = arg.TryAs<runtime::List>()) {
+            return ObjectHolder::Own(runtime::Number(static_cast<int>(list->GetSize())));
+        }
+        if (const auto* dict = arg.TryAs<runtime::Dict>()) {
+            return ObjectHolder::Own(runtime::Number(static_cast<int>(dict->GetSize())));
+        }
+        if (const auto* str = arg.TryAs<runtime::String>()) {
+            return ObjectHolder::Own(runtime::Number(static_cast<int>(str->GetValue().size())));
+        }
+        throw runtime_error("len expects a list, a dict or a string"s);
+    }
+
+    FormatString::FormatString(std::vector<std::string> literals, std::vector<std::unique_ptr<Statement>> values)
+        : literals_(std::move(literals))
+        , values_(std::move(values))
+    {
+        if (literals_.size() != values_.size() + 1) {
+            throw invalid_argument("FormatString needs one more literal than values"s);
+        }
+        for (const std::string& literal : literals_) {
+            literals_size_ += literal.size();
+        }
+    }
+
+    ObjectHolder FormatString::Execute(Closure& closure, Context& context) {
+        // Символы строк копируются сразу в результат, остальные значения сначала форматируются в text
+        struct Part {
+            ObjectHolder value;
+            const std::string* str = nullptr;
+            std::string text;
+        };
+        std::vector<Part> parts(values_.size());
+        size_t size = literals_size_;
+        for (size_t i = 0; i < values_.size(); ++i) {
+            Part& part = parts[i];
+            part.value = values_[i]->Execute(closure, context);
+            if (const auto* str = part.value.TryAs<runtime::String>()) {
+                part.str = &str->GetValue();
+            }
+            else {
+                FormatValue(part.value, context, part.text);
+            }
+            size += part.str != nullptr ? part.str->size() : part.text.size();
+        }
+
+        // Длинная строка не должна выделяться целиком, если не помещается в бюджет памяти
+        runtime::MemoryBudget::EnsureAvailable(size);
+        std::string result;
+        result.reserve(size);
+        for (size_t i = 0; i < parts.size(); ++i) {
+            result += literals_[i];
+            result += parts[i].str != nullptr ? *parts[i].str : parts[i].text;
+        }
+        result += literals_.back();
+        return ObjectHolder::Own(runtime::String(std::move(result)));
+    }
+
+    const std::vector<std::string>& FormatString::GetLiterals() const {
+        return literals_;
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& FormatString::GetValues() const {
+        return values_;
+    }
+
+    ObjectHolder Index::Execute(Closure& closure, Context& context) {
+        const ObjectHolder object = GetLhs()->Execute(closure, context);
+        if (const auto* dict = object.TryAs<runtime::Dict>()) {
+            return dict->At(GetRhs()->Execute(closure, context), context);
+        }
+        const int index = IndexValue(GetRhs()->Execute(closure, context));
+        if (const auto* list = object.TryAs<runtime::List>()) {
+            return list->At(index);
+        }
+        if (const auto* str = object.TryAs<runtime::String>()) {
+            const std::string& value = str->GetValue();
+            const long long position = index < 0 ? static_cast<long long>(value.size()) + index : index;
+            if (position < 0 || position >= static_cast<long long>(value.size())) {
+                throw runtime_error("String index "s + to_string(index) + " out of range"s);
+            }
+            return ObjectHolder::Own(runtime::String(std::string(1, value[position])));
+        }
+        throw runtime_error("Only lists, dicts and strings can be indexed"s);
+    }
+
+    IndexAssignment::IndexAssignment(std::unique_ptr<Statement> object, std::unique_ptr<Statement> index,
+                                     std::unique_ptr<Statement> rv)
+        : object_(std::move(object))
+        , index_(std::move(index))
+        , rv_(std::move(rv))
+    {
+    }
+
+    ObjectHolder IndexAssignment::Execute(Closure& closure, Context& context) {
+        const ObjectHolder object = object_->Execute(closure, context);
+        if (auto* dict = object.TryAs<runtime::Dict>()) {
+            ObjectHolder key = index_->Execute(closure, context);
+            ObjectHolder value = rv_->Execute(closure, context);
+            dict->Set(std::move(key), value, context);
+            return value;
+        }
+        auto* list = object.TryAs<runtime::List>();
+        if (list == nullptr) {
+            throw runtime_error("Only list and dict items can be assigned"s);
+        }
+        const int index = IndexValue(index_->Execute(closure, context));
+        ObjectHolder value = rv_->Execute(closure, context);
+        list->Set(index, value);
+        return value;
+    }
+
+    const std::unique_ptr<Statement>& IndexAssignment::GetObject() const {
+        return object_;
+    }
+
+    const std::unique_ptr<Statement>& IndexAssignment::GetIndex() const {
+        return index_;
+    }
+
+    const std::unique_ptr<Statement>& IndexAssignment::GetRv() const {
+        return rv_;
+    }
+
     ObjectHolder Not::Execute(Closure& closure, Context& context) {
         ObjectHolder arg = GetArgument()->Execute(closure, context);
         return ObjectHolder::Own(::runtime::Bool(!arg.TryAs<::runtime::Bool>()->GetValue()));
@@ -305,6 +806,10 @@ namespace ast {
         return ObjectHolder::Own(::runtime::Bool(cmp_(GetLhs()->Execute(closure, context), GetRhs()->Execute(closure, context), context)));
     }
 
+    const Comparison::Comparator& Comparison::GetComparator() const {
+        return cmp_;
+    }
+
     NewInstance::NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args)
         : class__(class_)
         , args_(std::move(args))
@@ -316,7 +821,7 @@ namespace ast {
     }
 
     ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
-        ObjectHolder object = ObjectHolder::Own(runtime::ClassInstance(class__));
+        ObjectHolder object = ObjectHolder::Make<runtime::ClassInstance>(class__);
 
         runtime::ClassInstance* cl = object.TryAs<runtime::ClassInstance>();
         if (cl->HasMethod(INIT_METHOD, args_.size())) {
@@ -325,24 +830,62 @@ namespace ast {
                 actual_args.emplace_back(std::move(arg->Execute(closure, context)));
             }
             cl->Call(INIT_METHOD, actual_args, context);
+            class__.NoteFieldCount(cl->Fields().size());
         }
 
         return object;
     }
 
+    const runtime::Class& NewInstance::GetClass() const {
+        return class__;
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& NewInstance::GetArgs() const {
+        return args_;
+    }
+
     MethodBody::MethodBody(std::unique_ptr<Statement>&& body) : body_(std::move(body))
     {
     }
 
     ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
-        ObjectHolder object = ObjectHolder::None();
-        try {
-            object = body_->Execute(closure, context);
+        body_->Execute(closure, context);
+        runtime::Frame& frame = runtime::CallStack::Current().Top();
+        if (frame.jump != runtime::Jump::Return) {
+            return ObjectHolder::None();
         }
-        catch (ObjectHolder& obj) {
-            object = std::move(obj);
-        }
-        return object;
+        frame.jump = runtime::Jump::None;
+        return std::exchange(frame.result, {});
+    }
+
+    const std::unique_ptr<Statement>& MethodBody::GetBody() const {
+        return body_;
+    }
+
+    LazyMethodBody::LazyMethodBody(Parser parser)
+        : parser_(std::move(parser))
+    {
+    }
+
+    ObjectHolder LazyMethodBody::Execute(Closure& closure, Context& context) {
+        return GetBody().Execute(closure, context);
+    }
+
+    MethodBody& LazyMethodBody::GetBody() const {
+        std::call_once(parsed_, [this] {
+            // Тело остаётся в дереве программы после прогона, который его разобрал,
+            // поэтому не учитывается в бюджете памяти этого прогона
+            runtime::MemoryBudget::Scope no_budget(nullptr);
+            body_ = std::make_unique<MethodBody>(parser_());
+            // Разбор больше не понадобится: отпускаем всё, что захватил parser
+            parser_ = nullptr;
+            is_parsed_.store(true, std::memory_order_release);
+        });
+        return *body_;
+    }
+
+    bool LazyMethodBody::IsParsed() const {
+        return is_parsed_.load(std::memory_order_acquire);
     }
 
     UnaryOperation::UnaryOperation(std::unique_ptr<Statement> argument)
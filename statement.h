@@ -2,27 +2,35 @@
 
 #include "runtime.h"
 
+#include <atomic>
 #include <functional>
+#include <mutex>
+#include <utility>
 
 namespace ast {
 
     using Statement = runtime::Executable;
 
     // Выражение, возвращающее значение типа T,
-    // используется как основа для создания констант
+    // используется как основа для создания констант.
+    // Значение разделяется с переменными, которым оно присвоено, и переживает узел дерева
     template <typename T>
     class ValueStatement : public Statement {
     public:
         explicit ValueStatement(T v)
-            : value_(std::move(v)) {
+            : value_(runtime::ObjectHolder::Own(std::move(v))) {
         }
 
         runtime::ObjectHolder Execute(runtime::Closure& /*closure*/, runtime::Context& /*context*/) override {
-            return runtime::ObjectHolder::Share(value_);
+            return value_;
+        }
+
+        const T& GetValue() const {
+            return *value_.TryAs<T>();
         }
 
     private:
-        T value_;
+        runtime::ObjectHolder value_;
     };
 
     using NumericConst = ValueStatement<runtime::Number>;
@@ -39,6 +47,7 @@ namespace ast {
         explicit VariableValue(const std::string& var_name);
         explicit VariableValue(std::vector<std::string> dotted_ids);
         runtime::ObjectHolder Execute(runtime::Closure& closure, [[maybe_unused]] runtime::Context& context) override;
+        const std::vector<std::string>& GetDottedIds() const;
 
     private:
         std::vector<std::string> dotted_ids_;
@@ -49,6 +58,8 @@ namespace ast {
     public:
         Assignment(std::string var, std::unique_ptr<Statement> rv);
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::string& GetVar() const;
+        const std::unique_ptr<Statement>& GetRv() const;
 
     private:
         std::string var_;
@@ -60,6 +71,9 @@ namespace ast {
     public:
         FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv);
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const VariableValue& GetObject() const;
+        const std::string& GetFieldName() const;
+        const std::unique_ptr<Statement>& GetRv() const;
 
     private:
         VariableValue object_;
@@ -67,6 +81,22 @@ namespace ast {
         std::unique_ptr<Statement> rv_;
     };
 
+    // Присваивает элементу object[index] списка или значению по ключу index словаря значение выражения rv
+    class IndexAssignment : public Statement {
+    public:
+        IndexAssignment(std::unique_ptr<Statement> object, std::unique_ptr<Statement> index,
+                        std::unique_ptr<Statement> rv);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::unique_ptr<Statement>& GetObject() const;
+        const std::unique_ptr<Statement>& GetIndex() const;
+        const std::unique_ptr<Statement>& GetRv() const;
+
+    private:
+        std::unique_ptr<Statement> object_;
+        std::unique_ptr<Statement> index_;
+        std::unique_ptr<Statement> rv_;
+    };
+
     // Значение None
     class None : public Statement {
     public:
@@ -84,9 +114,10 @@ namespace ast {
         explicit Print(std::vector<std::unique_ptr<Statement>> args);
         // Инициализирует команду print для вывода значения переменной name
         static std::unique_ptr<Print> Variable(const std::string& name);
-        // Во время выполнения команды print вывод должен осуществляться в поток, возвращаемый из
-        // context.GetOutputStream()
+        // Во время выполнения команды print вывод осуществляется через context.Write,
+        // поток context.GetOutputStream() используется только для объектов без собственного представления
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
 
     private:
         std::vector<std::unique_ptr<Statement>> args_;
@@ -97,6 +128,14 @@ namespace ast {
     public:
         MethodCall(std::unique_ptr<Statement> object, std::string method, std::vector<std::unique_ptr<Statement>> args);
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        // Вычисляет параметры вызова в порядке их следования
+        std::vector<runtime::ObjectHolder> EvaluateArgs(runtime::Closure& closure, runtime::Context& context) const;
+        // Вызывает метод у уже вычисленного объекта object
+        runtime::ObjectHolder Invoke(const runtime::ObjectHolder& object, const std::vector<runtime::ObjectHolder>& args,
+                                     runtime::Context& context) const;
+        const std::unique_ptr<Statement>& GetObject() const;
+        const std::string& GetMethod() const;
+        const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
 
     private:
         std::unique_ptr<Statement> object_;
@@ -124,12 +163,127 @@ namespace ast {
         NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args);
         // Возвращает объект, содержащий значение типа ClassInstance
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const runtime::Class& GetClass() const;
+        const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
 
     private:
         const runtime::Class& class__;
         std::vector<std::unique_ptr<Statement>> args_;
     };
 
+    // Создаёт список из значений выражений items (см. runtime::List): [a, b + 1]
+    class NewList : public Statement {
+    public:
+        explicit NewList(std::vector<std::unique_ptr<Statement>> items);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::vector<std::unique_ptr<Statement>>& GetItems() const;
+
+    private:
+        std::vector<std::unique_ptr<Statement>> items_;
+    };
+
+    // Создаёт словарь из пар значений выражений items (см. runtime::Dict): {'a': 1, key: value}.
+    // Пары добавляются по порядку, поэтому из повторяющихся ключей побеждает последний
+    class NewDict : public Statement {
+    public:
+        using Items = std::vector<std::pair<std::unique_ptr<Statement>, std::unique_ptr<Statement>>>;
+
+        explicit NewDict(Items items);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const Items& GetItems() const;
+
+    private:
+        Items items_;
+    };
+
+    /*
+    Вызов встроенной функции над списками (см. runtime::ListSum и соседние функции):
+
+    total = sum(xs)
+    lowest = min(xs)
+    highest = max(xs)
+    product = dot(xs, ys)
+    sums = add(xs, ys)
+    products = mul(xs, ys)
+    */
+    class ListFunction : public Statement {
+    public:
+        enum class Kind : uint8_t {
+            Sum,
+            Min,
+            Max,
+            Dot,
+            Add,
+            Mul,
+        };
+
+        ListFunction(Kind kind, std::vector<std::unique_ptr<Statement>> args);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        Kind GetKind() const;
+        const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
+
+        // Число аргументов функции kind
+        static size_t GetArity(Kind kind);
+
+    private:
+        Kind kind_;
+        std::vector<std::unique_ptr<Statement>> args_;
+    };
+
+    // Создаёт канал для обмена значениями между изолятами (см. runtime::Channel): ch = Channel()
+    class NewChannel : public Statement {
+    public:
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    /*
+    Запускает изолят, вызывающий метод object.method с параметрами args в отдельном потоке (см. runtime::Isolate),
+    и возвращает объект изолята:
+
+    worker = spawn(counter.count, 1000)
+    print worker.join()
+    */
+    class Spawn : public Statement {
+    public:
+        Spawn(std::unique_ptr<Statement> object, std::string method, std::vector<std::unique_ptr<Statement>> args);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::unique_ptr<Statement>& GetObject() const;
+        const std::string& GetMethod() const;
+        const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
+
+    private:
+        std::unique_ptr<Statement> object_;
+        std::string method_;
+        std::vector<std::unique_ptr<Statement>> args_;
+    };
+
+    /*
+    Запускает задачу, вызывающую метод object.method с параметрами args по очереди с программой
+    в том же потоке (см. runtime::Task), и возвращает объект задачи:
+
+    t = task(counter.count, 1000)
+    print t.join()
+    */
+    class StartTask : public Statement {
+    public:
+        StartTask(std::unique_ptr<Statement> object, std::string method, std::vector<std::unique_ptr<Statement>> args);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::unique_ptr<Statement>& GetObject() const;
+        const std::string& GetMethod() const;
+        const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
+
+    private:
+        std::unique_ptr<Statement> object_;
+        std::string method_;
+        std::vector<std::unique_ptr<Statement>> args_;
+    };
+
+    // Команда yield: задача уступает очередь другим задачам, программа выполняет задачи (см. runtime::CoroutineScheduler)
+    class Yield : public Statement {
+    public:
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
     // Базовый класс для унарных операций
     class UnaryOperation : public Statement {
     public:
@@ -147,6 +301,35 @@ namespace ast {
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
     };
 
+    // Операция len, возвращающая длину списка или строки либо число пар словаря
+    class Length : public UnaryOperation {
+    public:
+        using UnaryOperation::UnaryOperation;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    /*
+    Форматная строка: постоянные части literals, между которыми стоят значения выражений values,
+    преобразованные в строки так же, как функцией str. Длина постоянных частей вычисляется при разборе,
+    поэтому результат собирается в строку, память под которую выделяется один раз:
+
+    label = f"Rect({self.w}x{self.h})"
+    */
+    class FormatString : public Statement {
+    public:
+        // literals на один элемент длиннее values: literals[i] стоит перед values[i], последняя часть - после всех
+        FormatString(std::vector<std::string> literals, std::vector<std::unique_ptr<Statement>> values);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::vector<std::string>& GetLiterals() const;
+        const std::vector<std::unique_ptr<Statement>>& GetValues() const;
+
+    private:
+        std::vector<std::string> literals_;
+        std::vector<std::unique_ptr<Statement>> values_;
+        // Суммарная длина постоянных частей
+        size_t literals_size_ = 0;
+    };
+
     // Родительский класс Бинарная операция с аргументами lhs и rhs
     class BinaryOperation : public Statement {
     public:
@@ -224,6 +407,13 @@ namespace ast {
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
     };
 
+    // Возвращает элемент lhs[rhs] списка, значение по ключу rhs словаря либо символ строки в виде строки из одного символа
+    class Index : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
     // Возвращает результат вычисления логической операции not над единственным аргументом операции
     class Not : public UnaryOperation {
     public:
@@ -246,6 +436,7 @@ namespace ast {
         void AddStatement(std::unique_ptr<Statement> stmt);
         // Последовательно выполняет добавленные инструкции. Возвращает None
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::vector<std::unique_ptr<Statement>>& GetStatements() const;
 
     private:
         std::vector<std::unique_ptr<Statement>> statements_;
@@ -268,11 +459,40 @@ namespace ast {
         // Если внутри body была выполнена инструкция return, возвращает результат return
         // В противном случае возвращает None
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::unique_ptr<Statement>& GetBody() const;
 
     private:
         std::unique_ptr<Statement> body_;
     };
 
+    /*
+     * Тело метода, которое разбирается при первом вызове метода.
+     * parser возвращает инструкцию, из которой строится MethodBody. Если parser выбрасывает исключение,
+     * оно передаётся вызывающему, а разбор повторяется при следующем вызове.
+     * Разбор выполняется не более одного раза, в том числе при одновременных вызовах из разных потоков
+     */
+    class LazyMethodBody : public Statement {
+    public:
+        using Parser = std::function<std::unique_ptr<Statement>()>;
+
+        explicit LazyMethodBody(Parser parser);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        // Разбирает тело, если это ещё не сделано, и возвращает его
+        MethodBody& GetBody() const;
+
+        // Возвращает true, если тело уже разобрано
+        [[nodiscard]] bool IsParsed() const;
+
+    private:
+        mutable Parser parser_;
+        mutable std::once_flag parsed_;
+        mutable std::unique_ptr<MethodBody> body_;
+        // Устанавливается внутри call_once после разбора: IsParsed читает его без гонки с GetBody
+        mutable std::atomic<bool> is_parsed_ = false;
+    };
+
     // Выполняет инструкцию return с выражением statement
     class Return : public Statement {
     public:
@@ -280,10 +500,18 @@ namespace ast {
 
         // Останавливает выполнение текущего метода. После выполнения инструкции return метод,
         // внутри которого она была исполнена, должен вернуть результат вычисления выражения statement.
+        // Результат запоминается в кадре метода (см. runtime::CallStack), и составные инструкции метода
+        // прекращают выполнение. Вне метода выбрасывает runtime_error.
+        // Если statement - вызов метода экземпляра класса (return self.step(n - 1)), это хвостовой вызов:
+        // вычисляются только объект и параметры, а сам метод выполняется в кадре текущего метода после
+        // выхода из него (см. runtime::ClassInstance::Call), поэтому такая рекурсия не растит стек
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::unique_ptr<Statement>& GetStatement() const;
 
     private:
         std::unique_ptr<Statement> statement_;
+        // statement, если это вызов метода
+        const MethodCall* tail_call_;
     };
 
     // Объявляет класс
@@ -295,6 +523,7 @@ namespace ast {
         // Создаёт внутри closure новый объект, совпадающий с именем класса и значением, переданным в
         // конструктор
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const runtime::ObjectHolder& GetClass() const;
 
     private:
         runtime::ObjectHolder cls_;
@@ -306,6 +535,10 @@ namespace ast {
         // Параметр else_body может быть равен nullptr
         IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body, std::unique_ptr<Statement> else_body);
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::unique_ptr<Statement>& GetCondition() const;
+        const std::unique_ptr<Statement>& GetIfBody() const;
+        // Может вернуть nullptr, если ветка else отсутствует
+        const std::unique_ptr<Statement>& GetElseBody() const;
 
     private:
         std::unique_ptr<Statement> condition_;
@@ -313,6 +546,48 @@ namespace ast {
         std::unique_ptr<Statement> else_body_;
     };
 
+    // Цикл while <condition>: <body>. Тело выполняется, пока условие истинно; переход к следующему
+    // повторению только вычисляет условие заново, без новых кадров и переменных
+    class While : public Statement {
+    public:
+        While(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> body);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::unique_ptr<Statement>& GetCondition() const;
+        const std::unique_ptr<Statement>& GetBody() const;
+
+    private:
+        std::unique_ptr<Statement> condition_;
+        std::unique_ptr<Statement> body_;
+    };
+
+    // Цикл for <var> in <iterable>: <body>. Тело выполняется для каждого элемента списка или ключа словаря
+    // по порядку, элемент присваивается переменной var. Элементы и ключи, добавленные телом цикла, тоже перебираются
+    class For : public Statement {
+    public:
+        For(std::string var, std::unique_ptr<Statement> iterable, std::unique_ptr<Statement> body);
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const std::string& GetVar() const;
+        const std::unique_ptr<Statement>& GetIterable() const;
+        const std::unique_ptr<Statement>& GetBody() const;
+
+    private:
+        std::string var_;
+        std::unique_ptr<Statement> iterable_;
+        std::unique_ptr<Statement> body_;
+    };
+
+    // Команда break: завершает ближайший цикл
+    class Break : public Statement {
+    public:
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    // Команда continue: ближайший цикл переходит к следующему повторению
+    class Continue : public Statement {
+    public:
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
     // Операция сравнения
     class Comparison : public BinaryOperation {
     public:
@@ -324,6 +599,7 @@ namespace ast {
         // Вычисляет значение выражений lhs и rhs и возвращает результат работы comparator,
         // приведённый к типу runtime::Bool
         runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        const Comparator& GetComparator() const;
     private:
         Comparator cmp_;
     };
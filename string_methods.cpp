@@ -0,0 +1,184 @@
+#include "string_methods.h"
+
+#include "list.h"
+#include "text_kernels.h"
+
+#include <stdexcept>
+#include <string_view>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        void CheckArgCount(const string& method, const vector<ObjectHolder>& args, size_t least, size_t most) {
+            if (args.size() >= least && args.size() <= most) {
+                return;
+            }
+            const string expected = least == most ? to_string(least) : to_string(least) + " to "s + to_string(most);
+            throw runtime_error("String."s + method + " takes "s + expected + " argument(s), "s
+                                + to_string(args.size()) + " given"s);
+        }
+
+        const string& StringArg(const string& method, const vector<ObjectHolder>& args, size_t index) {
+            const auto* str = args[index].TryAs<String>();
+            if (str == nullptr) {
+                throw runtime_error("String."s + method + " expects a string argument"s);
+            }
+            return str->GetValue();
+        }
+
+        // Подстрока, которую ищут count, replace и split: пустая подстрока входит в строку бесконечно часто
+        string_view PatternArg(const string& method, const vector<ObjectHolder>& args, size_t index) {
+            const string& pattern = StringArg(method, args, index);
+            if (pattern.empty()) {
+                throw runtime_error("String."s + method + " expects a non-empty substring"s);
+            }
+            return pattern;
+        }
+
+        bool IsSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+        }
+
+        ObjectHolder Find(string_view value, const vector<ObjectHolder>& args) {
+            const string& sub = StringArg("find"s, args, 0);
+            size_t start = 0;
+            if (args.size() == 2) {
+                const auto* number = args[1].TryAs<Number>();
+                if (number == nullptr) {
+                    throw runtime_error("String.find expects a number start"s);
+                }
+                const long long position = number->GetValue() < 0
+                    ? static_cast<long long>(value.size()) + number->GetValue()
+                    : number->GetValue();
+                if (position > static_cast<long long>(value.size())) {
+                    return ObjectHolder::Own(Number(-1));
+                }
+                start = position < 0 ? 0 : static_cast<size_t>(position);
+            }
+            const size_t found = FindText(value.substr(start), sub);
+            return ObjectHolder::Own(Number(found == string_view::npos ? -1 : static_cast<int>(start + found)));
+        }
+
+        ObjectHolder Count(string_view value, string_view sub) {
+            int found = 0;
+            for (size_t position = FindText(value, sub); position != string_view::npos;
+                 position = FindText(value, sub)) {
+                ++found;
+                value.remove_prefix(position + sub.size());
+            }
+            return ObjectHolder::Own(Number(found));
+        }
+
+        ObjectHolder SplitSpaces(const ObjectHolder& self, string_view value) {
+            vector<ObjectHolder> parts;
+            size_t i = 0;
+            while (i < value.size()) {
+                while (i < value.size() && IsSpace(value[i])) {
+                    ++i;
+                }
+                const size_t begin = i;
+                while (i < value.size() && !IsSpace(value[i])) {
+                    ++i;
+                }
+                if (begin == 0 && i == value.size()) {
+                    parts.push_back(self);
+                }
+                else if (begin < i) {
+                    parts.push_back(ObjectHolder::Own(String(string(value.substr(begin, i - begin)))));
+                }
+            }
+            return ObjectHolder::Make<List>(std::move(parts));
+        }
+
+        ObjectHolder Split(const ObjectHolder& self, string_view value, string_view sep) {
+            vector<ObjectHolder> parts;
+            size_t position = FindText(value, sep);
+            if (position == string_view::npos) {
+                parts.push_back(self);
+                return ObjectHolder::Make<List>(std::move(parts));
+            }
+            for (; position != string_view::npos; position = FindText(value, sep)) {
+                parts.push_back(ObjectHolder::Own(String(string(value.substr(0, position)))));
+                value.remove_prefix(position + sep.size());
+            }
+            parts.push_back(ObjectHolder::Own(String(string(value))));
+            return ObjectHolder::Make<List>(std::move(parts));
+        }
+
+        // Позиции вхождений находятся заранее, чтобы выделить память под результат один раз
+        ObjectHolder Replace(const ObjectHolder& self, string_view value, string_view old, string_view replacement) {
+            vector<size_t> positions;
+            for (size_t position = FindText(value, old); position != string_view::npos;) {
+                positions.push_back(position);
+                const size_t next = FindText(value.substr(position + old.size()), old);
+                position = next == string_view::npos ? next : position + old.size() + next;
+            }
+            if (positions.empty()) {
+                return self;
+            }
+            string result;
+            result.reserve(value.size() - positions.size() * old.size() + positions.size() * replacement.size());
+            size_t copied = 0;
+            for (const size_t position : positions) {
+                result.append(value.substr(copied, position - copied));
+                result.append(replacement);
+                copied = position + old.size();
+            }
+            result.append(value.substr(copied));
+            return ObjectHolder::Own(String(std::move(result)));
+        }
+
+        ObjectHolder ChangeCase(const ObjectHolder& self, const string& value, char low, char high) {
+            const size_t first = FindByteInRange(value, low, high);
+            if (first == value.size()) {
+                return self;
+            }
+            string result = value;
+            FlipAsciiCase(result.data() + first, result.size() - first, low, high);
+            return ObjectHolder::Own(String(std::move(result)));
+        }
+    }  // namespace
+
+    ObjectHolder CallStringMethod(const ObjectHolder& self, const string& method, const vector<ObjectHolder>& args) {
+        const string& value = self.TryAs<String>()->GetValue();
+        if (method == "find"sv) {
+            CheckArgCount(method, args, 1, 2);
+            return Find(value, args);
+        }
+        if (method == "count"sv) {
+            CheckArgCount(method, args, 1, 1);
+            return Count(value, PatternArg(method, args, 0));
+        }
+        if (method == "startswith"sv || method == "endswith"sv) {
+            CheckArgCount(method, args, 1, 1);
+            const string_view part = StringArg(method, args, 0);
+            const string_view view = value;
+            const bool starts = method == "startswith"sv;
+            return ObjectHolder::Own(Bool(
+                part.size() <= view.size() && view.substr(starts ? 0 : view.size() - part.size(), part.size()) == part));
+        }
+        if (method == "split"sv) {
+            CheckArgCount(method, args, 0, 1);
+            if (args.empty()) {
+                return SplitSpaces(self, value);
+            }
+            return Split(self, value, PatternArg(method, args, 0));
+        }
+        if (method == "replace"sv) {
+            CheckArgCount(method, args, 2, 2);
+            return Replace(self, value, PatternArg(method, args, 0), StringArg(method, args, 1));
+        }
+        if (method == "upper"sv) {
+            CheckArgCount(method, args, 0, 0);
+            return ChangeCase(self, value, 'a', 'z');
+        }
+        if (method == "lower"sv) {
+            CheckArgCount(method, args, 0, 0);
+            return ChangeCase(self, value, 'A', 'Z');
+        }
+        throw runtime_error("String has no method "s + method);
+    }
+
+}  // namespace runtime
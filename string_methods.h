@@ -0,0 +1,27 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <string>
+#include <vector>
+
+namespace runtime {
+
+    /*
+     * Встроенные методы строк Mython, которые вызывает MethodCall, когда объект вызова - строка:
+     *   find(sub) и find(sub, start) - позиция первого вхождения sub начиная с позиции start либо -1;
+     *     отрицательный start отсчитывается от конца строки;
+     *   count(sub) - число непересекающихся вхождений непустой подстроки sub;
+     *   startswith(prefix), endswith(suffix) - True, если строка начинается с prefix (заканчивается на suffix);
+     *   split() - список слов, разделённых пробельными символами; split(sep) - список частей между
+     *     вхождениями непустого разделителя sep, включая пустые;
+     *   replace(old, new) - строка, в которой все вхождения непустой подстроки old заменены на new;
+     *   upper(), lower() - строка с заглавными (строчными) латинскими буквами.
+     * Подстроки ищутся функциями text_kernels.h. Если результат совпадает со строкой (replace без вхождений,
+     * upper строки без строчных букв), метод возвращает саму строку без копирования символов.
+     * Неизвестный метод, неверное число аргументов или аргумент не того типа - runtime_error
+     */
+    ObjectHolder CallStringMethod(const ObjectHolder& self, const std::string& method,
+                                  const std::vector<ObjectHolder>& args);
+
+}  // namespace runtime
@@ -0,0 +1,134 @@
+#include "bench_runner.h"
+#include "interpreter.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void RunProgram(const string& program) {
+    ostringstream out;
+    SimpleContext context(out);
+    RunMythonProgram(program, context, RunOptions{});
+    DoNotOptimize(out);
+}
+
+// Текст из 7174 символов со словом needle в конце, который замеры ниже обрабатывают 10 раз телом body.
+// Словарь upper_of нужен аналогу метода upper на Mython
+string TextProgram(const string& body) {
+    string upper_of = "upper_of = {"s;
+    for (char c = 'a'; c <= 'z'; ++c) {
+        upper_of += (c == 'a' ? "'"s : ", '"s) + c + "': '"s + static_cast<char>(c - 'a' + 'A') + "'"s;
+    }
+    return upper_of + R"(}
+text = 'lorem ipsum dolor sit amet, '
+i = 0
+while i < 8:
+  text = text + text
+  i = i + 1
+text = text + 'needle'
+n = len(text)
+rounds = 0
+while rounds < 10:
+)"s + body + R"(
+  rounds = rounds + 1
+)"s;
+}
+
+// Построение текста без обработки: общая часть замеров методов и их аналогов на Mython
+void BenchTextSetup() {
+    RunProgram(TextProgram("  idle = 0"s));
+}
+
+void BenchFindBuiltin() {
+    RunProgram(TextProgram("  found = text.find('needle')"s));
+}
+
+void BenchFindLoop() {
+    RunProgram(TextProgram(R"(
+  pattern = 'needle'
+  found = -1
+  i = 0
+  while i + 6 <= n and found < 0:
+    j = 0
+    while j < 6:
+      if text[i + j] == pattern[j]:
+        j = j + 1
+      else:
+        j = 7
+    if j == 6:
+      found = i
+    i = i + 1)"s));
+}
+
+void BenchSplitBuiltin() {
+    RunProgram(TextProgram("  words = text.split(' ')"s));
+}
+
+void BenchSplitLoop() {
+    RunProgram(TextProgram(R"(
+  words = []
+  word = ''
+  i = 0
+  while i < n:
+    c = text[i]
+    if c == ' ':
+      words.append(word)
+      word = ''
+    else:
+      word = word + c
+    i = i + 1
+  words.append(word))"s));
+}
+
+void BenchReplaceBuiltin() {
+    RunProgram(TextProgram("  result = text.replace(',', ';')"s));
+}
+
+void BenchReplaceLoop() {
+    RunProgram(TextProgram(R"(
+  result = ''
+  i = 0
+  while i < n:
+    c = text[i]
+    if c == ',':
+      c = ';'
+    result = result + c
+    i = i + 1)"s));
+}
+
+void BenchUpperBuiltin() {
+    RunProgram(TextProgram("  result = text.upper()"s));
+}
+
+void BenchUpperLoop() {
+    RunProgram(TextProgram(R"(
+  result = ''
+  i = 0
+  while i < n:
+    c = text[i]
+    if c in upper_of:
+      c = upper_of[c]
+    result = result + c
+    i = i + 1)"s));
+}
+
+}  // namespace
+
+void RunStringMethodsBenchmarks(BenchRunner& br) {
+    RUN_BENCH(br, BenchTextSetup);
+    RUN_BENCH(br, BenchFindBuiltin);
+    RUN_BENCH(br, BenchFindLoop);
+    RUN_BENCH(br, BenchSplitBuiltin);
+    RUN_BENCH(br, BenchSplitLoop);
+    RUN_BENCH(br, BenchReplaceBuiltin);
+    RUN_BENCH(br, BenchReplaceLoop);
+    RUN_BENCH(br, BenchUpperBuiltin);
+    RUN_BENCH(br, BenchUpperLoop);
+}
+
+}  // namespace runtime
@@ -0,0 +1,93 @@
+#include "interpreter.h"
+#include "lexer.h"
+#include "list.h"
+#include "string_methods.h"
+#include "test_program.h"
+#include "test_runner.h"
+
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestStringSearch() {
+    const string program = R"(
+s = 'abracadabra'
+print s.find('bra'), s.find('bra', 2), s.find('bra', -3), s.find('bra', 20), s.find('x'), s.find(''), s.find('', 11)
+print s.count('a'), s.count('abra'), s.count('aa')
+print s.startswith('abra'), s.startswith(''), s.startswith('bra'), s.endswith('abra'), s.endswith('abracadabra!')
+print 'cad' in s, 'dac' in s, 'dac' not in s
+)"s;
+    ASSERT_EQUAL(Run(program), "1 8 8 -1 -1 0 11\n5 2 0\nTrue True False True False\nTrue False True\n"s);
+}
+
+void TestStringSplitReplaceCase() {
+    const string program = R"(
+class Record:
+  def __init__(line):
+    self.fields = line.split(',')
+
+  def name():
+    first = self.fields[0]
+    return first.upper()
+
+line = 'ann,31,,oslo'
+record = Record(line)
+print record.fields, len(record.fields), record.name()
+spaced = '  one two\tthree\n'
+empty = ''
+blank = '   '
+single = 'word'
+commas = ',a,'
+print spaced.split(), empty.split(), blank.split(), single.split(), empty.split(','), commas.split(',')
+triple = 'aaa'
+print line.replace(',', ' | '), line.replace('31', ''), triple.replace('a', 'aa'), line.replace('x', 'y')
+greeting = 'Hello, World 42!'
+print greeting.upper(), greeting.lower(), empty.upper()
+phrase = 'to be or not to be'
+words = phrase.split(' ')
+print words.count('be'), len(words)
+)"s;
+    ASSERT_EQUAL(Run(program), "[ann, 31, , oslo] 4 ANN\n"
+                               "[one, two, three] [] [] [word] [] [, a, ]\n"
+                               "ann | 31 |  | oslo ann,,,oslo aaaaaa ann,31,,oslo\n"
+                               "HELLO, WORLD 42! hello, world 42! \n"
+                               "2 6\n"s);
+}
+
+void TestStringMethodErrors() {
+    for (const string& call : {"reverse()"s, "find()"s, "find('a', 1, 2)"s, "find(1)"s, "find('a', 'b')"s, "count('')"s,
+                              "split('')"s, "replace('', 'x')"s, "replace('a', None)"s, "upper(1)"s}) {
+        ASSERT_THROWS(Run("s = 'abc'\nprint s."s + call + "\n"s), runtime_error);
+    }
+    ASSERT_THROWS(Run("x = 5\nprint x.upper()\n"s), runtime_error);
+}
+
+// Результат, совпадающий со строкой, - сама строка, а не её копия
+void TestStringMethodsReuseReceiver() {
+    const ObjectHolder self = ObjectHolder::Own(String("ABC 123"s));
+    ASSERT(CallStringMethod(self, "upper"s, {}).Get() == self.Get());
+    ASSERT(CallStringMethod(self, "lower"s, {}).Get() != self.Get());
+    ASSERT(CallStringMethod(self, "replace"s, {ObjectHolder::Own(String("x"s)), ObjectHolder::Own(String("y"s))}).Get()
+           == self.Get());
+
+    const ObjectHolder parts = CallStringMethod(self, "split"s, {ObjectHolder::Own(String(","s))});
+    ASSERT_EQUAL(parts.TryAs<List>()->GetSize(), 1U);
+    ASSERT(parts.TryAs<List>()->Get(0).Get() == self.Get());
+    const ObjectHolder word = ObjectHolder::Own(String("word"s));
+    ASSERT(CallStringMethod(word, "split"s, {}).TryAs<List>()->Get(0).Get() == word.Get());
+}
+
+}  // namespace
+
+void RunStringMethodsTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestStringSearch);
+    RUN_TEST(tr, runtime::TestStringSplitReplaceCase);
+    RUN_TEST(tr, runtime::TestStringMethodErrors);
+    RUN_TEST(tr, runtime::TestStringMethodsReuseReceiver);
+}
+
+}  // namespace runtime
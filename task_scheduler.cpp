@@ -0,0 +1,178 @@
+#include "task_scheduler.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        // Пул и номер очереди рабочего потока, выполняющего код. Вне рабочих потоков пул равен nullptr
+        struct CurrentWorker {
+            TaskScheduler* scheduler = nullptr;
+            size_t index = 0;
+        };
+
+        thread_local CurrentWorker current_worker;
+    }  // namespace
+
+    TaskScheduler::TaskScheduler(size_t threads)
+        : target_threads_(min<size_t>(threads != 0 ? threads : max(thread::hardware_concurrency(), 1U), MAX_THREADS))
+        , workers_(MAX_THREADS) {
+    }
+
+    TaskScheduler::~TaskScheduler() {
+        {
+            lock_guard guard(sleep_lock_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        // Задачи, оставшиеся в очередях, могут запустить новые потоки, пока остальные завершаются
+        size_t joined = 0;
+        while (true) {
+            size_t count = 0;
+            {
+                lock_guard guard(grow_lock_);
+                count = worker_count_.load();
+            }
+            if (joined == count) {
+                break;
+            }
+            for (; joined < count; ++joined) {
+                workers_[joined]->thread.join();
+            }
+        }
+    }
+
+    TaskScheduler& TaskScheduler::Shared() {
+        static TaskScheduler scheduler;
+        return scheduler;
+    }
+
+    void TaskScheduler::Submit(Task task) {
+        if (worker_count_.load() == 0) {
+            StartThreads();
+        }
+        if (current_worker.scheduler == this) {
+            Worker& own = *workers_[current_worker.index];
+            lock_guard guard(own.lock);
+            own.tasks.push_back(std::move(task));
+        }
+        else {
+            lock_guard guard(injector_lock_);
+            injector_.push_back(std::move(task));
+        }
+        pending_.fetch_add(1);
+        {
+            // Поток, проверивший pending_ перед сном, уже ждёт на wake_ и получит уведомление
+            lock_guard guard(sleep_lock_);
+        }
+        wake_.notify_one();
+        MaybeAddThread();
+    }
+
+    size_t TaskScheduler::GetThreadCount() const {
+        return worker_count_.load();
+    }
+
+    TaskScheduler::BlockingScope::BlockingScope()
+        : scheduler_(current_worker.scheduler) {
+        if (scheduler_ != nullptr) {
+            scheduler_->active_.fetch_sub(1);
+            scheduler_->MaybeAddThread();
+        }
+    }
+
+    TaskScheduler::BlockingScope::~BlockingScope() {
+        if (scheduler_ != nullptr) {
+            scheduler_->active_.fetch_add(1);
+        }
+    }
+
+    void TaskScheduler::WorkerLoop(size_t index) {
+        current_worker = CurrentWorker{this, index};
+        while (true) {
+            if (Task task = FindTask(index)) {
+                pending_.fetch_sub(1);
+                try {
+                    task();
+                } catch (...) {
+                    // Задача сама сообщает о своих ошибках, поток продолжает работу
+                }
+                continue;
+            }
+            unique_lock lock(sleep_lock_);
+            if (pending_.load() > 0) {
+                continue;
+            }
+            if (stopping_) {
+                return;
+            }
+            wake_.wait(lock, [this] {
+                return pending_.load() > 0 || stopping_;
+            });
+        }
+    }
+
+    TaskScheduler::Task TaskScheduler::FindTask(size_t index) {
+        {
+            Worker& own = *workers_[index];
+            lock_guard guard(own.lock);
+            if (!own.tasks.empty()) {
+                Task task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return task;
+            }
+        }
+        {
+            lock_guard guard(injector_lock_);
+            if (!injector_.empty()) {
+                Task task = std::move(injector_.front());
+                injector_.pop_front();
+                return task;
+            }
+        }
+        const size_t count = worker_count_.load(memory_order_acquire);
+        for (size_t shift = 1; shift < count; ++shift) {
+            Worker& victim = *workers_[(index + shift) % count];
+            lock_guard guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                Task task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return task;
+            }
+        }
+        return {};
+    }
+
+    void TaskScheduler::StartThreads() {
+        lock_guard guard(grow_lock_);
+        while (worker_count_.load() < target_threads_) {
+            AddThreadLocked();
+        }
+    }
+
+    void TaskScheduler::MaybeAddThread() {
+        if (pending_.load() == 0 || active_.load() >= target_threads_) {
+            return;
+        }
+        lock_guard guard(grow_lock_);
+        if (pending_.load() > 0 && active_.load() < target_threads_) {
+            AddThreadLocked();
+        }
+    }
+
+    void TaskScheduler::AddThreadLocked() {
+        const size_t index = worker_count_.load();
+        if (index == MAX_THREADS) {
+            return;
+        }
+        workers_[index] = make_unique<Worker>();
+        active_.fetch_add(1);
+        worker_count_.store(index + 1, memory_order_release);
+        workers_[index]->thread = thread([this, index] {
+            WorkerLoop(index);
+        });
+    }
+
+}  // namespace runtime
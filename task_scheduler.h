@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+
+    /*
+     * Пул потоков с перехватом задач, на котором выполняются изоляты (см. isolate.h).
+     * У каждого рабочего потока своя очередь. Задача, запущенная из рабочего потока, попадает в его очередь
+     * и берётся оттуда с конца, пока её данные ещё в кэше, а простаивающие потоки забирают задачи с начала
+     * чужих очередей. Задачи из остальных потоков попадают в общую очередь.
+     *
+     * Пул создаётся с числом потоков по числу ядер, потоки запускаются при первой задаче.
+     * Задача, которая ждёт результата другой задачи (сообщения из канала, завершения изолята), отмечает
+     * ожидание через BlockingScope. Пока ожидающие потоки не дают выполнять задачи из очередей, пул добавляет
+     * потоки (не больше MAX_THREADS), поэтому ожидание не приводит к взаимной блокировке.
+     * Добавленные потоки остаются в пуле до его разрушения
+     */
+    class TaskScheduler {
+    public:
+        using Task = std::function<void()>;
+
+        static constexpr size_t MAX_THREADS = 256;
+
+        // Создаёт пул из threads потоков. 0 - по числу ядер
+        explicit TaskScheduler(size_t threads = 0);
+        // Дожидается выполнения задач из очередей и останавливает потоки
+        ~TaskScheduler();
+
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+        // Возвращает общий пул процесса
+        static TaskScheduler& Shared();
+
+        // Ставит задачу в очередь. Исключения, выброшенные задачей, игнорируются
+        void Submit(Task task);
+
+        // Возвращает число запущенных потоков пула
+        [[nodiscard]] size_t GetThreadCount() const;
+
+        // Отмечает ожидание текущего потока на время своей жизни. Вне рабочих потоков пула ничего не делает
+        class BlockingScope {
+        public:
+            BlockingScope();
+            ~BlockingScope();
+
+            BlockingScope(const BlockingScope&) = delete;
+            BlockingScope& operator=(const BlockingScope&) = delete;
+
+        private:
+            TaskScheduler* scheduler_;
+        };
+
+    private:
+        struct alignas(64) Worker {
+            std::mutex lock;
+            std::deque<Task> tasks;
+            std::thread thread;
+        };
+
+        void WorkerLoop(size_t index);
+        Task FindTask(size_t index);
+        void StartThreads();
+        // Запускает поток, если задачи ждут в очередях, а потоков без ожидания меньше target_threads_
+        void MaybeAddThread();
+        // Запускает ещё один поток. Вызывается под grow_lock_
+        void AddThreadLocked();
+
+        const size_t target_threads_;
+        // Очереди потоков. Заполненные элементы не перемещаются, их число - worker_count_
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::atomic<size_t> worker_count_{0};
+        std::mutex grow_lock_;
+
+        std::mutex injector_lock_;
+        std::deque<Task> injector_;
+
+        // Число задач в очередях и потоков, которые не ожидают внутри BlockingScope
+        std::atomic<size_t> pending_{0};
+        std::atomic<size_t> active_{0};
+
+        std::mutex sleep_lock_;
+        std::condition_variable wake_;
+        bool stopping_ = false;
+    };
+
+}  // namespace runtime
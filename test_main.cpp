@@ -0,0 +1,72 @@
+#include "test_runner.h"
+
+namespace parse {
+void RunOpenLexerTests(TestRunner& tr);
+void RunMappedFileTests(TestRunner& tr);
+}  // namespace parse
+
+namespace ast {
+void RunUnitTests(TestRunner& tr);
+void RunSerializeTests(TestRunner& tr);
+}  // namespace ast
+namespace runtime {
+void RunObjectHolderTests(TestRunner& tr);
+void RunObjectsTests(TestRunner& tr);
+void RunOutputContextTests(TestRunner& tr);
+void RunHeapTests(TestRunner& tr);
+void RunObjectPoolTests(TestRunner& tr);
+void RunMemoryBudgetTests(TestRunner& tr);
+void RunExecutionLimitsTests(TestRunner& tr);
+void RunIsolateTests(TestRunner& tr);
+void RunCoroutineTests(TestRunner& tr);
+void RunCallStackTests(TestRunner& tr);
+void RunIntKernelsTests(TestRunner& tr);
+void RunListTests(TestRunner& tr);
+void RunDictTests(TestRunner& tr);
+void RunTextKernelsTests(TestRunner& tr);
+void RunStringMethodsTests(TestRunner& tr);
+}  // namespace runtime
+
+namespace server {
+void RunServerTests(TestRunner& tr);
+}  // namespace server
+
+void TestParseProgram(TestRunner& tr);
+void RunInterpreterTests(TestRunner& tr);
+void RunBatchRunnerTests(TestRunner& tr);
+
+namespace {
+
+void TestAll() {
+    TestRunner tr;
+    parse::RunOpenLexerTests(tr);
+    parse::RunMappedFileTests(tr);
+    runtime::RunObjectHolderTests(tr);
+    runtime::RunObjectsTests(tr);
+    runtime::RunOutputContextTests(tr);
+    runtime::RunHeapTests(tr);
+    runtime::RunObjectPoolTests(tr);
+    runtime::RunMemoryBudgetTests(tr);
+    runtime::RunExecutionLimitsTests(tr);
+    runtime::RunCallStackTests(tr);
+    runtime::RunIntKernelsTests(tr);
+    runtime::RunListTests(tr);
+    runtime::RunDictTests(tr);
+    runtime::RunTextKernelsTests(tr);
+    runtime::RunStringMethodsTests(tr);
+    ast::RunUnitTests(tr);
+    ast::RunSerializeTests(tr);
+    TestParseProgram(tr);
+    RunInterpreterTests(tr);
+    RunBatchRunnerTests(tr);
+    runtime::RunIsolateTests(tr);
+    runtime::RunCoroutineTests(tr);
+    server::RunServerTests(tr);
+}
+
+}  // namespace
+
+int main() {
+    TestAll();
+    return 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "interpreter.h"
+
+#include <sstream>
+#include <string>
+
+namespace runtime {
+
+// Выполняет программу на Mython с параметрами options и возвращает её вывод
+inline std::string Run(const std::string& program, const RunOptions& options = {}) {
+    std::ostringstream out;
+    SimpleContext context(out);
+    RunMythonProgram(program, context, options);
+    return out.str();
+}
+
+}  // namespace runtime
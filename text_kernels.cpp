@@ -0,0 +1,155 @@
+#include "text_kernels.h"
+
+#include "int_kernels.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define TEXT_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        bool InRange(char c, char low, char high) {
+            return c >= low && c <= high;
+        }
+
+        // Кандидаты на вхождение находит memchr по первому байту, остаток сравнивает memcmp
+        size_t FindScalar(const char* text, size_t size, const char* pattern, size_t pattern_size) {
+            const char* const end = text + (size - pattern_size + 1);
+            for (const char* candidate = text; candidate < end; ++candidate) {
+                candidate = static_cast<const char*>(memchr(candidate, pattern[0], end - candidate));
+                if (candidate == nullptr) {
+                    break;
+                }
+                if (memcmp(candidate + 1, pattern + 1, pattern_size - 1) == 0) {
+                    return candidate - text;
+                }
+            }
+            return string_view::npos;
+        }
+
+        size_t FindInRangeScalar(const char* data, size_t size, char low, char high) {
+            size_t i = 0;
+            while (i < size && !InRange(data[i], low, high)) {
+                ++i;
+            }
+            return i;
+        }
+
+        void FlipScalar(char* data, size_t size, char low, char high) {
+            for (size_t i = 0; i < size; ++i) {
+                if (InRange(data[i], low, high)) {
+                    data[i] = static_cast<char>(data[i] ^ 0x20);
+                }
+            }
+        }
+
+#ifdef TEXT_KERNELS_AVX2
+        constexpr size_t BYTES = 32;
+
+        __attribute__((target("avx2"))) __m256i Load(const char* data) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        }
+
+        // Байты со знаком: байты от 0x80 отрицательны и в диапазон букв ASCII не попадают
+        __attribute__((target("avx2"))) __m256i RangeMask(__m256i block, char low, char high) {
+            return _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8(static_cast<char>(low - 1))),
+                                    _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(high + 1)), block));
+        }
+
+        // Блок из 32 возможных начал вхождения отбирается сравнением сразу первого и последнего байтов
+        // pattern, и memcmp проверяет только позиции, где совпали оба
+        __attribute__((target("avx2"))) size_t FindAvx2(const char* text, size_t size, const char* pattern,
+                                                        size_t pattern_size) {
+            const __m256i first = _mm256_set1_epi8(pattern[0]);
+            const __m256i last = _mm256_set1_epi8(pattern[pattern_size - 1]);
+            size_t i = 0;
+            for (; i + pattern_size - 1 + BYTES <= size; i += BYTES) {
+                const __m256i first_equal = _mm256_cmpeq_epi8(first, Load(text + i));
+                const __m256i last_equal = _mm256_cmpeq_epi8(last, Load(text + i + pattern_size - 1));
+                auto candidates = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(first_equal, last_equal)));
+                while (candidates != 0) {
+                    const size_t position = i + __builtin_ctz(candidates);
+                    if (memcmp(text + position + 1, pattern + 1, pattern_size - 2) == 0) {
+                        return position;
+                    }
+                    candidates &= candidates - 1;
+                }
+            }
+            const size_t rest = FindScalar(text + i, size - i, pattern, pattern_size);
+            return rest == string_view::npos ? rest : i + rest;
+        }
+
+        __attribute__((target("avx2"))) size_t FindInRangeAvx2(const char* data, size_t size, char low, char high) {
+            size_t i = 0;
+            for (; i + BYTES <= size; i += BYTES) {
+                const auto found = static_cast<uint32_t>(_mm256_movemask_epi8(RangeMask(Load(data + i), low, high)));
+                if (found != 0) {
+                    return i + __builtin_ctz(found);
+                }
+            }
+            return i + FindInRangeScalar(data + i, size - i, low, high);
+        }
+
+        __attribute__((target("avx2"))) void FlipAvx2(char* data, size_t size, char low, char high) {
+            const __m256i case_bit = _mm256_set1_epi8(0x20);
+            size_t i = 0;
+            for (; i + BYTES <= size; i += BYTES) {
+                const __m256i block = Load(data + i);
+                const __m256i flipped = _mm256_xor_si256(block, _mm256_and_si256(RangeMask(block, low, high), case_bit));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), flipped);
+            }
+            FlipScalar(data + i, size - i, low, high);
+        }
+
+        bool UseAvx2() {
+            return GetKernelIsa() == KernelIsa::Avx2;
+        }
+#endif
+    }  // namespace
+
+    size_t FindText(string_view text, string_view pattern) {
+        if (pattern.empty()) {
+            return 0;
+        }
+        if (pattern.size() > text.size()) {
+            return string_view::npos;
+        }
+        if (pattern.size() == 1) {
+            const void* found = memchr(text.data(), pattern[0], text.size());
+            return found == nullptr ? string_view::npos : static_cast<const char*>(found) - text.data();
+        }
+#ifdef TEXT_KERNELS_AVX2
+        if (UseAvx2()) {
+            return FindAvx2(text.data(), text.size(), pattern.data(), pattern.size());
+        }
+#endif
+        return FindScalar(text.data(), text.size(), pattern.data(), pattern.size());
+    }
+
+    size_t FindByteInRange(string_view text, char low, char high) {
+#ifdef TEXT_KERNELS_AVX2
+        if (UseAvx2()) {
+            return FindInRangeAvx2(text.data(), text.size(), low, high);
+        }
+#endif
+        return FindInRangeScalar(text.data(), text.size(), low, high);
+    }
+
+    void FlipAsciiCase(char* data, size_t size, char low, char high) {
+#ifdef TEXT_KERNELS_AVX2
+        if (UseAvx2()) {
+            FlipAvx2(data, size, low, high);
+            return;
+        }
+#endif
+        FlipScalar(data, size, low, high);
+    }
+
+}  // namespace runtime
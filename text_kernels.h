@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace runtime {
+
+    /*
+     * Векторные функции поиска и преобразования байтов строк, на которых работают методы строк Mython
+     * (string_methods.h) и оператор in. Строки Mython - последовательности байтов, поэтому регистр меняется
+     * только у латинских букв, остальные байты остаются как есть.
+     * Набор инструкций тот же, что у функций int_kernels.h, и переключается той же функцией SetKernelIsa:
+     * с AVX2 функции проверяют по 32 байта за инструкцию, без него ищут байт функцией memchr
+     */
+
+    // Позиция первого вхождения pattern в text либо std::string_view::npos.
+    // Пустой pattern находится в позиции 0
+    size_t FindText(std::string_view text, std::string_view pattern);
+    // Позиция первого байта text из диапазона [low, high] либо text.size(); low и high - символы ASCII
+    size_t FindByteInRange(std::string_view text, char low, char high);
+    // Меняет регистр байтов data из диапазона [low, high] букв ASCII: 'a'-'z' на заглавные, 'A'-'Z' на строчные
+    void FlipAsciiCase(char* data, size_t size, char low, char high);
+
+}  // namespace runtime
@@ -0,0 +1,83 @@
+#include "int_kernels.h"
+#include "text_kernels.h"
+#include "test_runner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Текст из букв 'a' и 'b' с редкими заглавными буквами и байтами от 0x80, детерминированный для воспроизводимости
+string MakeText(size_t size, uint32_t seed) {
+    string text(size, 'a');
+    uint32_t state = seed;
+    for (char& c : text) {
+        state = state * 1664525U + 1013904223U;
+        const uint32_t kind = (state >> 24) % 16;
+        c = kind == 0 ? 'Z' : kind == 1 ? static_cast<char>(0xE0) : kind < 8 ? 'b' : 'a';
+    }
+    return text;
+}
+
+// Проверяет функции текущего набора инструкций на текстах всех длин от 0 до 100: векторная часть,
+// остаток и вхождения на их границе
+void CheckKernels() {
+    for (size_t size = 0; size <= 100; ++size) {
+        const string text = MakeText(size, static_cast<uint32_t>(size));
+        for (size_t pattern_size = 0; pattern_size <= 5; ++pattern_size) {
+            for (size_t from = 0; from + pattern_size <= size; from += 7) {
+                const string_view pattern = string_view(text).substr(from, pattern_size);
+                ASSERT_EQUAL(FindText(text, pattern), text.find(pattern));
+            }
+            const string absent(pattern_size, 'c');
+            ASSERT_EQUAL(FindText(text, absent), pattern_size == 0 ? 0 : string_view::npos);
+        }
+
+        string expected = text;
+        for (char& c : expected) {
+            if (c >= 'a' && c <= 'z') {
+                c = static_cast<char>(c - 'a' + 'A');
+            }
+        }
+        string upper = text;
+        FlipAsciiCase(upper.data(), upper.size(), 'a', 'z');
+        ASSERT_EQUAL(upper, expected);
+        ASSERT_EQUAL(FindByteInRange(text, 'A', 'Z'), min(text.find('Z'), size));
+        ASSERT_EQUAL(FindByteInRange(upper, 'a', 'z'), size);
+    }
+
+    // Вхождение, которое начинается в векторной части и заканчивается в остатке
+    string text(40, 'x');
+    text.replace(30, 6, "needle"s);
+    ASSERT_EQUAL(FindText(text, "needle"s), 30U);
+    ASSERT_EQUAL(FindText(text, "needles"s), string_view::npos);
+    ASSERT_EQUAL(FindText("abc"s, "abcd"s), string_view::npos);
+}
+
+void TestScalarTextKernels() {
+    const KernelIsa previous = SetKernelIsa(KernelIsa::Scalar);
+    CheckKernels();
+    SetKernelIsa(previous);
+}
+
+void TestVectorTextKernels() {
+    // Без AVX2 набор не переключается, и проверка повторяет обычные циклы
+    const KernelIsa previous = SetKernelIsa(KernelIsa::Avx2);
+    CheckKernels();
+    SetKernelIsa(previous);
+}
+
+}  // namespace
+
+void RunTextKernelsTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestScalarTextKernels);
+    RUN_TEST(tr, runtime::TestVectorTextKernels);
+}
+
+}  // namespace runtime